@@ -1014,6 +1014,10 @@ class CHelpItems {
 					'key' => 'zabbix[vmware,buffer,<mode>]',
 					'description' => _('VMware cache statistics. Valid modes are: total, free, pfree, used and pused.')
 				],
+				[
+					'key' => 'zabbix[vmware,memory,<structure>]',
+					'description' => _('VMware cache memory used by the cached structures. Valid structures are: strings, hypervisors, vms, datastores, clusters, events and perf.')
+				],
 				[
 					'key' => 'zabbix[wcache,<cache>,<mode>]',
 					'description' => _('Data cache statistics. Cache - one of values (modes: all, float, uint, str, log, text), history (modes: pfree, total, used, free), trend (modes: pfree, total, used, free), text (modes: pfree, total, used, free).')
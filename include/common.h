@@ -423,6 +423,7 @@ zbx_graph_yaxis_types_t;
 /* runtime control options */
 #define ZBX_CONFIG_CACHE_RELOAD	"config_cache_reload"
 #define ZBX_HOUSEKEEPER_EXECUTE	"housekeeper_execute"
+#define ZBX_IPC_STATS		"ipc_stats"
 #define ZBX_LOG_LEVEL_INCREASE	"log_level_increase"
 #define ZBX_LOG_LEVEL_DECREASE	"log_level_decrease"
 
@@ -537,7 +538,10 @@ const char	*get_program_type_string(unsigned char program_type);
 #define ZBX_PROCESS_TYPE_PREPROCESSOR	27
 #define ZBX_PROCESS_TYPE_LLDMANAGER	28
 #define ZBX_PROCESS_TYPE_LLDWORKER	29
-#define ZBX_PROCESS_TYPE_COUNT		30	/* number of process types */
+#define ZBX_PROCESS_TYPE_AGENTPOLLER	30
+#define ZBX_PROCESS_TYPE_HTTPAGENTPOLLER	31
+#define ZBX_PROCESS_TYPE_SNMPPOLLER	32
+#define ZBX_PROCESS_TYPE_COUNT		33	/* number of process types */
 #define ZBX_PROCESS_TYPE_UNKNOWN	255
 const char	*get_process_type_string(unsigned char process_type);
 int		get_process_type_by_name(const char *proc_type_str);
@@ -894,6 +898,7 @@ zbx_task_t;
 #define ZBX_RTC_LOG_LEVEL_DECREASE	2
 #define ZBX_RTC_HOUSEKEEPER_EXECUTE	3
 #define ZBX_RTC_CONFIG_CACHE_RELOAD	8
+#define ZBX_RTC_IPC_STATS		9
 
 typedef enum
 {
@@ -66,6 +66,10 @@ typedef int	ZBX_SOCKET;
 #	define ZBX_SOCKADDR struct sockaddr_in
 #endif
 
+#ifndef SOCK_CLOEXEC
+#	define SOCK_CLOEXEC 0	/* SOCK_CLOEXEC is Linux-specific, available since 2.6.23 */
+#endif
+
 typedef enum
 {
 	ZBX_BUF_TYPE_STAT = 0,
@@ -119,6 +123,9 @@ int	zbx_tcp_connect(zbx_socket_t *s, const char *source_ip, const char *ip, unsi
 #define ZBX_TCP_PROTOCOL		0x01
 #define ZBX_TCP_COMPRESS		0x02
 
+#define ZBX_TCP_HEADER_DATA	"ZBXD"
+#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
+
 #define ZBX_TCP_SEC_UNENCRYPTED		1		/* do not use encryption with this socket */
 #define ZBX_TCP_SEC_TLS_PSK		2		/* use TLS with pre-shared key (PSK) with this socket */
 #define ZBX_TCP_SEC_TLS_CERT		4		/* use TLS with certificate with this socket */
@@ -35,12 +35,19 @@
 #define	ZBX_POLLER_TYPE_IPMI		2
 #define	ZBX_POLLER_TYPE_PINGER		3
 #define	ZBX_POLLER_TYPE_JAVA		4
-#define	ZBX_POLLER_TYPE_COUNT		5	/* number of poller types */
+#define	ZBX_POLLER_TYPE_AGENT		5
+#define	ZBX_POLLER_TYPE_HTTPAGENT	6
+#define	ZBX_POLLER_TYPE_SNMP		7
+#define	ZBX_POLLER_TYPE_COUNT		8	/* number of poller types */
 
 #define MAX_JAVA_ITEMS		32
 #define MAX_SNMP_ITEMS		128
-#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS) */
+#define MAX_AGENT_ITEMS		64	/* the maximum number of keys in agent bulk request */
+#define MAX_POLLER_ITEMS	128	/* MAX(MAX_JAVA_ITEMS, MAX_SNMP_ITEMS, MAX_AGENT_ITEMS) */
 #define MAX_PINGER_ITEMS	128
+#define MAX_AGENT_POLLER_ITEMS	512	/* the maximum number of concurrent checks in agent poller */
+#define MAX_HTTPAGENT_POLLER_ITEMS	512	/* the maximum number of concurrent checks in HTTP agent poller */
+#define MAX_SNMP_POLLER_ITEMS	512	/* the maximum number of items polled concurrently by SNMP poller */
 
 #define ZBX_TRIGGER_DEPENDENCY_LEVELS_MAX	32
 
@@ -60,6 +67,9 @@ extern int	CONFIG_POLLER_FORKS;
 extern int	CONFIG_UNREACHABLE_POLLER_FORKS;
 extern int	CONFIG_IPMIPOLLER_FORKS;
 extern int	CONFIG_JAVAPOLLER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_HTTPAGENTPOLLER_FORKS;
+extern int	CONFIG_SNMPPOLLER_FORKS;
 extern int	CONFIG_PINGER_FORKS;
 extern int	CONFIG_UNAVAILABLE_DELAY;
 extern int	CONFIG_UNREACHABLE_PERIOD;
@@ -658,6 +668,7 @@ void	DCconfig_get_triggers_by_itemids(zbx_hashset_t *trigger_info, zbx_vector_pt
 void	DCfree_triggers(zbx_vector_ptr_t *triggers);
 void	DCconfig_update_interface_snmp_stats(zbx_uint64_t interfaceid, int max_snmp_succeed, int min_snmp_fail);
 int	DCconfig_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk);
+void	DCconfig_disable_interface_agent_bulk(zbx_uint64_t interfaceid, int now);
 int	DCconfig_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid, unsigned char type);
 int	DCconfig_get_interface(DC_INTERFACE *interface, zbx_uint64_t hostid, zbx_uint64_t itemid);
 int	DCconfig_get_poller_nextcheck(unsigned char poller_type);
@@ -862,7 +873,7 @@ void	zbx_dc_get_trigger_dependencies(const zbx_vector_uint64_t *triggerids, zbx_
 
 void	zbx_dc_reschedule_items(const zbx_vector_uint64_t *itemids, int now, zbx_uint64_t *proxy_hostids);
 
-void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int limit);
+void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int limit, int partition);
 void	zbx_dc_get_timer_triggers_by_triggerids(zbx_hashset_t *trigger_info, zbx_vector_ptr_t *trigger_order,
 		const zbx_vector_uint64_t *triggerids, const zbx_timespec_t *ts);
 void	zbx_dc_clear_timer_queue(void);
@@ -67,6 +67,7 @@ void	zbx_mem_clear(zbx_mem_info_t *info);
 void	zbx_mem_dump_stats(int level, zbx_mem_info_t *info);
 
 size_t	zbx_mem_required_size(int chunks_num, const char *descr, const char *param);
+zbx_uint64_t	zbx_mem_required_chunk_size(zbx_uint64_t size);
 
 #define ZBX_MEM_FUNC1_DECL_MALLOC(__prefix)				\
 static void	*__prefix ## _mem_malloc_func(void *old, size_t size)
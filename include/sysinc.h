@@ -343,6 +343,18 @@
 #	include <sys/shm.h>
 #endif
 
+#ifdef HAVE_SYS_EVENTFD_H
+#	include <sys/eventfd.h>
+#endif
+
+#ifdef HAVE_SYS_UIO_H
+#	include <sys/uio.h>
+#endif
+
+#ifdef HAVE_POLL_H
+#	include <poll.h>
+#endif
+
 #ifdef HAVE_SYS_FILE_H
 #	include <sys/file.h>
 #endif
@@ -57,6 +57,38 @@ zbx_ipc_socket_t;
 
 typedef struct zbx_ipc_client zbx_ipc_client_t;
 
+/* the number of message queue latency histogram buckets, see ipc_service_update_latency() */
+#define ZBX_IPC_LATENCY_BUCKETS	7
+
+/* IPC service statistics */
+typedef struct
+{
+	/* the received and sent messages and bytes, including message headers */
+	zbx_uint64_t	rx_messages;
+	zbx_uint64_t	rx_bytes;
+	zbx_uint64_t	tx_messages;
+	zbx_uint64_t	tx_bytes;
+
+	/* the messages waiting to be returned by zbx_ipc_service_recv() and the peak value */
+	zbx_uint64_t	rx_queued;
+	zbx_uint64_t	rx_queued_max;
+
+	/* the messages waiting to be written to client sockets and the peak value */
+	zbx_uint64_t	tx_queued;
+	zbx_uint64_t	tx_queued_max;
+
+	/* the time received messages spent in queue before being returned by zbx_ipc_service_recv() */
+	zbx_uint64_t	latency[ZBX_IPC_LATENCY_BUCKETS];
+	double		latency_sum;
+	double		latency_max;
+
+	/* the service start time */
+	double		time_start;
+}
+zbx_ipc_service_stats_t;
+
+typedef struct zbx_ipc_ring zbx_ipc_ring_t;
+
 /* IPC service */
 typedef struct
 {
@@ -75,15 +107,52 @@ typedef struct
 
 	/* the clients with messages */
 	zbx_queue_ptr_t		clients_recv;
+
+	/* the ring buffer notification event */
+	struct event		*ev_ring;
+
+	/* the ring buffer added to service, used for statistics */
+	const zbx_ipc_ring_t	*ring;
+
+	zbx_ipc_service_stats_t	stats;
 }
 zbx_ipc_service_t;
 
+typedef struct zbx_ipc_ring_shared zbx_ipc_ring_shared_t;
+
+/* shared memory ring buffer, multiple producers - single consumer */
+struct zbx_ipc_ring
+{
+	/* the ring buffer data in shared memory */
+	zbx_ipc_ring_shared_t	*shared;
+
+	/* the wakeup descriptors (the same descriptor when eventfd is used) */
+	int			fd_read;
+	int			fd_write;
+
+	/* the consumer read position and the last known write position */
+	zbx_uint64_t		cursor;
+	zbx_uint64_t		head;
+
+	/* the fragmented message reassembly buffer */
+	unsigned char		*rx_data;
+	zbx_uint32_t		rx_size;
+	zbx_uint32_t		rx_alloc;
+
+	/* the messages and bytes read by consumer */
+	zbx_uint64_t		rx_messages;
+	zbx_uint64_t		rx_bytes;
+};
+
 int	zbx_ipc_service_init_env(const char *path, char **error);
 void	zbx_ipc_service_free_env(void);
 int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name, char **error);
 int	zbx_ipc_service_recv(zbx_ipc_service_t *service, int timeout, zbx_ipc_client_t **client,
 		zbx_ipc_message_t **message);
 void	zbx_ipc_service_close(zbx_ipc_service_t *service);
+int	zbx_ipc_service_add_ring(zbx_ipc_service_t *service, zbx_ipc_ring_t *ring, char **error);
+void	zbx_ipc_service_sigusr_handler(int flags);
+int	zbx_ipc_service_get_stats(const char *service_name, char **data, char **error);
 
 int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size);
 void	zbx_ipc_client_close(zbx_ipc_client_t *client);
@@ -104,5 +173,12 @@ void	zbx_ipc_message_init(zbx_ipc_message_t *message);
 void	zbx_ipc_message_format(const zbx_ipc_message_t *message, char **data);
 void	zbx_ipc_message_copy(zbx_ipc_message_t *dst, const zbx_ipc_message_t *src);
 
+int	zbx_ipc_ring_create(zbx_ipc_ring_t *ring, zbx_uint32_t size, char **error);
+void	zbx_ipc_ring_destroy(zbx_ipc_ring_t *ring);
+int	zbx_ipc_ring_get_fd(const zbx_ipc_ring_t *ring);
+void	zbx_ipc_ring_write(zbx_ipc_ring_t *ring, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size);
+int	zbx_ipc_ring_read(zbx_ipc_ring_t *ring, zbx_ipc_message_t *message);
+void	zbx_ipc_ring_release(zbx_ipc_ring_t *ring);
+
 #endif
 
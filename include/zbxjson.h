@@ -107,6 +107,7 @@
 #define ZBX_PROTO_VALUE_SUCCESS		"success"
 
 #define ZBX_PROTO_VALUE_GET_ACTIVE_CHECKS	"active checks"
+#define ZBX_PROTO_VALUE_PASSIVE_CHECKS		"passive checks"
 #define ZBX_PROTO_VALUE_PROXY_CONFIG		"proxy config"
 #define ZBX_PROTO_VALUE_PROXY_HEARTBEAT		"proxy heartbeat"
 #define ZBX_PROTO_VALUE_DISCOVERY_DATA		"discovery data"
@@ -170,6 +171,43 @@ struct zbx_json_parse
 	const char		*end;
 };
 
+/* json structural index token, describes a single json value or object member name */
+typedef struct
+{
+	const char	*start;		/* the first character of the value */
+	const char	*end;		/* the last character of the value */
+	int		next;		/* the index of the token following the value with all its contents */
+	int		escaped;	/* 1 - the string contains escape sequences */
+}
+zbx_json_token_t;
+
+/* json structural index, object members are stored as name token followed by value tokens */
+typedef struct
+{
+	zbx_json_token_t	*tokens;
+	int			tokens_num;
+	int			tokens_alloc;
+}
+zbx_json_index_t;
+
+/* compiled json path component */
+typedef struct
+{
+	char	*name;		/* the member name or NULL for array index */
+	int	index;		/* the array index */
+	int	offset;		/* the component offset in json path, used in error messages */
+}
+zbx_jsonpath_component_t;
+
+/* compiled json path */
+typedef struct
+{
+	char				*path;
+	zbx_jsonpath_component_t	*components;
+	int				components_num;
+}
+zbx_jsonpath_t;
+
 const char	*zbx_json_strerror(void);
 
 void	zbx_json_init(struct zbx_json *j, size_t allocate);
@@ -203,6 +241,25 @@ void		zbx_json_escape(char **string);
 
 int	zbx_json_path_check(const char *path, char * error, size_t errlen);
 int	zbx_json_path_open(const struct zbx_json_parse *jp, const char *path, struct zbx_json_parse *out);
+int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath);
+void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath);
+int	zbx_json_path_open_compiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath,
+		struct zbx_json_parse *out);
+int	zbx_json_index_open(const char *buffer, zbx_json_index_t *index);
+void	zbx_json_index_clear(zbx_json_index_t *index);
+int	zbx_json_index_next(const zbx_json_index_t *index, int node, int child);
+int	zbx_json_index_by_name(const zbx_json_index_t *index, int node, const char *name);
+void	zbx_json_index_parse(const zbx_json_index_t *index, int node, struct zbx_json_parse *jp);
+int	zbx_json_index_brackets_by_name(const zbx_json_index_t *index, int node, const char *name,
+		struct zbx_json_parse *out);
+int	zbx_json_index_value_by_name(const zbx_json_index_t *index, int node, const char *name, char *string,
+		size_t len);
+int	zbx_json_index_value_by_name_dyn(const zbx_json_index_t *index, int node, const char *name, char **string,
+		size_t *string_alloc);
+int	zbx_json_index_path_open(const zbx_json_index_t *index, int node, const zbx_jsonpath_t *jsonpath,
+		struct zbx_json_parse *out);
+int	zbx_json_path_open_multi(const struct zbx_json_parse *jp, const char **paths, int paths_num,
+		struct zbx_json_parse *out, int *found);
 void	zbx_json_value_dyn(const struct zbx_json_parse *jp, char **string, size_t *string_alloc);
 
 #endif /* ZABBIX_ZJSON_H */
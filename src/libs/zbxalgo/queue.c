@@ -192,6 +192,32 @@ void	*zbx_queue_ptr_pop(zbx_queue_ptr_t *queue)
 	return value;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_queue_ptr_peek                                               *
+ *                                                                            *
+ * Purpose: gets queued value without removing it from the queue              *
+ *                                                                            *
+ * Parameters: queue - [IN] the queue                                         *
+ *             index - [IN] the value index, 0 is the first value to be       *
+ *                          popped                                            *
+ *                                                                            *
+ * Return value: The queue element or NULL if index is out of range.          *
+ *                                                                            *
+ ******************************************************************************/
+void	*zbx_queue_ptr_peek(const zbx_queue_ptr_t *queue, int index)
+{
+	int	pos;
+
+	if (0 > index || zbx_queue_ptr_values_num((zbx_queue_ptr_t *)queue) <= index)
+		return NULL;
+
+	if ((pos = queue->tail_pos + index) >= queue->alloc_num)
+		pos -= queue->alloc_num;
+
+	return queue->values[pos];
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_queue_ptr_remove_value                                       *
@@ -1243,6 +1243,12 @@ const char	*get_process_type_string(unsigned char proc_type)
 			return "lld manager";
 		case ZBX_PROCESS_TYPE_LLDWORKER:
 			return "lld worker";
+		case ZBX_PROCESS_TYPE_AGENTPOLLER:
+			return "agent poller";
+		case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+			return "http agent poller";
+		case ZBX_PROCESS_TYPE_SNMPPOLLER:
+			return "snmp poller";
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
@@ -37,10 +37,6 @@
 #	define ZBX_SOCKLEN_T socklen_t
 #endif
 
-#ifndef SOCK_CLOEXEC
-#	define SOCK_CLOEXEC 0	/* SOCK_CLOEXEC is Linux-specific, available since 2.6.23 */
-#endif
-
 #ifdef HAVE_OPENSSL
 extern ZBX_THREAD_LOCAL char	info_buf[256];
 #endif
@@ -740,9 +736,6 @@ static ssize_t	zbx_tcp_write(zbx_socket_t *s, const char *buf, size_t len)
  *                                                                            *
  ******************************************************************************/
 
-#define ZBX_TCP_HEADER_DATA	"ZBXD"
-#define ZBX_TCP_HEADER_LEN	ZBX_CONST_STRLEN(ZBX_TCP_HEADER_DATA)
-
 int	zbx_tcp_send_ext(zbx_socket_t *s, const char *data, size_t len, unsigned char flags, int timeout)
 {
 #define ZBX_TLS_MAX_REC_LEN	16384
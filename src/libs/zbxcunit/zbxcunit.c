@@ -352,6 +352,12 @@ const char	*zbx_cu_poller_type_string(unsigned char poller_type)
 			return "icmp pinger";
 		case ZBX_POLLER_TYPE_JAVA:
 			return "java poller";
+		case ZBX_POLLER_TYPE_AGENT:
+			return "agent poller";
+		case ZBX_POLLER_TYPE_HTTPAGENT:
+			return "http agent poller";
+		case ZBX_POLLER_TYPE_SNMP:
+			return "snmp poller";
 		default:
 			return "unknown";
 	}
@@ -56,6 +56,7 @@ static char		*sql = NULL;
 static size_t		sql_alloc = 64 * ZBX_KIBIBYTE;
 
 extern unsigned char	program_type;
+extern int		process_num;
 
 #define ZBX_IDS_SIZE	8
 
@@ -2930,7 +2931,8 @@ static void	sync_server_history(int *values_num, int *triggers_num, int *more)
 
 		if (FAIL != ret)
 		{
-			zbx_dc_get_timer_triggerids(&timer_triggerids, time(NULL), ZBX_HC_TIMER_MAX);
+			/* each history syncer processes time based triggers from its own timer queue */
+			zbx_dc_get_timer_triggerids(&timer_triggerids, time(NULL), ZBX_HC_TIMER_MAX, process_num - 1);
 			timers_num = timer_triggerids.values_num;
 
 			if (ZBX_HC_TIMER_MAX == timers_num)
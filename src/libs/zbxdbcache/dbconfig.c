@@ -63,6 +63,9 @@ int	sync_in_progress = 0;
 #define ZBX_QUEUE_PRIORITY_NORMAL	1
 #define ZBX_QUEUE_PRIORITY_LOW		2
 
+/* period after which agent bulk requests are retried on interfaces that did not support them */
+#define ZBX_AGENT_BULK_RETRY_PERIOD	SEC_PER_HOUR
+
 /* shorthand macro for calling in_maintenance_without_data_collection() */
 #define DCin_maintenance_without_data_collection(dc_host, dc_item)			\
 		in_maintenance_without_data_collection(dc_host->maintenance_status,	\
@@ -90,6 +93,7 @@ static zbx_mem_info_t	*config_mem;
 
 extern unsigned char	program_type;
 extern int		CONFIG_TIMER_FORKS;
+extern int		CONFIG_HISTSYNCER_FORKS;
 
 ZBX_MEM_FUNC_IMPL(__config, config_mem)
 
@@ -264,6 +268,27 @@ static int	is_counted_in_item_queue(unsigned char type, const char *key)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DChost_is_async_agent                                            *
+ *                                                                            *
+ * Purpose: check if passive agent items of the host are polled by            *
+ *          asynchronous agent pollers                                        *
+ *                                                                            *
+ * Parameters: dc_host - [IN] the host                                        *
+ *                                                                            *
+ * Return value: SUCCEED - agent items are polled asynchronously one by one   *
+ *               FAIL    - agent items are polled by regular pollers          *
+ *                                                                            *
+ *****************************************************************************/
+static int	DChost_is_async_agent(const ZBX_DC_HOST *dc_host)
+{
+	if (0 == CONFIG_AGENTPOLLER_FORKS || ZBX_TCP_SEC_UNENCRYPTED != dc_host->tls_connect)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_item_nextcheck_seed                                          *
@@ -278,12 +303,34 @@ static int	is_counted_in_item_queue(unsigned char type, const char *key)
  *           same nextcheck values.                                           *
  *                                                                            *
  ******************************************************************************/
-static zbx_uint64_t	get_item_nextcheck_seed(zbx_uint64_t itemid, zbx_uint64_t interfaceid, unsigned char type,
-		const char *key)
+static zbx_uint64_t	get_item_nextcheck_seed(zbx_uint64_t itemid, zbx_uint64_t hostid, zbx_uint64_t interfaceid,
+		unsigned char type, const char *key)
 {
 	if (ITEM_TYPE_JMX == type)
 		return interfaceid;
 
+	if (ITEM_TYPE_ZABBIX == type)
+	{
+		ZBX_DC_HOST		*host;
+		ZBX_DC_INTERFACE	*interface;
+
+		/* asynchronous agent pollers check items one by one, spread them to even the load */
+		if (NULL == (host = (ZBX_DC_HOST *)zbx_hashset_search(&config->hosts, &hostid)) ||
+				SUCCEED == DChost_is_async_agent(host))
+		{
+			return itemid;
+		}
+
+		/* align checks of the same interface so they can be polled with a single bulk request */
+		if (NULL == (interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)) ||
+				0 != interface->agent_bulk_disable_until)
+		{
+			return itemid;
+		}
+
+		return interfaceid;
+	}
+
 	if (SUCCEED == is_snmp_type(type))
 	{
 		ZBX_DC_INTERFACE	*interface;
@@ -332,7 +379,7 @@ static void	DCitem_nextcheck_update(ZBX_DC_ITEM *item, unsigned char new_state,
 		return;	/* avoid unnecessary nextcheck updates when syncing items in cache */
 	}
 
-	seed = get_item_nextcheck_seed(item->itemid, item->interfaceid, item->type, item->key);
+	seed = get_item_nextcheck_seed(item->itemid, item->hostid, item->interfaceid, item->type, item->key);
 
 	/* for new items, supported items and items that are notsupported due to invalid update interval try to parse */
 	/* interval first and then decide whether it should become/remain supported/notsupported */
@@ -390,6 +437,41 @@ static void	DCitem_nextcheck_update(ZBX_DC_ITEM *item, unsigned char new_state,
 	item->schedulable = 1;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCitem_is_async_snmp                                             *
+ *                                                                            *
+ * Purpose: check if SNMP item can be polled by asynchronous SNMP pollers     *
+ *                                                                            *
+ * Parameters: dc_item - [IN] the item                                        *
+ *                                                                            *
+ * Return value: SUCCEED - SNMPv1 or SNMPv2c item with plain OID              *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Dynamic index and discovery items require walks, while SNMPv3    *
+ *           session opening performs synchronous engine ID discovery, so     *
+ *           such items are left to regular pollers.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	DCitem_is_async_snmp(const ZBX_DC_ITEM *dc_item)
+{
+	const ZBX_DC_SNMPITEM	*snmpitem;
+
+	if (ITEM_TYPE_SNMPv1 != dc_item->type && ITEM_TYPE_SNMPv2c != dc_item->type)
+		return FAIL;
+
+	if (0 != (ZBX_FLAG_DISCOVERY_RULE & dc_item->flags))
+		return FAIL;
+
+	if (NULL == (snmpitem = (const ZBX_DC_SNMPITEM *)zbx_hashset_search(&config->snmpitems, &dc_item->itemid)))
+		return FAIL;
+
+	if (ZBX_SNMP_OID_TYPE_NORMAL != snmpitem->snmp_oid_type)
+		return FAIL;
+
+	return SUCCEED;
+}
+
 static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *dc_host, int flags)
 {
 	unsigned char	poller_type;
@@ -400,12 +482,23 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 		return;
 	}
 
-	poller_type = poller_by_item(dc_item->type, dc_item->key);
+	/* unencrypted passive agent checks are performed asynchronously by agent pollers */
+	if (ITEM_TYPE_ZABBIX == dc_item->type && SUCCEED == DChost_is_async_agent(dc_host))
+		poller_type = ZBX_POLLER_TYPE_AGENT;
+	else if (ITEM_TYPE_HTTPAGENT == dc_item->type && 0 != CONFIG_HTTPAGENTPOLLER_FORKS)
+		poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+	else if (0 != CONFIG_SNMPPOLLER_FORKS && SUCCEED == DCitem_is_async_snmp(dc_item))
+		poller_type = ZBX_POLLER_TYPE_SNMP;
+	else
+		poller_type = poller_by_item(dc_item->type, dc_item->key);
 
 	if (0 != (flags & ZBX_HOST_UNREACHABLE))
 	{
-		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type)
+		if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+				ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type)
+		{
 			poller_type = ZBX_POLLER_TYPE_UNREACHABLE;
+		}
 
 		dc_item->poller_type = poller_type;
 		return;
@@ -417,8 +510,9 @@ static void	DCitem_poller_type_update(ZBX_DC_ITEM *dc_item, const ZBX_DC_HOST *d
 		return;
 	}
 
-	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type ||
-			(ZBX_POLLER_TYPE_NORMAL != poller_type && ZBX_POLLER_TYPE_JAVA != poller_type))
+	if (ZBX_POLLER_TYPE_UNREACHABLE != dc_item->poller_type || (ZBX_POLLER_TYPE_NORMAL != poller_type &&
+			ZBX_POLLER_TYPE_JAVA != poller_type && ZBX_POLLER_TYPE_AGENT != poller_type &&
+			ZBX_POLLER_TYPE_SNMP != poller_type))
 	{
 		dc_item->poller_type = poller_type;
 	}
@@ -2109,6 +2203,8 @@ static void	DCsync_interfaces(zbx_dbsync_t *sync)
 				interface->min_snmp_fail = MAX_SNMP_ITEMS + 1;
 			}
 		}
+		else if (INTERFACE_TYPE_AGENT == interface->type && 1 == reset_snmp_stats)
+			interface->agent_bulk_disable_until = 0;
 
 		/* first resolve macros for ip and dns fields in main agent interface  */
 		/* because other interfaces might reference main interfaces ip and dns */
@@ -4712,6 +4808,22 @@ static int	dc_timer_calculate_nextcheck(time_t now, zbx_uint64_t seed)
 	return nextcheck;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: dc_timer_queue_by_triggerid                                      *
+ *                                                                            *
+ * Purpose: returns timer queue partition the trigger belongs to              *
+ *                                                                            *
+ * Comments: Time based triggers are split between history syncers by         *
+ *           trigger identifier, so every syncer processes its own queue and  *
+ *           the same trigger is always processed by the same syncer.         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_binary_heap_t	*dc_timer_queue_by_triggerid(zbx_uint64_t triggerid)
+{
+	return &config->timer_queues[triggerid % (zbx_uint64_t)config->timer_queues_num];
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: dc_trigger_update_cache                                          *
@@ -4803,9 +4915,12 @@ static void	dc_trigger_update_cache(void)
 
 	zbx_vector_ptr_pair_destroy(&itemtrigs);
 
-	/* add triggers to timer queue */
+	/* add triggers to timer queues */
 	now = time(NULL);
-	zbx_binary_heap_clear(&config->timer_queue);
+
+	for (i = 0; i < config->timer_queues_num; i++)
+		zbx_binary_heap_clear(&config->timer_queues[i]);
+
 	zbx_hashset_iter_reset(&config->triggers, &iter);
 	while (NULL != (trigger = (ZBX_DC_TRIGGER *)zbx_hashset_iter_next(&iter)))
 	{
@@ -4823,7 +4938,7 @@ static void	dc_trigger_update_cache(void)
 		trigger->nextcheck = dc_timer_calculate_nextcheck(now, trigger->triggerid);
 		elem.key = trigger->triggerid;
 		elem.data = (void *)trigger;
-		zbx_binary_heap_insert(&config->timer_queue, &elem);
+		zbx_binary_heap_insert(dc_timer_queue_by_triggerid(trigger->triggerid), &elem);
 	}
 }
 
@@ -5461,8 +5576,11 @@ void	DCsync_configuration(unsigned char mode)
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() pqueue     : %d (%d allocated)", __function_name,
 				config->pqueue.elems_num, config->pqueue.elems_alloc);
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() timer queue: %d (%d allocated)", __function_name,
-				config->timer_queue.elems_num, config->timer_queue.elems_alloc);
+		for (i = 0; i < config->timer_queues_num; i++)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() timer[%d]   : %d (%d allocated)", __function_name,
+					i, config->timer_queues[i].elems_num, config->timer_queues[i].elems_alloc);
+		}
 
 		zabbix_log(LOG_LEVEL_DEBUG, "%s() configfree : " ZBX_FS_DBL "%%", __function_name,
 				100 * ((double)config_mem->free_size / config_mem->orig_size));
@@ -5677,6 +5795,24 @@ static int	__config_snmp_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *
 	return 0;
 }
 
+static int	__config_agent_item_compare(const ZBX_DC_ITEM *i1, const ZBX_DC_ITEM *i2)
+{
+	unsigned char	f1;
+	unsigned char	f2;
+
+	f1 = (ITEM_TYPE_ZABBIX == i1->type);
+	f2 = (ITEM_TYPE_ZABBIX == i2->type);
+
+	ZBX_RETURN_IF_NOT_EQUAL(f1, f2);
+
+	if (0 == f1)
+		return 0;
+
+	ZBX_RETURN_IF_NOT_EQUAL(i1->interfaceid, i2->interfaceid);
+
+	return 0;
+}
+
 static int	__config_heap_elem_compare(const void *d1, const void *d2)
 {
 	const zbx_binary_heap_elem_t	*e1 = (const zbx_binary_heap_elem_t *)d1;
@@ -5691,7 +5827,7 @@ static int	__config_heap_elem_compare(const void *d1, const void *d2)
 	if (SUCCEED != is_snmp_type(i1->type))
 	{
 		if (SUCCEED != is_snmp_type(i2->type))
-			return 0;
+			return __config_agent_item_compare(i1, i2);
 
 		return -1;
 	}
@@ -5971,12 +6107,20 @@ int	init_configuration_cache(char **error)
 					__config_mem_realloc_func,
 					__config_mem_free_func);
 
-	zbx_binary_heap_create_ext(&config->timer_queue,
-					__config_timer_compare,
-					ZBX_BINARY_HEAP_OPTION_DIRECT,
-					__config_mem_malloc_func,
-					__config_mem_realloc_func,
-					__config_mem_free_func);
+	/* time based triggers are processed by history syncers, each syncer owning one timer queue */
+	config->timer_queues_num = MAX(CONFIG_HISTSYNCER_FORKS, 1);
+	config->timer_queues = (zbx_binary_heap_t *)__config_mem_malloc_func(NULL,
+			sizeof(zbx_binary_heap_t) * config->timer_queues_num);
+
+	for (i = 0; i < config->timer_queues_num; i++)
+	{
+		zbx_binary_heap_create_ext(&config->timer_queues[i],
+						__config_timer_compare,
+						ZBX_BINARY_HEAP_OPTION_DIRECT,
+						__config_mem_malloc_func,
+						__config_mem_realloc_func,
+						__config_mem_free_func);
+	}
 
 	CREATE_HASHSET_EXT(config->data_sessions, 0, __config_data_session_hash, __config_data_session_compare);
 
@@ -7438,20 +7582,29 @@ void	zbx_dc_get_timer_triggers_by_triggerids(zbx_hashset_t *trigger_info, zbx_ve
  * Parameters: triggerids - [OUT] timer tirggerids to process                 *
  *             now        - [IN] current time                                 *
  *             limit      - [IN] the maximum number of triggerids to return   *
+ *             partition  - [IN] the timer queue partition (history syncer    *
+ *                               process number starting with 0)              *
  *                                                                            *
  * Comments: This function locks returned triggerids in configuration cache.  *
  *                                                                            *
  ******************************************************************************/
-void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int limit)
+void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int limit, int partition)
 {
+	zbx_binary_heap_t	*queue;
+
 	WRLOCK_CACHE;
 
-	while (SUCCEED != zbx_binary_heap_empty(&config->timer_queue) && 0 != limit)
+	if (0 > partition || partition >= config->timer_queues_num)
+		goto out;
+
+	queue = &config->timer_queues[partition];
+
+	while (SUCCEED != zbx_binary_heap_empty(queue) && 0 != limit)
 	{
 		zbx_binary_heap_elem_t	*elem;
 		ZBX_DC_TRIGGER		*dc_trigger;
 
-		elem = zbx_binary_heap_find_min(&config->timer_queue);
+		elem = zbx_binary_heap_find_min(queue);
 		dc_trigger = (ZBX_DC_TRIGGER *)elem->data;
 
 		if (dc_trigger->nextcheck > now)
@@ -7466,9 +7619,9 @@ void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int l
 		}
 
 		dc_trigger->nextcheck = dc_timer_calculate_nextcheck(now, dc_trigger->triggerid);
-		zbx_binary_heap_update_direct(&config->timer_queue, elem);
+		zbx_binary_heap_update_direct(queue, elem);
 	}
-
+out:
 	UNLOCK_CACHE;
 }
 
@@ -7476,13 +7629,18 @@ void	zbx_dc_get_timer_triggerids(zbx_vector_uint64_t *triggerids, int now, int l
  *                                                                            *
  * Function: zbx_dc_clear_timer_queue                                         *
  *                                                                            *
- * Purpose: clears timer trigger queue                                        *
+ * Purpose: clears timer trigger queues                                       *
  *                                                                            *
  ******************************************************************************/
 void	zbx_dc_clear_timer_queue(void)
 {
+	int	i;
+
 	WRLOCK_CACHE;
-	zbx_binary_heap_clear(&config->timer_queue);
+
+	for (i = 0; i < config->timer_queues_num; i++)
+		zbx_binary_heap_clear(&config->timer_queues[i]);
+
 	UNLOCK_CACHE;
 }
 
@@ -7562,6 +7720,62 @@ int	DCconfig_get_suggested_snmp_vars(zbx_uint64_t interfaceid, int *bulk)
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_disable_interface_agent_bulk                            *
+ *                                                                            *
+ * Purpose: stop polling agent interface with bulk requests                   *
+ *                                                                            *
+ * Parameters: interfaceid - [IN] the agent interface identifier              *
+ *             now         - [IN] the current timestamp                       *
+ *                                                                            *
+ * Comments: Bulk requests are retried after ZBX_AGENT_BULK_RETRY_PERIOD in   *
+ *           case the agent gets upgraded.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	DCconfig_disable_interface_agent_bulk(zbx_uint64_t interfaceid, int now)
+{
+	ZBX_DC_INTERFACE	*dc_interface;
+
+	WRLOCK_CACHE;
+
+	if (NULL != (dc_interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)))
+		dc_interface->agent_bulk_disable_until = now + ZBX_AGENT_BULK_RETRY_PERIOD;
+
+	UNLOCK_CACHE;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: DCconfig_get_agent_bulk_items_nolock                             *
+ *                                                                            *
+ * Purpose: get the number of agent items that can be polled with a single    *
+ *          bulk request                                                      *
+ *                                                                            *
+ * Parameters: interfaceid - [IN] the agent interface identifier              *
+ *             now         - [IN] the current timestamp                       *
+ *                                                                            *
+ * Return value: the maximum number of items in agent poller batch            *
+ *                                                                            *
+ ******************************************************************************/
+static int	DCconfig_get_agent_bulk_items_nolock(zbx_uint64_t interfaceid, int now)
+{
+	ZBX_DC_INTERFACE	*dc_interface;
+
+	if (NULL == (dc_interface = (ZBX_DC_INTERFACE *)zbx_hashset_search(&config->interfaces, &interfaceid)))
+		return 1;
+
+	if (0 != dc_interface->agent_bulk_disable_until)
+	{
+		if (dc_interface->agent_bulk_disable_until > now)
+			return 1;
+
+		dc_interface->agent_bulk_disable_until = 0;
+	}
+
+	return MAX_AGENT_ITEMS;
+}
+
 static int	dc_get_interface_by_type(DC_INTERFACE *interface, zbx_uint64_t hostid, unsigned char type)
 {
 	int				res = FAIL;
@@ -7789,9 +8003,9 @@ static void	dc_requeue_item_at(ZBX_DC_ITEM *dc_item, ZBX_DC_HOST *dc_host, int n
  *           always return the items they have taken using DCrequeue_items()  *
  *           or DCpoller_requeue_items().                                     *
  *                                                                            *
- *           Currently batch polling is supported only for JMX, SNMP and      *
- *           icmpping* simple checks. In other cases only single item is      *
- *           retrieved.                                                       *
+ *           Currently batch polling is supported only for JMX, SNMP, Zabbix  *
+ *           agent and icmpping* simple checks. In other cases only single    *
+ *           item is retrieved.                                               *
  *                                                                            *
  *           IPMI poller queue are handled by DCconfig_get_ipmi_poller_items()*
  *           function.                                                        *
@@ -7818,6 +8032,15 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 		case ZBX_POLLER_TYPE_PINGER:
 			max_items = MAX_PINGER_ITEMS;
 			break;
+		case ZBX_POLLER_TYPE_AGENT:
+			max_items = MAX_AGENT_POLLER_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_HTTPAGENT:
+			max_items = MAX_HTTPAGENT_POLLER_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_SNMP:
+			max_items = MAX_SNMP_POLLER_ITEMS;
+			break;
 		default:
 			max_items = 1;
 	}
@@ -7840,7 +8063,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 
 		if (0 != num)
 		{
-			if (SUCCEED == is_snmp_type(dc_item_prev->type))
+			if (SUCCEED == is_snmp_type(dc_item_prev->type) && ZBX_POLLER_TYPE_SNMP != poller_type)
 			{
 				if (0 != __config_snmp_item_compare(dc_item_prev, dc_item))
 					break;
@@ -7850,6 +8073,11 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				if (0 != __config_java_item_compare(dc_item_prev, dc_item))
 					break;
 			}
+			else if (ITEM_TYPE_ZABBIX == dc_item_prev->type && ZBX_POLLER_TYPE_AGENT != poller_type)
+			{
+				if (0 != __config_agent_item_compare(dc_item_prev, dc_item))
+					break;
+			}
 		}
 
 		zbx_binary_heap_remove_min(queue);
@@ -7886,6 +8114,7 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				/* postpone checks on hosts that have been checked recently and */
 				/* are still unreachable                                        */
 				if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_JAVA == poller_type ||
+						ZBX_POLLER_TYPE_AGENT == poller_type || ZBX_POLLER_TYPE_SNMP == poller_type ||
 						disable_until > now)
 				{
 					dc_requeue_item(dc_item, dc_host, dc_item->state,
@@ -7916,6 +8145,9 @@ int	DCconfig_get_poller_items(unsigned char poller_type, DC_ITEM *items)
 				max_items = DCconfig_get_suggested_snmp_vars_nolock(dc_item->interfaceid, NULL);
 			}
 		}
+
+		if (1 == num && ZBX_POLLER_TYPE_NORMAL == poller_type && ITEM_TYPE_ZABBIX == dc_item->type)
+			max_items = DCconfig_get_agent_bulk_items_nolock(dc_item->interfaceid, now);
 	}
 
 	UNLOCK_CACHE;
@@ -455,6 +455,7 @@ typedef struct
 	unsigned char	bulk;
 	unsigned char	max_snmp_succeed;
 	unsigned char	min_snmp_fail;
+	int		agent_bulk_disable_until;	/* agent bulk requests are not supported until */
 }
 ZBX_DC_INTERFACE;
 
@@ -799,7 +800,8 @@ typedef struct
 	zbx_hashset_t		data_sessions;
 	zbx_binary_heap_t	queues[ZBX_POLLER_TYPE_COUNT];
 	zbx_binary_heap_t	pqueue;
-	zbx_binary_heap_t	timer_queue;
+	zbx_binary_heap_t	*timer_queues;		/* time based triggers, partitioned by triggerid */
+	int			timer_queues_num;	/* between history syncer processes              */
 	ZBX_DC_CONFIG_TABLE	*config;
 	ZBX_DC_STATUS		*status;
 	zbx_hashset_t		strpool;
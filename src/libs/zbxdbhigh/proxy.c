@@ -3853,24 +3853,33 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 	zbx_timespec_t		unique_shift = {0, 0};
 	char			*error_step = NULL;
 	size_t			error_alloc = 0, error_offset = 0;
+	zbx_json_index_t	index;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
 	log_client_timediff(LOG_LEVEL_DEBUG, jp, ts);
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HOST_AVAILABILITY, &jp_data))
+	/* index proxy data, so the large data sections are not rescanned when looking up other sections */
+	if (SUCCEED != zbx_json_index_open(jp->start, &index))
+	{
+		*error = zbx_strdup(*error, zbx_json_strerror());
+		ret = FAIL;
+		goto out;
+	}
+
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, 0, ZBX_PROTO_TAG_HOST_AVAILABILITY, &jp_data))
 	{
 		if (SUCCEED != (ret = process_host_availability_contents(&jp_data, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, 0, ZBX_PROTO_TAG_HISTORY_DATA, &jp_data))
 	{
 		char			*token = NULL;
 		size_t			token_alloc = 0;
 		zbx_data_session_t	*session = NULL;
 
-		if (SUCCEED == zbx_json_value_by_name_dyn(jp, ZBX_PROTO_TAG_SESSION, &token, &token_alloc))
+		if (SUCCEED == zbx_json_index_value_by_name_dyn(&index, 0, ZBX_PROTO_TAG_SESSION, &token, &token_alloc))
 		{
 			size_t	token_len;
 
@@ -3879,7 +3888,7 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 				*error = zbx_dsprintf(*error, "invalid session token length %d", (int)token_len);
 				zbx_free(token);
 				ret = FAIL;
-				goto out;
+				goto clean;
 			}
 
 			session = zbx_dc_get_or_create_data_session(proxy->hostid, token);
@@ -3893,21 +3902,22 @@ int	process_proxy_data(const DC_PROXY *proxy, struct zbx_json_parse *jp, zbx_tim
 		}
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, 0, ZBX_PROTO_TAG_DISCOVERY_DATA, &jp_data))
 	{
 		if (SUCCEED != (ret = process_discovery_data_contents(&jp_data, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_AUTO_REGISTRATION, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, 0, ZBX_PROTO_TAG_AUTO_REGISTRATION, &jp_data))
 	{
 		if (SUCCEED != (ret = process_auto_registration_contents(&jp_data, proxy->hostid, &error_step)))
 			zbx_strcatnl_alloc(error, &error_alloc, &error_offset, error_step);
 	}
 
-	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_TASKS, &jp_data))
+	if (SUCCEED == zbx_json_index_brackets_by_name(&index, 0, ZBX_PROTO_TAG_TASKS, &jp_data))
 		process_tasks_contents(&jp_data);
-
+clean:
+	zbx_json_index_clear(&index);
 out:
 	zbx_free(error_step);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
@@ -370,6 +370,623 @@ static int	process_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int i
 	return ret;
 }
 
+/*
+ * Native ICMP engine
+ *
+ * Echo requests are sent from unprivileged datagram ICMP sockets (or raw sockets if the process has the required
+ * privileges) and replies of all hosts are received by a single select() loop. The payload of each echo request
+ * carries the request token, host index, packet index and send time, so replies are matched without keeping
+ * per-packet state. If ICMP sockets cannot be created the external fping binary is used instead.
+ */
+
+#define ZBX_ICMP_ECHO_REPLY		0
+#define ZBX_ICMP_ECHO_REQUEST		8
+#define ZBX_ICMPV6_ECHO_REQUEST		128
+#define ZBX_ICMPV6_ECHO_REPLY		129
+
+/* fping defaults, used when item key parameters are not specified */
+#define ZBX_ICMP_DEFAULT_INTERVAL	1000
+#define ZBX_ICMP_DEFAULT_SIZE		56
+#define ZBX_ICMP_DEFAULT_TIMEOUT	500
+
+#define ZBX_ICMP_IP_HEADER_MAX		60
+#define ZBX_ICMP_RCVBUF_SIZE		(1024 * ZBX_KIBIBYTE)
+
+/* number of echo requests sent before draining received replies */
+#define ZBX_ICMP_SEND_BATCH		64
+
+typedef struct
+{
+	unsigned char	type;
+	unsigned char	code;
+	unsigned short	checksum;
+	unsigned short	id;
+	unsigned short	seq;
+}
+zbx_icmp_header_t;
+
+/* echo request payload, padded with zeros up to the requested packet size */
+typedef struct
+{
+	zbx_uint32_t	token;
+	zbx_uint32_t	host;
+	zbx_uint32_t	packet;
+	double		sent;
+}
+zbx_icmp_payload_t;
+
+typedef struct
+{
+	int	fd;
+	int	family;
+	int	raw;	/* 1 - raw socket, replies must be filtered by ICMP identifier */
+}
+zbx_icmp_socket_t;
+
+typedef struct
+{
+	ZBX_SOCKADDR	addr;
+	ZBX_SOCKLEN_T	addrlen;
+	int		socket;	/* index of the socket used for the host or -1 if the address was not resolved */
+}
+zbx_icmp_target_t;
+
+typedef struct
+{
+	ZBX_FPING_HOST		*hosts;
+	zbx_icmp_target_t	*targets;
+	int			hosts_count;
+	int			count;
+	zbx_uint32_t		token;
+	unsigned short		id;
+	double			timeout;
+	unsigned char		*buffer;
+	size_t			buffer_size;
+	int			received;
+}
+zbx_icmp_ping_t;
+
+static unsigned char	icmp_fallback_logged = 0;
+
+static unsigned short	icmp_checksum(const unsigned char *data, size_t len)
+{
+	zbx_uint32_t	sum = 0;
+
+	for (; 1 < len; len -= 2, data += 2)
+		sum += (zbx_uint32_t)((data[0] << 8) | data[1]);
+
+	if (0 != len)
+		sum += (zbx_uint32_t)(data[0] << 8);
+
+	while (0 != (sum >> 16))
+		sum = (sum & 0xffff) + (sum >> 16);
+
+	return htons((unsigned short)~sum);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_resolve                                                     *
+ *                                                                            *
+ * Purpose: resolves host address for sending echo requests                   *
+ *                                                                            *
+ * Parameters: addr   - [IN] the host IP address or DNS name                  *
+ *             family - [IN] the required address family or PF_UNSPEC         *
+ *             target - [OUT] the resolved address                            *
+ *                                                                            *
+ * Return value: SUCCEED - the address was resolved                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_resolve(const char *addr, int family, zbx_icmp_target_t *target)
+{
+#ifdef HAVE_IPV6
+	struct addrinfo	hints, *ai = NULL;
+	int		ret = FAIL;
+
+	memset(&hints, 0, sizeof(hints));
+	hints.ai_family = family;
+	hints.ai_socktype = SOCK_DGRAM;
+
+	if (0 != getaddrinfo(addr, NULL, &hints, &ai))
+		goto out;
+
+	if ((PF_INET != ai->ai_family && PF_INET6 != ai->ai_family) || sizeof(target->addr) < ai->ai_addrlen)
+		goto out;
+
+	memcpy(&target->addr, ai->ai_addr, ai->ai_addrlen);
+	target->addrlen = (ZBX_SOCKLEN_T)ai->ai_addrlen;
+
+	ret = SUCCEED;
+out:
+	if (NULL != ai)
+		freeaddrinfo(ai);
+
+	return ret;
+#else
+	struct hostent	*hp;
+
+	ZBX_UNUSED(family);
+
+	if (NULL == (hp = gethostbyname(addr)))
+		return FAIL;
+
+	memset(&target->addr, 0, sizeof(target->addr));
+	target->addr.sin_family = AF_INET;
+	target->addr.sin_addr.s_addr = ((struct in_addr *)(hp->h_addr))->s_addr;
+	target->addrlen = sizeof(target->addr);
+
+	return SUCCEED;
+#endif
+}
+
+static int	icmp_addr_compare(const ZBX_SOCKADDR *addr1, const ZBX_SOCKADDR *addr2)
+{
+	const struct sockaddr	*sa1 = (const struct sockaddr *)addr1, *sa2 = (const struct sockaddr *)addr2;
+
+	if (sa1->sa_family != sa2->sa_family)
+		return FAIL;
+#ifdef HAVE_IPV6
+	if (AF_INET6 == sa1->sa_family)
+	{
+		return 0 == memcmp(&((const struct sockaddr_in6 *)sa1)->sin6_addr,
+				&((const struct sockaddr_in6 *)sa2)->sin6_addr, sizeof(struct in6_addr)) ? SUCCEED : FAIL;
+	}
+#endif
+	return ((const struct sockaddr_in *)sa1)->sin_addr.s_addr == ((const struct sockaddr_in *)sa2)->sin_addr.s_addr ?
+			SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_socket_open                                                 *
+ *                                                                            *
+ * Purpose: creates non-blocking ICMP socket                                  *
+ *                                                                            *
+ * Parameters: s             - [OUT] the ICMP socket                          *
+ *             family        - [IN] the address family                        *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED - the socket was created                             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Datagram ICMP sockets are tried first as they do not require     *
+ *           superuser privileges (see net.ipv4.ping_group_range on Linux).   *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_socket_open(zbx_icmp_socket_t *s, int family, char *error, int max_error_len)
+{
+	int	protocol, flags, rcvbuf = ZBX_ICMP_RCVBUF_SIZE;
+
+#ifdef HAVE_IPV6
+	protocol = (PF_INET6 == family ? IPPROTO_ICMPV6 : IPPROTO_ICMP);
+#else
+	protocol = IPPROTO_ICMP;
+#endif
+	s->family = family;
+	s->raw = 0;
+
+	if (-1 == (s->fd = socket(family, SOCK_DGRAM, protocol)))
+	{
+		s->raw = 1;
+
+		if (-1 == (s->fd = socket(family, SOCK_RAW, protocol)))
+		{
+			zbx_snprintf(error, max_error_len, "cannot create ICMP socket: %s", zbx_strerror(errno));
+			return FAIL;
+		}
+	}
+
+	if (-1 == (flags = fcntl(s->fd, F_GETFL, 0)) || -1 == fcntl(s->fd, F_SETFL, flags | O_NONBLOCK))
+	{
+		zbx_snprintf(error, max_error_len, "cannot set ICMP socket non-blocking mode: %s", zbx_strerror(errno));
+		goto fail;
+	}
+
+	/* replies of large batches arrive in bursts, ignore failure as the default buffer still works */
+	setsockopt(s->fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf, sizeof(rcvbuf));
+
+	if (NULL != CONFIG_SOURCE_IP)
+	{
+		zbx_icmp_target_t	source;
+
+		if (SUCCEED != icmp_resolve(CONFIG_SOURCE_IP, family, &source))
+		{
+			zbx_snprintf(error, max_error_len, "cannot resolve source address \"%s\"", CONFIG_SOURCE_IP);
+			goto fail;
+		}
+
+		if (-1 == bind(s->fd, (struct sockaddr *)&source.addr, source.addrlen))
+		{
+			zbx_snprintf(error, max_error_len, "cannot bind ICMP socket to \"%s\": %s", CONFIG_SOURCE_IP,
+					zbx_strerror(errno));
+			goto fail;
+		}
+	}
+
+	return SUCCEED;
+fail:
+	close(s->fd);
+	s->fd = -1;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_recv                                                        *
+ *                                                                            *
+ * Purpose: reads all pending replies from ICMP socket                        *
+ *                                                                            *
+ * Parameters: ping   - [IN/OUT] the ping batch                               *
+ *             s      - [IN] the ICMP socket                                  *
+ *             index  - [IN] the ICMP socket index                            *
+ *                                                                            *
+ * Comments: Replies from other addresses than the target address (broadcast  *
+ *           pings), duplicate and late replies are ignored - the same as     *
+ *           processing of individual fping responses does.                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_recv(zbx_icmp_ping_t *ping, const zbx_icmp_socket_t *s, int index)
+{
+	ZBX_SOCKADDR		from;
+	ZBX_SOCKLEN_T		fromlen;
+	ssize_t			n;
+	unsigned char		*ptr, reply_type;
+	zbx_icmp_header_t	header;
+	zbx_icmp_payload_t	payload;
+	ZBX_FPING_HOST		*host;
+	double			sec;
+
+#ifdef HAVE_IPV6
+	reply_type = (PF_INET6 == s->family ? ZBX_ICMPV6_ECHO_REPLY : ZBX_ICMP_ECHO_REPLY);
+#else
+	reply_type = ZBX_ICMP_ECHO_REPLY;
+#endif
+	while (1)
+	{
+		fromlen = sizeof(from);
+
+		if (-1 == (n = recvfrom(s->fd, ping->buffer, ping->buffer_size, 0, (struct sockaddr *)&from, &fromlen)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			break;
+		}
+
+		sec = zbx_time();
+		ptr = ping->buffer;
+
+		/* raw IPv4 sockets (and datagram sockets on some systems) return the IP header */
+		if (PF_INET == s->family && 0x40 == (ptr[0] & 0xf0))
+		{
+			if (n < (ptr[0] & 0x0f) * 4)
+				continue;
+
+			n -= (ptr[0] & 0x0f) * 4;
+			ptr += (ptr[0] & 0x0f) * 4;
+		}
+
+		if ((size_t)n < sizeof(header) + sizeof(payload))
+			continue;
+
+		memcpy(&header, ptr, sizeof(header));
+		memcpy(&payload, ptr + sizeof(header), sizeof(payload));
+
+		if (reply_type != header.type || (0 != s->raw && htons(ping->id) != header.id))
+			continue;
+
+		if (ping->token != payload.token || (zbx_uint32_t)ping->hosts_count <= payload.host ||
+				(zbx_uint32_t)ping->count <= payload.packet)
+		{
+			continue;
+		}
+
+		if (index != ping->targets[payload.host].socket ||
+				SUCCEED != icmp_addr_compare(&from, &ping->targets[payload.host].addr))
+		{
+			continue;
+		}
+
+		host = &ping->hosts[payload.host];
+
+		if (0 != host->status[payload.packet] || 0 > (sec -= payload.sent) || ping->timeout < sec)
+			continue;
+
+		host->status[payload.packet] = 1;
+
+		if (0 == host->rcv || host->min > sec)
+			host->min = sec;
+		if (0 == host->rcv || host->max < sec)
+			host->max = sec;
+		host->sum += sec;
+		host->rcv++;
+
+		ping->received++;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_send                                                        *
+ *                                                                            *
+ * Purpose: sends echo request to a host                                      *
+ *                                                                            *
+ * Parameters: ping   - [IN/OUT] the ping batch                               *
+ *             s      - [IN] the ICMP sockets                                 *
+ *             host   - [IN] the host index                                   *
+ *             packet - [IN] the packet index                                 *
+ *             data   - [IN/OUT] the echo request buffer                      *
+ *             size   - [IN] the echo request size                            *
+ *                                                                            *
+ * Comments: A request that cannot be sent is counted as lost, as fping does. *
+ *                                                                            *
+ ******************************************************************************/
+static void	icmp_send(zbx_icmp_ping_t *ping, const zbx_icmp_socket_t *s, int host, int packet, unsigned char *data,
+		size_t size)
+{
+	const zbx_icmp_target_t	*target = &ping->targets[host];
+	const zbx_icmp_socket_t	*sock = &s[target->socket];
+	zbx_icmp_header_t	header;
+	zbx_icmp_payload_t	payload;
+	int			retry = 1;
+
+	memset(&header, 0, sizeof(header));
+#ifdef HAVE_IPV6
+	header.type = (PF_INET6 == sock->family ? ZBX_ICMPV6_ECHO_REQUEST : ZBX_ICMP_ECHO_REQUEST);
+#else
+	header.type = ZBX_ICMP_ECHO_REQUEST;
+#endif
+	header.id = htons(ping->id);
+	header.seq = htons((unsigned short)packet);
+
+	memset(&payload, 0, sizeof(payload));
+	payload.token = ping->token;
+	payload.host = (zbx_uint32_t)host;
+	payload.packet = (zbx_uint32_t)packet;
+	payload.sent = zbx_time();
+
+	memcpy(data, &header, sizeof(header));
+	memcpy(data + sizeof(header), &payload, sizeof(payload));
+
+	/* the checksum of ICMPv6 and datagram ICMP sockets is calculated by kernel */
+	if (PF_INET == sock->family)
+	{
+		header.checksum = icmp_checksum(data, size);
+		memcpy(data, &header, sizeof(header));
+	}
+
+	while (-1 == sendto(sock->fd, data, size, 0, (const struct sockaddr *)&target->addr, target->addrlen))
+	{
+		fd_set		fdset;
+		struct timeval	tv;
+
+		if (EINTR == errno)
+			continue;
+
+		if ((EAGAIN != errno && ENOBUFS != errno) || 0 == retry--)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot send ICMP echo request to \"%s\": %s",
+					ping->hosts[host].addr, zbx_strerror(errno));
+			break;
+		}
+
+		/* the send buffer is full, wait until it is drained */
+		FD_ZERO(&fdset);
+		FD_SET(sock->fd, &fdset);
+		tv.tv_sec = 0;
+		tv.tv_usec = 10000;
+
+		select(sock->fd + 1, NULL, &fdset, NULL, &tv);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: icmp_ping                                                        *
+ *                                                                            *
+ * Purpose: pings hosts using ICMP sockets                                    *
+ *                                                                            *
+ * Parameters: hosts         - [IN/OUT] the hosts to ping                     *
+ *             hosts_count   - [IN] the number of hosts                       *
+ *             count         - [IN] the number of packets sent to each host   *
+ *             interval      - [IN] milliseconds between packets to one host  *
+ *             size          - [IN] the packet payload size in bytes          *
+ *             timeout       - [IN] milliseconds to wait for reply            *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED - the hosts were pinged                              *
+ *               FAIL    - ICMP sockets are not available, fping must be used *
+ *                                                                            *
+ * Comments: Zero interval, size and timeout mean fping defaults. Hosts with  *
+ *           addresses that cannot be resolved are left with zero sent        *
+ *           packets, the same as with fping.                                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	icmp_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout,
+		char *error, int max_error_len)
+{
+	const char		*__function_name = "icmp_ping";
+
+	static zbx_uint32_t	token;
+	zbx_icmp_ping_t		ping;
+	zbx_icmp_socket_t	sockets[2];
+	int			i, ret = FAIL, family = PF_UNSPEC, sockets_num = 0, packet = 0, expected = 0, fd_max;
+	unsigned char		*data = NULL;
+	size_t			data_size;
+	double			now, start, last_sent = 0, sec;
+	fd_set			fdset;
+	struct timeval		tv;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __function_name, hosts_count);
+
+	memset(&ping, 0, sizeof(ping));
+
+	if (0 == interval)
+		interval = ZBX_ICMP_DEFAULT_INTERVAL;
+
+	if (0 == size)
+		size = ZBX_ICMP_DEFAULT_SIZE;
+
+	if (0 == timeout)
+		timeout = ZBX_ICMP_DEFAULT_TIMEOUT;
+
+	if (sizeof(zbx_icmp_payload_t) > (size_t)size)
+		size = sizeof(zbx_icmp_payload_t);
+#ifdef HAVE_IPV6
+	if (NULL != CONFIG_SOURCE_IP && SUCCEED != get_address_family(CONFIG_SOURCE_IP, &family, error, max_error_len))
+		goto out;
+#else
+	family = PF_INET;
+#endif
+	ping.hosts = hosts;
+	ping.hosts_count = hosts_count;
+	ping.count = count;
+	ping.token = ((zbx_uint32_t)getpid() << 16) ^ ++token;
+	ping.id = (unsigned short)getpid();
+	ping.timeout = timeout / 1000.0;
+	ping.targets = (zbx_icmp_target_t *)zbx_malloc(NULL, sizeof(zbx_icmp_target_t) * hosts_count);
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		zbx_icmp_target_t	*target = &ping.targets[i];
+		int			j;
+
+		target->socket = -1;
+
+		if (SUCCEED != icmp_resolve(hosts[i].addr, family, target))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot resolve address \"%s\"", __function_name, hosts[i].addr);
+			continue;
+		}
+
+		for (j = 0; j < sockets_num; j++)
+		{
+			if (sockets[j].family == ((struct sockaddr *)&target->addr)->sa_family)
+				break;
+		}
+
+		if (j == sockets_num)
+		{
+			if (SUCCEED != icmp_socket_open(&sockets[j], ((struct sockaddr *)&target->addr)->sa_family,
+					error, max_error_len))
+			{
+				goto out;
+			}
+
+			sockets_num++;
+		}
+
+		target->socket = j;
+		expected += count;
+	}
+
+	ret = SUCCEED;
+
+	data_size = sizeof(zbx_icmp_header_t) + size;
+	data = (unsigned char *)zbx_malloc(NULL, data_size);
+	memset(data, 0, data_size);
+
+	ping.buffer_size = ZBX_ICMP_IP_HEADER_MAX + data_size;
+	ping.buffer = (unsigned char *)zbx_malloc(NULL, ping.buffer_size);
+
+	for (i = 0; i < hosts_count; i++)
+	{
+		if (-1 == ping.targets[i].socket)
+			continue;
+
+		hosts[i].status = (char *)zbx_malloc(NULL, count);
+		memset(hosts[i].status, 0, count);
+		hosts[i].cnt += count;
+	}
+
+	start = zbx_time();
+
+	while (0 != expected)
+	{
+		now = zbx_time();
+
+		if (packet < count)
+		{
+			if (now >= (sec = start + packet * (interval / 1000.0)))
+			{
+				for (i = 0; i < hosts_count; i++)
+				{
+					if (-1 == ping.targets[i].socket)
+						continue;
+
+					icmp_send(&ping, sockets, i, packet, data, data_size);
+
+					if (0 == (i + 1) % ZBX_ICMP_SEND_BATCH)
+					{
+						int	j;
+
+						for (j = 0; j < sockets_num; j++)
+							icmp_recv(&ping, &sockets[j], j);
+					}
+				}
+
+				packet++;
+				last_sent = zbx_time();
+				continue;
+			}
+		}
+		else if (ping.received == expected || now >= (sec = last_sent + ping.timeout))
+			break;
+
+		FD_ZERO(&fdset);
+
+		for (i = 0, fd_max = 0; i < sockets_num; i++)
+		{
+			FD_SET(sockets[i].fd, &fdset);
+			fd_max = MAX(fd_max, sockets[i].fd);
+		}
+
+		sec -= now;
+		tv.tv_sec = (time_t)sec;
+		tv.tv_usec = (long)((sec - tv.tv_sec) * 1000000);
+
+		if (-1 == select(fd_max + 1, &fdset, NULL, NULL, &tv))
+		{
+			if (EINTR == errno)
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for ICMP replies: %s", zbx_strerror(errno));
+			break;
+		}
+
+		for (i = 0; i < sockets_num; i++)
+		{
+			if (FD_ISSET(sockets[i].fd, &fdset))
+				icmp_recv(&ping, &sockets[i], i);
+		}
+	}
+
+	for (i = 0; i < hosts_count; i++)
+		zbx_free(hosts[i].status);
+out:
+	for (i = 0; i < sockets_num; i++)
+		close(sockets[i].fd);
+
+	zbx_free(ping.buffer);
+	zbx_free(data);
+	zbx_free(ping.targets);
+
+	if (FAIL == ret && 0 == icmp_fallback_logged)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "%s, using \"%s\" for ICMP pings", error, CONFIG_FPING_LOCATION);
+		icmp_fallback_logged = 1;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s received:%d", __function_name, zbx_result_string(ret),
+			ping.received);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: do_ping                                                          *
@@ -383,7 +1000,8 @@ static int	process_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int i
  *                                                                            *
  * Author: Alexei Vladishev                                                   *
  *                                                                            *
- * Comments: use external binary 'fping' to avoid superuser privileges        *
+ * Comments: ICMP sockets are used if they can be created, otherwise          *
+ *           external binary 'fping' is used to avoid superuser privileges    *
  *                                                                            *
  ******************************************************************************/
 int	do_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int size, int timeout, char *error, int max_error_len)
@@ -394,7 +1012,10 @@ int	do_ping(ZBX_FPING_HOST *hosts, int hosts_count, int count, int interval, int
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hosts_count:%d", __function_name, hosts_count);
 
-	if (NOTSUPPORTED == (res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+	if (FAIL == (res = icmp_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len)))
+		res = process_ping(hosts, hosts_count, count, interval, size, timeout, error, max_error_len);
+
+	if (NOTSUPPORTED == res)
 		zabbix_log(LOG_LEVEL_ERR, "%s", error);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(res));
@@ -0,0 +1,555 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+
+#ifdef HAVE_IPCSERVICE
+
+#include "log.h"
+#include "mutexs.h"
+#include "zbxipcservice.h"
+
+#if defined(__linux__)
+#	include <linux/futex.h>
+#	include <sys/syscall.h>
+#	define ZBX_IPC_RING_FUTEX
+#endif
+
+/*
+ * Shared memory ring buffer used to pass messages from multiple producers to
+ * a single consumer without socket round trips.
+ *
+ * The ring is allocated before worker processes are forked, so all processes
+ * share the same memory segment, mutex and wakeup descriptor. Messages are
+ * stored as records aligned to ZBX_IPC_RING_ALIGN bytes. A message is split
+ * into several records (fragments) if it does not fit in the contiguous free
+ * space. While a fragmented message is being written other producers wait, so
+ * fragments of the same message are always adjacent. If the writer of a
+ * fragmented message terminates, the waiting producers take over the ring and
+ * the consumer discards the incomplete message when the next message starts.
+ *
+ * Waiting producers sleep until the consumer releases space or the writer of
+ * a fragmented message completes it. On Linux a futex on the shared wakeup
+ * counter is used - unlike a process-shared condition variable it cannot be
+ * left in a blocking state by a killed process. Elsewhere the ring state is
+ * polled.
+ *
+ * The consumer reads complete messages directly from the ring memory, only
+ * fragmented messages are assembled in a local buffer.
+ */
+
+#define ZBX_IPC_RING_ALIGN		16
+#define ZBX_IPC_RING_WAIT_USEC		1000
+#define ZBX_IPC_RING_WAIT_SEC		1
+
+#define ZBX_IPC_RING_RECORD_FIRST	0x01
+#define ZBX_IPC_RING_RECORD_LAST	0x02
+
+#define ZBX_IPC_RING_ALIGN_SIZE(size)	(((size) + ZBX_IPC_RING_ALIGN - 1) & ~(zbx_uint32_t)(ZBX_IPC_RING_ALIGN - 1))
+
+/* ring buffer record header */
+typedef struct
+{
+	zbx_uint32_t	code;		/* the message code */
+	zbx_uint32_t	size;		/* the record data size */
+	zbx_uint32_t	total;		/* the total message size */
+	zbx_uint32_t	flags;		/* ZBX_IPC_RING_RECORD_* flags */
+}
+zbx_ipc_ring_record_t;
+
+#define ZBX_IPC_RING_RECORD_SIZE	((zbx_uint32_t)sizeof(zbx_ipc_ring_record_t))
+
+/* ring buffer data in shared memory */
+struct zbx_ipc_ring_shared
+{
+	zbx_uint64_t	head;		/* the total number of bytes written */
+	zbx_uint64_t	tail;		/* the total number of bytes released by consumer */
+	zbx_uint32_t	size;		/* the data buffer size */
+	pid_t		writer;		/* the process writing fragmented message or 0 */
+	zbx_uint32_t	wait_seq;	/* incremented when waiting producers are woken up */
+	zbx_uint32_t	waiters;	/* the number of producers waiting since the last wakeup */
+	unsigned char	wakeup;		/* 1 - consumer has been notified about new data */
+	unsigned char	*data;		/* the data buffer */
+};
+
+static zbx_mutex_t	ring_lock = ZBX_MUTEX_NULL;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_wait                                                    *
+ *                                                                            *
+ * Purpose: waits for the ring buffer state to change                         *
+ *                                                                            *
+ * Parameters: shared - [IN] the ring buffer data in shared memory            *
+ *                                                                            *
+ * Comments: Must be called with the ring lock held, the lock is released     *
+ *           before waiting. The wait is limited, so the caller can recheck   *
+ *           if the writer of fragmented message is still alive.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_ring_wait(zbx_ipc_ring_shared_t *shared)
+{
+#ifdef ZBX_IPC_RING_FUTEX
+	struct timespec	ts = {ZBX_IPC_RING_WAIT_SEC, 0};
+	zbx_uint32_t	seq;
+
+	seq = shared->wait_seq;
+	shared->waiters++;
+	zbx_mutex_unlock(ring_lock);
+
+	/* returns immediately if the sequence was changed after unlocking */
+	syscall(SYS_futex, &shared->wait_seq, FUTEX_WAIT, seq, &ts, NULL, 0);
+#else
+	struct timespec	ts = {0, ZBX_IPC_RING_WAIT_USEC * 1000};
+
+	ZBX_UNUSED(shared);
+	zbx_mutex_unlock(ring_lock);
+
+	nanosleep(&ts, NULL);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_wakeup                                                  *
+ *                                                                            *
+ * Purpose: wakes up producers waiting for the ring buffer state to change    *
+ *                                                                            *
+ * Parameters: shared - [IN] the ring buffer data in shared memory            *
+ *                                                                            *
+ * Comments: Must be called with the ring lock held.                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_ring_wakeup(zbx_ipc_ring_shared_t *shared)
+{
+#ifdef ZBX_IPC_RING_FUTEX
+	if (0 == shared->waiters)
+		return;
+
+	shared->waiters = 0;
+	shared->wait_seq++;
+
+	syscall(SYS_futex, &shared->wait_seq, FUTEX_WAKE, INT_MAX, NULL, NULL, 0);
+#else
+	ZBX_UNUSED(shared);
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_writer_alive                                            *
+ *                                                                            *
+ * Purpose: checks if the process writing fragmented message is still alive   *
+ *                                                                            *
+ * Parameters: shared - [IN] the ring buffer data in shared memory            *
+ *                                                                            *
+ * Return value: SUCCEED - the writer process is alive                        *
+ *               FAIL    - the writer process has terminated and was reset    *
+ *                                                                            *
+ * Comments: Must be called with the ring lock held.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_ring_writer_alive(zbx_ipc_ring_shared_t *shared)
+{
+	if (0 == kill(shared->writer, 0) || ESRCH != errno)
+		return SUCCEED;
+
+	zabbix_log(LOG_LEVEL_WARNING, "process with PID %d terminated while writing message to ring buffer,"
+			" the incomplete message will be discarded", (int)shared->writer);
+
+	shared->writer = 0;
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_notify                                                  *
+ *                                                                            *
+ * Purpose: wakes up the ring consumer                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_ring_notify(zbx_ipc_ring_t *ring)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	eventfd_t	value = 1;
+
+	if (-1 == write(ring->fd_write, &value, sizeof(value)) && EAGAIN != errno)
+#else
+	unsigned char	value = 1;
+
+	if (-1 == write(ring->fd_write, &value, sizeof(value)) && EAGAIN != errno)
+#endif
+		zabbix_log(LOG_LEVEL_WARNING, "cannot notify ring buffer consumer: %s", zbx_strerror(errno));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_ring_reset_notify                                            *
+ *                                                                            *
+ * Purpose: resets pending consumer notifications                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_ring_reset_notify(zbx_ipc_ring_t *ring)
+{
+#ifdef HAVE_SYS_EVENTFD_H
+	eventfd_t	value;
+
+	(void)read(ring->fd_read, &value, sizeof(value));
+#else
+	unsigned char	buffer[256];
+
+	while (0 < read(ring->fd_read, buffer, sizeof(buffer)))
+		;
+#endif
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_create                                              *
+ *                                                                            *
+ * Purpose: creates shared memory ring buffer                                 *
+ *                                                                            *
+ * Parameters: ring  - [OUT] the ring buffer                                  *
+ *             size  - [IN] the ring buffer size                              *
+ *             error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the ring buffer was created successfully           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The ring buffer must be created before forking the processes     *
+ *           using it.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_ring_create(zbx_ipc_ring_t *ring, zbx_uint32_t size, char **error)
+{
+	const char	*__function_name = "zbx_ipc_ring_create";
+	int		shm_id, ret = FAIL;
+	void		*base;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() size:%u", __function_name, size);
+
+	memset(ring, 0, sizeof(zbx_ipc_ring_t));
+	ring->fd_read = -1;
+	ring->fd_write = -1;
+
+	size = ZBX_IPC_RING_ALIGN_SIZE(size);
+
+	if (ZBX_MUTEX_NULL == ring_lock && SUCCEED != zbx_mutex_create(&ring_lock, ZBX_MUTEX_IPC_RING, error))
+		goto out;
+
+	if (-1 == (shm_id = shmget(IPC_PRIVATE, sizeof(zbx_ipc_ring_shared_t) + ZBX_IPC_RING_ALIGN + size, 0600)))
+	{
+		*error = zbx_dsprintf(*error, "cannot get private shared memory of size %u for ring buffer: %s",
+				size, zbx_strerror(errno));
+		goto out;
+	}
+
+	if ((void *)(-1) == (base = shmat(shm_id, NULL, 0)))
+	{
+		*error = zbx_dsprintf(*error, "cannot attach shared memory for ring buffer: %s", zbx_strerror(errno));
+		goto out;
+	}
+
+	if (-1 == shmctl(shm_id, IPC_RMID, NULL))
+		zbx_error("cannot mark shared memory %d for destruction: %s", shm_id, zbx_strerror(errno));
+
+#ifdef HAVE_SYS_EVENTFD_H
+	if (-1 == (ring->fd_read = eventfd(0, EFD_NONBLOCK)))
+	{
+		*error = zbx_dsprintf(*error, "cannot create ring buffer event descriptor: %s", zbx_strerror(errno));
+		shmdt(base);
+		goto out;
+	}
+
+	ring->fd_write = ring->fd_read;
+#else
+	{
+		int	fds[2];
+
+		if (-1 == pipe(fds))
+		{
+			*error = zbx_dsprintf(*error, "cannot create ring buffer notification pipe: %s",
+					zbx_strerror(errno));
+			shmdt(base);
+			goto out;
+		}
+
+		ring->fd_read = fds[0];
+		ring->fd_write = fds[1];
+		fcntl(ring->fd_read, F_SETFL, fcntl(ring->fd_read, F_GETFL) | O_NONBLOCK);
+		fcntl(ring->fd_write, F_SETFL, fcntl(ring->fd_write, F_GETFL) | O_NONBLOCK);
+	}
+#endif
+	ring->shared = (zbx_ipc_ring_shared_t *)base;
+	memset(ring->shared, 0, sizeof(zbx_ipc_ring_shared_t));
+	ring->shared->size = size;
+	ring->shared->data = (unsigned char *)base + ZBX_IPC_RING_ALIGN_SIZE(sizeof(zbx_ipc_ring_shared_t));
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_destroy                                             *
+ *                                                                            *
+ * Purpose: detaches ring buffer and frees local resources                    *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_ring_destroy(zbx_ipc_ring_t *ring)
+{
+	if (NULL == ring->shared)
+		return;
+
+	if (ring->fd_write != ring->fd_read)
+		close(ring->fd_write);
+
+	close(ring->fd_read);
+	shmdt(ring->shared);
+	zbx_free(ring->rx_data);
+
+	ring->shared = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_get_fd                                              *
+ *                                                                            *
+ * Purpose: returns descriptor that becomes readable when new messages are    *
+ *          written to the ring buffer                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_ring_get_fd(const zbx_ipc_ring_t *ring)
+{
+	return ring->fd_read;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_write                                               *
+ *                                                                            *
+ * Purpose: writes message to the ring buffer                                 *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *             code - [IN] the message code                                   *
+ *             data - [IN] the message data                                   *
+ *             size - [IN] the message data size                              *
+ *                                                                            *
+ * Comments: If there is not enough free space in the ring buffer, the        *
+ *           message is written in fragments, waiting for the consumer to     *
+ *           release the space. Other producers wait until the last fragment  *
+ *           is written or the writing process terminates.                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_ring_write(zbx_ipc_ring_t *ring, zbx_uint32_t code, const unsigned char *data, zbx_uint32_t size)
+{
+	zbx_ipc_ring_shared_t	*shared = ring->shared;
+	zbx_ipc_ring_record_t	*record;
+	zbx_uint32_t		offset = 0, pos, avail, chunk, flags = ZBX_IPC_RING_RECORD_FIRST;
+	pid_t			pid;
+	int			notify;
+
+	pid = getpid();
+
+	for (;;)
+	{
+		zbx_mutex_lock(ring_lock);
+
+		/* wait while other process is writing fragmented message */
+		if (0 != shared->writer && pid != shared->writer && SUCCEED == ipc_ring_writer_alive(shared))
+		{
+			ipc_ring_wait(shared);
+			continue;
+		}
+
+		pos = (zbx_uint32_t)(shared->head % shared->size);
+		avail = shared->size - (zbx_uint32_t)(shared->head - shared->tail);
+
+		/* records do not wrap around the end of data buffer */
+		if (avail > shared->size - pos)
+			avail = shared->size - pos;
+
+		if (ZBX_IPC_RING_RECORD_SIZE > avail)
+		{
+			/* the ring buffer is full, wait for consumer to release space */
+			if (0 == shared->wakeup)
+			{
+				shared->wakeup = 1;
+				ipc_ring_notify(ring);
+			}
+
+			ipc_ring_wait(shared);
+			continue;
+		}
+
+		chunk = MIN(size - offset, avail - ZBX_IPC_RING_RECORD_SIZE);
+
+		if (offset + chunk == size)
+			flags |= ZBX_IPC_RING_RECORD_LAST;
+
+		record = (zbx_ipc_ring_record_t *)(shared->data + pos);
+		record->code = code;
+		record->size = chunk;
+		record->total = size;
+		record->flags = flags;
+
+		if (0 != chunk)
+			memcpy((unsigned char *)record + ZBX_IPC_RING_RECORD_SIZE, data + offset, chunk);
+
+		shared->head += ZBX_IPC_RING_ALIGN_SIZE(ZBX_IPC_RING_RECORD_SIZE + chunk);
+
+		if (0 == (flags & ZBX_IPC_RING_RECORD_LAST))
+		{
+			shared->writer = pid;
+		}
+		else if (0 != shared->writer)
+		{
+			/* fragmented message is complete, wake up producers waiting for it */
+			shared->writer = 0;
+			ipc_ring_wakeup(shared);
+		}
+
+		notify = (0 == shared->wakeup);
+		shared->wakeup = 1;
+
+		zbx_mutex_unlock(ring_lock);
+
+		if (0 != notify)
+			ipc_ring_notify(ring);
+
+		if (0 != (flags & ZBX_IPC_RING_RECORD_LAST))
+			break;
+
+		offset += chunk;
+		flags = 0;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_read                                                *
+ *                                                                            *
+ * Purpose: reads the next message from ring buffer                           *
+ *                                                                            *
+ * Parameters: ring    - [IN] the ring buffer                                 *
+ *             message - [OUT] the message                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the message was read                               *
+ *               FAIL    - there are no complete messages in ring buffer      *
+ *                                                                            *
+ * Comments: The message data references ring buffer memory and must not be   *
+ *           freed. It stays valid until zbx_ipc_ring_release() is called.    *
+ *           This function must be called only by the ring consumer.          *
+ *           Fragments of an incomplete message left by a terminated writer   *
+ *           are discarded when the first fragment of the next message is     *
+ *           read.                                                            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_ring_read(zbx_ipc_ring_t *ring, zbx_ipc_message_t *message)
+{
+	zbx_ipc_ring_shared_t	*shared = ring->shared;
+	zbx_ipc_ring_record_t	*record;
+	unsigned char		*data;
+
+	for (;;)
+	{
+		if (ring->cursor == ring->head)
+		{
+			/* reset notification before taking new head to avoid losing wakeups */
+			ipc_ring_reset_notify(ring);
+
+			zbx_mutex_lock(ring_lock);
+			shared->wakeup = 0;
+			ring->head = shared->head;
+			zbx_mutex_unlock(ring_lock);
+
+			if (ring->cursor == ring->head)
+				return FAIL;
+		}
+
+		record = (zbx_ipc_ring_record_t *)(shared->data + ring->cursor % shared->size);
+		data = (unsigned char *)record + ZBX_IPC_RING_RECORD_SIZE;
+		ring->cursor += ZBX_IPC_RING_ALIGN_SIZE(ZBX_IPC_RING_RECORD_SIZE + record->size);
+
+		if ((ZBX_IPC_RING_RECORD_FIRST | ZBX_IPC_RING_RECORD_LAST) == record->flags)
+		{
+			/* complete message, pass it by reference */
+			message->code = record->code;
+			message->size = record->size;
+			message->data = data;
+			ring->rx_messages++;
+			ring->rx_bytes += record->size;
+			return SUCCEED;
+		}
+
+		if (0 != (record->flags & ZBX_IPC_RING_RECORD_FIRST))
+		{
+			if (ring->rx_alloc < record->total)
+			{
+				ring->rx_alloc = record->total;
+				ring->rx_data = (unsigned char *)zbx_realloc(ring->rx_data, ring->rx_alloc);
+			}
+
+			ring->rx_size = 0;
+		}
+
+		memcpy(ring->rx_data + ring->rx_size, data, record->size);
+		ring->rx_size += record->size;
+
+		if (0 != (record->flags & ZBX_IPC_RING_RECORD_LAST))
+		{
+			message->code = record->code;
+			message->size = ring->rx_size;
+			message->data = ring->rx_data;
+			ring->rx_messages++;
+			ring->rx_bytes += ring->rx_size;
+			return SUCCEED;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_ring_release                                             *
+ *                                                                            *
+ * Purpose: releases ring buffer space used by the messages read so far       *
+ *                                                                            *
+ * Parameters: ring - [IN] the ring buffer                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_ring_release(zbx_ipc_ring_t *ring)
+{
+	zbx_mutex_lock(ring_lock);
+
+	if (ring->shared->tail != ring->cursor)
+	{
+		ring->shared->tail = ring->cursor;
+		ipc_ring_wakeup(ring->shared);
+	}
+
+	zbx_mutex_unlock(ring_lock);
+}
+
+#endif
@@ -21,8 +21,30 @@ static size_t	ipc_path_root_len = 0;
 #define ZBX_IPC_CLIENT_STATE_NONE	0
 #define ZBX_IPC_CLIENT_STATE_QUEUED	1
 
+/* the reserved message code of statistics request, answered by IPC service itself */
+#define ZBX_IPC_SERVICE_STATS		0xffffffff
+
 extern unsigned char	program_type;
 
+/* set by runtime control signal to log statistics of the service owned by process */
+static volatile sig_atomic_t	ipc_stats_requested = 0;
+
+/* message in client receive queue */
+typedef struct
+{
+	/* the message must be the first member, so it can be freed with zbx_ipc_message_free() */
+	zbx_ipc_message_t	message;
+
+	/* the time message was added to the receive queue */
+	double			time_queued;
+}
+zbx_ipc_queued_message_t;
+
+/* the upper bounds of message queue latency histogram buckets, the last bucket is not bounded */
+static const double	ipc_latency_bounds[ZBX_IPC_LATENCY_BUCKETS - 1] = {0.0001, 0.001, 0.01, 0.1, 1, 10};
+static const char	*ipc_latency_names[ZBX_IPC_LATENCY_BUCKETS] = {
+		"100us", "1ms", "10ms", "100ms", "1s", "10s", "inf"};
+
 struct zbx_ipc_client
 {
 	zbx_ipc_socket_t	csocket;
@@ -55,6 +77,15 @@ struct zbx_ipc_client
 #define ZBX_IPC_MESSAGE_CODE	0
 #define ZBX_IPC_MESSAGE_SIZE	1
 
+/* the maximum number of queued messages coalesced into a single write */
+#define ZBX_IPC_WRITEV_MAX	64
+
+/* the number of buffers needed to write the current and coalesced queued messages */
+#define ZBX_IPC_WRITEV_IOV_NUM	((ZBX_IPC_WRITEV_MAX + 1) * 2)
+
+/* the minimum number of buffers accepted by writev() on all POSIX systems (_XOPEN_IOV_MAX) */
+#define ZBX_IPC_IOV_MAX_MIN	16
+
 #if !defined(LIBEVENT_VERSION_NUMBER) || LIBEVENT_VERSION_NUMBER < 0x2000000
 typedef int evutil_socket_t;
 
@@ -204,6 +235,95 @@ static int	ipc_write_data(int fd, const unsigned char *data, zbx_uint32_t size,
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_get_iov_max                                                  *
+ *                                                                            *
+ * Purpose: gets the maximum number of buffers that can be passed to a single *
+ *          writev() call                                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_get_iov_max(void)
+{
+	static int	iov_max = 0;
+
+	if (0 == iov_max)
+	{
+		long	limit = -1;
+
+#ifdef _SC_IOV_MAX
+		limit = sysconf(_SC_IOV_MAX);
+#endif
+		if (ZBX_IPC_IOV_MAX_MIN > limit)
+			limit = ZBX_IPC_IOV_MAX_MIN;
+		else if (ZBX_IPC_WRITEV_IOV_NUM < limit)
+			limit = ZBX_IPC_WRITEV_IOV_NUM;
+
+		iov_max = (int)limit;
+	}
+
+	return iov_max;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_writev_data                                                  *
+ *                                                                            *
+ * Purpose: writes data from multiple buffers to a socket                     *
+ *                                                                            *
+ * Parameters: fd        - [IN] the socket file descriptor                    *
+ *             iov       - [IN/OUT] the data buffers, updated to point at the *
+ *                                  unsent data                               *
+ *             iov_num   - [IN] the number of data buffers                    *
+ *             size_sent - [OUT] the actual size written to socket            *
+ *                                                                            *
+ * Return value: SUCCEED - no socket errors were detected. Either the data or *
+ *                         a part of it was written to socket or a write to   *
+ *                         non-blocking socket would block                    *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The buffers are written with several system calls if their       *
+ *           number exceeds the writev() limit of the system.                 *
+ *                                                                            *
+ ******************************************************************************/
+static int	ipc_writev_data(int fd, struct iovec *iov, int iov_num, zbx_uint64_t *size_sent)
+{
+	ssize_t	n;
+	int	ret = SUCCEED;
+
+	*size_sent = 0;
+
+	while (0 < iov_num)
+	{
+		if (-1 == (n = writev(fd, iov, MIN(iov_num, ipc_get_iov_max()))))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EWOULDBLOCK == errno || EAGAIN == errno)
+				break;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot write to IPC socket: %s", strerror(errno));
+			ret = FAIL;
+			break;
+		}
+
+		*size_sent += n;
+
+		/* skip the buffers that were sent completely */
+		for (; 0 < iov_num && (size_t)n >= iov->iov_len; iov++, iov_num--)
+			n -= iov->iov_len;
+
+		if (0 < n)
+		{
+			iov->iov_base = (char *)iov->iov_base + n;
+			iov->iov_len -= n;
+		}
+	}
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_read_data                                                    *
@@ -249,11 +369,11 @@ static int	ipc_read_data(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_u
 
 /******************************************************************************
  *                                                                            *
- * Function: ipc_read_data_full                                               *
+ * Function: ipc_socket_read_data_full                                        *
  *                                                                            *
  * Purpose: reads data from a socket until the requested data has been read   *
  *                                                                            *
- * Parameters: fd        - [IN] the socket file descriptor                    *
+ * Parameters: csocket   - [IN] the IPC socket                                *
  *             buffer    - [IN] the data                                      *
  *             size      - [IN] the data size                                 *
  *             read_size - [IN] the actual size read from socket              *
@@ -264,31 +384,50 @@ static int	ipc_read_data(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_u
  * Comments: When reading data from non-blocking sockets this function will   *
  *           return SUCCEED if there are no data to read, even if not all of  *
  *           the requested data has been read.                                *
+ *           The data following the requested data (the next messages) is     *
+ *           read into socket buffer with the same system call. The socket    *
+ *           buffer must be empty when calling this function.                 *
  *                                                                            *
  ******************************************************************************/
-static int	ipc_read_data_full(int fd, unsigned char *buffer, zbx_uint32_t size, zbx_uint32_t *read_size)
+static int	ipc_socket_read_data_full(zbx_ipc_socket_t *csocket, unsigned char *buffer, zbx_uint32_t size,
+		zbx_uint32_t *read_size)
 {
-	int		ret = FAIL;
-	zbx_uint32_t	offset = 0, chunk_size;
+	struct iovec	iov[2];
+	ssize_t		n;
 
 	*read_size = 0;
 
-	while (offset < size)
+	while (*read_size < size)
 	{
-		if (FAIL == ipc_read_data(fd, buffer + offset, size - offset, &chunk_size))
-			goto out;
+		iov[0].iov_base = buffer + *read_size;
+		iov[0].iov_len = size - *read_size;
+		iov[1].iov_base = csocket->rx_buffer;
+		iov[1].iov_len = ZBX_IPC_SOCKET_BUFFER_SIZE;
 
-		if (0 == chunk_size)
-			break;
+		if (-1 == (n = readv(csocket->fd, iov, 2)))
+		{
+			if (EINTR == errno)
+				continue;
 
-		offset += chunk_size;
-	}
+			if (EWOULDBLOCK == errno || EAGAIN == errno)
+				break;
 
-	ret = SUCCEED;
-out:
-	*read_size = offset;
+			return FAIL;
+		}
 
-	return ret;
+		if (0 == n)
+			return FAIL;
+
+		if ((size_t)n > iov[0].iov_len)
+		{
+			csocket->rx_buffer_bytes = n - iov[0].iov_len;
+			n = iov[0].iov_len;
+		}
+
+		*read_size += n;
+	}
+
+	return SUCCEED;
 }
 
 /******************************************************************************
@@ -317,7 +456,9 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
 		zbx_uint32_t size, zbx_uint32_t *tx_size)
 {
 	int		ret;
-	zbx_uint32_t	size_data, buffer[ZBX_IPC_SOCKET_BUFFER_SIZE / sizeof(zbx_uint32_t)];
+	zbx_uint32_t	buffer[ZBX_IPC_SOCKET_BUFFER_SIZE / sizeof(zbx_uint32_t)];
+	zbx_uint64_t	size_sent;
+	struct iovec	iov[2];
 
 	buffer[0] = code;
 	buffer[1] = size;
@@ -330,15 +471,14 @@ static int	ipc_socket_write_message(zbx_ipc_socket_t *csocket, zbx_uint32_t code
 		return ipc_write_data(csocket->fd, (unsigned char *)buffer, size + ZBX_IPC_HEADER_SIZE, tx_size);
 	}
 
-	if (FAIL == ipc_write_data(csocket->fd, (unsigned char *)buffer, ZBX_IPC_HEADER_SIZE, tx_size))
-		return FAIL;
+	/* write header and data of large messages with a single system call */
+	iov[0].iov_base = buffer;
+	iov[0].iov_len = ZBX_IPC_HEADER_SIZE;
+	iov[1].iov_base = (void *)data;
+	iov[1].iov_len = size;
 
-	/* in the case of non-blocking sockets only a part of the header might be sent */
-	if (ZBX_IPC_HEADER_SIZE != *tx_size)
-		return SUCCEED;
-
-	ret = ipc_write_data(csocket->fd, data, size, &size_data);
-	*tx_size += size_data;
+	ret = ipc_writev_data(csocket->fd, iov, 2, &size_sent);
+	*tx_size = (zbx_uint32_t)size_sent;
 
 	return ret;
 }
@@ -474,10 +614,11 @@ static int	ipc_socket_read_message(zbx_ipc_socket_t *csocket, zbx_uint32_t *head
 			offset = *rx_bytes - ZBX_IPC_HEADER_SIZE;
 			data_size = header[ZBX_IPC_MESSAGE_SIZE] - offset;
 
-			/* long messages will be read directly into message buffer */
+			/* long messages will be read directly into message buffer, following */
+			/* messages - into socket buffer                                       */
 			if (ZBX_IPC_SOCKET_BUFFER_SIZE * 0.75 < data_size)
 			{
-				ret = ipc_read_data_full(csocket->fd, *data + offset, data_size, &read_size);
+				ret = ipc_socket_read_data_full(csocket, *data + offset, data_size, &read_size);
 				*rx_bytes += read_size;
 				goto out;
 			}
@@ -545,13 +686,19 @@ static void	ipc_client_free(zbx_ipc_client_t *client)
 	zbx_ipc_socket_close(&client->csocket);
 
 	while (NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&client->rx_queue)))
+	{
 		zbx_ipc_message_free(message);
+		client->service->stats.rx_queued--;
+	}
 
 	zbx_queue_ptr_destroy(&client->rx_queue);
 	zbx_free(client->rx_data);
 
 	while (NULL != (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&client->tx_queue)))
+	{
 		zbx_ipc_message_free(message);
+		client->service->stats.tx_queued--;
+	}
 
 	zbx_queue_ptr_destroy(&client->tx_queue);
 	zbx_free(client->tx_data);
@@ -572,13 +719,21 @@ static void	ipc_client_free(zbx_ipc_client_t *client)
  ******************************************************************************/
 static void	ipc_client_push_rx_message(zbx_ipc_client_t *client)
 {
-	zbx_ipc_message_t	*message;
+	zbx_ipc_queued_message_t	*queued;
+	zbx_ipc_service_stats_t		*stats = &client->service->stats;
 
-	message = (zbx_ipc_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_message_t));
-	message->code = client->rx_header[ZBX_IPC_MESSAGE_CODE];
-	message->size = client->rx_header[ZBX_IPC_MESSAGE_SIZE];
-	message->data = client->rx_data;
-	zbx_queue_ptr_push(&client->rx_queue, message);
+	queued = (zbx_ipc_queued_message_t *)zbx_malloc(NULL, sizeof(zbx_ipc_queued_message_t));
+	queued->message.code = client->rx_header[ZBX_IPC_MESSAGE_CODE];
+	queued->message.size = client->rx_header[ZBX_IPC_MESSAGE_SIZE];
+	queued->message.data = client->rx_data;
+	queued->time_queued = zbx_time();
+	zbx_queue_ptr_push(&client->rx_queue, queued);
+
+	stats->rx_messages++;
+	stats->rx_bytes += ZBX_IPC_HEADER_SIZE + queued->message.size;
+
+	if (++stats->rx_queued > stats->rx_queued_max)
+		stats->rx_queued_max = stats->rx_queued;
 
 	client->rx_data = NULL;
 	client->rx_bytes = 0;
@@ -603,6 +758,8 @@ static void	ipc_client_pop_tx_message(zbx_ipc_client_t *client)
 	if (NULL == (message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&client->tx_queue)))
 		return;
 
+	client->service->stats.tx_queued--;
+
 	client->tx_bytes = ZBX_IPC_HEADER_SIZE + message->size;
 	client->tx_header[ZBX_IPC_MESSAGE_CODE] = message->code;
 	client->tx_header[ZBX_IPC_MESSAGE_SIZE] = message->size;
@@ -621,16 +778,19 @@ static void	ipc_client_pop_tx_message(zbx_ipc_client_t *client)
  *                                                                            *
  * Comments: This function reads data from socket, parses it and adds         *
  *           parsed messages to received messages queue.                      *
+ *           Reading stops when all buffered messages are parsed and the last *
+ *           read did not fill the socket buffer - the remaining data (if     *
+ *           any) will be read during the next read event.                    *
  *                                                                            *
  ******************************************************************************/
 static int	ipc_client_read(zbx_ipc_client_t *client)
 {
-	int	rc;
+	zbx_ipc_socket_t	*csocket = &client->csocket;
+	int			rc;
 
 	do
 	{
-		if (FAIL == ipc_socket_read_message(&client->csocket, client->rx_header, &client->rx_data,
-				&client->rx_bytes))
+		if (FAIL == ipc_socket_read_message(csocket, client->rx_header, &client->rx_data, &client->rx_bytes))
 		{
 			zbx_free(client->rx_data);
 			client->rx_bytes = 0;
@@ -638,9 +798,16 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
 		}
 
 		if (SUCCEED == (rc = ipc_message_is_completed(client->rx_header, client->rx_bytes)))
+		{
 			ipc_client_push_rx_message(client);
-	}
 
+			if (csocket->rx_buffer_offset == csocket->rx_buffer_bytes &&
+					ZBX_IPC_SOCKET_BUFFER_SIZE > csocket->rx_buffer_bytes)
+			{
+				break;
+			}
+		}
+	}
 	while (SUCCEED == rc);
 
 	return SUCCEED;
@@ -657,48 +824,85 @@ static int	ipc_client_read(zbx_ipc_client_t *client)
  * Return value: SUCCEED - the data was sent successfully                     *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: The current message and up to ZBX_IPC_WRITEV_MAX queued messages *
+ *           are written with a single system call.                           *
+ *                                                                            *
  ******************************************************************************/
 static int	ipc_client_write(zbx_ipc_client_t *client)
 {
-	zbx_uint32_t	data_size, write_size;
-
-	data_size = client->tx_header[ZBX_IPC_MESSAGE_SIZE];
+	zbx_uint32_t		data_size, header_size, headers[ZBX_IPC_WRITEV_MAX][2];
+	zbx_uint64_t		write_size, sent_size, total_size;
+	zbx_ipc_message_t	*message;
+	struct iovec		iov[ZBX_IPC_WRITEV_IOV_NUM];
+	int			i, iov_num;
 
-	if (data_size < client->tx_bytes)
+	while (0 != client->tx_bytes)
 	{
-		zbx_uint32_t	size, offset;
+		iov_num = 0;
 
-		size = client->tx_bytes - data_size;
-		offset = ZBX_IPC_HEADER_SIZE - size;
+		/* the remaining part of the current message */
+		data_size = client->tx_header[ZBX_IPC_MESSAGE_SIZE];
 
-		if (SUCCEED != ipc_write_data(client->csocket.fd, (unsigned char *)client->tx_header + offset, size,
-				&write_size))
+		if (data_size < client->tx_bytes)
 		{
-			return FAIL;
-		}
+			header_size = client->tx_bytes - data_size;
+			iov[iov_num].iov_base = (char *)client->tx_header + ZBX_IPC_HEADER_SIZE - header_size;
+			iov[iov_num++].iov_len = header_size;
 
-		client->tx_bytes -= write_size;
+			if (0 != data_size)
+			{
+				iov[iov_num].iov_base = client->tx_data;
+				iov[iov_num++].iov_len = data_size;
+			}
+		}
+		else
+		{
+			iov[iov_num].iov_base = client->tx_data + data_size - client->tx_bytes;
+			iov[iov_num++].iov_len = client->tx_bytes;
+		}
 
-		if (data_size < client->tx_bytes)
-			return SUCCEED;
-	}
+		total_size = client->tx_bytes;
 
-	while (0 < client->tx_bytes)
-	{
-		if (SUCCEED != ipc_write_data(client->csocket.fd, client->tx_data + data_size - client->tx_bytes,
-				client->tx_bytes, &write_size))
+		/* the queued messages */
+		for (i = 0; ZBX_IPC_WRITEV_MAX > i && NULL != (message = (zbx_ipc_message_t *)
+				zbx_queue_ptr_peek(&client->tx_queue, i)); i++)
 		{
-			return FAIL;
+			headers[i][ZBX_IPC_MESSAGE_CODE] = message->code;
+			headers[i][ZBX_IPC_MESSAGE_SIZE] = message->size;
+			iov[iov_num].iov_base = headers[i];
+			iov[iov_num++].iov_len = ZBX_IPC_HEADER_SIZE;
+
+			if (0 != message->size)
+			{
+				iov[iov_num].iov_base = message->data;
+				iov[iov_num++].iov_len = message->size;
+			}
+
+			total_size += ZBX_IPC_HEADER_SIZE + message->size;
 		}
 
-		if (0 == write_size)
-			return SUCCEED;
+		if (SUCCEED != ipc_writev_data(client->csocket.fd, iov, iov_num, &sent_size))
+			return FAIL;
 
-		client->tx_bytes -= write_size;
-	}
+		write_size = sent_size;
 
-	if (0 == client->tx_bytes)
-		ipc_client_pop_tx_message(client);
+		/* advance through the sent messages */
+		while (0 != write_size)
+		{
+			if (write_size < client->tx_bytes)
+			{
+				client->tx_bytes -= write_size;
+				break;
+			}
+
+			write_size -= client->tx_bytes;
+			ipc_client_pop_tx_message(client);
+		}
+
+		/* socket buffer is full, the remaining data will be sent during the next write event */
+		if (sent_size != total_size)
+			break;
+	}
 
 	return SUCCEED;
 }
@@ -1026,6 +1230,23 @@ static void	ipc_service_timer_cb(evutil_socket_t fd, short what, void *arg)
 	ZBX_UNUSED(arg);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_service_ring_cb                                              *
+ *                                                                            *
+ * Purpose: ring buffer notification callback                                 *
+ *                                                                            *
+ * Comments: The notification only interrupts event loop, the ring buffer     *
+ *           messages are read by service owner.                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_service_ring_cb(evutil_socket_t fd, short what, void *arg)
+{
+	ZBX_UNUSED(fd);
+	ZBX_UNUSED(what);
+	ZBX_UNUSED(arg);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: ipc_check_running_service                                        *
@@ -1049,6 +1270,203 @@ static int	ipc_check_running_service(const char *service_name)
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_service_update_latency                                       *
+ *                                                                            *
+ * Purpose: updates message queue latency statistics                          *
+ *                                                                            *
+ * Parameters: stats  - [IN/OUT] the service statistics                       *
+ *             queued - [IN] the message removed from client receive queue    *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_service_update_latency(zbx_ipc_service_stats_t *stats, const zbx_ipc_queued_message_t *queued)
+{
+	double	latency;
+	int	i;
+
+	stats->rx_queued--;
+
+	if (0 > (latency = zbx_time() - queued->time_queued))
+		latency = 0;
+
+	for (i = 0; i < ZBX_IPC_LATENCY_BUCKETS - 1 && latency > ipc_latency_bounds[i]; i++)
+		;
+
+	stats->latency[i]++;
+	stats->latency_sum += latency;
+
+	if (latency > stats->latency_max)
+		stats->latency_max = latency;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_client_get_queues                                            *
+ *                                                                            *
+ * Purpose: gets the number of messages in client receive and send queues     *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_client_get_queues(const zbx_ipc_client_t *client, int *rx_num, int *tx_num)
+{
+	*rx_num = zbx_queue_ptr_values_num((zbx_queue_ptr_t *)&client->rx_queue);
+	*tx_num = zbx_queue_ptr_values_num((zbx_queue_ptr_t *)&client->tx_queue);
+
+	/* count partially sent message */
+	if (0 != client->tx_bytes)
+		(*tx_num)++;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_service_format_stats                                         *
+ *                                                                            *
+ * Purpose: formats service statistics in json format                         *
+ *                                                                            *
+ * Parameters: service     - [IN] the IPC service                             *
+ *             data        - [IN/OUT] the output buffer                       *
+ *             data_alloc  - [IN/OUT] the output buffer size                  *
+ *             data_offset - [IN/OUT] the output buffer offset                *
+ *                                                                            *
+ * Comments: Only clients with queued messages are listed.                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_service_format_stats(const zbx_ipc_service_t *service, char **data, size_t *data_alloc,
+		size_t *data_offset)
+{
+	const zbx_ipc_service_stats_t	*stats = &service->stats;
+	zbx_uint64_t			latency_num = 0;
+	int				i, rx_num, tx_num;
+	const char			*delim = "";
+
+	for (i = 0; i < ZBX_IPC_LATENCY_BUCKETS; i++)
+		latency_num += stats->latency[i];
+
+	zbx_snprintf_alloc(data, data_alloc, data_offset, "{\"service\":\"%s\",\"uptime\":%.3f,\"clients\":%d,"
+			"\"rx\":{\"messages\":" ZBX_FS_UI64 ",\"bytes\":" ZBX_FS_UI64 ",\"queued\":" ZBX_FS_UI64
+			",\"queued_max\":" ZBX_FS_UI64 "},"
+			"\"tx\":{\"messages\":" ZBX_FS_UI64 ",\"bytes\":" ZBX_FS_UI64 ",\"queued\":" ZBX_FS_UI64
+			",\"queued_max\":" ZBX_FS_UI64 "},"
+			"\"latency\":{\"avg\":%.6f,\"max\":%.6f",
+			service->path, zbx_time() - stats->time_start, service->clients.values_num,
+			stats->rx_messages, stats->rx_bytes, stats->rx_queued, stats->rx_queued_max,
+			stats->tx_messages, stats->tx_bytes, stats->tx_queued, stats->tx_queued_max,
+			0 != latency_num ? stats->latency_sum / latency_num : 0.0, stats->latency_max);
+
+	for (i = 0; i < ZBX_IPC_LATENCY_BUCKETS; i++)
+	{
+		zbx_snprintf_alloc(data, data_alloc, data_offset, ",\"%s\":" ZBX_FS_UI64, ipc_latency_names[i],
+				stats->latency[i]);
+	}
+
+	zbx_strcpy_alloc(data, data_alloc, data_offset, "}");
+
+	if (NULL != service->ring)
+	{
+		zbx_snprintf_alloc(data, data_alloc, data_offset, ",\"ring\":{\"messages\":" ZBX_FS_UI64
+				",\"bytes\":" ZBX_FS_UI64 "}", service->ring->rx_messages, service->ring->rx_bytes);
+	}
+
+	zbx_strcpy_alloc(data, data_alloc, data_offset, ",\"queues\":[");
+
+	for (i = 0; i < service->clients.values_num; i++)
+	{
+		const zbx_ipc_client_t	*client = (const zbx_ipc_client_t *)service->clients.values[i];
+
+		ipc_client_get_queues(client, &rx_num, &tx_num);
+
+		if (0 == rx_num && 0 == tx_num)
+			continue;
+
+		zbx_snprintf_alloc(data, data_alloc, data_offset, "%s{\"clientid\":" ZBX_FS_UI64 ",\"rx\":%d,\"tx\":%d}",
+				delim, client->id, rx_num, tx_num);
+		delim = ",";
+	}
+
+	zbx_strcpy_alloc(data, data_alloc, data_offset, "]}");
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_service_send_stats                                           *
+ *                                                                            *
+ * Purpose: sends service statistics to the client                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_service_send_stats(const zbx_ipc_service_t *service, zbx_ipc_client_t *client)
+{
+	char	*data = NULL;
+	size_t	data_alloc = 0, data_offset = 0;
+
+	ipc_service_format_stats(service, &data, &data_alloc, &data_offset);
+	zbx_ipc_client_send(client, ZBX_IPC_SERVICE_STATS, (const unsigned char *)data, (zbx_uint32_t)data_offset + 1);
+	zbx_free(data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ipc_service_log_stats                                            *
+ *                                                                            *
+ * Purpose: writes service statistics to log file                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	ipc_service_log_stats(const zbx_ipc_service_t *service)
+{
+	const zbx_ipc_service_stats_t	*stats = &service->stats;
+	double				uptime;
+	zbx_uint64_t			latency_num = 0;
+	char				*hist = NULL;
+	size_t				hist_alloc = 0, hist_offset = 0;
+	int				i, rx_num, tx_num;
+
+	if (0 >= (uptime = zbx_time() - stats->time_start))
+		uptime = 1;
+
+	for (i = 0; i < ZBX_IPC_LATENCY_BUCKETS; i++)
+	{
+		latency_num += stats->latency[i];
+		zbx_snprintf_alloc(&hist, &hist_alloc, &hist_offset, " %s:" ZBX_FS_UI64, ipc_latency_names[i],
+				stats->latency[i]);
+	}
+
+	zabbix_log(LOG_LEVEL_WARNING, "== IPC service \"%s\" statistics, uptime %.0f sec ==", service->path,
+			uptime);
+	zabbix_log(LOG_LEVEL_WARNING, "received messages:" ZBX_FS_UI64 " bytes:" ZBX_FS_UI64 " (%.1f msg/sec)",
+			stats->rx_messages, stats->rx_bytes, stats->rx_messages / uptime);
+	zabbix_log(LOG_LEVEL_WARNING, "sent messages:" ZBX_FS_UI64 " bytes:" ZBX_FS_UI64 " (%.1f msg/sec)",
+			stats->tx_messages, stats->tx_bytes, stats->tx_messages / uptime);
+	zabbix_log(LOG_LEVEL_WARNING, "queued to receive:" ZBX_FS_UI64 " (max " ZBX_FS_UI64 "), to send:" ZBX_FS_UI64
+			" (max " ZBX_FS_UI64 ")", stats->rx_queued, stats->rx_queued_max, stats->tx_queued,
+			stats->tx_queued_max);
+	zabbix_log(LOG_LEVEL_WARNING, "queue latency avg:%.6f max:%.6f sec, messages by latency:%s",
+			0 != latency_num ? stats->latency_sum / latency_num : 0.0, stats->latency_max, hist);
+
+	if (NULL != service->ring)
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "ring buffer messages:" ZBX_FS_UI64 " bytes:" ZBX_FS_UI64 " (%.1f msg/sec)",
+				service->ring->rx_messages, service->ring->rx_bytes, service->ring->rx_messages / uptime);
+	}
+
+	zabbix_log(LOG_LEVEL_WARNING, "clients:%d", service->clients.values_num);
+
+	for (i = 0; i < service->clients.values_num; i++)
+	{
+		const zbx_ipc_client_t	*client = (const zbx_ipc_client_t *)service->clients.values[i];
+
+		ipc_client_get_queues(client, &rx_num, &tx_num);
+
+		if (0 == rx_num && 0 == tx_num)
+			continue;
+
+		zabbix_log(LOG_LEVEL_WARNING, "  clientid:" ZBX_FS_UI64 " queued to receive:%d, to send:%d",
+				client->id, rx_num, tx_num);
+	}
+
+	zabbix_log(LOG_LEVEL_WARNING, "==");
+
+	zbx_free(hist);
+}
+
 /*
  * Public client API
  */
@@ -1491,6 +1909,11 @@ int	zbx_ipc_service_start(zbx_ipc_service_t *service, const char *service_name,
 	event_add(service->ev_listener, NULL);
 
 	service->ev_timer = event_new(service->ev, -1, 0, ipc_service_timer_cb, service);
+	service->ev_ring = NULL;
+	service->ring = NULL;
+
+	memset(&service->stats, 0, sizeof(service->stats));
+	service->stats.time_start = zbx_time();
 
 	ret = SUCCEED;
 out:
@@ -1527,6 +1950,9 @@ void	zbx_ipc_service_close(zbx_ipc_service_t *service)
 	zbx_vector_ptr_destroy(&service->clients);
 	zbx_queue_ptr_destroy(&service->clients_recv);
 
+	if (NULL != service->ev_ring)
+		event_free(service->ev_ring);
+
 	event_free(service->ev_timer);
 	event_free(service->ev_listener);
 	event_base_free(service->ev);
@@ -1534,6 +1960,112 @@ void	zbx_ipc_service_close(zbx_ipc_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_service_add_ring                                         *
+ *                                                                            *
+ * Purpose: makes IPC service to wake up when messages are written to the     *
+ *          ring buffer                                                       *
+ *                                                                            *
+ * Parameters: service - [IN/OUT] the IPC service                             *
+ *             ring    - [IN] the ring buffer consumed by service owner       *
+ *             error   - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED - the ring buffer was added successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Only one ring buffer can be added to a service. After            *
+ *           zbx_ipc_service_recv() returns the service owner must read all   *
+ *           messages from the ring buffer with zbx_ipc_ring_read().          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_service_add_ring(zbx_ipc_service_t *service, zbx_ipc_ring_t *ring, char **error)
+{
+	if (NULL != service->ev_ring)
+	{
+		*error = zbx_strdup(*error, "ring buffer is already added to the service");
+		return FAIL;
+	}
+
+	if (NULL == (service->ev_ring = event_new(service->ev, zbx_ipc_ring_get_fd(ring), EV_READ | EV_PERSIST,
+			ipc_service_ring_cb, service)))
+	{
+		*error = zbx_strdup(*error, "cannot create ring buffer event");
+		return FAIL;
+	}
+
+	event_add(service->ev_ring, NULL);
+	service->ring = ring;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_service_sigusr_handler                                   *
+ *                                                                            *
+ * Purpose: handles runtime control signals of IPC service owner processes    *
+ *                                                                            *
+ * Parameters: flags - [IN] the runtime control message                       *
+ *                                                                            *
+ * Comments: The statistics are logged by the next zbx_ipc_service_recv()     *
+ *           call, outside signal handler.                                    *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ipc_service_sigusr_handler(int flags)
+{
+	if (ZBX_RTC_IPC_STATS == ZBX_RTC_GET_MSG(flags))
+		ipc_stats_requested = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ipc_service_get_stats                                        *
+ *                                                                            *
+ * Purpose: requests statistics of a running IPC service                      *
+ *                                                                            *
+ * Parameters: service_name - [IN] the IPC service name                       *
+ *             data         - [OUT] the statistics in json format             *
+ *             error        - [OUT] the error message                         *
+ *                                                                            *
+ * Return value: SUCCEED - the statistics were returned successfully          *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_ipc_service_get_stats(const char *service_name, char **data, char **error)
+{
+	zbx_ipc_socket_t	csocket;
+	zbx_ipc_message_t	message;
+	int			ret = FAIL;
+
+	if (FAIL == zbx_ipc_socket_open(&csocket, service_name, SEC_PER_MIN, error))
+		return FAIL;
+
+	zbx_ipc_message_init(&message);
+
+	if (FAIL == zbx_ipc_socket_write(&csocket, ZBX_IPC_SERVICE_STATS, NULL, 0))
+	{
+		*error = zbx_dsprintf(*error, "cannot send statistics request to \"%s\" service", service_name);
+		goto out;
+	}
+
+	if (FAIL == zbx_ipc_socket_read(&csocket, &message) || 0 == message.size ||
+			'\0' != message.data[message.size - 1])
+	{
+		*error = zbx_dsprintf(*error, "cannot read statistics response from \"%s\" service", service_name);
+		goto out;
+	}
+
+	*data = (char *)message.data;
+	message.data = NULL;
+	ret = SUCCEED;
+out:
+	zbx_ipc_socket_close(&csocket);
+	zbx_ipc_message_clean(&message);
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_ipc_service_recv                                             *
@@ -1581,10 +2113,27 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, int timeout, zbx_ipc_client
 
 	event_base_loop(service->ev, flags);
 
-	if (NULL != (*client = ipc_service_pop_client(service)))
+	if (0 != ipc_stats_requested)
+	{
+		ipc_stats_requested = 0;
+		ipc_service_log_stats(service);
+	}
+
+	while (NULL != (*client = ipc_service_pop_client(service)))
 	{
 		if (NULL != (*message = (zbx_ipc_message_t *)zbx_queue_ptr_pop(&(*client)->rx_queue)))
 		{
+			ipc_service_update_latency(&service->stats, (zbx_ipc_queued_message_t *)*message);
+			ipc_service_push_client(service, *client);
+
+			/* statistics requests are answered without involving service owner */
+			if (ZBX_IPC_SERVICE_STATS == (*message)->code)
+			{
+				ipc_service_send_stats(service, *client);
+				zbx_ipc_message_free(*message);
+				continue;
+			}
+
 			if (SUCCEED == zabbix_check_log_level(LOG_LEVEL_TRACE))
 			{
 				char	*data = NULL;
@@ -1595,12 +2144,14 @@ int	zbx_ipc_service_recv(zbx_ipc_service_t *service, int timeout, zbx_ipc_client
 				zbx_free(data);
 			}
 
-			ipc_service_push_client(service, *client);
 			zbx_ipc_client_addref(*client);
 		}
 
-		ret = (EVLOOP_NONBLOCK == flags ? ZBX_IPC_RECV_IMMEDIATE : ZBX_IPC_RECV_WAIT);
+		break;
 	}
+
+	if (NULL != *client)
+		ret = (EVLOOP_NONBLOCK == flags ? ZBX_IPC_RECV_IMMEDIATE : ZBX_IPC_RECV_WAIT);
 	else
 	{	ret = ZBX_IPC_RECV_TIMEOUT;
 		*client = NULL;
@@ -1633,14 +2184,23 @@ int	zbx_ipc_client_send(zbx_ipc_client_t *client, zbx_uint32_t code, const unsig
 	const char		*__function_name = "zbx_ipc_client_send";
 	zbx_uint32_t		tx_size = 0;
 	zbx_ipc_message_t	*message;
+	zbx_ipc_service_stats_t	*stats;
 	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() clientid:" ZBX_FS_UI64, __function_name, client->id);
 
+	stats = &client->service->stats;
+	stats->tx_messages++;
+	stats->tx_bytes += ZBX_IPC_HEADER_SIZE + size;
+
 	if (0 != client->tx_bytes)
 	{
 		message = ipc_message_create(code, data, size);
 		zbx_queue_ptr_push(&client->tx_queue, message);
+
+		if (++stats->tx_queued > stats->tx_queued_max)
+			stats->tx_queued_max = stats->tx_queued;
+
 		ret = SUCCEED;
 		goto out;
 	}
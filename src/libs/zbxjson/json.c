@@ -21,6 +21,19 @@
 #include "zbxjson.h"
 #include "json_parser.h"
 
+#define ZBX_JSON_WORD_ONES		__UINT64_C(0x0101010101010101)
+#define ZBX_JSON_WORD_HIGHS		__UINT64_C(0x8080808080808080)
+
+/* checks if any byte of 64 bit word is zero */
+#define ZBX_JSON_WORD_HAS_ZERO(w)	(0 != (((w) - ZBX_JSON_WORD_ONES) & ~(w) & ZBX_JSON_WORD_HIGHS))
+
+/* checks if any byte of 64 bit word matches the specified character */
+#define ZBX_JSON_WORD_HAS_CHAR(w, c)	ZBX_JSON_WORD_HAS_ZERO((w) ^ (ZBX_JSON_WORD_ONES * (unsigned char)(c)))
+
+/* checks if any byte of 64 bit word is a control character (0x00-0x1f) */
+#define ZBX_JSON_WORD_HAS_CNTRL(w)	\
+	(0 != (((w) - ZBX_JSON_WORD_ONES * 0x20) & ~(w) & ZBX_JSON_WORD_HIGHS))
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_json_strerror                                                *
@@ -160,15 +173,67 @@ void	zbx_json_free(struct zbx_json *j)
 		zbx_free(j->buffer);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: json_plain_span                                                  *
+ *                                                                            *
+ * Purpose: gets length of the string prefix that can be written to json      *
+ *          without escaping                                                  *
+ *                                                                            *
+ * Parameters: p   - [IN] the string                                          *
+ *             end - [IN] the end of string                                   *
+ *                                                                            *
+ * Return value: the number of characters not requiring escaping              *
+ *                                                                            *
+ * Comments: The string is checked 8 characters at a time, so the long runs   *
+ *           of plain text are skipped without per character comparisons.     *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	json_plain_span(const char *p, const char *end)
+{
+	const char	*start = p;
+	zbx_uint64_t	word;
+
+	while (p + sizeof(word) <= end)
+	{
+		memcpy(&word, p, sizeof(word));
+
+		if (ZBX_JSON_WORD_HAS_CNTRL(word) || ZBX_JSON_WORD_HAS_CHAR(word, '"') ||
+				ZBX_JSON_WORD_HAS_CHAR(word, '\\') || ZBX_JSON_WORD_HAS_CHAR(word, 0x7f))
+		{
+			break;
+		}
+
+		p += sizeof(word);
+	}
+
+	for (; p < end; p++)
+	{
+		if ('"' == *p || '\\' == *p || 0 != iscntrl(*p))
+			break;
+	}
+
+	return p - start;
+}
+
 static size_t	__zbx_json_stringsize(const char *string, zbx_json_type_t type)
 {
-	size_t		len = 0;
-	const char	*sptr;
+	size_t		len = 0, span;
+	const char	*sptr, *end;
 	char		buffer[] = {"null"};
 
-	for (sptr = (NULL != string ? string : buffer); '\0' != *sptr; sptr++)
+	sptr = (NULL != string ? string : buffer);
+	end = sptr + strlen(sptr);
+
+	while (sptr < end)
 	{
-		switch (*sptr)
+		span = json_plain_span(sptr, end);
+		len += span;
+
+		if ((sptr += span) == end)
+			break;
+
+		switch (*sptr++)
 		{
 			case '"':  /* quotation mark */
 			case '\\': /* reverse solidus */
@@ -180,10 +245,7 @@ static size_t	__zbx_json_stringsize(const char *string, zbx_json_type_t type)
 				len += 2;
 				break;
 			default:
-				if (0 != iscntrl(*sptr))
-					len += 6;
-				else
-					len++;
+				len += 6;
 		}
 	}
 
@@ -218,57 +280,59 @@ static char	zbx_num2hex(unsigned char c)
 
 static char	*__zbx_json_insstring(char *p, const char *string, zbx_json_type_t type)
 {
-	const char	*sptr;
+	const char	*sptr, *end;
 	char		buffer[] = {"null"};
+	size_t		span;
 
 	if (NULL != string && ZBX_JSON_TYPE_STRING == type)
 		*p++ = '"';
 
-	for (sptr = (NULL != string ? string : buffer); '\0' != *sptr; sptr++)
+	sptr = (NULL != string ? string : buffer);
+	end = sptr + strlen(sptr);
+
+	while (sptr < end)
 	{
+		span = json_plain_span(sptr, end);
+		memcpy(p, sptr, span);
+		p += span;
+
+		if ((sptr += span) == end)
+			break;
+
+		*p++ = '\\';
+
 		switch (*sptr)
 		{
 			case '"':		/* quotation mark */
-				*p++ = '\\';
 				*p++ = '"';
 				break;
 			case '\\':		/* reverse solidus */
-				*p++ = '\\';
 				*p++ = '\\';
 				break;
 			case '\b':		/* backspace */
-				*p++ = '\\';
 				*p++ = 'b';
 				break;
 			case '\f':		/* formfeed */
-				*p++ = '\\';
 				*p++ = 'f';
 				break;
 			case '\n':		/* newline */
-				*p++ = '\\';
 				*p++ = 'n';
 				break;
 			case '\r':		/* carriage return */
-				*p++ = '\\';
 				*p++ = 'r';
 				break;
 			case '\t':		/* horizontal tab */
-				*p++ = '\\';
 				*p++ = 't';
 				break;
 			default:
-				if (0 != iscntrl(*sptr))
-				{
-					*p++ = '\\';
-					*p++ = 'u';
-					*p++ = '0';
-					*p++ = '0';
-					*p++ = zbx_num2hex((*sptr >> 4) & 0xf);
-					*p++ = zbx_num2hex(*sptr & 0xf);
-				}
-				else
-					*p++ = *sptr;
+				*p++ = 'u';
+				*p++ = '0';
+				*p++ = '0';
+				*p++ = zbx_num2hex((*sptr >> 4) & 0xf);
+				*p++ = zbx_num2hex(*sptr & 0xf);
 		}
+
+		sptr++;
 	}
 
 	if (NULL != string && ZBX_JSON_TYPE_STRING == type)
@@ -1215,10 +1279,6 @@ int	zbx_json_count(const struct zbx_json_parse *jp)
  * limited JSONPath support
  */
 
-#define ZBX_JSONPATH_COMPONENT_DOT	0
-#define ZBX_JSONPATH_COMPONENT_BRACKET	1
-#define ZBX_JSONPATH_ARRAY_INDEX	2
-
 /******************************************************************************
  *                                                                            *
  * Function: zbx_jsonpath_error                                               *
@@ -1339,7 +1399,7 @@ int	zbx_jsonpath_next(const char *path, const char **pnext, zbx_strloc_t *loc, i
  *                                                                            *
  * Purpose: opens an object by json path                                      *
  *                                                                            *
- * Return value: SUCCESS - processed successfully                             *
+ * Return value: SUCCEED - processed successfully                             *
  *               FAIL - an error occurred                                     *
  *                                                                            *
  * Comments: Only direct path to single object in dot or bracket notation     *
@@ -1348,57 +1408,238 @@ int	zbx_jsonpath_next(const char *path, const char **pnext, zbx_strloc_t *loc, i
  ******************************************************************************/
 int	zbx_json_path_open(const struct zbx_json_parse *jp, const char *path, struct zbx_json_parse *out)
 {
-	const char		*p, *next = 0;
-	char			buffer[MAX_STRING_LEN];
-	zbx_strloc_t		loc;
-	int			type, index;
-	struct zbx_json_parse	object;
+	zbx_jsonpath_t	jsonpath;
+	int		ret;
+
+	if (FAIL == zbx_jsonpath_compile(path, &jsonpath))
+		return FAIL;
 
-	object = *jp;
+	ret = zbx_json_path_open_compiled(jp, &jsonpath, out);
+	zbx_jsonpath_clear(&jsonpath);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_compile                                             *
+ *                                                                            *
+ * Purpose: parses json path into components, so it can be used to open       *
+ *          objects without parsing the path again                            *
+ *                                                                            *
+ * Parameters: path     - [IN] the json path                                  *
+ *             jsonpath - [OUT] the compiled json path                        *
+ *                                                                            *
+ * Return value: SUCCEED - the json path was compiled successfully            *
+ *               FAIL    - invalid json path                                  *
+ *                                                                            *
+ * Comments: The compiled json path must be freed with zbx_jsonpath_clear()   *
+ *           function.                                                        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_jsonpath_compile(const char *path, zbx_jsonpath_t *jsonpath)
+{
+	const char			*next = NULL;
+	zbx_strloc_t			loc;
+	int				type, components_alloc = 0;
+	zbx_jsonpath_component_t	*component;
+
+	jsonpath->path = zbx_strdup(NULL, path);
+	jsonpath->components = NULL;
+	jsonpath->components_num = 0;
 
 	do
 	{
 		if (FAIL == zbx_jsonpath_next(path, &next, &loc, &type))
-			return FAIL;
+			goto fail;
 
-		if (ZBX_JSONPATH_ARRAY_INDEX == type)
+		if (jsonpath->components_num == components_alloc)
 		{
-			if ('[' != *object.start)
-				return FAIL;
-
-			if (FAIL == is_uint_n_range(path + loc.l, loc.r - loc.l + 1, &index, sizeof(index), 0,
-					0xFFFFFFFF))
-			{
-				return FAIL;
-			}
+			components_alloc += 8;
+			jsonpath->components = (zbx_jsonpath_component_t *)zbx_realloc(jsonpath->components,
+					sizeof(zbx_jsonpath_component_t) * components_alloc);
+		}
 
-			for (p = NULL; NULL != (p = zbx_json_next(&object, p)) && 0 != index; index--)
-				;
+		component = &jsonpath->components[jsonpath->components_num];
+		component->offset = loc.l;
 
-			if (0 != index || NULL == p)
+		if (ZBX_JSONPATH_ARRAY_INDEX == type)
+		{
+			if (FAIL == is_uint_n_range(path + loc.l, loc.r - loc.l + 1, &component->index,
+					sizeof(component->index), 0, 0xFFFFFFFF))
 			{
-				zbx_set_json_strerror("array index out of bounds starting with json path: \"%s\"",
-						path + loc.l);
-				return FAIL;
+				goto fail;
 			}
+
+			component->name = NULL;
 		}
 		else
 		{
-			zbx_strlcpy(buffer, path + loc.l, loc.r - loc.l + 2);
+			component->name = (char *)zbx_malloc(NULL, loc.r - loc.l + 2);
+			zbx_strlcpy(component->name, path + loc.l, loc.r - loc.l + 2);
+			component->index = 0;
+		}
+
+		jsonpath->components_num++;
+	}
+	while ('\0' != *next);
+
+	return SUCCEED;
+fail:
+	zbx_jsonpath_clear(jsonpath);
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_jsonpath_clear                                               *
+ *                                                                            *
+ * Purpose: frees resources allocated by compiled json path                   *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_jsonpath_clear(zbx_jsonpath_t *jsonpath)
+{
+	int	i;
+
+	for (i = 0; i < jsonpath->components_num; i++)
+		zbx_free(jsonpath->components[i].name);
+
+	zbx_free(jsonpath->components);
+	zbx_free(jsonpath->path);
+	jsonpath->components_num = 0;
+}
 
-			if (NULL == (p = zbx_json_pair_by_name(&object, buffer)))
+/* json node accessor used to walk compiled json path over different json representations */
+typedef struct
+{
+	/* returns SUCCEED if the node is an array */
+	int	(*is_array)(const void *data, const void *node);
+
+	/* moves node to the specified array element, returns FAIL if the index is out of bounds */
+	int	(*element)(const void *data, void *node, int index);
+
+	/* moves node to the specified object member value, returns FAIL if the member was not found */
+	int	(*member)(const void *data, void *node, const char *name);
+}
+zbx_json_path_accessor_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_path_walk                                                   *
+ *                                                                            *
+ * Purpose: moves node along compiled json path                               *
+ *                                                                            *
+ * Parameters: jsonpath - [IN] the compiled json path                         *
+ *             accessor - [IN] the json node accessor                         *
+ *             data     - [IN] the json data passed to accessor               *
+ *             node     - [IN/OUT] the starting node, the located node on     *
+ *                                 success                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the node was located                               *
+ *               FAIL    - an error occurred                                  *
+ *                                                                            *
+ *****************************************************************************/
+static int	json_path_walk(const zbx_jsonpath_t *jsonpath, const zbx_json_path_accessor_t *accessor,
+		const void *data, void *node)
+{
+	const zbx_jsonpath_component_t	*component;
+	int				i;
+
+	for (i = 0; i < jsonpath->components_num; i++)
+	{
+		component = &jsonpath->components[i];
+
+		if (NULL == component->name)
+		{
+			if (SUCCEED != accessor->is_array(data, node))
+				return FAIL;
+
+			if (SUCCEED != accessor->element(data, node, component->index))
 			{
-				zbx_set_json_strerror("object not found starting with json path: \"%s\"", path + loc.l);
+				zbx_set_json_strerror("array index out of bounds starting with json path: \"%s\"",
+						jsonpath->path + component->offset);
 				return FAIL;
 			}
 		}
+		else if (SUCCEED != accessor->member(data, node, component->name))
+		{
+			zbx_set_json_strerror("object not found starting with json path: \"%s\"",
+					jsonpath->path + component->offset);
+			return FAIL;
+		}
+	}
 
-		object.start = p;
+	return SUCCEED;
+}
 
-		if (NULL == (object.end = __zbx_json_rbracket(p)))
-			object.end = p + json_parse_value(p, NULL) - 1;
-	}
-	while ('\0' != *next);
+/* json parse location accessor, the node is struct zbx_json_parse */
+
+static void	json_parse_set_value(struct zbx_json_parse *object, const char *p)
+{
+	object->start = p;
+
+	if (NULL == (object->end = __zbx_json_rbracket(p)))
+		object->end = p + json_parse_value(p, NULL) - 1;
+}
+
+static int	json_parse_is_array(const void *data, const void *node)
+{
+	return '[' == *((const struct zbx_json_parse *)node)->start ? SUCCEED : FAIL;
+}
+
+static int	json_parse_element(const void *data, void *node, int index)
+{
+	struct zbx_json_parse	*object = (struct zbx_json_parse *)node;
+	const char		*p;
+
+	for (p = NULL; NULL != (p = zbx_json_next(object, p)) && 0 != index; index--)
+		;
+
+	if (0 != index || NULL == p)
+		return FAIL;
+
+	json_parse_set_value(object, p);
+
+	return SUCCEED;
+}
+
+static int	json_parse_member(const void *data, void *node, const char *name)
+{
+	struct zbx_json_parse	*object = (struct zbx_json_parse *)node;
+	const char		*p;
+
+	if (NULL == (p = zbx_json_pair_by_name(object, name)))
+		return FAIL;
+
+	json_parse_set_value(object, p);
+
+	return SUCCEED;
+}
+
+static const zbx_json_path_accessor_t	json_parse_accessor = {json_parse_is_array, json_parse_element,
+		json_parse_member};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_path_open_compiled                                      *
+ *                                                                            *
+ * Purpose: opens an object by compiled json path                             *
+ *                                                                            *
+ * Return value: SUCCEED - processed successfully                             *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Comments: Only direct path to single object in dot or bracket notation     *
+ *           is supported.                                                    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_path_open_compiled(const struct zbx_json_parse *jp, const zbx_jsonpath_t *jsonpath,
+		struct zbx_json_parse *out)
+{
+	struct zbx_json_parse	object = *jp;
+
+	if (SUCCEED != json_path_walk(jsonpath, &json_parse_accessor, NULL, &object))
+		return FAIL;
 
 	*out = object;
 
@@ -1457,3 +1698,436 @@ int	zbx_json_path_check(const char *path, char * error, size_t errlen)
 
 	return SUCCEED;
 }
+
+/*
+ * Json structural index.
+ *
+ * The json data is scanned once and every value (and object member name) is
+ * stored as a token in document order. Object and array tokens are followed by
+ * tokens of their contents and each token has a link to the token following
+ * its contents, so values can be skipped without scanning them again:
+ *
+ *   {"a":[1,2],"b":"x"}
+ *
+ *   #  token   next
+ *   0  {...}   7
+ *   1  "a"     2
+ *   2  [1,2]   5
+ *   3  1       4
+ *   4  2       5
+ *   5  "b"     6
+ *   6  "x"     7
+ *
+ * Strings, which usually make the bulk of json data, are scanned 8 bytes at a
+ * time looking for quotes and backslashes.
+ */
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_index_string_end                                            *
+ *                                                                            *
+ * Purpose: locates the closing quote of json string                          *
+ *                                                                            *
+ * Parameters: p       - [IN] the first character after the opening quote     *
+ *             end     - [IN] the end of json data                            *
+ *             escaped - [OUT] 1 - the string contains escape sequences       *
+ *                                                                            *
+ * Return value: the closing quote location                                   *
+ *                                                                            *
+ * Comments: The json data must be already validated.                         *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*json_index_string_end(const char *p, const char *end, int *escaped)
+{
+	zbx_uint64_t	word;
+
+	for (;;)
+	{
+		/* skip blocks of 8 characters without quotes and backslashes */
+		while (p + sizeof(word) <= end)
+		{
+			memcpy(&word, p, sizeof(word));
+
+			if (ZBX_JSON_WORD_HAS_CHAR(word, '"') || ZBX_JSON_WORD_HAS_CHAR(word, '\\'))
+				break;
+
+			p += sizeof(word);
+		}
+
+		switch (*p)
+		{
+			case '"':
+				return p;
+			case '\\':
+				*escaped = 1;
+				p += 2;
+				break;
+			default:
+				p++;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: json_index_add                                                   *
+ *                                                                            *
+ * Purpose: adds token to json index                                          *
+ *                                                                            *
+ * Return value: the index of added token                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	json_index_add(zbx_json_index_t *index, const char *start)
+{
+	zbx_json_token_t	*token;
+
+	if (index->tokens_num == index->tokens_alloc)
+	{
+		index->tokens_alloc += index->tokens_alloc / 2 + 16;
+		index->tokens = (zbx_json_token_t *)zbx_realloc(index->tokens,
+				sizeof(zbx_json_token_t) * index->tokens_alloc);
+	}
+
+	token = &index->tokens[index->tokens_num];
+	token->start = start;
+	token->end = start;
+	token->escaped = 0;
+	token->next = ++index->tokens_num;
+
+	return index->tokens_num - 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_open                                              *
+ *                                                                            *
+ * Purpose: validates json data and builds its structural index               *
+ *                                                                            *
+ * Parameters: buffer - [IN] the json data                                    *
+ *             index  - [OUT] the json index, the root object (array) is the  *
+ *                            token 0                                         *
+ *                                                                            *
+ * Return value: SUCCEED - the index was built successfully                   *
+ *               FAIL    - invalid json data                                  *
+ *                                                                            *
+ * Comments: The index refers to the json data, so the data must not be       *
+ *           changed or freed while the index is used. The index must be      *
+ *           freed with zbx_json_index_clear() function.                      *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_open(const char *buffer, zbx_json_index_t *index)
+{
+	struct zbx_json_parse	jp;
+	const char		*p, *end;
+	int			*stack = NULL, stack_num = 0, stack_alloc = 0, i;
+
+	index->tokens = NULL;
+	index->tokens_num = 0;
+	index->tokens_alloc = 0;
+
+	if (SUCCEED != zbx_json_open(buffer, &jp))
+		return FAIL;
+
+	/* rough estimate to avoid reallocations for typical json data */
+	index->tokens_alloc = (int)((jp.end - jp.start) / 16) + 16;
+	index->tokens = (zbx_json_token_t *)zbx_malloc(NULL, sizeof(zbx_json_token_t) * index->tokens_alloc);
+
+	for (p = jp.start, end = jp.end + 1; p < end;)
+	{
+		switch (*p)
+		{
+			case '{':
+			case '[':
+				if (stack_num == stack_alloc)
+				{
+					stack_alloc += 16;
+					stack = (int *)zbx_realloc(stack, sizeof(int) * stack_alloc);
+				}
+
+				stack[stack_num++] = json_index_add(index, p++);
+				break;
+			case '}':
+			case ']':
+				i = stack[--stack_num];
+				index->tokens[i].end = p++;
+				index->tokens[i].next = index->tokens_num;
+				break;
+			case '"':
+				i = json_index_add(index, p);
+				p = json_index_string_end(p + 1, end, &index->tokens[i].escaped);
+				index->tokens[i].end = p++;
+				break;
+			case ' ':
+			case '\t':
+			case '\r':
+			case '\n':
+			case ',':
+			case ':':
+				p++;
+				break;
+			default:
+				/* number, true, false or null */
+				i = json_index_add(index, p);
+
+				while (p < end && NULL == strchr(",]} \t\r\n", *p))
+					p++;
+
+				index->tokens[i].end = p - 1;
+		}
+	}
+
+	zbx_free(stack);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_clear                                             *
+ *                                                                            *
+ * Purpose: frees resources allocated by json index                           *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_json_index_clear(zbx_json_index_t *index)
+{
+	zbx_free(index->tokens);
+	index->tokens_num = 0;
+	index->tokens_alloc = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_next                                              *
+ *                                                                            *
+ * Purpose: locates the next array element or object member value             *
+ *                                                                            *
+ * Parameters: index - [IN] the json index                                    *
+ *             node  - [IN] the object or array token                         *
+ *             child - [IN] the current element (member value) token or -1 to *
+ *                          get the first element                             *
+ *                                                                            *
+ * Return value: the next element (member value) token or -1 if there are no  *
+ *               more elements                                                *
+ *                                                                            *
+ * Comments: The member name token precedes member value token.               *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_next(const zbx_json_index_t *index, int node, int child)
+{
+	const zbx_json_token_t	*tokens = index->tokens;
+	int			next;
+
+	if ('{' != *tokens[node].start && '[' != *tokens[node].start)
+		return -1;
+
+	next = (-1 == child ? node + 1 : tokens[child].next);
+
+	/* skip object member name */
+	if ('{' == *tokens[node].start)
+		next++;
+
+	return (next < tokens[node].next ? next : -1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_by_name                                           *
+ *                                                                            *
+ * Purpose: locates object member value by its name                           *
+ *                                                                            *
+ * Parameters: index - [IN] the json index                                    *
+ *             node  - [IN] the object token                                  *
+ *             name  - [IN] the member name                                   *
+ *                                                                            *
+ * Return value: the member value token or -1 if the member was not found     *
+ *                                                                            *
+ * Comments: Only member names are compared, member values are skipped        *
+ *           without scanning them.                                           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_by_name(const zbx_json_index_t *index, int node, const char *name)
+{
+	const zbx_json_token_t	*tokens = index->tokens, *token;
+	char			buffer[MAX_STRING_LEN];
+	size_t			len;
+	int			i;
+
+	if ('{' == *tokens[node].start)
+	{
+		len = strlen(name);
+
+		for (i = node + 1; i < tokens[node].next; i = tokens[i + 1].next)
+		{
+			token = &tokens[i];
+
+			if (0 == token->escaped)
+			{
+				if ((size_t)(token->end - token->start - 1) == len && 0 == memcmp(token->start + 1, name, len))
+					return i + 1;
+
+				continue;
+			}
+
+			if (NULL != zbx_json_decodevalue(token->start, buffer, sizeof(buffer), NULL) &&
+					0 == strcmp(buffer, name))
+			{
+				return i + 1;
+			}
+		}
+	}
+
+	zbx_set_json_strerror("cannot find pair with name \"%s\"", name);
+
+	return -1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_parse                                             *
+ *                                                                            *
+ * Purpose: gets json value location of the token                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_json_index_parse(const zbx_json_index_t *index, int node, struct zbx_json_parse *jp)
+{
+	jp->start = index->tokens[node].start;
+	jp->end = index->tokens[node].end;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_brackets_by_name                                  *
+ *                                                                            *
+ * Purpose: opens object member object or array value, see                    *
+ *          zbx_json_brackets_by_name()                                       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_brackets_by_name(const zbx_json_index_t *index, int node, const char *name,
+		struct zbx_json_parse *out)
+{
+	int	value;
+
+	if (-1 == (value = zbx_json_index_by_name(index, node, name)))
+		return FAIL;
+
+	if ('{' != *index->tokens[value].start && '[' != *index->tokens[value].start)
+	{
+		zbx_set_json_strerror("cannot open JSON object or array \"%.64s\"", index->tokens[value].start);
+		return FAIL;
+	}
+
+	zbx_json_index_parse(index, value, out);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_value_by_name                                     *
+ *                                                                            *
+ * Purpose: gets object member value, see zbx_json_value_by_name()            *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_value_by_name(const zbx_json_index_t *index, int node, const char *name, char *string,
+		size_t len)
+{
+	int	value;
+
+	if (-1 == (value = zbx_json_index_by_name(index, node, name)))
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue(index->tokens[value].start, string, len, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_value_by_name_dyn                                 *
+ *                                                                            *
+ * Purpose: gets object member value, see zbx_json_value_by_name_dyn()        *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_value_by_name_dyn(const zbx_json_index_t *index, int node, const char *name, char **string,
+		size_t *string_alloc)
+{
+	int	value;
+
+	if (-1 == (value = zbx_json_index_by_name(index, node, name)))
+		return FAIL;
+
+	if (NULL == zbx_json_decodevalue_dyn(index->tokens[value].start, string, string_alloc, NULL))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/* json index accessor, the node is token number */
+
+static int	json_index_is_array(const void *data, const void *node)
+{
+	const zbx_json_index_t	*index = (const zbx_json_index_t *)data;
+
+	return '[' == *index->tokens[*(const int *)node].start ? SUCCEED : FAIL;
+}
+
+static int	json_index_element(const void *data, void *node, int pos)
+{
+	const zbx_json_index_t	*index = (const zbx_json_index_t *)data;
+	int			child;
+
+	for (child = zbx_json_index_next(index, *(int *)node, -1); -1 != child && 0 != pos; pos--)
+		child = zbx_json_index_next(index, *(int *)node, child);
+
+	if (-1 == child)
+		return FAIL;
+
+	*(int *)node = child;
+
+	return SUCCEED;
+}
+
+static int	json_index_member(const void *data, void *node, const char *name)
+{
+	int	child;
+
+	if (-1 == (child = zbx_json_index_by_name((const zbx_json_index_t *)data, *(int *)node, name)))
+		return FAIL;
+
+	*(int *)node = child;
+
+	return SUCCEED;
+}
+
+static const zbx_json_path_accessor_t	json_index_accessor = {json_index_is_array, json_index_element,
+		json_index_member};
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_index_path_open                                         *
+ *                                                                            *
+ * Purpose: opens an object by compiled json path                             *
+ *                                                                            *
+ * Parameters: index    - [IN] the json index                                 *
+ *             node     - [IN] the token to start from                        *
+ *             jsonpath - [IN] the compiled json path                         *
+ *             out      - [OUT] the located object                            *
+ *                                                                            *
+ * Return value: SUCCEED - processed successfully                             *
+ *               FAIL - an error occurred                                     *
+ *                                                                            *
+ * Comments: Walks the path with the same code as zbx_json_path_open(), only  *
+ *           the json node accessor differs.                                  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_index_path_open(const zbx_json_index_t *index, int node, const zbx_jsonpath_t *jsonpath,
+		struct zbx_json_parse *out)
+{
+	if (SUCCEED != json_path_walk(jsonpath, &json_index_accessor, index, &node))
+		return FAIL;
+
+	zbx_json_index_parse(index, node, out);
+
+	return SUCCEED;
+}
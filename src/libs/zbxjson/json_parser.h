@@ -31,4 +31,10 @@ int	zbx_json_validate(const char *start, char **error);
 
 int	json_parse_value(const char *start, char **error);
 
+#define ZBX_JSONPATH_COMPONENT_DOT	0
+#define ZBX_JSONPATH_COMPONENT_BRACKET	1
+#define ZBX_JSONPATH_ARRAY_INDEX	2
+
+int	zbx_jsonpath_next(const char *path, const char **pnext, zbx_strloc_t *loc, int *type);
+
 #endif
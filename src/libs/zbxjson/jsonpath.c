@@ -0,0 +1,317 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "common.h"
+#include "zbxalgo.h"
+#include "zbxjson.h"
+#include "json_parser.h"
+
+/*
+ * Resolving multiple json paths in a single pass.
+ *
+ * The json paths are merged into a trie of path components, so paths sharing
+ * the same prefix are resolved together. Each json object or array on the
+ * way is iterated only once, looking up its members (elements) in the trie.
+ */
+
+/* json path trie node */
+typedef struct zbx_jsonpath_node
+{
+	/* the parent node, the node member name and array index form hashset key */
+	const struct zbx_jsonpath_node	*parent;
+	char				*name;		/* the member name or NULL for array index */
+	int				index;		/* the array index */
+
+	int				children_num;	/* the number of child nodes */
+	int				paths;		/* the first path ending at this node or -1 */
+	int				resolved;	/* 1 - the node was already resolved */
+}
+zbx_jsonpath_node_t;
+
+typedef struct
+{
+	zbx_hashset_t		nodes;
+	int			*paths_next;	/* the next path ending at the same node or -1 */
+	struct zbx_json_parse	*out;
+	int			*found;
+}
+zbx_jsonpath_trie_t;
+
+static zbx_hash_t	jsonpath_node_hash(const void *data)
+{
+	const zbx_jsonpath_node_t	*node = (const zbx_jsonpath_node_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_PTR_HASH_ALGO(&node->parent, sizeof(node->parent), ZBX_DEFAULT_HASH_SEED);
+
+	if (NULL != node->name)
+		return ZBX_DEFAULT_STRING_HASH_ALGO(node->name, strlen(node->name), hash);
+
+	return ZBX_DEFAULT_HASH_ALGO(&node->index, sizeof(node->index), hash);
+}
+
+static int	jsonpath_node_compare(const void *d1, const void *d2)
+{
+	const zbx_jsonpath_node_t	*n1 = (const zbx_jsonpath_node_t *)d1;
+	const zbx_jsonpath_node_t	*n2 = (const zbx_jsonpath_node_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(n1->parent, n2->parent);
+
+	if (NULL == n1->name || NULL == n2->name)
+	{
+		ZBX_RETURN_IF_NOT_EQUAL(n1->name, n2->name);
+		ZBX_RETURN_IF_NOT_EQUAL(n1->index, n2->index);
+		return 0;
+	}
+
+	return strcmp(n1->name, n2->name);
+}
+
+static void	jsonpath_node_clean(void *data)
+{
+	zbx_free(((zbx_jsonpath_node_t *)data)->name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_trie_add                                                *
+ *                                                                            *
+ * Purpose: adds json path to the trie                                        *
+ *                                                                            *
+ * Parameters: trie  - [IN/OUT] the json path trie                            *
+ *             root  - [IN] the trie root node                                *
+ *             path  - [IN] the json path                                     *
+ *             index - [IN] the json path index                               *
+ *                                                                            *
+ * Return value: SUCCEED - the json path was added                            *
+ *               FAIL    - invalid json path                                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	jsonpath_trie_add(zbx_jsonpath_trie_t *trie, zbx_jsonpath_node_t *root, const char *path, int index)
+{
+	const char		*next = NULL;
+	char			buffer[MAX_STRING_LEN];
+	zbx_strloc_t		loc;
+	int			type;
+	zbx_jsonpath_node_t	*node = root, *child, node_local;
+
+	do
+	{
+		if (FAIL == zbx_jsonpath_next(path, &next, &loc, &type))
+			return FAIL;
+
+		node_local.parent = node;
+
+		if (ZBX_JSONPATH_ARRAY_INDEX == type)
+		{
+			if (FAIL == is_uint_n_range(path + loc.l, loc.r - loc.l + 1, &node_local.index,
+					sizeof(node_local.index), 0, 0xFFFFFFFF))
+			{
+				return FAIL;
+			}
+
+			node_local.name = NULL;
+		}
+		else
+		{
+			zbx_strlcpy(buffer, path + loc.l, loc.r - loc.l + 2);
+			node_local.name = buffer;
+			node_local.index = 0;
+		}
+
+		if (NULL == (child = (zbx_jsonpath_node_t *)zbx_hashset_search(&trie->nodes, &node_local)))
+		{
+			if (NULL != node_local.name)
+				node_local.name = zbx_strdup(NULL, buffer);
+
+			node_local.children_num = 0;
+			node_local.paths = -1;
+			node_local.resolved = 0;
+
+			child = (zbx_jsonpath_node_t *)zbx_hashset_insert(&trie->nodes, &node_local, sizeof(node_local));
+			node->children_num++;
+		}
+
+		node = child;
+	}
+	while ('\0' != *next);
+
+	trie->paths_next[index] = node->paths;
+	node->paths = index;
+
+	return SUCCEED;
+}
+
+static void	jsonpath_trie_resolve_node(zbx_jsonpath_trie_t *trie, const zbx_jsonpath_node_t *node,
+		const struct zbx_json_parse *jp);
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_trie_resolve_child                                      *
+ *                                                                            *
+ * Purpose: resolves json paths going through the child node                  *
+ *                                                                            *
+ * Parameters: trie  - [IN/OUT] the json path trie                            *
+ *             child - [IN] the child node                                    *
+ *             p     - [IN] the child node value location                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonpath_trie_resolve_child(zbx_jsonpath_trie_t *trie, zbx_jsonpath_node_t *child, const char *p)
+{
+	struct zbx_json_parse	object;
+
+	child->resolved = 1;
+
+	if (('{' != *p && '[' != *p) || SUCCEED != zbx_json_brackets_open(p, &object))
+	{
+		object.start = p;
+		object.end = p + json_parse_value(p, NULL) - 1;
+	}
+
+	jsonpath_trie_resolve_node(trie, child, &object);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: jsonpath_trie_resolve_node                                       *
+ *                                                                            *
+ * Purpose: resolves json paths going through the node                        *
+ *                                                                            *
+ * Parameters: trie - [IN/OUT] the json path trie                             *
+ *             node - [IN] the trie node                                      *
+ *             jp   - [IN] the json value located by the node                 *
+ *                                                                            *
+ * Comments: If object contains several members with the same name, the first *
+ *           one is used - the same as zbx_json_path_open() does.             *
+ *                                                                            *
+ ******************************************************************************/
+static void	jsonpath_trie_resolve_node(zbx_jsonpath_trie_t *trie, const zbx_jsonpath_node_t *node,
+		const struct zbx_json_parse *jp)
+{
+	const char		*p = NULL;
+	char			buffer[MAX_STRING_LEN];
+	int			index, resolved_num = 0;
+	zbx_jsonpath_node_t	*child, node_local;
+
+	for (index = node->paths; -1 != index; index = trie->paths_next[index])
+	{
+		trie->out[index] = *jp;
+		trie->found[index] = SUCCEED;
+	}
+
+	if (0 == node->children_num)
+		return;
+
+	node_local.parent = node;
+
+	if ('{' == *jp->start)
+	{
+		node_local.name = buffer;
+		node_local.index = 0;
+
+		while (NULL != (p = zbx_json_pair_next(jp, p, buffer, sizeof(buffer))))
+		{
+			if (NULL == (child = (zbx_jsonpath_node_t *)zbx_hashset_search(&trie->nodes, &node_local)) ||
+					0 != child->resolved)
+			{
+				continue;
+			}
+
+			jsonpath_trie_resolve_child(trie, child, p);
+
+			if (++resolved_num == node->children_num)
+				break;
+		}
+	}
+	else if ('[' == *jp->start)
+	{
+		node_local.name = NULL;
+
+		for (node_local.index = 0; NULL != (p = zbx_json_next(jp, p)); node_local.index++)
+		{
+			if (NULL == (child = (zbx_jsonpath_node_t *)zbx_hashset_search(&trie->nodes, &node_local)))
+				continue;
+
+			jsonpath_trie_resolve_child(trie, child, p);
+
+			if (++resolved_num == node->children_num)
+				break;
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_json_path_open_multi                                         *
+ *                                                                            *
+ * Purpose: opens multiple objects by json paths with a single pass over the  *
+ *          json data                                                         *
+ *                                                                            *
+ * Parameters: jp        - [IN] the json data                                 *
+ *             paths     - [IN] the json paths, NULL paths are skipped        *
+ *             paths_num - [IN] the number of json paths                      *
+ *             out       - [OUT] the located objects                          *
+ *             found     - [OUT] SUCCEED - the object was located by the path *
+ *                               FAIL    - otherwise                          *
+ *                                                                            *
+ * Return value: the number of located objects                                *
+ *                                                                            *
+ * Comments: Supports the same json paths as zbx_json_path_open() and locates *
+ *           the same objects. Error message is not set for paths that were   *
+ *           not found, zbx_json_path_open() can be used to get it.           *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_json_path_open_multi(const struct zbx_json_parse *jp, const char **paths, int paths_num,
+		struct zbx_json_parse *out, int *found)
+{
+	zbx_jsonpath_trie_t	trie;
+	zbx_jsonpath_node_t	root;
+	int			i, found_num = 0;
+
+	memset(&root, 0, sizeof(root));
+	root.paths = -1;
+
+	zbx_hashset_create_ext(&trie.nodes, paths_num, jsonpath_node_hash, jsonpath_node_compare, jsonpath_node_clean,
+			ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
+
+	trie.paths_next = (int *)zbx_malloc(NULL, sizeof(int) * paths_num);
+	trie.out = out;
+	trie.found = found;
+
+	for (i = 0; i < paths_num; i++)
+	{
+		found[i] = FAIL;
+
+		if (NULL != paths[i])
+			jsonpath_trie_add(&trie, &root, paths[i], i);
+	}
+
+	jsonpath_trie_resolve_node(&trie, &root, jp);
+
+	for (i = 0; i < paths_num; i++)
+	{
+		if (SUCCEED == found[i])
+			found_num++;
+	}
+
+	zbx_free(trie.paths_next);
+	zbx_hashset_destroy(&trie.nodes);
+
+	return found_num;
+}
@@ -820,3 +820,14 @@ size_t	zbx_mem_required_size(int chunks_num, const char *descr, const char *para
 
 	return size;
 }
+
+zbx_uint64_t	zbx_mem_required_chunk_size(zbx_uint64_t size)
+{
+	/* the shared memory taken by a chunk allocated for 'size' bytes, including its overhead; */
+	/* larger free chunks are not split if the remainder is too small, so this is a minimum   */
+
+	if (0 == size)
+		return 0;
+
+	return mem_proper_alloc_size(size) + 2 * MEM_SIZE_FIELD;
+}
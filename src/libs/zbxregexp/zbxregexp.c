@@ -39,6 +39,23 @@ zbx_regmatch_t;
 					/* Group \0 contains the matching part of string, groups \1 ...\9 */
 					/* contain captured groups (substrings).                          */
 
+#define ZBX_REGEXP_CACHE_SIZE	32	/* Max number of compiled regular expressions cached per thread.  */
+
+/* compiled regular expression cache entry */
+typedef struct
+{
+	char		*pattern;
+	int		flags;
+	zbx_regexp_t	*regexp;
+}
+zbx_regexp_cache_entry_t;
+
+/* the cached regular expressions, ordered from the most recently used one */
+ZBX_THREAD_LOCAL static zbx_regexp_cache_entry_t	regexp_cache[ZBX_REGEXP_CACHE_SIZE];
+ZBX_THREAD_LOCAL static int				regexp_cache_num = 0;
+ZBX_THREAD_LOCAL static zbx_uint64_t			regexp_cache_hits = 0;
+ZBX_THREAD_LOCAL static zbx_uint64_t			regexp_cache_misses = 0;
+
 /******************************************************************************
  *                                                                            *
  * Function: regexp_compile                                                   *
@@ -94,7 +111,16 @@ static int	regexp_compile(const char *pattern, int flags, zbx_regexp_t **regexp,
 
 	if (NULL != regexp)
 	{
-		if (NULL == (extra = pcre_study(pcre_regexp, 0, err_msg_static)) && NULL != *err_msg_static)
+		int	study_options = 0;
+
+#ifdef PCRE_STUDY_JIT_COMPILE
+		int	jit = 0;
+
+		/* use just-in-time compilation if pcre library was built with it */
+		if (0 == pcre_config(PCRE_CONFIG_JIT, &jit) && 0 != jit)
+			study_options |= PCRE_STUDY_JIT_COMPILE;
+#endif
+		if (NULL == (extra = pcre_study(pcre_regexp, study_options, err_msg_static)) && NULL != *err_msg_static)
 		{
 			pcre_free(pcre_regexp);
 			return FAIL;
@@ -142,39 +168,78 @@ int	zbx_regexp_compile_ext(const char *pattern, zbx_regexp_t **regexp, int flags
  *                                                                                                  *
  * Function: regexp_prepare                                                                         *
  *                                                                                                  *
- * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the last used regexp.                 *
+ * Purpose: wrapper for zbx_regexp_compile. Caches and reuses the recently used regexps.            *
+ *                                                                                                  *
+ * Comments: The returned regexp is valid until the next call of this function.                     *
  *                                                                                                  *
  ****************************************************************************************************/
 static int	regexp_prepare(const char *pattern, int flags, zbx_regexp_t **regexp, const char **err_msg_static)
 {
-	ZBX_THREAD_LOCAL static zbx_regexp_t	*curr_regexp = NULL;
-	ZBX_THREAD_LOCAL static char		*curr_pattern = NULL;
-	ZBX_THREAD_LOCAL static int		curr_flags = 0;
-	int					ret = SUCCEED;
+	int				i;
+	zbx_regexp_cache_entry_t	entry;
 
-	if (NULL == curr_regexp || 0 != strcmp(curr_pattern, pattern) || curr_flags != flags)
+	for (i = 0; i < regexp_cache_num; i++)
 	{
-		if (NULL != curr_regexp)
+		if (regexp_cache[i].flags == flags && 0 == strcmp(regexp_cache[i].pattern, pattern))
+			break;
+	}
+
+	if (i < regexp_cache_num)
+	{
+		regexp_cache_hits++;
+		entry = regexp_cache[i];
+	}
+	else
+	{
+		regexp_cache_misses++;
+
+		if (SUCCEED != regexp_compile(pattern, flags, &entry.regexp, err_msg_static))
 		{
-			zbx_regexp_free(curr_regexp);
-			zbx_free(curr_pattern);
+			*regexp = NULL;
+			return FAIL;
 		}
 
-		curr_regexp = NULL;
-		curr_pattern = NULL;
-		curr_flags = 0;
+		entry.pattern = zbx_strdup(NULL, pattern);
+		entry.flags = flags;
 
-		if (SUCCEED == regexp_compile(pattern, flags, &curr_regexp, err_msg_static))
+		/* drop the least recently used regexp */
+		if (ZBX_REGEXP_CACHE_SIZE == regexp_cache_num)
 		{
-			curr_pattern = zbx_strdup(curr_pattern, pattern);
-			curr_flags = flags;
+			i = --regexp_cache_num;
+			zbx_regexp_free(regexp_cache[i].regexp);
+			zbx_free(regexp_cache[i].pattern);
 		}
 		else
-			ret = FAIL;
+			i = regexp_cache_num;
+
+		regexp_cache_num++;
 	}
 
-	*regexp = curr_regexp;
-	return ret;
+	/* move the regexp to the head of cache */
+	if (0 != i)
+		memmove(regexp_cache + 1, regexp_cache, sizeof(zbx_regexp_cache_entry_t) * i);
+
+	regexp_cache[0] = entry;
+	*regexp = entry.regexp;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_regexp_cache_stats                                           *
+ *                                                                            *
+ * Purpose: gets compiled regular expression cache statistics of the calling  *
+ *          thread                                                            *
+ *                                                                            *
+ * Parameters: hits   - [OUT] the number of regexps found in cache            *
+ *             misses - [OUT] the number of regexps compiled                  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_regexp_cache_stats(zbx_uint64_t *hits, zbx_uint64_t *misses)
+{
+	*hits = regexp_cache_hits;
+	*misses = regexp_cache_misses;
 }
 
 /***********************************************************************************
@@ -227,7 +292,17 @@ static int	regexp_exec(const char *string, const zbx_regexp_t *regexp, int flags
 	pextra->match_limit_recursion = 1000000;
 #endif
 	/* see "man pcreapi" about pcre_exec() return value and 'ovector' size and layout */
-	if (0 <= (r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize)))
+	r = pcre_exec(regexp->pcre_regexp, pextra, string, strlen(string), flags, 0, ovector, ovecsize);
+#if defined(PCRE_ERROR_JIT_STACKLIMIT) && defined(PCRE_EXTRA_EXECUTABLE_JIT)
+	/* JIT code uses a small machine stack, fall back to the interpreter which obeys the match limits above */
+	if (PCRE_ERROR_JIT_STACKLIMIT == r)
+	{
+		extra = *pextra;
+		extra.flags &= ~PCRE_EXTRA_EXECUTABLE_JIT;
+		r = pcre_exec(regexp->pcre_regexp, &extra, string, strlen(string), flags, 0, ovector, ovecsize);
+	}
+#endif
+	if (0 <= r)
 	{
 		if (NULL != matches)
 			memcpy(matches, ovector, (size_t)((0 < r) ? MIN(r, count) : count) * sizeof(zbx_regmatch_t));
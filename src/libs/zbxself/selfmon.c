@@ -117,6 +117,9 @@ extern int	CONFIG_PREPROCMAN_FORKS;
 extern int	CONFIG_PREPROCESSOR_FORKS;
 extern int	CONFIG_LLDMANAGER_FORKS;
 extern int	CONFIG_LLDWORKER_FORKS;
+extern int	CONFIG_AGENTPOLLER_FORKS;
+extern int	CONFIG_HTTPAGENTPOLLER_FORKS;
+extern int	CONFIG_SNMPPOLLER_FORKS;
 
 extern unsigned char	process_type;
 extern int		process_num;
@@ -198,6 +201,12 @@ int	get_process_type_forks(unsigned char proc_type)
 			return CONFIG_LLDMANAGER_FORKS;
 		case ZBX_PROCESS_TYPE_LLDWORKER:
 			return CONFIG_LLDWORKER_FORKS;
+		case ZBX_PROCESS_TYPE_AGENTPOLLER:
+			return CONFIG_AGENTPOLLER_FORKS;
+		case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+			return CONFIG_HTTPAGENTPOLLER_FORKS;
+		case ZBX_PROCESS_TYPE_SNMPPOLLER:
+			return CONFIG_SNMPPOLLER_FORKS;
 	}
 
 	THIS_SHOULD_NEVER_HAPPEN;
@@ -1654,76 +1654,146 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: evaluate_NODATA                                                  *
+ * Function: evaluate_nodata_functions                                        *
  *                                                                            *
- * Purpose: evaluate function 'nodata' for the item                           *
+ * Purpose: evaluate multiple 'nodata' functions of the same item             *
  *                                                                            *
- * Parameters: item - item (performance metric)                               *
- *             parameter - number of seconds                                  *
+ * Parameters: item      - [IN] item (performance metric)                     *
+ *             funcs     - [IN/OUT] the nodata functions to evaluate          *
+ *             funcs_num - [IN] the number of functions                       *
  *                                                                            *
- * Return value: SUCCEED - evaluated successfully, result is stored in 'value'*
- *               FAIL - failed to evaluate function                           *
+ * Comments: All functions are evaluated with a single value cache request    *
+ *           covering the longest of the requested periods.                   *
  *                                                                            *
  ******************************************************************************/
-static int	evaluate_NODATA(char *value, DC_ITEM *item, const char *parameters, char **error)
+void	evaluate_nodata_functions(DC_ITEM *item, zbx_nodata_func_t *funcs, int funcs_num)
 {
-	const char			*__function_name = "evaluate_NODATA";
-	int				arg1, ret = FAIL;
+	const char			*__function_name = "evaluate_nodata_functions";
+	int				i, *periods, period_max = 0, seconds, expected_ret = FAIL, expected = 0;
 	zbx_value_type_t		arg1_type;
 	zbx_vector_history_record_t	values;
-	zbx_timespec_t			ts;
+	zbx_timespec_t			ts, start;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid:" ZBX_FS_UI64 " funcs_num:%d", __function_name, item->itemid,
+			funcs_num);
 
 	zbx_history_record_vector_create(&values);
+	periods = (int *)zbx_malloc(NULL, sizeof(int) * (size_t)funcs_num);
 
-	if (1 < num_param(parameters))
+	for (i = 0; i < funcs_num; i++)
 	{
-		*error = zbx_strdup(*error, "invalid number of parameters");
-		goto out;
+		funcs[i].ret = FAIL;
+		periods[i] = 0;
+
+		if (1 < num_param(funcs[i].parameter))
+		{
+			funcs[i].error = zbx_strdup(funcs[i].error, "invalid number of parameters");
+			continue;
+		}
+
+		if (SUCCEED != get_function_parameter_int(item->host.hostid, funcs[i].parameter, 1,
+				ZBX_PARAM_MANDATORY, &periods[i], &arg1_type) || ZBX_VALUE_SECONDS != arg1_type ||
+				0 >= periods[i])
+		{
+			funcs[i].error = zbx_strdup(funcs[i].error, "invalid first parameter");
+			periods[i] = 0;
+			continue;
+		}
+
+		if (periods[i] > period_max)
+			period_max = periods[i];
 	}
 
-	if (SUCCEED != get_function_parameter_int(item->host.hostid, parameters, 1, ZBX_PARAM_MANDATORY, &arg1,
-			&arg1_type) || ZBX_VALUE_SECONDS != arg1_type || 0 >= arg1)
-	{
-		*error = zbx_strdup(*error, "invalid first parameter");
+	if (0 == period_max)
 		goto out;
-	}
 
 	zbx_timespec(&ts);
 
-	if (SUCCEED == zbx_vc_get_values(item->itemid, item->value_type, &values, arg1, 1, &ts) &&
-			1 == values.values_num)
-	{
-		zbx_strlcpy(value, "0", MAX_BUFFER_LEN);
-	}
-	else
+	/* the latest value within the longest period answers all functions */
+	if (SUCCEED != zbx_vc_get_values(item->itemid, item->value_type, &values, period_max, 1, &ts))
+		values.values_num = 0;
+
+	for (i = 0; i < funcs_num; i++)
 	{
-		int	seconds;
+		if (0 == periods[i])
+			continue;
+
+		start.sec = ts.sec - periods[i];
+		start.ns = ts.ns;
 
-		if (SUCCEED != DCget_data_expected_from(item->itemid, &seconds))
+		if (1 == values.values_num && 0 < zbx_timespec_compare(&values.values[0].timestamp, &start))
 		{
-			*error = zbx_strdup(*error, "item does not exist, is disabled or belongs to a disabled host");
-			goto out;
+			funcs[i].result = 0;
+			funcs[i].ret = SUCCEED;
+			continue;
+		}
+
+		if (0 == expected)
+		{
+			expected_ret = DCget_data_expected_from(item->itemid, &seconds);
+			expected = 1;
+		}
+
+		if (SUCCEED != expected_ret)
+		{
+			funcs[i].error = zbx_strdup(funcs[i].error,
+					"item does not exist, is disabled or belongs to a disabled host");
+			continue;
 		}
 
-		if (seconds + arg1 > ts.sec)
+		if (seconds + periods[i] > ts.sec)
 		{
-			*error = zbx_strdup(*error,
+			funcs[i].error = zbx_strdup(funcs[i].error,
 					"item does not have enough data after server start or item creation");
-			goto out;
+			continue;
 		}
 
-		zbx_strlcpy(value, "1", MAX_BUFFER_LEN);
+		funcs[i].result = 1;
+		funcs[i].ret = SUCCEED;
 	}
-
-	ret = SUCCEED;
 out:
+	zbx_free(periods);
 	zbx_history_record_vector_destroy(&values, item->value_type);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
 
-	return ret;
+/******************************************************************************
+ *                                                                            *
+ * Function: evaluate_NODATA                                                  *
+ *                                                                            *
+ * Purpose: evaluate function 'nodata' for the item                           *
+ *                                                                            *
+ * Parameters: item - item (performance metric)                               *
+ *             parameter - number of seconds                                  *
+ *                                                                            *
+ * Return value: SUCCEED - evaluated successfully, result is stored in 'value'*
+ *               FAIL - failed to evaluate function                           *
+ *                                                                            *
+ ******************************************************************************/
+static int	evaluate_NODATA(char *value, DC_ITEM *item, const char *parameters, char **error)
+{
+	const char		*__function_name = "evaluate_NODATA";
+	zbx_nodata_func_t	func;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+
+	func.parameter = parameters;
+	func.error = NULL;
+
+	evaluate_nodata_functions(item, &func, 1);
+
+	if (SUCCEED == func.ret)
+		zbx_snprintf(value, MAX_BUFFER_LEN, "%d", func.result);
+	else
+	{
+		zbx_free(*error);
+		*error = func.error;
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(func.ret));
+
+	return func.ret;
 }
 
 /******************************************************************************
@@ -20,8 +20,23 @@
 #ifndef ZABBIX_EVALFUNC_H
 #define ZABBIX_EVALFUNC_H
 
+#include "dbcache.h"
+
+typedef struct
+{
+	/* input data */
+	const char	*parameter;
+
+	/* output data */
+	int		ret;
+	int		result;
+	char		*error;
+}
+zbx_nodata_func_t;
+
 int	evaluate_macro_function(char **result, const char *host, const char *key, const char *function,
 		const char *parameter);
 int	evaluatable_for_notsupported(const char *fn);
+void	evaluate_nodata_functions(DC_ITEM *item, zbx_nodata_func_t *funcs, int funcs_num);
 
 #endif
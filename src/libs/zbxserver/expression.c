@@ -4719,15 +4719,130 @@ static void	zbx_populate_function_items(const zbx_vector_uint64_t *functionids,
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() ifuncs_num:%d", __function_name, ifuncs->num_data);
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: func_set_result                                                  *
+ *                                                                            *
+ * Purpose: store function evaluation result or compose 'unknown' message     *
+ *                                                                            *
+ * Parameters: func         - [IN/OUT] the function                           *
+ *             item         - [IN] the function item                          *
+ *             ret          - [IN] the function evaluation result             *
+ *             value        - [IN] the function value (if ret is SUCCEED)     *
+ *             error        - [IN] the evaluation error, freed by this        *
+ *                                 function (optional)                        *
+ *             unknown_msgs - [IN/OUT] the 'unknown' messages                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	func_set_result(zbx_func_t *func, const DC_ITEM *item, int ret, const char *value, char *error,
+		zbx_vector_ptr_t *unknown_msgs)
+{
+	char	*unknown_msg;
+
+	if (SUCCEED == ret)
+	{
+		func->value = zbx_strdup(func->value, value);
+		return;
+	}
+
+	/* compose and store error message for future use */
+	if (NULL != error)
+	{
+		unknown_msg = zbx_dsprintf(NULL, "Cannot evaluate function \"%s:%s.%s(%s)\": %s.",
+				item->host.host, item->key_orig, func->function, func->parameter, error);
+		zbx_free(error);
+	}
+	else
+	{
+		unknown_msg = zbx_dsprintf(NULL, "Cannot evaluate function \"%s:%s.%s(%s)\".",
+				item->host.host, item->key_orig, func->function, func->parameter);
+	}
+
+	zbx_free(func->error);
+	zbx_vector_ptr_append(unknown_msgs, unknown_msg);
+
+	/* write a special token of unknown value with 'unknown' message number, like */
+	/* ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. not wrapped in () */
+	func->value = zbx_dsprintf(func->value, ZBX_UNKNOWN_STR "%d", unknown_msgs->values_num - 1);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_evaluate_nodata_functions                                    *
+ *                                                                            *
+ * Purpose: evaluate nodata() functions of a single item in one batch         *
+ *                                                                            *
+ * Parameters: item         - [IN] the functions item                         *
+ *             funcs        - [IN/OUT] the nodata() functions                 *
+ *             unknown_msgs - [IN/OUT] the 'unknown' messages                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_evaluate_nodata_functions(DC_ITEM *item, zbx_vector_ptr_t *funcs, zbx_vector_ptr_t *unknown_msgs)
+{
+	zbx_nodata_func_t	*nodata;
+	zbx_func_t		*func;
+	char			value[MAX_ID_LEN];
+	int			i;
+
+	nodata = (zbx_nodata_func_t *)zbx_malloc(NULL, sizeof(zbx_nodata_func_t) * (size_t)funcs->values_num);
+
+	for (i = 0; i < funcs->values_num; i++)
+	{
+		func = (zbx_func_t *)funcs->values[i];
+		nodata[i].parameter = func->parameter;
+		nodata[i].error = NULL;
+	}
+
+	evaluate_nodata_functions(item, nodata, funcs->values_num);
+
+	for (i = 0; i < funcs->values_num; i++)
+	{
+		func = (zbx_func_t *)funcs->values[i];
+
+		if (SUCCEED == nodata[i].ret)
+			zbx_snprintf(value, sizeof(value), "%d", nodata[i].result);
+
+		func_set_result(func, item, nodata[i].ret, value, nodata[i].error, unknown_msgs);
+	}
+
+	zbx_free(nodata);
+	zbx_vector_ptr_clear(funcs);
+}
+
+static int	func_itemid_compare_func(const void *d1, const void *d2)
+{
+	const zbx_func_t	*func1 = *(const zbx_func_t * const *)d1;
+	const zbx_func_t	*func2 = *(const zbx_func_t * const *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(func1->itemid, func2->itemid);
+
+	return 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_evaluate_item_functions                                      *
+ *                                                                            *
+ * Purpose: evaluate trigger functions                                        *
+ *                                                                            *
+ * Parameters: funcs        - [IN/OUT] functions indexed by itemid, name,     *
+ *                                     parameter, timestamp                   *
+ *             unknown_msgs - [IN/OUT] the 'unknown' messages                 *
+ *                                                                            *
+ * Comments: Functions are evaluated grouped by item, nodata() functions of   *
+ *           the same item are evaluated with a single value cache request.   *
+ *                                                                            *
+ ******************************************************************************/
 static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *unknown_msgs)
 {
 	const char	*__function_name = "zbx_evaluate_item_functions";
 
 	DC_ITEM			*items = NULL;
 	char			value[MAX_BUFFER_LEN], *error = NULL;
-	int			i;
+	int			i, j, ret;
 	zbx_func_t		*func;
 	zbx_vector_uint64_t	itemids;
+	zbx_vector_ptr_t	funcs_sorted, nodata_funcs;
 	int			*errcodes = NULL;
 	zbx_hashset_iter_t	iter;
 
@@ -4735,24 +4850,29 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 
 	zbx_vector_uint64_create(&itemids);
 	zbx_vector_uint64_reserve(&itemids, funcs->num_data);
+	zbx_vector_ptr_create(&funcs_sorted);
+	zbx_vector_ptr_reserve(&funcs_sorted, funcs->num_data);
+	zbx_vector_ptr_create(&nodata_funcs);
 
 	zbx_hashset_iter_reset(funcs, &iter);
 	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	{
 		zbx_vector_uint64_append(&itemids, func->itemid);
+		zbx_vector_ptr_append(&funcs_sorted, func);
+	}
 
 	zbx_vector_uint64_sort(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 	zbx_vector_uint64_uniq(&itemids, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
+	zbx_vector_ptr_sort(&funcs_sorted, func_itemid_compare_func);
 
 	items = (DC_ITEM *)zbx_malloc(items, sizeof(DC_ITEM) * (size_t)itemids.values_num);
 	errcodes = (int *)zbx_malloc(errcodes, sizeof(int) * (size_t)itemids.values_num);
 
 	DCconfig_get_items_by_itemids(items, itemids.values, errcodes, itemids.values_num);
 
-	zbx_hashset_iter_reset(funcs, &iter);
-	while (NULL != (func = (zbx_func_t *)zbx_hashset_iter_next(&iter)))
+	for (j = 0; j < funcs_sorted.values_num; j++)
 	{
-		int	ret_unknown = 0;	/* flag raised if current function evaluates to ZBX_UNKNOWN */
-		char	*unknown_msg;
+		func = (zbx_func_t *)funcs_sorted.values[j];
 
 		i = zbx_vector_uint64_bsearch(&itemids, func->itemid, ZBX_DEFAULT_UINT64_COMPARE_FUNC);
 
@@ -4790,58 +4910,34 @@ static void	zbx_evaluate_item_functions(zbx_hashset_t *funcs, zbx_vector_ptr_t *
 		if (ITEM_STATE_NOTSUPPORTED == items[i].state && FAIL == evaluatable_for_notsupported(func->function))
 		{
 			/* compose and store 'unknown' message for future use */
-			unknown_msg = zbx_dsprintf(NULL,
-					"Cannot evaluate function \"%s:%s.%s(%s)\": item is not supported.",
-					items[i].host.host, items[i].key_orig, func->function, func->parameter);
-
-			zbx_free(func->error);
-			zbx_vector_ptr_append(unknown_msgs, unknown_msg);
-			ret_unknown = 1;
+			error = zbx_strdup(NULL, "item is not supported");
+			func_set_result(func, &items[i], FAIL, NULL, error, unknown_msgs);
+			error = NULL;
 		}
-
-		if (0 == ret_unknown && SUCCEED != evaluate_function(value, &items[i], func->function,
-				func->parameter, &func->timespec, &error))
+		else if (0 == strcmp(func->function, "nodata"))
 		{
-			/* compose and store error message for future use */
-			if (NULL != error)
-			{
-				unknown_msg = zbx_dsprintf(NULL,
-						"Cannot evaluate function \"%s:%s.%s(%s)\": %s.",
-						items[i].host.host, items[i].key_orig, func->function,
-						func->parameter, error);
-
-				zbx_free(func->error);
-				zbx_free(error);
-			}
-			else
-			{
-				unknown_msg = zbx_dsprintf(NULL,
-						"Cannot evaluate function \"%s:%s.%s(%s)\".",
-						items[i].host.host, items[i].key_orig,
-						func->function, func->parameter);
-
-				zbx_free(func->error);
-			}
-
-			zbx_vector_ptr_append(unknown_msgs, unknown_msg);
-			ret_unknown = 1;
+			/* nodata() functions are evaluated together after the last function of the item */
+			zbx_vector_ptr_append(&nodata_funcs, func);
 		}
-
-		if (0 == ret_unknown)
+		else
 		{
-			func->value = zbx_strdup(func->value, value);
+			ret = evaluate_function(value, &items[i], func->function, func->parameter, &func->timespec,
+					&error);
+			func_set_result(func, &items[i], ret, value, error, unknown_msgs);
+			error = NULL;
 		}
-		else
+
+		if (0 != nodata_funcs.values_num && (j + 1 == funcs_sorted.values_num ||
+				((zbx_func_t *)funcs_sorted.values[j + 1])->itemid != func->itemid))
 		{
-			/* write a special token of unknown value with 'unknown' message number, like */
-			/* ZBX_UNKNOWN0, ZBX_UNKNOWN1 etc. not wrapped in () */
-			func->value = zbx_dsprintf(func->value, ZBX_UNKNOWN_STR "%d",
-					unknown_msgs->values_num - 1);
+			zbx_evaluate_nodata_functions(&items[i], &nodata_funcs, unknown_msgs);
 		}
 	}
 
 	DCconfig_clean_items(items, errcodes, itemids.values_num);
 	zbx_vector_uint64_destroy(&itemids);
+	zbx_vector_ptr_destroy(&funcs_sorted);
+	zbx_vector_ptr_destroy(&nodata_funcs);
 
 	zbx_free(errcodes);
 	zbx_free(items);
@@ -41,9 +41,10 @@ void	zbx_get_zabbix_stats(struct zbx_json *json)
 {
 	zbx_config_cache_info_t	count_stats;
 	zbx_vmware_stats_t	vmware_stats;
+	zbx_uint64_t		vmware_memory[ZBX_VMWARE_MEMORY_COUNT];
 	zbx_wcache_info_t	wcache_info;
 	zbx_process_info_t	process_stats[ZBX_PROCESS_TYPE_COUNT];
-	int			proc_type;
+	int			proc_type, i;
 
 	DCget_count_stats_all(&count_stats);
 
@@ -132,6 +133,18 @@ void	zbx_get_zabbix_stats(struct zbx_json *json)
 				vmware_stats.memory_total * 100);
 		zbx_json_adduint64(json, "used", vmware_stats.memory_used);
 		zbx_json_addfloat(json, "pused", (double)vmware_stats.memory_used / vmware_stats.memory_total * 100);
+
+		/* zabbix[vmware,memory,<structure>] */
+		if (SUCCEED == zbx_vmware_get_memory_usage(vmware_memory))
+		{
+			zbx_json_addobject(json, "memory");
+
+			for (i = 0; i < ZBX_VMWARE_MEMORY_COUNT; i++)
+				zbx_json_adduint64(json, zbx_vmware_memory_string(i), vmware_memory[i]);
+
+			zbx_json_close(json);
+		}
+
 		zbx_json_close(json);
 	}
 
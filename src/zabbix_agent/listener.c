@@ -26,6 +26,7 @@
 #include "stats.h"
 #include "sysinfo.h"
 #include "log.h"
+#include "zbxjson.h"
 
 extern unsigned char			program_type;
 extern ZBX_THREAD_LOCAL unsigned char	process_type;
@@ -40,11 +41,106 @@ extern ZBX_THREAD_LOCAL int		server_num, process_num;
 #include "../libs/zbxcrypto/tls.h"
 #include "../libs/zbxcrypto/tls_tcp_active.h"
 
+/******************************************************************************
+ *                                                                            *
+ * Function: process_passive_checks                                           *
+ *                                                                            *
+ * Purpose: processes bulk request of passive checks                          *
+ *                                                                            *
+ * Parameters: s  - [IN] the connection socket                                *
+ *             jp - [IN] the request                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the response was sent successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The values are returned in the same order as the keys were       *
+ *           requested:                                                       *
+ *             {"request":"passive checks","data":[{"key":"<key>"},...]}      *
+ *             {"response":"success","data":[{"value":"<value>"},             *
+ *                     {"error":"<error>"},...]}                              *
+ *           All keys share the Timeout budget. Once it is spent the          *
+ *           remaining keys are not evaluated and errors are returned for     *
+ *           them, so the response is sent before the server gives up.        *
+ *                                                                            *
+ ******************************************************************************/
+static int	process_passive_checks(zbx_socket_t *s, const struct zbx_json_parse *jp)
+{
+	struct zbx_json		json;
+	struct zbx_json_parse	jp_data, jp_row;
+	AGENT_RESULT		result;
+	const char		*p = NULL;
+	char			*key = NULL, **value;
+	size_t			key_alloc = 0;
+	int			ret;
+	double			deadline;
+
+	deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&json, ZBX_PROTO_TAG_RESPONSE, ZBX_PROTO_VALUE_SUCCESS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&json, ZBX_PROTO_TAG_DATA);
+
+	if (SUCCEED == zbx_json_brackets_by_name(jp, ZBX_PROTO_TAG_DATA, &jp_data))
+	{
+		while (NULL != (p = zbx_json_next(&jp_data, p)))
+		{
+			zbx_json_addobject(&json, NULL);
+
+			if (SUCCEED != zbx_json_brackets_open(p, &jp_row) ||
+					SUCCEED != zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_KEY, &key, &key_alloc))
+			{
+				zbx_json_addstring(&json, ZBX_PROTO_TAG_ERROR, "Invalid request format.",
+						ZBX_JSON_TYPE_STRING);
+				zbx_json_close(&json);
+				continue;
+			}
+
+			if (zbx_time() >= deadline)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]: [" ZBX_NOTSUPPORTED ": timeout]", key);
+				zbx_json_addstring(&json, ZBX_PROTO_TAG_ERROR, "Timeout while processing bulk request.",
+						ZBX_JSON_TYPE_STRING);
+				zbx_json_close(&json);
+				continue;
+			}
+
+			init_result(&result);
+
+			if (SUCCEED == process(key, PROCESS_WITH_ALIAS, &result) &&
+					NULL != (value = GET_TEXT_RESULT(&result)))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]: [%s]", key, *value);
+				zbx_json_addstring(&json, ZBX_PROTO_TAG_VALUE, *value, ZBX_JSON_TYPE_STRING);
+			}
+			else
+			{
+				value = GET_MSG_RESULT(&result);
+
+				zabbix_log(LOG_LEVEL_DEBUG, "Sending back [%s]: [" ZBX_NOTSUPPORTED ": %s]", key,
+						NULL != value ? *value : "");
+				zbx_json_addstring(&json, ZBX_PROTO_TAG_ERROR, NULL != value ? *value : "",
+						ZBX_JSON_TYPE_STRING);
+			}
+
+			free_result(&result);
+			zbx_json_close(&json);
+		}
+	}
+
+	ret = zbx_tcp_send_to(s, json.buffer, CONFIG_TIMEOUT);
+
+	zbx_free(key);
+	zbx_json_free(&json);
+
+	return ret;
+}
+
 static void	process_listener(zbx_socket_t *s)
 {
-	AGENT_RESULT	result;
-	char		**value = NULL;
-	int		ret;
+	AGENT_RESULT		result;
+	struct zbx_json_parse	jp;
+	char			**value = NULL, request[MAX_STRING_LEN];
+	int			ret;
 
 	if (SUCCEED == (ret = zbx_tcp_recv_to(s, CONFIG_TIMEOUT)))
 	{
@@ -52,6 +148,15 @@ static void	process_listener(zbx_socket_t *s)
 
 		zabbix_log(LOG_LEVEL_DEBUG, "Requested [%s]", s->buffer);
 
+		/* item keys cannot start with '{', so older servers never send such requests */
+		if ('{' == *s->buffer && SUCCEED == zbx_json_open(s->buffer, &jp) &&
+				SUCCEED == zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_REQUEST, request, sizeof(request)) &&
+				0 == strcmp(request, ZBX_PROTO_VALUE_PASSIVE_CHECKS))
+		{
+			ret = process_passive_checks(s, &jp);
+			goto out;
+		}
+
 		init_result(&result);
 
 		if (SUCCEED == process(s->buffer, PROCESS_WITH_ALIAS, &result))
@@ -94,7 +199,7 @@ static void	process_listener(zbx_socket_t *s)
 
 		free_result(&result);
 	}
-
+out:
 	if (FAIL == ret)
 		zabbix_log(LOG_LEVEL_DEBUG, "Process listener error: %s", zbx_socket_strerror());
 }
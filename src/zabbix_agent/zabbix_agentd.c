@@ -269,6 +269,9 @@ int	CONFIG_PREPROCMAN_FORKS		= 0;
 int	CONFIG_PREPROCESSOR_FORKS	= 0;
 int	CONFIG_LLDMANAGER_FORKS		= 0;
 int	CONFIG_LLDWORKER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_HTTPAGENTPOLLER_FORKS	= 0;
+int	CONFIG_SNMPPOLLER_FORKS		= 0;
 
 char	*opt = NULL;
 
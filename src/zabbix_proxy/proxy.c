@@ -44,6 +44,7 @@
 #include "housekeeper/housekeeper.h"
 #include "../zabbix_server/pinger/pinger.h"
 #include "../zabbix_server/poller/poller.h"
+#include "../zabbix_server/poller/checks_snmp.h"
 #include "../zabbix_server/trapper/trapper.h"
 #include "../zabbix_server/trapper/proxydata.h"
 #include "../zabbix_server/snmptrapper/snmptrapper.h"
@@ -86,6 +87,7 @@ const char	*help_message[] = {
 	"    Runtime control options:",
 	"      " ZBX_CONFIG_CACHE_RELOAD "        Reload configuration cache",
 	"      " ZBX_HOUSEKEEPER_EXECUTE "        Execute the housekeeper",
+	"      " ZBX_IPC_STATS "                  Log IPC service statistics",
 	"      " ZBX_LOG_LEVEL_INCREASE "=target  Increase log level, affects all processes if",
 	"                                 target is not specified",
 	"      " ZBX_LOG_LEVEL_DECREASE "=target  Decrease log level, affects all processes if",
@@ -155,6 +157,9 @@ int	CONFIG_IPMIPOLLER_FORKS		= 0;
 int	CONFIG_TRAPPER_FORKS		= 5;
 int	CONFIG_SNMPTRAPPER_FORKS	= 0;
 int	CONFIG_JAVAPOLLER_FORKS		= 0;
+int	CONFIG_AGENTPOLLER_FORKS	= 0;
+int	CONFIG_HTTPAGENTPOLLER_FORKS	= 0;
+int	CONFIG_SNMPPOLLER_FORKS		= 0;
 int	CONFIG_SELFMON_FORKS		= 1;
 int	CONFIG_PROXYPOLLER_FORKS	= 0;
 int	CONFIG_ESCALATOR_FORKS		= 0;
@@ -194,6 +199,8 @@ int	CONFIG_VMWARE_FORKS		= 0;
 int	CONFIG_VMWARE_FREQUENCY		= 60;
 int	CONFIG_VMWARE_PERF_FREQUENCY	= 60;
 int	CONFIG_VMWARE_TIMEOUT		= 10;
+int	CONFIG_VMWARE_INCREMENTAL_UPDATE	= 0;
+int	CONFIG_VMWARE_PERF_CONCURRENCY	= 1;
 
 zbx_uint64_t	CONFIG_CONF_CACHE_SIZE		= 8 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_HISTORY_CACHE_SIZE	= 16 * ZBX_MEBIBYTE;
@@ -201,14 +208,19 @@ zbx_uint64_t	CONFIG_HISTORY_INDEX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
 zbx_uint64_t	CONFIG_TRENDS_CACHE_SIZE	= 0;
 zbx_uint64_t	CONFIG_VALUE_CACHE_SIZE		= 0;
 zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE	= 8 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_SNMPIDX_CACHE_SIZE	= 4 * ZBX_MEBIBYTE;
+zbx_uint64_t	CONFIG_PREPROCESSOR_RING_SIZE	= 0;
 zbx_uint64_t	CONFIG_EXPORT_FILE_SIZE;
 
 int	CONFIG_UNREACHABLE_PERIOD	= 45;
 int	CONFIG_UNREACHABLE_DELAY	= 15;
 int	CONFIG_UNAVAILABLE_DELAY	= 60;
+int	CONFIG_ODBC_POOL_SIZE		= 8;
+int	CONFIG_ODBC_POOL_IDLE_TIMEOUT	= 60;
 int	CONFIG_LOG_LEVEL		= LOG_LEVEL_WARNING;
 char	*CONFIG_ALERT_SCRIPTS_PATH	= NULL;
 char	*CONFIG_EXTERNALSCRIPTS		= NULL;
+char	*CONFIG_EXTERNALSCRIPTS_PERSISTENT	= NULL;
 char	*CONFIG_TMPDIR			= NULL;
 char	*CONFIG_FPING_LOCATION		= NULL;
 char	*CONFIG_FPING6_LOCATION		= NULL;
@@ -235,6 +247,8 @@ char	*CONFIG_JAVA_GATEWAY		= NULL;
 int	CONFIG_JAVA_GATEWAY_PORT	= ZBX_DEFAULT_GATEWAY_PORT;
 
 char	*CONFIG_SSH_KEY_LOCATION	= NULL;
+int	CONFIG_SSH_SESSION_POOL_SIZE	= 100;
+int	CONFIG_SSH_SESSION_IDLE_TIMEOUT	= 60;
 
 int	CONFIG_LOG_SLOW_QUERIES		= 0;	/* ms; 0 - disable */
 
@@ -335,6 +349,21 @@ int	get_process_info_by_thread(int local_server_num, unsigned char *local_proces
 		*local_process_type = ZBX_PROCESS_TYPE_JAVAPOLLER;
 		*local_process_num = local_server_num - server_count + CONFIG_JAVAPOLLER_FORKS;
 	}
+	else if (local_server_num <= (server_count += CONFIG_AGENTPOLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_AGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_AGENTPOLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_HTTPAGENTPOLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_HTTPAGENTPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_HTTPAGENTPOLLER_FORKS;
+	}
+	else if (local_server_num <= (server_count += CONFIG_SNMPPOLLER_FORKS))
+	{
+		*local_process_type = ZBX_PROCESS_TYPE_SNMPPOLLER;
+		*local_process_num = local_server_num - server_count + CONFIG_SNMPPOLLER_FORKS;
+	}
 	else if (local_server_num <= (server_count += CONFIG_SNMPTRAPPER_FORKS))
 	{
 		*local_process_type = ZBX_PROCESS_TYPE_SNMPTRAPPER;
@@ -503,10 +532,11 @@ static void	zbx_validate_config(ZBX_TASK_EX *task)
 		err = 1;
 	}
 
-	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS && 0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS)
+	if (0 == CONFIG_UNREACHABLE_POLLER_FORKS &&
+			0 != CONFIG_POLLER_FORKS + CONFIG_JAVAPOLLER_FORKS + CONFIG_AGENTPOLLER_FORKS)
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "\"StartPollersUnreachable\" configuration parameter must not be 0"
-				" if regular or Java pollers are started");
+				" if regular, Java or agent pollers are started");
 		err = 1;
 	}
 
@@ -625,6 +655,12 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1000},
 		{"StartJavaPollers",		&CONFIG_JAVAPOLLER_FORKS,		TYPE_INT,
 			PARM_OPT,	0,			1000},
+		{"StartAgentPollers",		&CONFIG_AGENTPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartHTTPAgentPollers",	&CONFIG_HTTPAGENTPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"StartSNMPPollers",		&CONFIG_SNMPPOLLER_FORKS,		TYPE_INT,
+			PARM_OPT,	0,			1000},
 		{"JavaGateway",			&CONFIG_JAVA_GATEWAY,			TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"JavaGatewayPort",		&CONFIG_JAVA_GATEWAY_PORT,		TYPE_INT,
@@ -639,6 +675,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HistoryIndexCacheSize",	&CONFIG_HISTORY_INDEX_CACHE_SIZE,	TYPE_UINT64,
 			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
+		{"SNMPIndexCacheSize",		&CONFIG_SNMPIDX_CACHE_SIZE,		TYPE_UINT64,
+			PARM_OPT,	128 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"HousekeepingFrequency",	&CONFIG_HOUSEKEEPING_FREQUENCY,		TYPE_INT,
 			PARM_OPT,	0,			24},
 		{"ProxyLocalBuffer",		&CONFIG_PROXY_LOCAL_BUFFER,		TYPE_INT,
@@ -659,6 +697,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			0},
 		{"Timeout",			&CONFIG_TIMEOUT,			TYPE_INT,
 			PARM_OPT,	1,			30},
+		{"ODBCPoolSize",		&CONFIG_ODBC_POOL_SIZE,			TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"ODBCPoolIdleTimeout",	&CONFIG_ODBC_POOL_IDLE_TIMEOUT,		TYPE_INT,
+			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"TrapperTimeout",		&CONFIG_TRAPPER_TIMEOUT,		TYPE_INT,
 			PARM_OPT,	1,			300},
 		{"UnreachablePeriod",		&CONFIG_UNREACHABLE_PERIOD,		TYPE_INT,
@@ -685,6 +727,8 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	0,			1024},
 		{"ExternalScripts",		&CONFIG_EXTERNALSCRIPTS,		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"PersistentExternalScripts",	&CONFIG_EXTERNALSCRIPTS_PERSISTENT,	TYPE_STRING_LIST,
+			PARM_OPT,	0,			0},
 		{"DBHost",			&CONFIG_DBHOST,				TYPE_STRING,
 			PARM_OPT,	0,			0},
 		{"DBName",			&CONFIG_DBNAME,				TYPE_STRING,
@@ -701,6 +745,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	1024,			65535},
 		{"SSHKeyLocation",		&CONFIG_SSH_KEY_LOCATION,		TYPE_STRING,
 			PARM_OPT,	0,			0},
+		{"SSHSessionPoolSize",		&CONFIG_SSH_SESSION_POOL_SIZE,		TYPE_INT,
+			PARM_OPT,	0,			1000},
+		{"SSHSessionIdleTimeout",	&CONFIG_SSH_SESSION_IDLE_TIMEOUT,	TYPE_INT,
+			PARM_OPT,	1,			SEC_PER_HOUR},
 		{"LogSlowQueries",		&CONFIG_LOG_SLOW_QUERIES,		TYPE_INT,
 			PARM_OPT,	0,			3600000},
 		{"LoadModulePath",		&CONFIG_LOAD_MODULE_PATH,		TYPE_STRING,
@@ -717,6 +765,10 @@ static void	zbx_load_config(ZBX_TASK_EX *task)
 			PARM_OPT,	256 * ZBX_KIBIBYTE,	__UINT64_C(2) * ZBX_GIBIBYTE},
 		{"VMwareTimeout",		&CONFIG_VMWARE_TIMEOUT,			TYPE_INT,
 			PARM_OPT,	1,			300},
+		{"VMwareIncrementalUpdate",	&CONFIG_VMWARE_INCREMENTAL_UPDATE,	TYPE_INT,
+			PARM_OPT,	0,			1},
+		{"VMwarePerfConcurrency",	&CONFIG_VMWARE_PERF_CONCURRENCY,	TYPE_INT,
+			PARM_OPT,	1,			32},
 		{"AllowRoot",			&CONFIG_ALLOW_ROOT,			TYPE_INT,
 			PARM_OPT,	0,			1},
 		{"User",			&CONFIG_USER,				TYPE_STRING,
@@ -1023,6 +1075,14 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 		zbx_free(error);
 		exit(EXIT_FAILURE);
 	}
+#ifdef HAVE_NETSNMP
+	if (SUCCEED != zbx_snmp_index_cache_init(&error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot initialize SNMP index cache: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+#endif
 
 	if (SUCCEED != DBinit(&error))
 	{
@@ -1056,7 +1116,8 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 			+ CONFIG_PINGER_FORKS + CONFIG_HOUSEKEEPER_FORKS + CONFIG_HTTPPOLLER_FORKS
 			+ CONFIG_DISCOVERER_FORKS + CONFIG_HISTSYNCER_FORKS + CONFIG_IPMIPOLLER_FORKS
 			+ CONFIG_JAVAPOLLER_FORKS + CONFIG_SNMPTRAPPER_FORKS + CONFIG_SELFMON_FORKS
-			+ CONFIG_VMWARE_FORKS + CONFIG_IPMIMANAGER_FORKS + CONFIG_TASKMANAGER_FORKS;
+			+ CONFIG_VMWARE_FORKS + CONFIG_IPMIMANAGER_FORKS + CONFIG_TASKMANAGER_FORKS
+			+ CONFIG_AGENTPOLLER_FORKS + CONFIG_HTTPAGENTPOLLER_FORKS + CONFIG_SNMPPOLLER_FORKS;
 
 	threads = (pid_t *)zbx_calloc(threads, threads_num, sizeof(pid_t));
 
@@ -1133,6 +1194,21 @@ int	MAIN_ZABBIX_ENTRY(int flags)
 				thread_args.args = &poller_type;
 				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
 				break;
+			case ZBX_PROCESS_TYPE_AGENTPOLLER:
+				poller_type = ZBX_POLLER_TYPE_AGENT;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_HTTPAGENTPOLLER:
+				poller_type = ZBX_POLLER_TYPE_HTTPAGENT;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
+			case ZBX_PROCESS_TYPE_SNMPPOLLER:
+				poller_type = ZBX_POLLER_TYPE_SNMP;
+				thread_args.args = &poller_type;
+				zbx_thread_start(poller_thread, &thread_args, &threads[i]);
+				break;
 			case ZBX_PROCESS_TYPE_SNMPTRAPPER:
 				zbx_thread_start(snmptrapper_thread, &thread_args, &threads[i]);
 				break;
@@ -1201,6 +1277,11 @@ void	zbx_on_exit(void)
 	if (0 != CONFIG_VMWARE_FORKS)
 		zbx_vmware_destroy();
 
+#ifdef HAVE_NETSNMP
+	/* free SNMP index cache */
+	zbx_snmp_index_cache_destroy();
+#endif
+
 	free_selfmon_collector();
 	free_proxy_history_lock();
 
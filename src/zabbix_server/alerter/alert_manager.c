@@ -1964,6 +1964,8 @@ ZBX_THREAD_ENTRY(alert_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_set_sigusr_handler(zbx_ipc_service_sigusr_handler);
+
 	am_init(&manager);
 
 	manager.dbstatus = DBconnect(ZBX_DB_CONNECT_NORMAL);
@@ -979,6 +979,8 @@ ZBX_THREAD_ENTRY(ipmi_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_set_sigusr_handler(zbx_ipc_service_sigusr_handler);
+
 	ipmi_manager_init(&ipmi_manager);
 
 	DBconnect(ZBX_DB_CONNECT_NORMAL);
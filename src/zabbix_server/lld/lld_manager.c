@@ -21,6 +21,7 @@
 
 #include "zbxself.h"
 #include "log.h"
+#include "daemon.h"
 #include "zbxipcservice.h"
 #include "lld_manager.h"
 #include "lld_protocol.h"
@@ -511,6 +512,8 @@ ZBX_THREAD_ENTRY(lld_manager_thread, args)
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_set_sigusr_handler(zbx_ipc_service_sigusr_handler);
+
 	lld_manager_init(&manager);
 
 	/* initialize statistics */
@@ -30,10 +30,18 @@
 #include "zbxjson.h"
 #include "zbxalgo.h"
 
+extern int	CONFIG_ODBC_POOL_SIZE;
+extern int	CONFIG_ODBC_POOL_IDLE_TIMEOUT;
+
 struct zbx_odbc_data_source
 {
 	SQLHENV	henv;
 	SQLHDBC	hdbc;
+	/* connection pool key and last access time, set for pooled connections only */
+	char	*dsn;
+	char	*user;
+	char	*pass;
+	time_t	lastaccess;
 };
 
 struct zbx_odbc_query_result
@@ -229,6 +237,10 @@ zbx_odbc_data_source_t	*zbx_odbc_connect(const char *dsn, const char *user, cons
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() dsn:'%s' user:'%s'", __function_name, dsn, user);
 
 	data_source = (zbx_odbc_data_source_t *)zbx_malloc(data_source, sizeof(zbx_odbc_data_source_t));
+	data_source->dsn = NULL;
+	data_source->user = NULL;
+	data_source->pass = NULL;
+	data_source->lastaccess = 0;
 
 	if (0 != SQL_SUCCEEDED(SQLAllocHandle(SQL_HANDLE_ENV, SQL_NULL_HANDLE, &data_source->henv)))
 	{
@@ -298,9 +310,183 @@ void	zbx_odbc_data_source_free(zbx_odbc_data_source_t *data_source)
 	SQLDisconnect(data_source->hdbc);
 	SQLFreeHandle(SQL_HANDLE_DBC, data_source->hdbc);
 	SQLFreeHandle(SQL_HANDLE_ENV, data_source->henv);
+	zbx_free(data_source->dsn);
+	zbx_free(data_source->user);
+	zbx_free(data_source->pass);
 	zbx_free(data_source);
 }
 
+/* idle connections of the per-process connection pool, ordered by last access time */
+static zbx_vector_ptr_t	odbc_pool;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_odbc_connection_alive                                        *
+ *                                                                            *
+ * Purpose: check if pooled connection was not closed by data source          *
+ *                                                                            *
+ * Parameters: data_source - [IN] pointer to data source structure            *
+ *                                                                            *
+ * Return value: SUCCEED - the connection can be reused                       *
+ *               FAIL    - the connection is dead                             *
+ *                                                                            *
+ * Comments: Connections of drivers that do not support connection dead       *
+ *           attribute are considered alive, failed query on such connection  *
+ *           is retried with a new connection.                                *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_odbc_connection_alive(const zbx_odbc_data_source_t *data_source)
+{
+#ifdef SQL_ATTR_CONNECTION_DEAD
+	SQLUINTEGER	dead = SQL_CD_FALSE;
+
+	if (0 != SQL_SUCCEEDED(SQLGetConnectAttr(data_source->hdbc, SQL_ATTR_CONNECTION_DEAD, &dead, 0, NULL)) &&
+			SQL_CD_TRUE == dead)
+	{
+		return FAIL;
+	}
+#else
+	ZBX_UNUSED(data_source);
+#endif
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_odbc_pool_connect                                            *
+ *                                                                            *
+ * Purpose: get ODBC connection from the connection pool or connect to ODBC   *
+ *          data source                                                       *
+ *                                                                            *
+ * Parameters: dsn     - [IN] data source name                                *
+ *             user    - [IN] user name                                       *
+ *             pass    - [IN] password                                        *
+ *             timeout - [IN] timeout                                         *
+ *             reused  - [OUT] 1 - the connection was taken from the pool,    *
+ *                             0 - new connection was made                    *
+ *             error   - [OUT] error message                                  *
+ *                                                                            *
+ * Return value: pointer to opaque data source data structure or NULL in case *
+ *               of failure, allocated error message is returned in error     *
+ *                                                                            *
+ * Comments: The returned connection must be passed back with                 *
+ *           zbx_odbc_pool_release().                                         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_odbc_data_source_t	*zbx_odbc_pool_connect(const char *dsn, const char *user, const char *pass, int timeout,
+		int *reused, char **error)
+{
+	const char		*__function_name = "zbx_odbc_pool_connect";
+	zbx_odbc_data_source_t	*data_source;
+	int			i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() dsn:'%s' user:'%s' idle:%d", __function_name, dsn, user,
+			NULL != odbc_pool.values ? odbc_pool.values_num : 0);
+
+	*reused = 0;
+
+	if (NULL == odbc_pool.values)
+		zbx_vector_ptr_create(&odbc_pool);
+
+	/* prefer the most recently used connection, it is the least likely to be closed by the data source */
+	for (i = odbc_pool.values_num - 1; 0 <= i; i--)
+	{
+		data_source = (zbx_odbc_data_source_t *)odbc_pool.values[i];
+
+		if (0 != strcmp(data_source->dsn, dsn) || 0 != strcmp(data_source->user, user) ||
+				0 != strcmp(data_source->pass, pass))
+		{
+			continue;
+		}
+
+		zbx_vector_ptr_remove(&odbc_pool, i);
+
+		if (SUCCEED == zbx_odbc_connection_alive(data_source))
+		{
+			*reused = 1;
+			goto out;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() dropping dead pooled connection", __function_name);
+		zbx_odbc_data_source_free(data_source);
+	}
+
+	if (NULL != (data_source = zbx_odbc_connect(dsn, user, pass, timeout, error)))
+	{
+		data_source->dsn = zbx_strdup(NULL, dsn);
+		data_source->user = zbx_strdup(NULL, user);
+		data_source->pass = zbx_strdup(NULL, pass);
+	}
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() reused:%d", __function_name, *reused);
+
+	return data_source;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_odbc_pool_release                                            *
+ *                                                                            *
+ * Purpose: return ODBC connection to the connection pool                     *
+ *                                                                            *
+ * Parameters: data_source - [IN] pointer to data source structure            *
+ *             reuse       - [IN] SUCCEED - the connection can be reused,     *
+ *                                FAIL    - the connection must be closed     *
+ *                                                                            *
+ * Comments: Input parameter data_source must be obtained using               *
+ *           zbx_odbc_pool_connect(). If the pool is full the least recently  *
+ *           used connection is closed.                                       *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_odbc_pool_release(zbx_odbc_data_source_t *data_source, int reuse)
+{
+	if (SUCCEED != reuse || 0 == CONFIG_ODBC_POOL_SIZE)
+	{
+		zbx_odbc_data_source_free(data_source);
+		return;
+	}
+
+	data_source->lastaccess = time(NULL);
+	zbx_vector_ptr_append(&odbc_pool, data_source);
+
+	while (CONFIG_ODBC_POOL_SIZE < odbc_pool.values_num)
+	{
+		zbx_odbc_data_source_free((zbx_odbc_data_source_t *)odbc_pool.values[0]);
+		zbx_vector_ptr_remove(&odbc_pool, 0);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_odbc_pool_expire                                             *
+ *                                                                            *
+ * Purpose: close pooled ODBC connections that were idle for longer than      *
+ *          ODBCPoolIdleTimeout                                               *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_odbc_pool_expire(void)
+{
+	zbx_odbc_data_source_t	*data_source;
+	time_t			now;
+
+	if (NULL == odbc_pool.values)
+		return;
+
+	now = time(NULL);
+
+	while (0 != odbc_pool.values_num)
+	{
+		data_source = (zbx_odbc_data_source_t *)odbc_pool.values[0];
+
+		if (data_source->lastaccess + CONFIG_ODBC_POOL_IDLE_TIMEOUT > now)
+			break;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "closing idle ODBC connection to '%s'", data_source->dsn);
+		zbx_odbc_data_source_free(data_source);
+		zbx_vector_ptr_remove(&odbc_pool, 0);
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: zbx_odbc_select                                                  *
@@ -32,4 +32,9 @@ int	zbx_odbc_query_result_to_lld_json(zbx_odbc_query_result_t *query_result, cha
 void	zbx_odbc_query_result_free(zbx_odbc_query_result_t *query_result);
 void	zbx_odbc_data_source_free(zbx_odbc_data_source_t *data_source);
 
+zbx_odbc_data_source_t	*zbx_odbc_pool_connect(const char *dsn, const char *user, const char *pass, int timeout,
+		int *reused, char **error);
+void	zbx_odbc_pool_release(zbx_odbc_data_source_t *data_source, int reuse);
+void	zbx_odbc_pool_expire(void);
+
 #endif
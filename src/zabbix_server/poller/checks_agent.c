@@ -20,6 +20,8 @@
 #include "common.h"
 #include "comms.h"
 #include "log.h"
+#include "zbxcompress.h"
+#include "zbxjson.h"
 #include "../../libs/zbxcrypto/tls_tcp_active.h"
 
 #include "checks_agent.h"
@@ -28,6 +30,151 @@
 extern unsigned char	program_type;
 #endif
 
+/* Zabbix protocol header - signature, flags, data length and reserved fields */
+#define ZBX_AGENT_HEADER_SIZE	(ZBX_TCP_HEADER_LEN + 1 + 2 * sizeof(zbx_uint32_t))
+
+#define ZBX_AGENT_BUFFER_SIZE	4096
+
+/* asynchronous agent check states */
+#define ZBX_AGENT_CHECK_CONNECT	0
+#define ZBX_AGENT_CHECK_SEND	1
+#define ZBX_AGENT_CHECK_RECV	2
+
+typedef struct
+{
+	const DC_ITEM	*item;
+	AGENT_RESULT	*result;
+	int		*errcode;
+	int		fd;
+	unsigned char	state;
+
+	/* the request being sent or the response being received */
+	char		*buffer;
+	size_t		buffer_alloc;
+	size_t		buffer_offset;
+	size_t		request_size;
+}
+zbx_agent_check_t;
+
+/* resolved agent address, shared by checks of the same interface */
+typedef struct
+{
+	const char	*host;
+	unsigned short	port;
+
+	/* SUCCEED - the address was resolved, FAIL - cannot resolve, TIMEOUT_ERROR - resolving timed out */
+	int		ret;
+
+	ZBX_SOCKADDR	addr;
+	socklen_t	addrlen;
+}
+zbx_agent_addr_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_parse_response                                             *
+ *                                                                            *
+ * Purpose: parses value received from Zabbix agent                           *
+ *                                                                            *
+ * Parameters: item         - [IN] the item                                   *
+ *             data         - [IN/OUT] the received data, trimmed during      *
+ *                                     parsing                                *
+ *             data_len     - [IN] the received data length                   *
+ *             received_len - [IN] the number of bytes received including     *
+ *                                 protocol header                            *
+ *             result       - [OUT] the item value or error message           *
+ *                                                                            *
+ * Return value: SUCCEED - the value was parsed successfully                  *
+ *               NETWORK_ERROR - empty response was received                  *
+ *               NOTSUPPORTED - item not supported by the agent               *
+ *               AGENT_ERROR - uncritical error on agent side occurred        *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_parse_response(const DC_ITEM *item, char *data, size_t data_len, size_t received_len,
+		AGENT_RESULT *result)
+{
+	zbx_rtrim(data, " \r\n");
+	zbx_ltrim(data, " ");
+
+	zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", data);
+
+	if (0 == strcmp(data, ZBX_NOTSUPPORTED))
+	{
+		/* 'ZBX_NOTSUPPORTED\0<error message>' */
+		if (sizeof(ZBX_NOTSUPPORTED) < data_len)
+			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", data + sizeof(ZBX_NOTSUPPORTED)));
+		else
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+
+		return NOTSUPPORTED;
+	}
+
+	if (0 == strcmp(data, ZBX_ERROR))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
+		return AGENT_ERROR;
+	}
+
+	if (0 == received_len)
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
+				" Assuming that agent dropped connection because of access permissions.",
+				item->interface.addr));
+		return NETWORK_ERROR;
+	}
+
+	set_result_type(result, ITEM_VALUE_TYPE_TEXT, data);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_tls_args                                               *
+ *                                                                            *
+ * Purpose: gets TLS connection arguments of the item host                    *
+ *                                                                            *
+ * Parameters: item     - [IN] the item                                       *
+ *             tls_arg1 - [OUT] the certificate issuer or PSK identity        *
+ *             tls_arg2 - [OUT] the certificate subject or PSK                *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED      - the arguments were retrieved                  *
+ *               CONFIG_ERROR - the host TLS configuration is not supported   *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_get_tls_args(const DC_ITEM *item, const char **tls_arg1, const char **tls_arg2, char **error)
+{
+	switch (item->host.tls_connect)
+	{
+		case ZBX_TCP_SEC_UNENCRYPTED:
+			*tls_arg1 = NULL;
+			*tls_arg2 = NULL;
+			return SUCCEED;
+#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
+		case ZBX_TCP_SEC_TLS_CERT:
+			*tls_arg1 = item->host.tls_issuer;
+			*tls_arg2 = item->host.tls_subject;
+			return SUCCEED;
+		case ZBX_TCP_SEC_TLS_PSK:
+			*tls_arg1 = item->host.tls_psk_identity;
+			*tls_arg2 = item->host.tls_psk;
+			return SUCCEED;
+#else
+		case ZBX_TCP_SEC_TLS_CERT:
+		case ZBX_TCP_SEC_TLS_PSK:
+			*error = zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
+					" but support for TLS was not compiled into %s.",
+					get_program_type_string(program_type));
+			return CONFIG_ERROR;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			*error = zbx_strdup(NULL, "Invalid TLS connection parameters.");
+			return CONFIG_ERROR;
+	}
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: get_value_agent                                                  *
@@ -48,11 +195,12 @@ extern unsigned char	program_type;
  * Comments: error will contain error message                                 *
  *                                                                            *
  ******************************************************************************/
-int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result)
+int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result)
 {
 	const char	*__function_name = "get_value_agent";
 	zbx_socket_t	s;
-	char		*tls_arg1, *tls_arg2;
+	const char	*tls_arg1, *tls_arg2;
+	char		*error = NULL;
 	int		ret = SUCCEED;
 	ssize_t		received_len;
 
@@ -63,35 +211,10 @@ int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result)
 				zbx_tcp_connection_type_name(item->host.tls_connect));
 	}
 
-	switch (item->host.tls_connect)
+	if (SUCCEED != (ret = agent_get_tls_args(item, &tls_arg1, &tls_arg2, &error)))
 	{
-		case ZBX_TCP_SEC_UNENCRYPTED:
-			tls_arg1 = NULL;
-			tls_arg2 = NULL;
-			break;
-#if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
-		case ZBX_TCP_SEC_TLS_CERT:
-			tls_arg1 = item->host.tls_issuer;
-			tls_arg2 = item->host.tls_subject;
-			break;
-		case ZBX_TCP_SEC_TLS_PSK:
-			tls_arg1 = item->host.tls_psk_identity;
-			tls_arg2 = item->host.tls_psk;
-			break;
-#else
-		case ZBX_TCP_SEC_TLS_CERT:
-		case ZBX_TCP_SEC_TLS_PSK:
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "A TLS connection is configured to be used with agent"
-					" but support for TLS was not compiled into %s.",
-					get_program_type_string(program_type)));
-			ret = CONFIG_ERROR;
-			goto out;
-#endif
-		default:
-			THIS_SHOULD_NEVER_HAPPEN;
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid TLS connection parameters."));
-			ret = CONFIG_ERROR;
-			goto out;
+		SET_MSG_RESULT(result, error);
+		goto out;
 	}
 
 	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
@@ -112,43 +235,911 @@ int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result)
 		ret = NETWORK_ERROR;
 
 	if (SUCCEED == ret)
+		ret = agent_parse_response(item, s.buffer, s.read_bytes, (size_t)received_len, result);
+	else
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+
+	zbx_tcp_close(&s);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_close                                                *
+ *                                                                            *
+ * Purpose: finishes asynchronous agent check                                 *
+ *                                                                            *
+ * Parameters: check   - [IN/OUT] the agent check                             *
+ *             errcode - [IN] the check result code                           *
+ *             error   - [IN] the error message or NULL, freed by this        *
+ *                            function                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_check_close(zbx_agent_check_t *check, int errcode, char *error)
+{
+	if (NULL != error)
 	{
-		zbx_rtrim(s.buffer, " \r\n");
-		zbx_ltrim(s.buffer, " ");
+		SET_MSG_RESULT(check->result, zbx_dsprintf(NULL, "Get value from agent failed: %s", error));
+		zbx_free(error);
+	}
+
+	*check->errcode = errcode;
+
+	close(check->fd);
+	check->fd = -1;
+
+	zbx_free(check->buffer);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_resolve_addr                                               *
+ *                                                                            *
+ * Purpose: resolves host address                                             *
+ *                                                                            *
+ * Parameters: host    - [IN] the host name or IP address                     *
+ *             port    - [IN] the port number                                 *
+ *             addr    - [OUT] the resolved address                           *
+ *             addrlen - [OUT] the resolved address length                    *
+ *                                                                            *
+ * Return value: SUCCEED - the address was resolved                           *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_resolve_addr(const char *host, unsigned short port, ZBX_SOCKADDR *addr, socklen_t *addrlen)
+{
+#ifdef HAVE_IPV6
+	struct addrinfo	*ai = NULL, hints;
+	char		service[8];
+
+	zbx_snprintf(service, sizeof(service), "%hu", port);
+	memset(&hints, 0x00, sizeof(struct addrinfo));
+	hints.ai_family = PF_UNSPEC;
+	hints.ai_socktype = SOCK_STREAM;
 
-		zabbix_log(LOG_LEVEL_DEBUG, "get value from agent result: '%s'", s.buffer);
+	if (0 != getaddrinfo(host, service, &hints, &ai))
+		return FAIL;
 
-		if (0 == strcmp(s.buffer, ZBX_NOTSUPPORTED))
+	memcpy(addr, ai->ai_addr, ai->ai_addrlen);
+	*addrlen = (socklen_t)ai->ai_addrlen;
+
+	freeaddrinfo(ai);
+#else
+	struct hostent	*hp;
+
+	if (NULL == (hp = gethostbyname(host)))
+		return FAIL;
+
+	memset(addr, 0, sizeof(ZBX_SOCKADDR));
+	addr->sin_family = AF_INET;
+	addr->sin_addr.s_addr = ((struct in_addr *)(hp->h_addr))->s_addr;
+	addr->sin_port = htons(port);
+	*addrlen = sizeof(ZBX_SOCKADDR);
+#endif
+	return SUCCEED;
+}
+
+static zbx_hash_t	agent_addr_hash(const void *data)
+{
+	const zbx_agent_addr_t	*addr = (const zbx_agent_addr_t *)data;
+	zbx_hash_t		hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(addr->host, strlen(addr->host), ZBX_DEFAULT_HASH_SEED);
+
+	return ZBX_DEFAULT_HASH_ALGO(&addr->port, sizeof(addr->port), hash);
+}
+
+static int	agent_addr_compare(const void *d1, const void *d2)
+{
+	const zbx_agent_addr_t	*addr1 = (const zbx_agent_addr_t *)d1;
+	const zbx_agent_addr_t	*addr2 = (const zbx_agent_addr_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(addr1->port, addr2->port);
+
+	return strcmp(addr1->host, addr2->host);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_addr_get                                                   *
+ *                                                                            *
+ * Purpose: gets resolved address from cache, resolving it if necessary       *
+ *                                                                            *
+ * Parameters: addrs - [IN/OUT] the resolved address cache                    *
+ *             host  - [IN] the host name or IP address, must stay valid while*
+ *                          the cache is used                                 *
+ *             port  - [IN] the port number                                   *
+ *                                                                            *
+ * Return value: the cached address                                           *
+ *                                                                            *
+ * Comments: Once the resolving alarm fires the remaining addresses are not   *
+ *           resolved to avoid blocking the poller any longer.                *
+ *                                                                            *
+ *****************************************************************************/
+static const zbx_agent_addr_t	*agent_addr_get(zbx_hashset_t *addrs, const char *host, unsigned short port)
+{
+	zbx_agent_addr_t	addr_local, *addr;
+
+	addr_local.host = host;
+	addr_local.port = port;
+
+	if (NULL != (addr = (zbx_agent_addr_t *)zbx_hashset_search(addrs, &addr_local)))
+		return addr;
+
+	if (SUCCEED == zbx_alarm_timed_out())
+		addr_local.ret = TIMEOUT_ERROR;
+	else
+		addr_local.ret = agent_resolve_addr(host, port, &addr_local.addr, &addr_local.addrlen);
+
+	return (const zbx_agent_addr_t *)zbx_hashset_insert(addrs, &addr_local, sizeof(addr_local));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_start                                                *
+ *                                                                            *
+ * Purpose: starts asynchronous agent check by initiating non-blocking        *
+ *          connection and preparing the request                              *
+ *                                                                            *
+ * Parameters: check  - [IN/OUT] the agent check                              *
+ *             addr   - [IN] the resolved agent address                       *
+ *             source - [IN] the resolved source address or NULL              *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is being established                *
+ *               FAIL    - the check failed, the result is set                *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_check_start(zbx_agent_check_t *check, const zbx_agent_addr_t *addr,
+		const zbx_agent_addr_t *source)
+{
+	const DC_ITEM	*item = check->item;
+	zbx_uint32_t	len32_le;
+	size_t		key_len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "starting agent check host:'%s' addr:'%s' key:'%s'", item->host.host,
+			item->interface.addr, item->key);
+
+	if (SUCCEED != addr->ret)
+	{
+		SET_MSG_RESULT(check->result, zbx_dsprintf(NULL, "Get value from agent failed: cannot resolve [%s]%s",
+				item->interface.addr, TIMEOUT_ERROR == addr->ret ? ": timed out" : ""));
+		*check->errcode = NETWORK_ERROR;
+		return FAIL;
+	}
+
+	if (-1 == (check->fd = socket(((const struct sockaddr *)&addr->addr)->sa_family, SOCK_STREAM | SOCK_CLOEXEC,
+			0)))
+	{
+		SET_MSG_RESULT(check->result, zbx_dsprintf(NULL, "Get value from agent failed: cannot create socket"
+				" [[%s]:%hu]: %s", item->interface.addr, item->interface.port, zbx_strerror(errno)));
+		*check->errcode = NETWORK_ERROR;
+		return FAIL;
+	}
+#if !SOCK_CLOEXEC
+	fcntl(check->fd, F_SETFD, FD_CLOEXEC);
+#endif
+	if (NULL != source)
+	{
+		if (SUCCEED != source->ret)
 		{
-			/* 'ZBX_NOTSUPPORTED\0<error message>' */
-			if (sizeof(ZBX_NOTSUPPORTED) < s.read_bytes)
-				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "%s", s.buffer + sizeof(ZBX_NOTSUPPORTED)));
-			else
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "invalid source IP address [%s]",
+					CONFIG_SOURCE_IP));
+			return FAIL;
+		}
 
-			ret = NOTSUPPORTED;
+		if (-1 == bind(check->fd, (const struct sockaddr *)&source->addr, source->addrlen))
+		{
+			agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "bind() failed: %s",
+					zbx_strerror(errno)));
+			return FAIL;
 		}
-		else if (0 == strcmp(s.buffer, ZBX_ERROR))
+	}
+
+	if (-1 == fcntl(check->fd, F_SETFL, fcntl(check->fd, F_GETFL) | O_NONBLOCK))
+	{
+		agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot set non-blocking mode: %s",
+				zbx_strerror(errno)));
+		return FAIL;
+	}
+
+	if (-1 == connect(check->fd, (const struct sockaddr *)&addr->addr, addr->addrlen) && EINPROGRESS != errno)
+	{
+		agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]: %s",
+				item->interface.addr, item->interface.port, zbx_strerror(errno)));
+		return FAIL;
+	}
+
+	/* prepare the request in Zabbix protocol format */
+	key_len = strlen(item->key);
+	check->request_size = ZBX_AGENT_HEADER_SIZE + key_len;
+	check->buffer_alloc = MAX(check->request_size, ZBX_AGENT_BUFFER_SIZE);
+	check->buffer = (char *)zbx_malloc(NULL, check->buffer_alloc);
+
+	memcpy(check->buffer, ZBX_TCP_HEADER_DATA, ZBX_TCP_HEADER_LEN);
+	check->buffer[ZBX_TCP_HEADER_LEN] = ZBX_TCP_PROTOCOL;
+	len32_le = zbx_htole_uint32((zbx_uint32_t)key_len);
+	memcpy(check->buffer + ZBX_TCP_HEADER_LEN + 1, &len32_le, sizeof(len32_le));
+	len32_le = 0;
+	memcpy(check->buffer + ZBX_TCP_HEADER_LEN + 1 + sizeof(len32_le), &len32_le, sizeof(len32_le));
+	memcpy(check->buffer + ZBX_AGENT_HEADER_SIZE, item->key, key_len);
+
+	check->buffer_offset = 0;
+	check->state = ZBX_AGENT_CHECK_CONNECT;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_get_expected                                         *
+ *                                                                            *
+ * Purpose: gets the expected response size from the received protocol header *
+ *                                                                            *
+ * Parameters: check    - [IN] the agent check                                *
+ *             expected - [OUT] the expected response size including header   *
+ *             error    - [OUT] the error message                             *
+ *                                                                            *
+ * Return value: SUCCEED - the expected size was retrieved                    *
+ *               FAIL    - the header is not received yet or is invalid, in   *
+ *                         the last case the error is set                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_check_get_expected(const zbx_agent_check_t *check, size_t *expected, char **error)
+{
+	zbx_uint32_t	len32_le;
+	unsigned char	flags;
+
+	if (0 != strncmp(check->buffer, ZBX_TCP_HEADER_DATA, MIN(check->buffer_offset, ZBX_TCP_HEADER_LEN)))
+	{
+		*error = zbx_dsprintf(NULL, "message from [%s] is missing header", check->item->interface.addr);
+		return FAIL;
+	}
+
+	if (ZBX_AGENT_HEADER_SIZE > check->buffer_offset)
+		return FAIL;
+
+	flags = (unsigned char)check->buffer[ZBX_TCP_HEADER_LEN];
+
+	if (0 == (flags & ZBX_TCP_PROTOCOL) || flags > (ZBX_TCP_PROTOCOL | ZBX_TCP_COMPRESS))
+	{
+		*error = zbx_dsprintf(NULL, "message from [%s] is using unsupported protocol version \"%d\"",
+				check->item->interface.addr, (int)flags);
+		return FAIL;
+	}
+
+	memcpy(&len32_le, check->buffer + ZBX_TCP_HEADER_LEN + 1, sizeof(len32_le));
+
+	if (ZBX_MAX_RECV_DATA_SIZE < zbx_letoh_uint32(len32_le))
+	{
+		*error = zbx_dsprintf(NULL, "message size " ZBX_FS_UI64 " from [%s] exceeds the maximum size "
+				ZBX_FS_UI64 " bytes", (zbx_uint64_t)zbx_letoh_uint32(len32_le),
+				check->item->interface.addr, (zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE);
+		return FAIL;
+	}
+
+	*expected = ZBX_AGENT_HEADER_SIZE + zbx_letoh_uint32(len32_le);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_finish                                               *
+ *                                                                            *
+ * Purpose: parses the received response and finishes the check               *
+ *                                                                            *
+ * Parameters: check - [IN/OUT] the agent check                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_check_finish(zbx_agent_check_t *check)
+{
+	char		*data, *out = NULL, *error = NULL;
+	size_t		data_len, expected;
+	zbx_uint32_t	reserved;
+
+	/* connection was closed without sending anything */
+	if (0 == check->buffer_offset)
+	{
+		*check->buffer = '\0';
+		agent_check_close(check, agent_parse_response(check->item, check->buffer, 0, 0, check->result), NULL);
+		return;
+	}
+
+	if (SUCCEED != agent_check_get_expected(check, &expected, &error))
+	{
+		if (NULL == error)
 		{
-			SET_MSG_RESULT(result, zbx_strdup(NULL, "Zabbix Agent non-critical error"));
-			ret = AGENT_ERROR;
+			error = zbx_dsprintf(NULL, "message from [%s] is missing data length",
+					check->item->interface.addr);
 		}
-		else if (0 == received_len)
+
+		agent_check_close(check, NETWORK_ERROR, error);
+		return;
+	}
+
+	if (expected != check->buffer_offset)
+	{
+		agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "message from [%s] is %s than"
+				" expected " ZBX_FS_SIZE_T " bytes", check->item->interface.addr,
+				expected > check->buffer_offset ? "shorter" : "longer",
+				(zbx_fs_size_t)(expected - ZBX_AGENT_HEADER_SIZE)));
+		return;
+	}
+
+	data = check->buffer + ZBX_AGENT_HEADER_SIZE;
+	data_len = expected - ZBX_AGENT_HEADER_SIZE;
+
+	if (0 != (check->buffer[ZBX_TCP_HEADER_LEN] & ZBX_TCP_COMPRESS))
+	{
+		memcpy(&reserved, check->buffer + ZBX_TCP_HEADER_LEN + 1 + sizeof(zbx_uint32_t), sizeof(reserved));
+		reserved = zbx_letoh_uint32(reserved);
+
+		if (ZBX_MAX_RECV_DATA_SIZE < reserved)
 		{
-			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Received empty response from Zabbix Agent at [%s]."
-					" Assuming that agent dropped connection because of access permissions.",
-					item->interface.addr));
-			ret = NETWORK_ERROR;
+			agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "uncompressed message size "
+					ZBX_FS_UI64 " from [%s] exceeds the maximum size " ZBX_FS_UI64 " bytes",
+					(zbx_uint64_t)reserved, check->item->interface.addr,
+					(zbx_uint64_t)ZBX_MAX_RECV_DATA_SIZE));
+			return;
+		}
+
+		out = (char *)zbx_malloc(NULL, reserved + 1);
+		data_len = reserved;
+
+		if (FAIL == zbx_uncompress(data, expected - ZBX_AGENT_HEADER_SIZE, out, &data_len) ||
+				data_len != reserved)
+		{
+			zbx_free(out);
+			agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot uncompress data: %s",
+					zbx_compress_strerror()));
+			return;
+		}
+
+		data = out;
+	}
+
+	data[data_len] = '\0';
+
+	agent_check_close(check, agent_parse_response(check->item, data, data_len, check->buffer_offset,
+			check->result), NULL);
+
+	zbx_free(out);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_process                                              *
+ *                                                                            *
+ * Purpose: processes socket event of asynchronous agent check                *
+ *                                                                            *
+ * Parameters: check - [IN/OUT] the agent check                               *
+ *                                                                            *
+ * Return value: SUCCEED - the check is still in progress                     *
+ *               FAIL    - the check was finished                             *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_check_process(zbx_agent_check_t *check)
+{
+	ssize_t		n;
+	size_t		expected;
+	int		err;
+	socklen_t	err_len = sizeof(err);
+	char		*error = NULL;
+
+	switch (check->state)
+	{
+		case ZBX_AGENT_CHECK_CONNECT:
+			if (-1 == getsockopt(check->fd, SOL_SOCKET, SO_ERROR, &err, &err_len))
+				err = errno;
+
+			if (0 != err)
+			{
+				agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot connect to"
+						" [[%s]:%hu]: %s", check->item->interface.addr,
+						check->item->interface.port, zbx_strerror(err)));
+				return FAIL;
+			}
+
+			check->state = ZBX_AGENT_CHECK_SEND;
+			ZBX_FALLTHROUGH;
+		case ZBX_AGENT_CHECK_SEND:
+			if (-1 == (n = write(check->fd, check->buffer + check->buffer_offset,
+					check->request_size - check->buffer_offset)))
+			{
+				if (EINTR == errno || EAGAIN == errno || EWOULDBLOCK == errno)
+					return SUCCEED;
+
+				agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "ZBX_TCP_WRITE() failed:"
+						" [%d] %s", errno, zbx_strerror(errno)));
+				return FAIL;
+			}
+
+			if (check->request_size != (check->buffer_offset += n))
+				return SUCCEED;
+
+			zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", check->item->key);
+
+			/* reuse the request buffer for response */
+			check->buffer_offset = 0;
+			check->state = ZBX_AGENT_CHECK_RECV;
+			return SUCCEED;
+		case ZBX_AGENT_CHECK_RECV:
+			/* keep one byte for terminating zero */
+			if (check->buffer_alloc - 1 == check->buffer_offset)
+			{
+				check->buffer_alloc *= 2;
+				check->buffer = (char *)zbx_realloc(check->buffer, check->buffer_alloc);
+			}
+
+			if (-1 == (n = read(check->fd, check->buffer + check->buffer_offset,
+					check->buffer_alloc - check->buffer_offset - 1)))
+			{
+				if (EINTR == errno || EAGAIN == errno || EWOULDBLOCK == errno)
+					return SUCCEED;
+
+				agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "ZBX_TCP_READ() failed:"
+						" [%d] %s", errno, zbx_strerror(errno)));
+				return FAIL;
+			}
+
+			if (0 == n)
+			{
+				agent_check_finish(check);
+				return FAIL;
+			}
+
+			check->buffer_offset += n;
+
+			if (SUCCEED != agent_check_get_expected(check, &expected, &error))
+			{
+				if (NULL == error)
+					return SUCCEED;
+
+				agent_check_close(check, NETWORK_ERROR, error);
+				return FAIL;
+			}
+
+			if (expected <= check->buffer_offset)
+			{
+				agent_check_finish(check);
+				return FAIL;
+			}
+
+			/* allocate the whole message buffer once the size is known */
+			if (expected + 1 > check->buffer_alloc)
+			{
+				check->buffer_alloc = expected + 1;
+				check->buffer = (char *)zbx_realloc(check->buffer, check->buffer_alloc);
+			}
+
+			return SUCCEED;
+	}
+
+	THIS_SHOULD_NEVER_HAPPEN;
+	agent_check_close(check, NETWORK_ERROR, zbx_strdup(NULL, "invalid check state"));
+
+	return FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_check_timeout                                              *
+ *                                                                            *
+ * Purpose: finishes timed out asynchronous agent check                       *
+ *                                                                            *
+ * Parameters: check - [IN/OUT] the agent check                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_check_timeout(zbx_agent_check_t *check)
+{
+	switch (check->state)
+	{
+		case ZBX_AGENT_CHECK_CONNECT:
+			agent_check_close(check, NETWORK_ERROR, zbx_dsprintf(NULL, "cannot connect to [[%s]:%hu]:"
+					" timed out", check->item->interface.addr, check->item->interface.port));
+			break;
+		case ZBX_AGENT_CHECK_SEND:
+			agent_check_close(check, NETWORK_ERROR, zbx_strdup(NULL, "ZBX_TCP_WRITE() timed out"));
+			break;
+		default:
+			agent_check_close(check, TIMEOUT_ERROR, zbx_strdup(NULL, "ZBX_TCP_READ() timed out"));
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent                                                 *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from Zabbix agents              *
+ *          concurrently                                                      *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Unencrypted checks are performed asynchronously - connections to *
+ *           all agents are established at once and multiplexed with poll().  *
+ *           Agent addresses are resolved once per interface before any       *
+ *           connection is started. All checks, including resolving, share    *
+ *           the same Timeout deadline.                                       *
+ *           Encrypted checks are performed sequentially afterwards.          *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	const char		*__function_name = "get_values_agent";
+	zbx_agent_check_t	*checks;
+	const zbx_agent_addr_t	**addrs, *source = NULL;
+	zbx_hashset_t		addrs_cache;
+	struct pollfd		*pfds;
+	int			i, *pfd_checks, pfds_num, active_num = 0, timeout_ms, err;
+	double			deadline;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __function_name, num);
+
+	checks = (zbx_agent_check_t *)zbx_malloc(NULL, sizeof(zbx_agent_check_t) * num);
+	pfds = (struct pollfd *)zbx_malloc(NULL, sizeof(struct pollfd) * num);
+	pfd_checks = (int *)zbx_malloc(NULL, sizeof(int) * num);
+	addrs = (const zbx_agent_addr_t **)zbx_malloc(NULL, sizeof(zbx_agent_addr_t *) * num);
+	zbx_hashset_create(&addrs_cache, (size_t)num, agent_addr_hash, agent_addr_compare);
+
+	deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	/* resolve addresses before starting checks so name resolution does not stall the established connections */
+	zbx_alarm_on(CONFIG_TIMEOUT);
+
+	if (NULL != CONFIG_SOURCE_IP)
+		source = agent_addr_get(&addrs_cache, CONFIG_SOURCE_IP, 0);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i] || ZBX_TCP_SEC_UNENCRYPTED != items[i].host.tls_connect)
+			continue;
+
+		addrs[i] = agent_addr_get(&addrs_cache, items[i].interface.addr, items[i].interface.port);
+	}
+
+	zbx_alarm_off();
+
+	for (i = 0; i < num; i++)
+	{
+		checks[i].fd = -1;
+		checks[i].buffer = NULL;
+
+		if (SUCCEED != errcodes[i] || ZBX_TCP_SEC_UNENCRYPTED != items[i].host.tls_connect)
+			continue;
+
+		checks[i].item = &items[i];
+		checks[i].result = &results[i];
+		checks[i].errcode = &errcodes[i];
+
+		if (SUCCEED == agent_check_start(&checks[i], addrs[i], source))
+			active_num++;
+	}
+
+	zbx_hashset_destroy(&addrs_cache);
+	zbx_free(addrs);
+
+	while (0 < active_num)
+	{
+		for (i = 0, pfds_num = 0; i < num; i++)
+		{
+			if (-1 == checks[i].fd)
+				continue;
+
+			pfds[pfds_num].fd = checks[i].fd;
+			pfds[pfds_num].events = (ZBX_AGENT_CHECK_RECV == checks[i].state ? POLLIN : POLLOUT);
+			pfds[pfds_num].revents = 0;
+			pfd_checks[pfds_num++] = i;
+		}
+
+		if (0 >= (timeout_ms = (int)((deadline - zbx_time()) * 1000)))
+		{
+			for (i = 0; i < pfds_num; i++)
+				agent_check_timeout(&checks[pfd_checks[i]]);
+			break;
+		}
+
+		if (-1 == poll(pfds, pfds_num, timeout_ms))
+		{
+			if (EINTR == (err = errno))
+				continue;
+
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for agent connections: %s", zbx_strerror(err));
+
+			for (i = 0; i < pfds_num; i++)
+			{
+				agent_check_close(&checks[pfd_checks[i]], NETWORK_ERROR, zbx_dsprintf(NULL,
+						"poll() failed: %s", zbx_strerror(err)));
+			}
+			break;
+		}
+
+		for (i = 0; i < pfds_num; i++)
+		{
+			if (0 != pfds[i].revents && SUCCEED != agent_check_process(&checks[pfd_checks[i]]))
+				active_num--;
+		}
+	}
+
+	zbx_free(pfd_checks);
+	zbx_free(pfds);
+	zbx_free(checks);
+
+	/* encrypted checks cannot be performed asynchronously */
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i] || ZBX_TCP_SEC_UNENCRYPTED == items[i].host.tls_connect)
+			continue;
+
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		errcodes[i] = get_value_agent(&items[i], &results[i]);
+		zbx_alarm_off();
+	}
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_get_values_single                                          *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from the same Zabbix agent      *
+ *          interface one by one                                              *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Once the agent is found unreachable the remaining items get the  *
+ *           same error without waiting for connection timeouts again. Read   *
+ *           timeouts are specific to the item key and are not propagated.    *
+ *                                                                            *
+ ******************************************************************************/
+static void	agent_get_values_single(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	int	i, j;
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zbx_alarm_on(CONFIG_TIMEOUT);
+		errcodes[i] = get_value_agent(&items[i], &results[i]);
+		zbx_alarm_off();
+
+		if (NETWORK_ERROR != errcodes[i])
+			continue;
+
+		for (j = i + 1; j < num; j++)
+		{
+			if (SUCCEED != errcodes[j])
+				continue;
+
+			SET_MSG_RESULT(&results[j], zbx_strdup(NULL, results[i].msg));
+			errcodes[j] = errcodes[i];
+		}
+
+		break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: agent_parse_bulk_response                                        *
+ *                                                                            *
+ * Purpose: parses values of multiple items received from Zabbix agent        *
+ *                                                                            *
+ * Parameters: items         - [IN] the requested items                       *
+ *             results       - [OUT] the item values or error messages        *
+ *             errcodes      - [IN/OUT] the item result codes, only items     *
+ *                                      with SUCCEED code were requested      *
+ *             num           - [IN] the number of items                       *
+ *             requested_num - [IN] the number of requested items             *
+ *             data          - [IN] the received data                         *
+ *             received_len  - [IN] the number of bytes received including    *
+ *                                  protocol header                           *
+ *                                                                            *
+ * Return value: SUCCEED - the response was parsed, item results are set      *
+ *               FAIL    - the response is not a valid bulk response          *
+ *                                                                            *
+ ******************************************************************************/
+static int	agent_parse_bulk_response(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num,
+		int requested_num, const char *data, size_t received_len)
+{
+	struct zbx_json_parse	jp, jp_data, jp_row;
+	const char		*p = NULL;
+	char			response[16], *value = NULL;
+	size_t			value_alloc = 0;
+	int			i;
+
+	if (0 == received_len)
+	{
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED == errcodes[i])
+				errcodes[i] = agent_parse_response(&items[i], (char *)"", 0, 0, &results[i]);
 		}
+
+		return SUCCEED;
+	}
+
+	if (SUCCEED != zbx_json_open(data, &jp) ||
+			SUCCEED != zbx_json_value_by_name(&jp, ZBX_PROTO_TAG_RESPONSE, response, sizeof(response)) ||
+			0 != strcmp(response, ZBX_PROTO_VALUE_SUCCESS) ||
+			SUCCEED != zbx_json_brackets_by_name(&jp, ZBX_PROTO_TAG_DATA, &jp_data) ||
+			requested_num != zbx_json_count(&jp_data))
+	{
+		return FAIL;
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		p = zbx_json_next(&jp_data, p);
+
+		if (SUCCEED != zbx_json_brackets_open(p, &jp_row))
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			errcodes[i] = NOTSUPPORTED;
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_VALUE, &value, &value_alloc))
+		{
+			errcodes[i] = agent_parse_response(&items[i], value, strlen(value), received_len, &results[i]);
+		}
+		else if (SUCCEED == zbx_json_value_by_name_dyn(&jp_row, ZBX_PROTO_TAG_ERROR, &value, &value_alloc) &&
+				'\0' != *value)
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, value));
+			errcodes[i] = NOTSUPPORTED;
+		}
+		else
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Not supported by Zabbix Agent"));
+			errcodes[i] = NOTSUPPORTED;
+		}
+	}
+
+	zbx_free(value);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_agent_bulk                                            *
+ *                                                                            *
+ * Purpose: retrieve values of multiple items from the same Zabbix agent      *
+ *          interface with a single request                                   *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check, all sharing the same       *
+ *                             interface                                      *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: The item keys are sent in a single request:                      *
+ *             {"request":"passive checks","data":[{"key":"<key>"},...]}      *
+ *           and the agent responds with values in the same order:            *
+ *             {"response":"success","data":[{"value":"<value>"},             *
+ *                     {"error":"<error>"},...]}                              *
+ *           Older agents respond with ZBX_NOTSUPPORTED. In this case bulk    *
+ *           requests are disabled for the interface and the items are        *
+ *           checked one by one.                                              *
+ *           If the bulk request times out after connecting, the items are    *
+ *           checked one by one without disabling bulk requests, so a single  *
+ *           slow key does not fail the others. Connection errors are         *
+ *           reported for all requested items.                                *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_agent_bulk(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	const char	*__function_name = "get_values_agent_bulk";
+	zbx_socket_t	s;
+	struct zbx_json	j;
+	const char	*tls_arg1, *tls_arg2;
+	char		*error = NULL;
+	int		i, ret, requested_num = 0;
+	ssize_t		received_len;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() host:'%s' addr:'%s' num:%d", __function_name, items[0].host.host,
+			items[0].interface.addr, num);
+
+	zbx_json_init(&j, ZBX_JSON_STAT_BUF_LEN);
+	zbx_json_addstring(&j, ZBX_PROTO_TAG_REQUEST, ZBX_PROTO_VALUE_PASSIVE_CHECKS, ZBX_JSON_TYPE_STRING);
+	zbx_json_addarray(&j, ZBX_PROTO_TAG_DATA);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zbx_json_addobject(&j, NULL);
+		zbx_json_addstring(&j, ZBX_PROTO_TAG_KEY, items[i].key, ZBX_JSON_TYPE_STRING);
+		zbx_json_close(&j);
+		requested_num++;
+	}
+
+	/* single checks and TLS configuration errors are handled by the regular agent check */
+	if (2 > requested_num || SUCCEED != agent_get_tls_args(&items[0], &tls_arg1, &tls_arg2, &error))
+	{
+		zbx_free(error);
+		agent_get_values_single(items, results, errcodes, num);
+		goto out;
+	}
+
+	zbx_alarm_on(CONFIG_TIMEOUT);
+
+	if (SUCCEED == (ret = zbx_tcp_connect(&s, CONFIG_SOURCE_IP, items[0].interface.addr,
+			items[0].interface.port, 0, items[0].host.tls_connect, tls_arg1, tls_arg2)))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Sending [%s]", j.buffer);
+
+		if (SUCCEED != zbx_tcp_send(&s, j.buffer))
+			ret = NETWORK_ERROR;
+		else if (FAIL != (received_len = zbx_tcp_recv_ext(&s, 0)))
+			ret = SUCCEED;
+		else if (SUCCEED == zbx_alarm_timed_out())
+			ret = TIMEOUT_ERROR;
 		else
-			set_result_type(result, ITEM_VALUE_TYPE_TEXT, s.buffer);
+			ret = NETWORK_ERROR;
 	}
 	else
-		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror()));
+		ret = NETWORK_ERROR;
+
+	zbx_alarm_off();
+
+	if (SUCCEED == ret)
+	{
+		ret = agent_parse_bulk_response(items, results, errcodes, num, requested_num, s.buffer,
+				(size_t)received_len);
+	}
+	else if (TIMEOUT_ERROR != ret)
+	{
+		error = zbx_dsprintf(NULL, "Get value from agent failed: %s", zbx_socket_strerror());
+
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED != errcodes[i])
+				continue;
+
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, error));
+			errcodes[i] = ret;
+		}
+
+		zbx_free(error);
+	}
 
 	zbx_tcp_close(&s);
+
+	if (FAIL == ret)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "cannot poll agent at [%s] with bulk requests, falling back to single"
+				" requests", items[0].interface.addr);
+
+		DCconfig_disable_interface_agent_bulk(items[0].interface.interfaceid, (int)time(NULL));
+		agent_get_values_single(items, results, errcodes, num);
+	}
+	else if (TIMEOUT_ERROR == ret)
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "bulk request to agent at [%s] timed out, falling back to single requests",
+				items[0].interface.addr);
+
+		agent_get_values_single(items, results, errcodes, num);
+	}
 out:
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+	zbx_json_free(&j);
 
-	return ret;
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
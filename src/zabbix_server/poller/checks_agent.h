@@ -25,6 +25,8 @@
 
 extern char	*CONFIG_SOURCE_IP;
 
-int	get_value_agent(DC_ITEM *item, AGENT_RESULT *result);
+int	get_value_agent(const DC_ITEM *item, AGENT_RESULT *result);
+void	get_values_agent(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
+void	get_values_agent_bulk(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
 
 #endif
@@ -47,7 +47,8 @@ int	get_value_db(DC_ITEM *item, AGENT_RESULT *result)
 	const char		*dsn;
 	zbx_odbc_data_source_t	*data_source;
 	zbx_odbc_query_result_t	*query_result;
-	char			*error = NULL;
+	char			*error = NULL, *text = NULL;
+	int			reused, attempt;
 	int			(*query_result_to_text)(zbx_odbc_query_result_t *query_result, char **text, char **error),
 				ret = NOTSUPPORTED;
 
@@ -91,22 +92,36 @@ int	get_value_db(DC_ITEM *item, AGENT_RESULT *result)
 		goto out;
 	}
 
-	if (NULL != (data_source = zbx_odbc_connect(dsn, item->username, item->password, CONFIG_TIMEOUT, &error)))
+	for (attempt = 0; attempt < 2; attempt++)
 	{
-		if (NULL != (query_result = zbx_odbc_select(data_source, item->params, &error)))
+		if (NULL == (data_source = zbx_odbc_pool_connect(dsn, item->username, item->password, CONFIG_TIMEOUT,
+				&reused, &error)))
 		{
-			char	*text = NULL;
+			break;
+		}
+
+		if (NULL == (query_result = zbx_odbc_select(data_source, item->params, &error)))
+		{
+			zbx_odbc_pool_release(data_source, FAIL);
 
-			if (SUCCEED == query_result_to_text(query_result, &text, &error))
-			{
-				SET_TEXT_RESULT(result, text);
-				ret = SUCCEED;
-			}
+			/* pooled connection might have been closed by data source, retry once with a new connection */
+			if (0 == reused || 0 != attempt)
+				break;
 
-			zbx_odbc_query_result_free(query_result);
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() query failed on pooled connection: %s", __function_name, error);
+			zbx_free(error);
+			continue;
+		}
+
+		if (SUCCEED == query_result_to_text(query_result, &text, &error))
+		{
+			SET_TEXT_RESULT(result, text);
+			ret = SUCCEED;
 		}
 
-		zbx_odbc_data_source_free(data_source);
+		zbx_odbc_query_result_free(query_result);
+		zbx_odbc_pool_release(data_source, SUCCEED);
+		break;
 	}
 
 	if (SUCCEED != ret)
@@ -20,10 +20,515 @@
 #include "common.h"
 #include "log.h"
 #include "zbxexec.h"
+#include "zbxjson.h"
+#include "threads.h"
 
 #include "checks_external.h"
 
 extern char	*CONFIG_EXTERNALSCRIPTS;
+extern char	*CONFIG_EXTERNALSCRIPTS_PERSISTENT;
+
+/*
+ * Persistent external checks
+ * ==========================
+ *
+ * Scripts listed in PersistentExternalScripts parameter are started once per poller process (without arguments) and
+ * then receive requests on stdin and send responses to stdout:
+ *
+ *   request  - one line with item key parameters as JSON array, for example ["param1","param2"]
+ *   response - header line "OK <length>" or "ERROR <length>" followed by <length> bytes of value or error message
+ *
+ * The script is restarted if it exits, does not respond in Timeout seconds or violates the protocol, including output
+ * written after the response. The script must exit when its stdin is closed. The script stderr is discarded.
+ */
+
+typedef struct
+{
+	char	*script;
+	pid_t	pid;
+	int	fd_in;		/* write end of script stdin */
+	int	fd_out;		/* read end of script stdout */
+}
+zbx_external_worker_t;
+
+#define ZBX_EXTERNAL_READ_SIZE	4096
+
+static zbx_vector_ptr_t	external_workers;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_stop                                             *
+ *                                                                            *
+ * Purpose: terminates persistent external script and frees its resources     *
+ *                                                                            *
+ ******************************************************************************/
+static void	external_worker_stop(zbx_external_worker_t *worker)
+{
+	int	i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "stopping persistent external script \"%s\" pid:%d", worker->script,
+			(int)worker->pid);
+
+	close(worker->fd_in);
+	close(worker->fd_out);
+
+	/* kill the whole process group, pid is the leader */
+	if (-1 == kill(-worker->pid, SIGTERM) && ESRCH != errno)
+	{
+		zabbix_log(LOG_LEVEL_ERR, "failed to kill persistent external script \"%s\": %s", worker->script,
+				zbx_strerror(errno));
+	}
+
+	while (-1 == waitpid(worker->pid, NULL, 0) && EINTR == errno)
+		;
+
+	if (FAIL != (i = zbx_vector_ptr_search(&external_workers, worker, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+		zbx_vector_ptr_remove_noorder(&external_workers, i);
+
+	zbx_free(worker->script);
+	zbx_free(worker);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_start                                            *
+ *                                                                            *
+ * Purpose: starts persistent external script                                 *
+ *                                                                            *
+ * Parameters: script        - [IN] the script name                           *
+ *             path          - [IN] the script path                           *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: the started script or NULL on error                          *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_external_worker_t	*external_worker_start(const char *script, const char *path, char *error,
+		size_t max_error_len)
+{
+	zbx_external_worker_t	*worker;
+	int			fd_in[2], fd_out[2], fd_null, stderr_orig;
+	pid_t			pid;
+
+	if (-1 == pipe(fd_in))
+	{
+		zbx_snprintf(error, max_error_len, "cannot create pipe: %s", zbx_strerror(errno));
+		return NULL;
+	}
+
+	if (-1 == pipe(fd_out))
+	{
+		zbx_snprintf(error, max_error_len, "cannot create pipe: %s", zbx_strerror(errno));
+		close(fd_in[0]);
+		close(fd_in[1]);
+		return NULL;
+	}
+
+	if (-1 == (pid = zbx_fork()))
+	{
+		zbx_snprintf(error, max_error_len, "cannot fork: %s", zbx_strerror(errno));
+		close(fd_in[0]);
+		close(fd_in[1]);
+		close(fd_out[0]);
+		close(fd_out[1]);
+		return NULL;
+	}
+
+	if (0 == pid)
+	{
+		/* set the child as the process group leader, otherwise orphans may be left after kill */
+		if (-1 == setpgid(0, 0))
+		{
+			zabbix_log(LOG_LEVEL_ERR, "cannot create process group for persistent external script"
+					" \"%s\": %s", path, zbx_strerror(errno));
+			exit(EXIT_FAILURE);
+		}
+
+		/* preserve stderr to restore it in case execl() fails */
+		stderr_orig = dup(STDERR_FILENO);
+		fcntl(stderr_orig, F_SETFD, FD_CLOEXEC);
+
+		/* script diagnostics must not end up in the log file mixed with our output */
+		if (-1 != (fd_null = open("/dev/null", O_WRONLY)))
+		{
+			dup2(fd_null, STDERR_FILENO);
+			close(fd_null);
+		}
+
+		dup2(fd_in[0], STDIN_FILENO);
+		dup2(fd_out[1], STDOUT_FILENO);
+		close(fd_in[0]);
+		close(fd_in[1]);
+		close(fd_out[0]);
+		close(fd_out[1]);
+
+		execl(path, path, NULL);
+
+		dup2(stderr_orig, STDERR_FILENO);
+		close(stderr_orig);
+
+		/* stdout is the pipe now, the failure is reported to log and to server by closed pipe */
+		zabbix_log(LOG_LEVEL_WARNING, "execl() failed for [%s]: %s", path, zbx_strerror(errno));
+		exit(EXIT_FAILURE);
+	}
+
+	close(fd_in[0]);
+	close(fd_out[1]);
+
+	/* pipes must not be inherited by other scripts, otherwise the script would not see its stdin closed */
+	fcntl(fd_in[1], F_SETFD, FD_CLOEXEC);
+	fcntl(fd_out[0], F_SETFD, FD_CLOEXEC);
+	fcntl(fd_in[1], F_SETFL, fcntl(fd_in[1], F_GETFL) | O_NONBLOCK);
+	fcntl(fd_out[0], F_SETFL, fcntl(fd_out[0], F_GETFL) | O_NONBLOCK);
+
+	worker = (zbx_external_worker_t *)zbx_malloc(NULL, sizeof(zbx_external_worker_t));
+	worker->script = zbx_strdup(NULL, script);
+	worker->pid = pid;
+	worker->fd_in = fd_in[1];
+	worker->fd_out = fd_out[0];
+
+	zbx_vector_ptr_append(&external_workers, worker);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "started persistent external script \"%s\" pid:%d", script, (int)pid);
+
+	return worker;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_wait                                             *
+ *                                                                            *
+ * Purpose: waits until script pipe is ready for reading or writing           *
+ *                                                                            *
+ * Parameters: fd       - [IN] the pipe file descriptor                       *
+ *             write    - [IN] 1 - wait for writing, 0 - wait for reading     *
+ *             deadline - [IN] the request deadline                           *
+ *                                                                            *
+ * Return value: SUCCEED - the pipe is ready                                  *
+ *               TIMEOUT_ERROR - the deadline has passed                      *
+ *               FAIL - select() failed                                       *
+ *                                                                            *
+ ******************************************************************************/
+static int	external_worker_wait(int fd, int write, double deadline)
+{
+	fd_set		fdset;
+	struct timeval	tv;
+	double		sec;
+	int		rc;
+
+	do
+	{
+		if (0 >= (sec = deadline - zbx_time()))
+			return TIMEOUT_ERROR;
+
+		tv.tv_sec = (time_t)sec;
+		tv.tv_usec = (long)((sec - tv.tv_sec) * 1000000);
+
+		FD_ZERO(&fdset);
+		FD_SET(fd, &fdset);
+
+		rc = select(fd + 1, 0 == write ? &fdset : NULL, 0 != write ? &fdset : NULL, NULL, &tv);
+	}
+	while (0 == rc || (-1 == rc && EINTR == errno));
+
+	return -1 == rc ? FAIL : SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_is_idle                                          *
+ *                                                                            *
+ * Purpose: checks that script has not written anything to stdout or exited   *
+ *          since the last response                                           *
+ *                                                                            *
+ * Return value: SUCCEED - the script is waiting for request                  *
+ *               FAIL - the script has pending output, has exited or select() *
+ *                      failed                                                *
+ *                                                                            *
+ *****************************************************************************/
+static int	external_worker_is_idle(const zbx_external_worker_t *worker)
+{
+	fd_set		fdset;
+	struct timeval	tv = {0, 0};
+
+	FD_ZERO(&fdset);
+	FD_SET(worker->fd_out, &fdset);
+
+	return 0 == select(worker->fd_out + 1, &fdset, NULL, NULL, &tv) ? SUCCEED : FAIL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_write                                            *
+ *                                                                            *
+ * Purpose: writes request to script stdin                                    *
+ *                                                                            *
+ * Return value: SUCCEED - the request was written                            *
+ *               TIMEOUT_ERROR - the deadline has passed                      *
+ *               FAIL - the script has closed its stdin or other error        *
+ *                                                                            *
+ ******************************************************************************/
+static int	external_worker_write(zbx_external_worker_t *worker, const char *data, size_t size, double deadline,
+		char *error, size_t max_error_len)
+{
+	ssize_t	n;
+	int	ret;
+
+	while (0 != size)
+	{
+		if (-1 == (n = write(worker->fd_in, data, size)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN != errno)
+			{
+				zbx_snprintf(error, max_error_len, "cannot write to script: %s", zbx_strerror(errno));
+				return FAIL;
+			}
+
+			if (SUCCEED != (ret = external_worker_wait(worker->fd_in, 1, deadline)))
+			{
+				zbx_snprintf(error, max_error_len, "cannot write to script: %s", TIMEOUT_ERROR == ret ?
+						"timeout" : zbx_strerror(errno));
+				return ret;
+			}
+
+			continue;
+		}
+
+		data += n;
+		size -= (size_t)n;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: external_worker_read                                             *
+ *                                                                            *
+ * Purpose: reads response from script stdout                                 *
+ *                                                                            *
+ * Parameters: worker        - [IN] the persistent script                     *
+ *             value         - [OUT] the value or error message returned by   *
+ *                                   script                                   *
+ *             deadline      - [IN] the request deadline                      *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED - the script returned value                          *
+ *               NOTSUPPORTED - the script returned error message             *
+ *               TIMEOUT_ERROR - the deadline has passed                      *
+ *               FAIL - the script has exited or violated the protocol        *
+ *                                                                            *
+ ******************************************************************************/
+static int	external_worker_read(zbx_external_worker_t *worker, char **value, double deadline, char *error,
+		size_t max_error_len)
+{
+	char		*buf = NULL, *body = NULL, *ptr;
+	size_t		buf_alloc = ZBX_EXTERNAL_READ_SIZE, buf_offset = 0, len = 0;
+	ssize_t		n;
+	int		ret = FAIL, rc;
+	zbx_uint64_t	length;
+
+	buf = (char *)zbx_malloc(NULL, buf_alloc);
+
+	while (NULL == body || buf_offset < (size_t)(body - buf) + len)
+	{
+		if (buf_alloc - buf_offset < ZBX_EXTERNAL_READ_SIZE)
+		{
+			buf_alloc *= 2;
+			ptr = buf;
+			buf = (char *)zbx_realloc(buf, buf_alloc);
+
+			if (NULL != body)
+				body = buf + (body - ptr);
+		}
+
+		if (-1 == (n = read(worker->fd_out, buf + buf_offset, buf_alloc - buf_offset - 1)))
+		{
+			if (EINTR == errno)
+				continue;
+
+			if (EAGAIN != errno)
+			{
+				zbx_snprintf(error, max_error_len, "cannot read from script: %s", zbx_strerror(errno));
+				goto out;
+			}
+
+			if (SUCCEED != (ret = external_worker_wait(worker->fd_out, 0, deadline)))
+			{
+				if (TIMEOUT_ERROR == ret)
+					zbx_strlcpy(error, "Timeout while waiting for script response.", max_error_len);
+				else
+					zbx_snprintf(error, max_error_len, "cannot read from script: %s", zbx_strerror(errno));
+				goto out;
+			}
+
+			ret = FAIL;
+			continue;
+		}
+
+		if (0 == n)
+		{
+			zbx_strlcpy(error, "Script has exited.", max_error_len);
+			goto out;
+		}
+
+		buf_offset += (size_t)n;
+		buf[buf_offset] = '\0';
+
+		if (NULL != body || NULL == (ptr = strchr(buf, '\n')))
+			continue;
+
+		*ptr = '\0';
+
+		if (0 == strncmp(buf, "OK ", ZBX_CONST_STRLEN("OK ")))
+			rc = SUCCEED;
+		else if (0 == strncmp(buf, "ERROR ", ZBX_CONST_STRLEN("ERROR ")))
+			rc = NOTSUPPORTED;
+		else
+			rc = FAIL;
+
+		if (FAIL == rc || SUCCEED != is_uint64(strchr(buf, ' ') + 1, &length) ||
+				MAX_EXECUTE_OUTPUT_LEN < length)
+		{
+			zbx_snprintf(error, max_error_len, "Invalid script response header \"%.*s\".", 64, buf);
+			goto out;
+		}
+
+		ret = rc;
+		len = (size_t)length;
+		body = ptr + 1;
+	}
+
+	if (buf_offset != (size_t)(body - buf) + len)
+	{
+		zbx_strlcpy(error, "Script returned more data than specified in response header.", max_error_len);
+		ret = FAIL;
+		goto out;
+	}
+
+	body[len] = '\0';
+	*value = zbx_strdup(NULL, body);
+out:
+	if (FAIL == ret || TIMEOUT_ERROR == ret)
+		*value = NULL;
+
+	zbx_free(buf);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_value_external_persistent                                    *
+ *                                                                            *
+ * Purpose: retrieve data from persistent script running on Zabbix server     *
+ *                                                                            *
+ * Parameters: path    - [IN] the script path                                 *
+ *             request - [IN] the item key request                            *
+ *             result  - [OUT] the check result                               *
+ *                                                                            *
+ * Return value: SUCCEED - data successfully retrieved and stored in result   *
+ *               NOTSUPPORTED - requested item is not supported               *
+ *                                                                            *
+ ******************************************************************************/
+static int	get_value_external_persistent(const char *path, AGENT_REQUEST *request, AGENT_RESULT *result)
+{
+	const char		*__function_name = "get_value_external_persistent";
+
+	zbx_external_worker_t	*worker = NULL;
+	struct zbx_json		j;
+	char			error[ITEM_ERROR_LEN_MAX], *value = NULL, *line;
+	int			i, ret = NOTSUPPORTED, rc, started = 0;
+	double			deadline;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() script:'%s'", __function_name, get_rkey(request));
+
+	if (NULL == external_workers.values)
+		zbx_vector_ptr_create(&external_workers);
+
+	for (i = 0; i < external_workers.values_num; i++)
+	{
+		if (0 == strcmp(((zbx_external_worker_t *)external_workers.values[i])->script, get_rkey(request)))
+		{
+			worker = (zbx_external_worker_t *)external_workers.values[i];
+			break;
+		}
+	}
+
+	/* leftover output would be taken as the response to this request */
+	if (NULL != worker && SUCCEED != external_worker_is_idle(worker))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "persistent external script \"%s\" has unexpected output or has exited,"
+				" restarting", worker->script);
+		external_worker_stop(worker);
+		worker = NULL;
+	}
+
+	zbx_json_initarray(&j, ZBX_JSON_STAT_BUF_LEN);
+
+	for (i = 0; i < get_rparams_num(request); i++)
+		zbx_json_addstring(&j, NULL, get_rparam(request, i), ZBX_JSON_TYPE_STRING);
+
+	line = zbx_dsprintf(NULL, "%s\n", j.buffer);
+	zbx_json_free(&j);
+
+	deadline = zbx_time() + CONFIG_TIMEOUT;
+
+	while (1)
+	{
+		if (NULL == worker)
+		{
+			if (NULL == (worker = external_worker_start(get_rkey(request), path, error, sizeof(error))))
+				goto out;
+
+			started = 1;
+		}
+
+		if (SUCCEED == (rc = external_worker_write(worker, line, strlen(line), deadline, error,
+				sizeof(error))))
+		{
+			break;
+		}
+
+		external_worker_stop(worker);
+		worker = NULL;
+
+		/* the script may have exited after the previous request, start it again once */
+		if (TIMEOUT_ERROR == rc || 0 != started)
+			goto out;
+	}
+
+	if (FAIL == (rc = external_worker_read(worker, &value, deadline, error, sizeof(error))) ||
+			TIMEOUT_ERROR == rc)
+	{
+		external_worker_stop(worker);
+		goto out;
+	}
+
+	if (SUCCEED == rc)
+	{
+		zbx_rtrim(value, ZBX_WHITESPACE);
+		set_result_type(result, ITEM_VALUE_TYPE_TEXT, value);
+		ret = SUCCEED;
+	}
+	else
+		zbx_strlcpy(error, value, sizeof(error));
+
+	zbx_free(value);
+out:
+	if (SUCCEED != ret)
+		SET_MSG_RESULT(result, zbx_strdup(NULL, error));
+
+	zbx_free(line);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ret;
+}
 
 /******************************************************************************
  *                                                                            *
@@ -68,6 +573,13 @@ int	get_value_external(DC_ITEM *item, AGENT_RESULT *result)
 		goto out;
 	}
 
+	if (NULL != CONFIG_EXTERNALSCRIPTS_PERSISTENT &&
+			SUCCEED == str_in_list(CONFIG_EXTERNALSCRIPTS_PERSISTENT, get_rkey(&request), ','))
+	{
+		ret = get_value_external_persistent(cmd, &request, result);
+		goto out;
+	}
+
 	for (i = 0; i < get_rparams_num(&request); i++)
 	{
 		const char	*param;
@@ -39,6 +39,16 @@ typedef struct
 }
 zbx_http_response_t;
 
+typedef struct
+{
+	CURL			*easyhandle;
+	struct curl_slist	*headers_slist;
+	zbx_http_response_t	body;
+	zbx_http_response_t	header;
+	char			errbuf[CURL_ERROR_SIZE];
+}
+zbx_http_context_t;
+
 static const char	*zbx_request_string(int result)
 {
 	switch (result)
@@ -206,31 +216,30 @@ static void	http_output_json(unsigned char retrieve_mode, char **buffer, zbx_htt
 	zbx_json_free(&json);
 }
 
-int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+/******************************************************************************
+ *                                                                            *
+ * Function: http_request_prepare                                             *
+ *                                                                            *
+ * Purpose: sets up cURL easy handle to perform HTTP agent item request       *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] the request context with initialized easy   *
+ *                                handle                                      *
+ *             item    - [IN] the item                                        *
+ *             result  - [OUT] the error message                              *
+ *                                                                            *
+ * Return value: SUCCEED      - the request is ready to be performed          *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_request_prepare(zbx_http_context_t *context, const DC_ITEM *item, AGENT_RESULT *result)
 {
-	const char		*__function_name = "get_value_http";
-
-	CURL			*easyhandle;
-	CURLcode		err;
-	char			url[ITEM_URL_LEN_MAX], errbuf[CURL_ERROR_SIZE], *error = NULL, *headers, *line, *buffer;
-	int			ret = NOTSUPPORTED, timeout_seconds, found = FAIL;
-	long			response_code;
-	struct curl_slist	*headers_slist = NULL;
-	struct zbx_json		json;
-	zbx_http_response_t	body = {0}, header = {0};
-	size_t			(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
-	char			application_json[] = {"Content-Type: application/json"};
-	char			application_xml[] = {"Content-Type: application/xml"};
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
-			__function_name, zbx_request_string(item->request_method), item->url, item->query_fields,
-			item->headers, item->posts);
-
-	if (NULL == (easyhandle = curl_easy_init()))
-	{
-		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize cURL library"));
-		goto clean;
-	}
+	CURL		*easyhandle = context->easyhandle;
+	CURLcode	err;
+	char		url[ITEM_URL_LEN_MAX], *error = NULL, *headers, *line;
+	int		timeout_seconds, found = FAIL;
+	size_t		(*curl_body_cb)(void *ptr, size_t size, size_t nmemb, void *userdata);
+	char		application_json[] = {"Content-Type: application/json"};
+	char		application_xml[] = {"Content-Type: application/xml"};
 
 	switch (item->retrieve_mode)
 	{
@@ -244,52 +253,52 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 		default:
 			THIS_SHOULD_NEVER_HAPPEN;
 			SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid retrieve mode"));
-			goto clean;
+			return NOTSUPPORTED;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERFUNCTION, curl_write_cb)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header function: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERDATA, &header)))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HEADERDATA, &context->header)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set header callback: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_body_cb)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write function: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &body)))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, &context->body)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set write callback: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, errbuf)))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_ERRORBUFFER, context->errbuf)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set error buffer: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_PROXY, item->http_proxy)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set proxy: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_FOLLOWLOCATION,
 			0 == item->follow_redirects ? 0L : 1L)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set follow redirects: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (0 != item->follow_redirects &&
@@ -297,44 +306,44 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot set number of redirects allowed: %s",
 				curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (FAIL == is_time_suffix(item->timeout, &timeout_seconds, strlen(item->timeout)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Invalid timeout: %s", item->timeout));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_TIMEOUT, (long)timeout_seconds)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify timeout: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (SUCCEED != zbx_http_prepare_ssl(easyhandle, item->ssl_cert_file, item->ssl_key_file, item->ssl_key_password,
 			item->verify_peer, item->verify_host, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (SUCCEED != zbx_http_prepare_auth(easyhandle, item->authtype, item->username, item->password, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if (SUCCEED != http_prepare_request(easyhandle, item->posts, item->request_method, &error))
 	{
 		SET_MSG_RESULT(result, error);
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	headers = item->headers;
 	while (NULL != (line = zbx_http_get_header(&headers)))
 	{
-		headers_slist = curl_slist_append(headers_slist, line);
+		context->headers_slist = curl_slist_append(context->headers_slist, line);
 
 		if (FAIL == found && 0 == strncmp(line, "Content-Type:", ZBX_CONST_STRLEN("Content-Type:")))
 			found = SUCCEED;
@@ -345,90 +354,117 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 	if (FAIL == found)
 	{
 		if (ZBX_POSTTYPE_JSON == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_json);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_json);
 		else if (ZBX_POSTTYPE_XML == item->post_type)
-			headers_slist = curl_slist_append(headers_slist, application_xml);
+			context->headers_slist = curl_slist_append(context->headers_slist, application_xml);
 	}
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, headers_slist)))
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_HTTPHEADER, context->headers_slist)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify headers: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	zbx_snprintf(url, sizeof(url),"%s%s", item->url, item->query_fields);
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_URL, url)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot specify URL: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	*errbuf = '\0';
+	*context->errbuf = '\0';
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_request_finish                                              *
+ *                                                                            *
+ * Purpose: checks the performed HTTP agent item request and converts the     *
+ *          received response into the item value                             *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] the request context                         *
+ *             item    - [IN] the item                                        *
+ *             err     - [IN] the request result code                         *
+ *             result  - [OUT] the item value or error message                *
+ *                                                                            *
+ * Return value: SUCCEED      - the value was retrieved successfully          *
+ *               NOTSUPPORTED - otherwise                                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_request_finish(zbx_http_context_t *context, const DC_ITEM *item, CURLcode err,
+		AGENT_RESULT *result)
+{
+	char			*headers, *line, *buffer;
+	long			response_code;
+	struct zbx_json		json;
+	zbx_http_response_t	*body = &context->body, *header = &context->header;
 
-	if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+	if (CURLE_OK != err)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot perform request: %s",
-				'\0' == *errbuf ? curl_easy_strerror(err) : errbuf));
-		goto clean;
+				'\0' == *context->errbuf ? curl_easy_strerror(err) : context->errbuf));
+		return NOTSUPPORTED;
 	}
 
-	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
+	if (CURLE_OK != (err = curl_easy_getinfo(context->easyhandle, CURLINFO_RESPONSE_CODE, &response_code)))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot get the response code: %s", curl_easy_strerror(err)));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	if ('\0' != *item->status_codes && FAIL == int_in_list(item->status_codes, response_code))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Response code \"%ld\" did not match any of the"
 				" required status codes \"%s\"", response_code, item->status_codes));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
-	if (NULL == header.data)
+	if (NULL == header->data)
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty header"));
-		goto clean;
+		return NOTSUPPORTED;
 	}
 
 	switch (item->retrieve_mode)
 	{
 		case ZBX_RETRIEVE_MODE_CONTENT:
-			if (NULL == body.data)
+			if (NULL == body->data)
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned empty content"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
-			if (FAIL == zbx_is_utf8(body.data))
+			if (FAIL == zbx_is_utf8(body->data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, header, body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, body.data);
-				body.data = NULL;
+				SET_TEXT_RESULT(result, body->data);
+				body->data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_HEADERS:
-			if (FAIL == zbx_is_utf8(header.data))
+			if (FAIL == zbx_is_utf8(header->data))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
 				zbx_json_init(&json, ZBX_JSON_STAT_BUF_LEN);
 				zbx_json_addobject(&json, "header");
-				headers = header.data;
+				headers = header->data;
 				while (NULL != (line = zbx_http_get_header(&headers)))
 				{
 					http_add_json_header(&json, line);
@@ -439,40 +475,304 @@ int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
 			}
 			else
 			{
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				SET_TEXT_RESULT(result, header->data);
+				header->data = NULL;
 			}
 			break;
 		case ZBX_RETRIEVE_MODE_BOTH:
-			if (FAIL == zbx_is_utf8(header.data) || (NULL != body.data && FAIL == zbx_is_utf8(body.data)))
+			if (FAIL == zbx_is_utf8(header->data) || (NULL != body->data && FAIL == zbx_is_utf8(body->data)))
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Server returned invalid UTF-8 sequence"));
-				goto clean;
+				return NOTSUPPORTED;
 			}
 
 			if (HTTP_STORE_JSON == item->output_format)
 			{
-				http_output_json(item->retrieve_mode, &buffer, &header, &body);
+				http_output_json(item->retrieve_mode, &buffer, header, body);
 				SET_TEXT_RESULT(result, buffer);
 			}
 			else
 			{
-				zbx_strncpy_alloc(&header.data, &header.allocated, &header.offset,
-						body.data, body.offset);
-				SET_TEXT_RESULT(result, header.data);
-				header.data = NULL;
+				zbx_strncpy_alloc(&header->data, &header->allocated, &header->offset,
+						body->data, body->offset);
+				SET_TEXT_RESULT(result, header->data);
+				header->data = NULL;
 			}
 			break;
 	}
 
-	ret = SUCCEED;
-clean:
-	curl_slist_free_all(headers_slist);	/* must be called after curl_easy_perform() */
-	curl_easy_cleanup(easyhandle);
-	zbx_free(body.data);
-	zbx_free(header.data);
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_context_clean                                               *
+ *                                                                            *
+ * Purpose: releases resources allocated by HTTP agent item request           *
+ *                                                                            *
+ * Parameters: context - [IN/OUT] the request context                         *
+ *                                                                            *
+ * Comments: The cURL easy handle is not released.                            *
+ *                                                                            *
+ ******************************************************************************/
+static void	http_context_clean(zbx_http_context_t *context)
+{
+	curl_slist_free_all(context->headers_slist);	/* must be called after curl_easy_perform() */
+	context->headers_slist = NULL;
+	zbx_free(context->body.data);
+	zbx_free(context->header.data);
+}
+
+int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result)
+{
+	const char		*__function_name = "get_value_http";
+
+	zbx_http_context_t	context;
+	int			ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
+			__function_name, zbx_request_string(item->request_method), item->url, item->query_fields,
+			item->headers, item->posts);
+
+	memset(&context, 0, sizeof(context));
+
+	if (NULL == (context.easyhandle = curl_easy_init()))
+	{
+		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize cURL library"));
+		ret = NOTSUPPORTED;
+		goto out;
+	}
+
+	if (SUCCEED == (ret = http_request_prepare(&context, item, result)))
+		ret = http_request_finish(&context, item, curl_easy_perform(context.easyhandle), result);
+
+	http_context_clean(&context);
+	curl_easy_cleanup(context.easyhandle);
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
 
 	return ret;
 }
+
+/* curl_multi_wait() is supported starting with version 7.28.0 (0x071c00) */
+#if LIBCURL_VERSION_NUM >= 0x071c00
+
+#define ZBX_HTTP_WAIT_TIMEOUT	1000	/* milliseconds */
+
+/* cURL handles kept between polling rounds to reuse connections, TLS sessions and DNS cache */
+static CURLM		*curl_multi = NULL;
+static CURLSH		*curl_share = NULL;
+static zbx_vector_ptr_t	curl_handles;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_multi_init                                                  *
+ *                                                                            *
+ * Purpose: initializes cURL multi and share handles on first use             *
+ *                                                                            *
+ * Return value: SUCCEED - the handles are initialized                        *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	http_multi_init(void)
+{
+	if (NULL != curl_multi)
+		return SUCCEED;
+
+	if (NULL == (curl_multi = curl_multi_init()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize cURL multi handle");
+		return FAIL;
+	}
+
+	if (NULL != (curl_share = curl_share_init()))
+	{
+		/* the share handle is used by a single thread, so no locking callbacks are needed */
+		curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+		curl_share_setopt(curl_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+	}
+	else
+		zabbix_log(LOG_LEVEL_WARNING, "cannot initialize cURL share handle");
+
+	/* keep idle connections of all handles in the pool for reuse by the next checks */
+	curl_multi_setopt(curl_multi, CURLMOPT_MAXCONNECTS, (long)MAX_HTTPAGENT_POLLER_ITEMS);
+
+	zbx_vector_ptr_create(&curl_handles);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: http_handle_acquire                                              *
+ *                                                                            *
+ * Purpose: gets cURL easy handle from the idle handle pool or creates new    *
+ *                                                                            *
+ * Return value: the cURL easy handle or NULL on failure                      *
+ *                                                                            *
+ ******************************************************************************/
+static CURL	*http_handle_acquire(void)
+{
+	CURL	*easyhandle;
+
+	if (0 == curl_handles.values_num)
+		easyhandle = curl_easy_init();
+	else
+	{
+		easyhandle = (CURL *)curl_handles.values[curl_handles.values_num - 1];
+		zbx_vector_ptr_remove_noorder(&curl_handles, curl_handles.values_num - 1);
+		curl_easy_reset(easyhandle);
+	}
+
+	if (NULL != easyhandle && NULL != curl_share)
+		curl_easy_setopt(easyhandle, CURLOPT_SHARE, curl_share);
+
+	return easyhandle;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_http                                                  *
+ *                                                                            *
+ * Purpose: retrieve values of multiple HTTP agent items concurrently         *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: The requests are driven by a cURL multi handle kept for the      *
+ *           process lifetime, so connections and TLS sessions are reused by  *
+ *           subsequent checks of the same hosts. Each request is limited by  *
+ *           its item timeout.                                                *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_http(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	const char		*__function_name = "get_values_http";
+
+	zbx_http_context_t	*contexts;
+	CURLMsg			*msg;
+	CURLMcode		mcode;
+	int			i, running = 0, active_num = 0, msgs_num, fds;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __function_name, num);
+
+	if (SUCCEED != http_multi_init())
+	{
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED == errcodes[i])
+				errcodes[i] = get_value_http(&items[i], &results[i]);
+		}
+
+		goto out;
+	}
+
+	contexts = (zbx_http_context_t *)zbx_malloc(NULL, sizeof(zbx_http_context_t) * num);
+	memset(contexts, 0, sizeof(zbx_http_context_t) * num);
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() request method '%s' URL '%s%s' headers '%s' message body '%s'",
+				__function_name, zbx_request_string(items[i].request_method), items[i].url,
+				items[i].query_fields, items[i].headers, items[i].posts);
+
+		if (NULL == (contexts[i].easyhandle = http_handle_acquire()))
+		{
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Cannot initialize cURL library"));
+			errcodes[i] = NOTSUPPORTED;
+			continue;
+		}
+
+		if (SUCCEED != (errcodes[i] = http_request_prepare(&contexts[i], &items[i], &results[i])))
+			continue;
+
+		curl_easy_setopt(contexts[i].easyhandle, CURLOPT_PRIVATE, &contexts[i]);
+
+		if (CURLM_OK != (mcode = curl_multi_add_handle(curl_multi, contexts[i].easyhandle)))
+		{
+			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "Cannot add request: %s",
+					curl_multi_strerror(mcode)));
+			errcodes[i] = NOTSUPPORTED;
+			continue;
+		}
+
+		active_num++;
+	}
+
+	while (0 < active_num)
+	{
+		if (CURLM_OK != (mcode = curl_multi_perform(curl_multi, &running)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot perform on cURL multi handle: %s",
+					curl_multi_strerror(mcode));
+			break;
+		}
+
+		while (NULL != (msg = curl_multi_info_read(curl_multi, &msgs_num)))
+		{
+			zbx_http_context_t	*context;
+
+			if (CURLMSG_DONE != msg->msg)
+				continue;
+
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE, (char **)&context);
+			i = (int)(context - contexts);
+
+			errcodes[i] = http_request_finish(context, &items[i], msg->data.result, &results[i]);
+
+			curl_multi_remove_handle(curl_multi, msg->easy_handle);
+			active_num--;
+		}
+
+		if (0 == running)
+			break;
+
+		if (CURLM_OK != (mcode = curl_multi_wait(curl_multi, NULL, 0, ZBX_HTTP_WAIT_TIMEOUT, &fds)))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait on cURL multi handle: %s",
+					curl_multi_strerror(mcode));
+			break;
+		}
+	}
+
+	for (i = 0; i < num; i++)
+	{
+		if (NULL == contexts[i].easyhandle)
+			continue;
+
+		/* requests left unfinished after cURL multi handle failure */
+		if (SUCCEED == errcodes[i] && !ISSET_TEXT(&results[i]))
+		{
+			curl_multi_remove_handle(curl_multi, contexts[i].easyhandle);
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Cannot perform request: cURL multi handle"
+					" failure"));
+			errcodes[i] = NOTSUPPORTED;
+		}
+
+		http_context_clean(&contexts[i]);
+		zbx_vector_ptr_append(&curl_handles, contexts[i].easyhandle);
+	}
+
+	zbx_free(contexts);
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
+#else
+void	get_values_http(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	int	i;
+
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED == errcodes[i])
+			errcodes[i] = get_value_http(&items[i], &results[i]);
+	}
+}
+#endif
 #endif
@@ -26,6 +26,7 @@
 #include "dbcache.h"
 
 int	get_value_http(const DC_ITEM *item, AGENT_RESULT *result);
+void	get_values_http(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
 #endif
 
 #endif
@@ -684,6 +684,32 @@ int	get_value_internal(DC_ITEM *item, AGENT_RESULT *result)
 				goto out;
 			}
 		}
+		else if (0 == strcmp(tmp, "memory"))
+		{
+			zbx_uint64_t	memory[ZBX_VMWARE_MEMORY_COUNT];
+			int		i;
+
+			for (i = 0; i < ZBX_VMWARE_MEMORY_COUNT; i++)
+			{
+				if (0 == strcmp(tmp1, zbx_vmware_memory_string(i)))
+					break;
+			}
+
+			if (ZBX_VMWARE_MEMORY_COUNT == i)
+			{
+				SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid third parameter."));
+				goto out;
+			}
+
+			if (SUCCEED != zbx_vmware_get_memory_usage(memory))
+			{
+				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "No \"%s\" processes started.",
+						get_process_type_string(ZBX_PROCESS_TYPE_VMWARE)));
+				goto out;
+			}
+
+			SET_UI64_RESULT(result, memory[i]);
+		}
 		else
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
@@ -21,6 +21,7 @@
 #include "valuecache.h"
 #include "preproc.h"
 #include "zbxlld.h"
+#include "zbxipcservice.h"
 #include "checks_internal.h"
 
 /******************************************************************************
@@ -201,6 +202,34 @@ int	zbx_get_value_internal_ext(const char *param1, const AGENT_REQUEST *request,
 
 		SET_UI64_RESULT(result, value);
 	}
+	else if (0 == strcmp(param1, "ipc"))			/* zabbix["ipc",<service>] */
+	{
+		char	*service, *data = NULL, *error = NULL;
+
+		if (2 != nparams)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid number of parameters."));
+			goto out;
+		}
+
+		service = get_rparam(request, 1);
+
+		/* service name is used in socket path, allow only the characters used by Zabbix services */
+		if ('\0' == *service || strlen(service) != strspn(service, "abcdefghijklmnopqrstuvwxyz0123456789_"))
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Invalid second parameter."));
+			goto out;
+		}
+
+		if (FAIL == zbx_ipc_service_get_stats(service, &data, &error))
+		{
+			SET_MSG_RESULT(result, error);
+			goto out;
+		}
+
+		set_result_type(result, ITEM_VALUE_TYPE_TEXT, data);
+		zbx_free(data);
+	}
 	else
 	{
 		ret = FAIL;
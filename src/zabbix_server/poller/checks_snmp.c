@@ -26,6 +26,8 @@
 #include <net-snmp/net-snmp-includes.h>
 
 #include "comms.h"
+#include "memalloc.h"
+#include "mutexs.h"
 #include "zbxalgo.h"
 #include "zbxjson.h"
 
@@ -68,6 +70,10 @@
  * The cache is implemented using hash tables. In ERD:
  * zbx_snmpidx_main_key_t -------------------------------------------0< zbx_snmpidx_mapping_t
  * (OID, host, <v2c: community|v3: (context, security name)>)           (index, value)
+ *
+ * The hash tables are stored in shared memory (see SNMPIndexCacheSize) and protected by a mutex, so the index table
+ * walked by one poller is reused by all other pollers. When the shared memory is exhausted the whole cache is flushed
+ * and rebuilt on demand.
  */
 
 /******************************************************************************
@@ -101,7 +107,34 @@ typedef struct
 }
 zbx_snmpidx_mapping_t;
 
-static zbx_hashset_t	snmpidx;		/* Dynamic Index Cache */
+extern zbx_uint64_t	CONFIG_SNMPIDX_CACHE_SIZE;
+
+static zbx_mutex_t	snmpidx_lock = ZBX_MUTEX_NULL;
+
+static zbx_mem_info_t	*snmpidx_mem = NULL;
+
+ZBX_MEM_FUNC_IMPL(__snmpidx, snmpidx_mem)
+
+static zbx_hashset_t	*snmpidx = NULL;	/* Dynamic Index Cache */
+
+static char	*snmpidx_shared_strdup(const char *str)
+{
+	char	*ptr;
+	size_t	len;
+
+	len = strlen(str) + 1;
+
+	if (NULL != (ptr = (char *)__snmpidx_mem_malloc_func(NULL, len)))
+		memcpy(ptr, str, len);
+
+	return ptr;
+}
+
+static void	snmpidx_shared_free(void *ptr)
+{
+	if (NULL != ptr)
+		__snmpidx_mem_free_func(ptr);
+}
 
 static zbx_hash_t	__snmpidx_main_key_hash(const void *data)
 {
@@ -143,12 +176,16 @@ static void	__snmpidx_main_key_clean(void *data)
 {
 	zbx_snmpidx_main_key_t	*main_key = (zbx_snmpidx_main_key_t *)data;
 
-	zbx_free(main_key->addr);
-	zbx_free(main_key->oid);
-	zbx_free(main_key->community_context);
-	zbx_free(main_key->security_name);
-	zbx_hashset_destroy(main_key->mappings);
-	zbx_free(main_key->mappings);
+	snmpidx_shared_free(main_key->addr);
+	snmpidx_shared_free(main_key->oid);
+	snmpidx_shared_free(main_key->community_context);
+	snmpidx_shared_free(main_key->security_name);
+
+	if (NULL != main_key->mappings)
+	{
+		zbx_hashset_destroy(main_key->mappings);
+		__snmpidx_mem_free_func(main_key->mappings);
+	}
 }
 
 static zbx_hash_t	__snmpidx_mapping_hash(const void *data)
@@ -170,8 +207,8 @@ static void	__snmpidx_mapping_clean(void *data)
 {
 	zbx_snmpidx_mapping_t	*mapping = (zbx_snmpidx_mapping_t *)data;
 
-	zbx_free(mapping->value);
-	zbx_free(mapping->index);
+	snmpidx_shared_free(mapping->value);
+	snmpidx_shared_free(mapping->index);
 }
 
 static char	*get_item_community_context(const DC_ITEM *item)
@@ -193,6 +230,92 @@ static char	*get_item_security_name(const DC_ITEM *item)
 	return "";
 }
 
+static void	snmpidx_main_key_local_init(zbx_snmpidx_main_key_t *main_key_local, const DC_ITEM *item,
+		const char *snmp_oid)
+{
+	main_key_local->addr = item->interface.addr;
+	main_key_local->port = item->interface.port;
+	main_key_local->oid = (char *)snmp_oid;
+
+	main_key_local->community_context = get_item_community_context(item);
+	main_key_local->security_name = get_item_security_name(item);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_index_cache_init                                        *
+ *                                                                            *
+ * Purpose: initializes SNMP dynamic index cache in shared memory             *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the cache was initialized successfully             *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: This function must be called before worker threads are forked.   *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_snmp_index_cache_init(char **error)
+{
+	const char	*__function_name = "zbx_snmp_index_cache_init";
+
+	int		ret = FAIL;
+	zbx_uint64_t	size_reserved;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+
+	if (SUCCEED != zbx_mutex_create(&snmpidx_lock, ZBX_MUTEX_SNMPIDX, error))
+		goto out;
+
+	size_reserved = zbx_mem_required_size(1, "SNMP index cache size", "SNMPIndexCacheSize");
+
+	CONFIG_SNMPIDX_CACHE_SIZE -= size_reserved;
+
+	/* out of memory is handled by flushing the cache */
+	if (SUCCEED != zbx_mem_create(&snmpidx_mem, CONFIG_SNMPIDX_CACHE_SIZE, "SNMP index cache size",
+			"SNMPIndexCacheSize", 1, error))
+	{
+		goto out;
+	}
+
+	snmpidx = (zbx_hashset_t *)__snmpidx_mem_malloc_func(NULL, sizeof(zbx_hashset_t));
+
+	zbx_hashset_create_ext(snmpidx, 100, __snmpidx_main_key_hash, __snmpidx_main_key_compare,
+			__snmpidx_main_key_clean, __snmpidx_mem_malloc_func, __snmpidx_mem_realloc_func,
+			__snmpidx_mem_free_func);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_index_cache_destroy                                     *
+ *                                                                            *
+ * Purpose: destroys SNMP dynamic index cache                                 *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_snmp_index_cache_destroy(void)
+{
+	const char	*__function_name = "zbx_snmp_index_cache_destroy";
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+
+	if (NULL != snmpidx)
+	{
+		zbx_hashset_destroy(snmpidx);
+		__snmpidx_mem_free_func(snmpidx);
+		snmpidx = NULL;
+	}
+
+	zbx_mutex_destroy(&snmpidx_lock);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: cache_get_snmp_index                                             *
@@ -226,24 +349,21 @@ static int	cache_get_snmp_index(const DC_ITEM *item, const char *snmp_oid, const
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' value:'%s'", __function_name, snmp_oid, value);
 
-	if (NULL == snmpidx.slots)
+	if (NULL == snmpidx)
 		goto end;
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
-	main_key_local.oid = (char *)snmp_oid;
+	snmpidx_main_key_local_init(&main_key_local, item, snmp_oid);
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	zbx_mutex_lock(snmpidx_lock);
 
-	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
-		goto end;
-
-	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
-		goto end;
+	if (NULL != (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(snmpidx, &main_key_local)) &&
+			NULL != (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
+	{
+		zbx_strcpy_alloc(idx, idx_alloc, &idx_offset, mapping->index);
+		ret = SUCCEED;
+	}
 
-	zbx_strcpy_alloc(idx, idx_alloc, &idx_offset, mapping->index);
-	ret = SUCCEED;
+	zbx_mutex_unlock(snmpidx_lock);
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s idx:'%s'", __function_name, zbx_result_string(ret),
 			SUCCEED == ret ? *idx : "");
@@ -251,6 +371,82 @@ end:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: snmpidx_put                                                      *
+ *                                                                            *
+ * Purpose: store the index-value pair in the shared index cache              *
+ *                                                                            *
+ * Parameters: main_key_local - [IN] the index cache key                      *
+ *             index          - [IN] index part of the index-value pair       *
+ *             value          - [IN] value part of the index-value pair       *
+ *                                                                            *
+ * Return value: SUCCEED - the index-value pair was stored                    *
+ *               FAIL    - out of shared memory                               *
+ *                                                                            *
+ * Comments: The cache must be locked by the caller.                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	snmpidx_put(const zbx_snmpidx_main_key_t *main_key_local, const char *index, const char *value)
+{
+	zbx_snmpidx_main_key_t	*main_key, main_key_new;
+	zbx_snmpidx_mapping_t	*mapping, mapping_local;
+	char			*index_new;
+
+	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(snmpidx, main_key_local)))
+	{
+		memset(&main_key_new, 0, sizeof(main_key_new));
+		main_key_new.port = main_key_local->port;
+
+		if (NULL == (main_key_new.addr = snmpidx_shared_strdup(main_key_local->addr)) ||
+				NULL == (main_key_new.oid = snmpidx_shared_strdup(main_key_local->oid)) ||
+				NULL == (main_key_new.community_context =
+						snmpidx_shared_strdup(main_key_local->community_context)) ||
+				NULL == (main_key_new.security_name =
+						snmpidx_shared_strdup(main_key_local->security_name)) ||
+				NULL == (main_key_new.mappings =
+						(zbx_hashset_t *)__snmpidx_mem_malloc_func(NULL, sizeof(zbx_hashset_t))))
+		{
+			__snmpidx_main_key_clean(&main_key_new);
+			return FAIL;
+		}
+
+		zbx_hashset_create_ext(main_key_new.mappings, 0,
+				__snmpidx_mapping_hash, __snmpidx_mapping_compare, __snmpidx_mapping_clean,
+				__snmpidx_mem_malloc_func, __snmpidx_mem_realloc_func, __snmpidx_mem_free_func);
+
+		if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_insert(snmpidx, &main_key_new,
+				sizeof(main_key_new))))
+		{
+			__snmpidx_main_key_clean(&main_key_new);
+			return FAIL;
+		}
+	}
+
+	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
+	{
+		mapping_local.index = NULL;
+
+		if (NULL == (mapping_local.value = snmpidx_shared_strdup(value)) ||
+				NULL == (mapping_local.index = snmpidx_shared_strdup(index)) ||
+				NULL == zbx_hashset_insert(main_key->mappings, &mapping_local, sizeof(mapping_local)))
+		{
+			__snmpidx_mapping_clean(&mapping_local);
+			return FAIL;
+		}
+	}
+	else if (0 != strcmp(mapping->index, index))
+	{
+		if (NULL == (index_new = snmpidx_shared_strdup(index)))
+			return FAIL;
+
+		__snmpidx_mem_free_func(mapping->index);
+		mapping->index = index_new;
+	}
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: cache_put_snmp_index                                             *
@@ -264,59 +460,41 @@ end:
  *             index     - [IN] index part of the index-value pair            *
  *             value     - [IN] value part of the index-value pair            *
  *                                                                            *
+ * Comments: If the shared memory is exhausted the whole cache is flushed and *
+ *           the pair is stored again into the empty cache.                   *
+ *                                                                            *
  ******************************************************************************/
 static void	cache_put_snmp_index(const DC_ITEM *item, const char *snmp_oid, const char *index, const char *value)
 {
 	const char		*__function_name = "cache_put_snmp_index";
 
-	zbx_snmpidx_main_key_t	*main_key, main_key_local;
-	zbx_snmpidx_mapping_t	*mapping, mapping_local;
+	zbx_snmpidx_main_key_t	main_key_local;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s' index:'%s' value:'%s'", __function_name, snmp_oid, index, value);
 
-	if (NULL == snmpidx.slots)
-	{
-		zbx_hashset_create_ext(&snmpidx, 100,
-				__snmpidx_main_key_hash, __snmpidx_main_key_compare, __snmpidx_main_key_clean,
-				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-	}
+	if (NULL == snmpidx)
+		goto end;
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
-	main_key_local.oid = (char *)snmp_oid;
+	snmpidx_main_key_local_init(&main_key_local, item, snmp_oid);
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	zbx_mutex_lock(snmpidx_lock);
 
-	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
+	if (SUCCEED != snmpidx_put(&main_key_local, index, value))
 	{
-		main_key_local.addr = zbx_strdup(NULL, item->interface.addr);
-		main_key_local.oid = zbx_strdup(NULL, snmp_oid);
-
-		main_key_local.community_context = zbx_strdup(NULL, get_item_community_context(item));
-		main_key_local.security_name = zbx_strdup(NULL, get_item_security_name(item));
-
-		main_key_local.mappings = (zbx_hashset_t *)zbx_malloc(NULL, sizeof(zbx_hashset_t));
-		zbx_hashset_create_ext(main_key_local.mappings, 100,
-				__snmpidx_mapping_hash, __snmpidx_mapping_compare, __snmpidx_mapping_clean,
-				ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC, ZBX_DEFAULT_MEM_FREE_FUNC);
-
-		main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_insert(&snmpidx, &main_key_local, sizeof(main_key_local));
-	}
+		zabbix_log(LOG_LEVEL_WARNING, "SNMP index cache is full, flushing it:"
+				" consider increasing \"SNMPIndexCacheSize\" configuration parameter");
 
-	if (NULL == (mapping = (zbx_snmpidx_mapping_t *)zbx_hashset_search(main_key->mappings, &value)))
-	{
-		mapping_local.value = zbx_strdup(NULL, value);
-		mapping_local.index = zbx_strdup(NULL, index);
+		zbx_hashset_clear(snmpidx);
 
-		zbx_hashset_insert(main_key->mappings, &mapping_local, sizeof(mapping_local));
-	}
-	else if (0 != strcmp(mapping->index, index))
-	{
-		zbx_free(mapping->index);
-		mapping->index = zbx_strdup(NULL, index);
+		if (SUCCEED != snmpidx_put(&main_key_local, index, value))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot store SNMP index of \"%s\" in \"%s\": not enough space in"
+					" SNMP index cache", value, snmp_oid);
+		}
 	}
 
+	zbx_mutex_unlock(snmpidx_lock);
+end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
@@ -343,20 +521,17 @@ static void	cache_del_snmp_index_subtree(const DC_ITEM *item, const char *snmp_o
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() OID:'%s'", __function_name, snmp_oid);
 
-	if (NULL == snmpidx.slots)
+	if (NULL == snmpidx)
 		goto end;
 
-	main_key_local.addr = item->interface.addr;
-	main_key_local.port = item->interface.port;
-	main_key_local.oid = (char *)snmp_oid;
+	snmpidx_main_key_local_init(&main_key_local, item, snmp_oid);
 
-	main_key_local.community_context = get_item_community_context(item);
-	main_key_local.security_name = get_item_security_name(item);
+	zbx_mutex_lock(snmpidx_lock);
 
-	if (NULL == (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(&snmpidx, &main_key_local)))
-		goto end;
+	if (NULL != (main_key = (zbx_snmpidx_main_key_t *)zbx_hashset_search(snmpidx, &main_key_local)))
+		zbx_hashset_clear(main_key->mappings);
 
-	zbx_hashset_clear(main_key->mappings);
+	zbx_mutex_unlock(snmpidx_lock);
 end:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
@@ -1245,69 +1420,131 @@ out:
 	return ret;
 }
 
-static int	zbx_snmp_get_values(struct snmp_session *ss, const DC_ITEM *items, char oids[][ITEM_SNMP_OID_LEN_MAX],
-		AGENT_RESULT *results, int *errcodes, unsigned char *query_and_ignore_type, int num, int level,
-		char *error, size_t max_error_len, int *max_succeed, int *min_fail)
+/* SNMP GET request data shared by synchronous and asynchronous polling */
+typedef struct
 {
-	const char		*__function_name = "zbx_snmp_get_values";
+	const DC_ITEM	*item;			/* the reference item, used for host and interface data */
+	char		(*oids)[ITEM_SNMP_OID_LEN_MAX];
+	AGENT_RESULT	*results;
+	int		*errcodes;
+	unsigned char	*query_and_ignore_type;
+	int		num;
+	int		level;
+
+	/* request variable bindings mapped to the items */
+	int		mapping[MAX_SNMP_ITEMS];
+	int		mapping_num;
+	oid		(*parsed_oids)[MAX_OID_LEN];
+	size_t		*parsed_oid_lens;
+}
+zbx_snmp_get_t;
 
-	int			i, j, status, ret = SUCCEED;
-	int			mapping[MAX_SNMP_ITEMS], mapping_num = 0;
-	oid			parsed_oids[MAX_SNMP_ITEMS][MAX_OID_LEN];
-	size_t			parsed_oid_lens[MAX_SNMP_ITEMS];
-	struct snmp_pdu		*pdu, *response;
-	struct variable_list	*var;
+#define ZBX_SNMP_GET_DONE	0	/* the request is processed */
+#define ZBX_SNMP_GET_RETRY	1	/* the fixed request must be sent again */
+#define ZBX_SNMP_GET_HALVE	2	/* the request must be split into smaller requests */
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d level:%d", __function_name, num, level);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_get_prepare                                             *
+ *                                                                            *
+ * Purpose: creates GET request PDU for the request items                     *
+ *                                                                            *
+ * Parameters: get           - [IN/OUT] the request data                      *
+ *             pdu           - [OUT] the request PDU or NULL if there are no  *
+ *                                   items to query                           *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *                                                                            *
+ * Return value: SUCCEED      - the PDU was created or there is nothing to    *
+ *                              query                                         *
+ *               CONFIG_ERROR - the PDU cannot be created                     *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_get_prepare(zbx_snmp_get_t *get, struct snmp_pdu **pdu, char *error, size_t max_error_len)
+{
+	int	i;
+
+	get->mapping_num = 0;
 
-	if (NULL == (pdu = snmp_pdu_create(SNMP_MSG_GET)))
+	if (NULL == (*pdu = snmp_pdu_create(SNMP_MSG_GET)))
 	{
 		zbx_strlcpy(error, "snmp_pdu_create(): cannot create PDU object.", max_error_len);
-		ret = CONFIG_ERROR;
-		goto out;
+		return CONFIG_ERROR;
 	}
 
-	for (i = 0; i < num; i++)
+	for (i = 0; i < get->num; i++)
 	{
-		if (SUCCEED != errcodes[i])
+		if (SUCCEED != get->errcodes[i])
 			continue;
 
-		if (NULL != query_and_ignore_type && 0 == query_and_ignore_type[i])
+		if (NULL != get->query_and_ignore_type && 0 == get->query_and_ignore_type[i])
 			continue;
 
-		parsed_oid_lens[i] = MAX_OID_LEN;
+		get->parsed_oid_lens[i] = MAX_OID_LEN;
 
-		if (NULL == snmp_parse_oid(oids[i], parsed_oids[i], &parsed_oid_lens[i]))
+		if (NULL == snmp_parse_oid(get->oids[i], get->parsed_oids[i], &get->parsed_oid_lens[i]))
 		{
-			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "snmp_parse_oid(): cannot parse OID \"%s\".",
-					oids[i]));
-			errcodes[i] = CONFIG_ERROR;
+			SET_MSG_RESULT(&get->results[i], zbx_dsprintf(NULL, "snmp_parse_oid(): cannot parse OID \"%s\".",
+					get->oids[i]));
+			get->errcodes[i] = CONFIG_ERROR;
 			continue;
 		}
 
-		if (NULL == snmp_add_null_var(pdu, parsed_oids[i], parsed_oid_lens[i]))
+		if (NULL == snmp_add_null_var(*pdu, get->parsed_oids[i], get->parsed_oid_lens[i]))
 		{
-			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "snmp_add_null_var(): cannot add null variable."));
-			errcodes[i] = CONFIG_ERROR;
+			SET_MSG_RESULT(&get->results[i], zbx_strdup(NULL, "snmp_add_null_var(): cannot add null variable."));
+			get->errcodes[i] = CONFIG_ERROR;
 			continue;
 		}
 
-		mapping[mapping_num++] = i;
+		get->mapping[get->mapping_num++] = i;
 	}
 
-	if (0 == mapping_num)
+	if (0 == get->mapping_num)
 	{
-		snmp_free_pdu(pdu);
-		goto out;
+		snmp_free_pdu(*pdu);
+		*pdu = NULL;
 	}
 
-	ss->retries = (1 == mapping_num && 0 == level ? 1 : 0);
-retry:
-	status = snmp_synch_response(ss, pdu, &response);
+	return SUCCEED;
+}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "%s() snmp_synch_response() status:%d s_snmp_errno:%d errstat:%ld mapping_num:%d",
-			__function_name, status, ss->s_snmp_errno, NULL == response ? (long)-1 : response->errstat,
-			mapping_num);
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_get_process                                             *
+ *                                                                            *
+ * Purpose: processes response to GET request                                 *
+ *                                                                            *
+ * Parameters: ss            - [IN] the SNMP session                          *
+ *             get           - [IN/OUT] the request data                      *
+ *             status        - [IN] the request status (STAT_*)               *
+ *             response      - [IN] the response PDU, can be NULL             *
+ *             pdu           - [OUT] the fixed request PDU to send again      *
+ *             ret           - [OUT] the request result code, valid when the  *
+ *                                   request is processed                     *
+ *             error         - [OUT] the error message                        *
+ *             max_error_len - [IN] the error message buffer size             *
+ *             max_succeed   - [OUT] the number of variables that succeeded   *
+ *             min_fail      - [OUT] the number of variables that failed      *
+ *                                                                            *
+ * Return value: ZBX_SNMP_GET_DONE  - the request is processed                *
+ *               ZBX_SNMP_GET_RETRY - the request must be sent again with the *
+ *                                    bad variable removed                    *
+ *               ZBX_SNMP_GET_HALVE - the request must be split into smaller  *
+ *                                    requests                                *
+ *                                                                            *
+ * Comments: The response PDU is not freed by this function.                  *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_get_process(struct snmp_session *ss, zbx_snmp_get_t *get, int status,
+		struct snmp_pdu *response, struct snmp_pdu **pdu, int *ret, char *error, size_t max_error_len,
+		int *max_succeed, int *min_fail)
+{
+	const char		*__function_name = "zbx_snmp_get_process";
+	int			i, j;
+	struct variable_list	*var;
+
+	*ret = SUCCEED;
 
 	if (STAT_SUCCESS == status && SNMP_ERR_NOERROR == response->errstat)
 	{
@@ -1315,20 +1552,20 @@ retry:
 		{
 			/* check that response variable binding matches the request variable binding */
 
-			if (i == mapping_num)
+			if (i == get->mapping_num)
 			{
 				if (NULL != var)
 				{
 					zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
-							" too many variable bindings", items[0].host.host);
+							" too many variable bindings", get->item->host.host);
 
-					if (1 != mapping_num)	/* give device a chance to handle a smaller request */
+					if (1 != get->mapping_num)	/* give device a chance to handle a smaller request */
 						goto halve;
 
 					zbx_strlcpy(error, "Invalid SNMP response: too many variable bindings.",
 							max_error_len);
 
-					ret = NOTSUPPORTED;
+					*ret = NOTSUPPORTED;
 				}
 
 				break;
@@ -1337,33 +1574,34 @@ retry:
 			if (NULL == var)
 			{
 				zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
-						" too few variable bindings", items[0].host.host);
+						" too few variable bindings", get->item->host.host);
 
-				if (1 != mapping_num)	/* give device a chance to handle a smaller request */
+				if (1 != get->mapping_num)	/* give device a chance to handle a smaller request */
 					goto halve;
 
 				zbx_strlcpy(error, "Invalid SNMP response: too few variable bindings.", max_error_len);
 
-				ret = NOTSUPPORTED;
+				*ret = NOTSUPPORTED;
 				break;
 			}
 
-			j = mapping[i];
+			j = get->mapping[i];
 
-			if (parsed_oid_lens[j] != var->name_length ||
-					0 != memcmp(parsed_oids[j], var->name, parsed_oid_lens[j] * sizeof(oid)))
+			if (get->parsed_oid_lens[j] != var->name_length ||
+					0 != memcmp(get->parsed_oids[j], var->name, get->parsed_oid_lens[j] * sizeof(oid)))
 			{
 				char	sent_oid[ITEM_SNMP_OID_LEN_MAX], received_oid[ITEM_SNMP_OID_LEN_MAX];
 
-				zbx_snmp_dump_oid(sent_oid, sizeof(sent_oid), parsed_oids[j], parsed_oid_lens[j]);
+				zbx_snmp_dump_oid(sent_oid, sizeof(sent_oid), get->parsed_oids[j],
+						get->parsed_oid_lens[j]);
 				zbx_snmp_dump_oid(received_oid, sizeof(received_oid), var->name, var->name_length);
 
-				if (1 != mapping_num)
+				if (1 != get->mapping_num)
 				{
 					zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
 							" variable bindings that do not match the request:"
 							" sent \"%s\", received \"%s\"",
-							items[0].host.host, sent_oid, received_oid);
+							get->item->host.host, sent_oid, received_oid);
 
 					goto halve;	/* give device a chance to handle a smaller request */
 				}
@@ -1372,31 +1610,31 @@ retry:
 					zabbix_log(LOG_LEVEL_DEBUG, "SNMP response from host \"%s\" contains"
 							" variable bindings that do not match the request:"
 							" sent \"%s\", received \"%s\"",
-							items[0].host.host, sent_oid, received_oid);
+							get->item->host.host, sent_oid, received_oid);
 				}
 			}
 
 			/* process received data */
 
-			if (NULL != query_and_ignore_type && 1 == query_and_ignore_type[j])
+			if (NULL != get->query_and_ignore_type && 1 == get->query_and_ignore_type[j])
 			{
-				(void)zbx_snmp_set_result(var, &results[j]);
+				(void)zbx_snmp_set_result(var, &get->results[j]);
 			}
 			else
 			{
-				errcodes[j] = zbx_snmp_set_result(var, &results[j]);
+				get->errcodes[j] = zbx_snmp_set_result(var, &get->results[j]);
 			}
 		}
 
-		if (SUCCEED == ret)
+		if (SUCCEED == *ret)
 		{
-			if (*max_succeed < mapping_num)
-				*max_succeed = mapping_num;
+			if (*max_succeed < get->mapping_num)
+				*max_succeed = get->mapping_num;
 		}
-		else if (1 < mapping_num)
+		else if (1 < get->mapping_num)
 		{
-			if (*min_fail > mapping_num)
-				*min_fail = mapping_num;
+			if (*min_fail > get->mapping_num)
+				*min_fail = get->mapping_num;
 		}
 	}
 	else if (STAT_SUCCESS == status && SNMP_ERR_NOSUCHNAME == response->errstat && 0 != response->errindex)
@@ -1410,48 +1648,47 @@ retry:
 
 		i = response->errindex - 1;
 
-		if (0 > i || i >= mapping_num)
+		if (0 > i || i >= get->mapping_num)
 		{
 			zabbix_log(LOG_LEVEL_WARNING, "SNMP response from host \"%s\" contains"
-					" an out of bounds error index: %ld", items[0].host.host, response->errindex);
+					" an out of bounds error index: %ld", get->item->host.host, response->errindex);
 
 			zbx_strlcpy(error, "Invalid SNMP response: error index out of bounds.", max_error_len);
 
-			ret = NOTSUPPORTED;
-			goto exit;
+			*ret = NOTSUPPORTED;
+			return ZBX_SNMP_GET_DONE;
 		}
 
-		j = mapping[i];
+		j = get->mapping[i];
 
-		zabbix_log(LOG_LEVEL_DEBUG, "%s() snmp_synch_response() errindex:%ld OID:'%s'", __function_name,
-				response->errindex, oids[j]);
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() errindex:%ld OID:'%s'", __function_name, response->errindex,
+				get->oids[j]);
 
-		if (NULL == query_and_ignore_type || 0 == query_and_ignore_type[j])
+		if (NULL == get->query_and_ignore_type || 0 == get->query_and_ignore_type[j])
 		{
-			errcodes[j] = zbx_get_snmp_response_error(ss, &items[0].interface, status, response, error,
-					max_error_len);
-			SET_MSG_RESULT(&results[j], zbx_strdup(NULL, error));
+			get->errcodes[j] = zbx_get_snmp_response_error(ss, &get->item->interface, status, response,
+					error, max_error_len);
+			SET_MSG_RESULT(&get->results[j], zbx_strdup(NULL, error));
 			*error = '\0';
 		}
 
-		if (1 < mapping_num)
+		if (1 < get->mapping_num)
 		{
-			if (NULL != (pdu = snmp_fix_pdu(response, SNMP_MSG_GET)))
+			if (NULL != (*pdu = snmp_fix_pdu(response, SNMP_MSG_GET)))
 			{
-				memmove(mapping + i, mapping + i + 1, sizeof(int) * (mapping_num - i - 1));
-				mapping_num--;
+				memmove(get->mapping + i, get->mapping + i + 1, sizeof(int) * (get->mapping_num - i - 1));
+				get->mapping_num--;
 
-				snmp_free_pdu(response);
-				goto retry;
+				return ZBX_SNMP_GET_RETRY;
 			}
 			else
 			{
 				zbx_strlcpy(error, "snmp_fix_pdu(): cannot fix PDU object.", max_error_len);
-				ret = NOTSUPPORTED;
+				*ret = NOTSUPPORTED;
 			}
 		}
 	}
-	else if (1 < mapping_num &&
+	else if (1 < get->mapping_num &&
 			((STAT_SUCCESS == status && SNMP_ERR_TOOBIG == response->errstat) || STAT_TIMEOUT == status ||
 			(STAT_ERROR == status && SNMPERR_TOO_LONG == ss->s_snmp_errno)))
 	{
@@ -1470,50 +1707,100 @@ retry:
 		/* The explanation above is for the first two conditions. The third condition comes from SNMPv3, */
 		/* where the size of the request that we are trying to send exceeds device's "msgMaxSize" limit. */
 halve:
-		if (*min_fail > mapping_num)
-			*min_fail = mapping_num;
+		if (*min_fail > get->mapping_num)
+			*min_fail = get->mapping_num;
 
-		if (0 == level)
-		{
-			/* halve the number of items */
+		return ZBX_SNMP_GET_HALVE;
+	}
+	else
+		*ret = zbx_get_snmp_response_error(ss, &get->item->interface, status, response, error, max_error_len);
 
-			int	base;
+	return ZBX_SNMP_GET_DONE;
+}
 
-			ret = zbx_snmp_get_values(ss, items, oids, results, errcodes, query_and_ignore_type, num / 2,
-					level + 1, error, max_error_len, max_succeed, min_fail);
+static int	zbx_snmp_get_values(struct snmp_session *ss, const DC_ITEM *items, char oids[][ITEM_SNMP_OID_LEN_MAX],
+		AGENT_RESULT *results, int *errcodes, unsigned char *query_and_ignore_type, int num, int level,
+		char *error, size_t max_error_len, int *max_succeed, int *min_fail)
+{
+	const char		*__function_name = "zbx_snmp_get_values";
 
-			if (SUCCEED != ret)
-				goto exit;
+	int			i, status, action, ret;
+	zbx_snmp_get_t		get;
+	oid			parsed_oids[MAX_SNMP_ITEMS][MAX_OID_LEN];
+	size_t			parsed_oid_lens[MAX_SNMP_ITEMS];
+	struct snmp_pdu		*pdu, *response;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d level:%d", __function_name, num, level);
 
-			base = num / 2;
+	get.item = &items[0];
+	get.oids = oids;
+	get.results = results;
+	get.errcodes = errcodes;
+	get.query_and_ignore_type = query_and_ignore_type;
+	get.num = num;
+	get.level = level;
+	get.parsed_oids = parsed_oids;
+	get.parsed_oid_lens = parsed_oid_lens;
+
+	if (SUCCEED != (ret = zbx_snmp_get_prepare(&get, &pdu, error, max_error_len)) || NULL == pdu)
+		goto out;
 
-			ret = zbx_snmp_get_values(ss, items + base, oids + base, results + base, errcodes + base,
-					NULL == query_and_ignore_type ? NULL : query_and_ignore_type + base, num - base,
-					level + 1, error, max_error_len, max_succeed, min_fail);
-		}
-		else if (1 == level)
-		{
-			/* resort to querying items one by one */
+	ss->retries = (1 == get.mapping_num && 0 == level ? 1 : 0);
 
-			for (i = 0; i < num; i++)
-			{
-				if (SUCCEED != errcodes[i])
-					continue;
+	do
+	{
+		status = snmp_synch_response(ss, pdu, &response);
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() snmp_synch_response() status:%d s_snmp_errno:%d errstat:%ld"
+				" mapping_num:%d", __function_name, status, ss->s_snmp_errno,
+				NULL == response ? (long)-1 : response->errstat, get.mapping_num);
 
-				ret = zbx_snmp_get_values(ss, items + i, oids + i, results + i, errcodes + i,
-						NULL == query_and_ignore_type ? NULL : query_and_ignore_type + i, 1,
-						level + 1, error, max_error_len, max_succeed, min_fail);
+		action = zbx_snmp_get_process(ss, &get, status, response, &pdu, &ret, error, max_error_len,
+				max_succeed, min_fail);
 
-				if (SUCCEED != ret)
-					goto exit;
-			}
+		if (NULL != response)
+			snmp_free_pdu(response);
+	}
+	while (ZBX_SNMP_GET_RETRY == action);
+
+	if (ZBX_SNMP_GET_HALVE != action)
+		goto out;
+
+	if (0 == level)
+	{
+		/* halve the number of items */
+
+		int	base;
+
+		ret = zbx_snmp_get_values(ss, items, oids, results, errcodes, query_and_ignore_type, num / 2,
+				level + 1, error, max_error_len, max_succeed, min_fail);
+
+		if (SUCCEED != ret)
+			goto out;
+
+		base = num / 2;
+
+		ret = zbx_snmp_get_values(ss, items + base, oids + base, results + base, errcodes + base,
+				NULL == query_and_ignore_type ? NULL : query_and_ignore_type + base, num - base,
+				level + 1, error, max_error_len, max_succeed, min_fail);
+	}
+	else if (1 == level)
+	{
+		/* resort to querying items one by one */
+
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED != errcodes[i])
+				continue;
+
+			ret = zbx_snmp_get_values(ss, items + i, oids + i, results + i, errcodes + i,
+					NULL == query_and_ignore_type ? NULL : query_and_ignore_type + i, 1,
+					level + 1, error, max_error_len, max_succeed, min_fail);
+
+			if (SUCCEED != ret)
+				goto out;
 		}
 	}
-	else
-		ret = zbx_get_snmp_response_error(ss, &items[0].interface, status, response, error, max_error_len);
-exit:
-	if (NULL != response)
-		snmp_free_pdu(response);
 out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
 
@@ -2030,6 +2317,36 @@ exit:
 	return ret;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_prepare_standard_oid                                    *
+ *                                                                            *
+ * Purpose: validates and translates OID of standard SNMP item                *
+ *                                                                            *
+ * Parameters: item           - [IN] the item                                 *
+ *             oid_translated - [OUT] the translated OID                      *
+ *             max_oid_len    - [IN] the translated OID buffer size           *
+ *             result         - [OUT] the error message                       *
+ *                                                                            *
+ * Return value: SUCCEED      - the OID was translated                        *
+ *               CONFIG_ERROR - the OID contains parameters                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_prepare_standard_oid(const DC_ITEM *item, char *oid_translated, size_t max_oid_len,
+		AGENT_RESULT *result)
+{
+	if (0 != num_key_param(item->snmp_oid))
+	{
+		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
+				item->snmp_oid));
+		return CONFIG_ERROR;
+	}
+
+	zbx_snmp_translate(oid_translated, item->snmp_oid, max_oid_len);
+
+	return SUCCEED;
+}
+
 static int	zbx_snmp_process_standard(struct snmp_session *ss, const DC_ITEM *items, AGENT_RESULT *results,
 		int *errcodes, int num, char *error, size_t max_error_len, int *max_succeed, int *min_fail)
 {
@@ -2045,15 +2362,8 @@ static int	zbx_snmp_process_standard(struct snmp_session *ss, const DC_ITEM *ite
 		if (SUCCEED != errcodes[i])
 			continue;
 
-		if (0 != num_key_param(items[i].snmp_oid))
-		{
-			SET_MSG_RESULT(&results[i], zbx_dsprintf(NULL, "OID \"%s\" contains unsupported parameters.",
-					items[i].snmp_oid));
-			errcodes[i] = CONFIG_ERROR;
-			continue;
-		}
-
-		zbx_snmp_translate(oids_translated[i], items[i].snmp_oid, sizeof(oids_translated[i]));
+		errcodes[i] = zbx_snmp_prepare_standard_oid(&items[i], oids_translated[i], sizeof(oids_translated[i]),
+				&results[i]);
 	}
 
 	ret = zbx_snmp_get_values(ss, items, oids_translated, results, errcodes, NULL, num, 0, error, max_error_len,
@@ -2145,6 +2455,479 @@ out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
+#define ZBX_SNMP_HOST_READY	0	/* the next request can be sent */
+#define ZBX_SNMP_HOST_WAITING	1	/* waiting for response to the request in flight */
+#define ZBX_SNMP_HOST_DONE	2	/* all requests are processed */
+
+/* pending GET request of asynchronously polled host */
+typedef struct
+{
+	int	base;
+	int	num;
+	int	level;
+}
+zbx_snmp_request_t;
+
+/* items of one interface with the same SNMP parameters, polled asynchronously */
+typedef struct
+{
+	const DC_ITEM		*item;		/* the reference item */
+	struct snmp_session	*ss;
+
+	/* the host item data, copied from and to the batch by indexes */
+	int			*indexes;
+	int			num;
+	char			(*oids)[ITEM_SNMP_OID_LEN_MAX];
+	AGENT_RESULT		*results;
+	int			*errcodes;
+	oid			(*parsed_oids)[MAX_OID_LEN];
+	size_t			*parsed_oid_lens;
+
+	/* the requests waiting to be sent, the last one is sent first */
+	zbx_vector_ptr_t	requests;
+
+	zbx_snmp_get_t		get;		/* the request in flight */
+	struct snmp_pdu		*pdu;		/* the fixed request PDU to be sent again */
+
+	int			state;
+	int			ret;
+	int			bulk;
+	int			max_succeed;
+	int			min_fail;
+	char			error[MAX_STRING_LEN];
+}
+zbx_snmp_host_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_host_match                                              *
+ *                                                                            *
+ * Purpose: checks if item can be queried in the same session as host items   *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_host_match(const zbx_snmp_host_t *host, const DC_ITEM *item)
+{
+	if (host->item->interface.interfaceid != item->interface.interfaceid)
+		return FAIL;
+
+	if (host->item->interface.port != item->interface.port || host->item->type != item->type)
+		return FAIL;
+
+	if (0 != strcmp(host->item->snmp_community, item->snmp_community))
+		return FAIL;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_host_push_request                                       *
+ *                                                                            *
+ * Purpose: queues request for the specified range of host items              *
+ *                                                                            *
+ * Parameters: host  - [IN/OUT] the host                                      *
+ *             base  - [IN] the first item                                    *
+ *             num   - [IN] the number of items                               *
+ *             level - [IN] the request level                                 *
+ *                                                                            *
+ * Comments: The last queued request is sent first, so requests must be       *
+ *           queued in reverse item order.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_host_push_request(zbx_snmp_host_t *host, int base, int num, int level)
+{
+	zbx_snmp_request_t	*request;
+
+	request = (zbx_snmp_request_t *)zbx_malloc(NULL, sizeof(zbx_snmp_request_t));
+	request->base = base;
+	request->num = num;
+	request->level = level;
+	zbx_vector_ptr_append(&host->requests, request);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_host_finish                                             *
+ *                                                                            *
+ * Purpose: stops polling the host with the specified result                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_host_finish(zbx_snmp_host_t *host, int ret)
+{
+	host->ret = ret;
+	host->state = ZBX_SNMP_HOST_DONE;
+
+	if (NULL != host->pdu)
+	{
+		snmp_free_pdu(host->pdu);
+		host->pdu = NULL;
+	}
+
+	zbx_vector_ptr_clear_ext(&host->requests, zbx_ptr_free);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_host_process                                            *
+ *                                                                            *
+ * Purpose: processes result of the host request in flight                    *
+ *                                                                            *
+ * Parameters: host     - [IN/OUT] the host                                   *
+ *             status   - [IN] the request status (STAT_*)                    *
+ *             response - [IN] the response PDU, can be NULL                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_host_process(zbx_snmp_host_t *host, int status, struct snmp_pdu *response)
+{
+	const char	*__function_name = "zbx_snmp_host_process";
+	zbx_snmp_get_t	*get = &host->get;
+	int		i, base, ret;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() host:'%s' status:%d s_snmp_errno:%d errstat:%ld mapping_num:%d",
+			__function_name, host->item->host.host, status, host->ss->s_snmp_errno,
+			NULL == response ? (long)-1 : response->errstat, get->mapping_num);
+
+	switch (zbx_snmp_get_process(host->ss, get, status, response, &host->pdu, &ret, host->error,
+			sizeof(host->error), &host->max_succeed, &host->min_fail))
+	{
+		case ZBX_SNMP_GET_RETRY:
+			break;
+		case ZBX_SNMP_GET_HALVE:
+			/* halve the number of items and then resort to querying items */
+			/* one by one, see zbx_snmp_get_values() for details           */
+			base = (int)(get->results - host->results);
+
+			if (0 == get->level)
+			{
+				zbx_snmp_host_push_request(host, base + get->num / 2, get->num - get->num / 2, 1);
+				zbx_snmp_host_push_request(host, base, get->num / 2, 1);
+			}
+			else if (1 == get->level)
+			{
+				for (i = get->num - 1; 0 <= i; i--)
+					zbx_snmp_host_push_request(host, base + i, 1, 2);
+			}
+			break;
+		default:
+			if (SUCCEED != ret)
+			{
+				zbx_snmp_host_finish(host, ret);
+				return;
+			}
+	}
+
+	host->state = ZBX_SNMP_HOST_READY;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_async_cb                                                *
+ *                                                                            *
+ * Purpose: Net-SNMP asynchronous request callback                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	zbx_snmp_async_cb(int operation, struct snmp_session *ss, int reqid, struct snmp_pdu *pdu,
+		void *magic)
+{
+	zbx_snmp_host_t	*host = (zbx_snmp_host_t *)magic;
+
+	ZBX_UNUSED(reqid);
+
+	/* ignore requests cancelled when closing session */
+	if (ZBX_SNMP_HOST_WAITING != host->state)
+		return 1;
+
+	switch (operation)
+	{
+		case NETSNMP_CALLBACK_OP_RECEIVED_MESSAGE:
+			if (SNMP_MSG_RESPONSE == pdu->command)
+			{
+				zbx_snmp_host_process(host, STAT_SUCCESS, pdu);
+				break;
+			}
+
+			ss->s_snmp_errno = SNMPERR_PROTOCOL;
+			zbx_snmp_host_process(host, STAT_ERROR, NULL);
+			break;
+		case NETSNMP_CALLBACK_OP_TIMED_OUT:
+			ss->s_snmp_errno = SNMPERR_TIMEOUT;
+			zbx_snmp_host_process(host, STAT_TIMEOUT, NULL);
+			break;
+		default:
+			zbx_snmp_host_process(host, STAT_ERROR, NULL);
+	}
+
+	return 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_snmp_host_send                                               *
+ *                                                                            *
+ * Purpose: sends the next host request                                       *
+ *                                                                            *
+ * Comments: Requests without items left to query are skipped. Each host has  *
+ *           at most one request in flight.                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	zbx_snmp_host_send(zbx_snmp_host_t *host)
+{
+	zbx_snmp_get_t		*get = &host->get;
+	zbx_snmp_request_t	*request;
+	struct snmp_pdu		*pdu;
+	int			ret;
+
+	while (ZBX_SNMP_HOST_READY == host->state)
+	{
+		if (NULL != host->pdu)
+		{
+			/* resend the fixed request */
+			pdu = host->pdu;
+			host->pdu = NULL;
+		}
+		else
+		{
+			if (0 == host->requests.values_num)
+			{
+				zbx_snmp_host_finish(host, SUCCEED);
+				break;
+			}
+
+			request = (zbx_snmp_request_t *)host->requests.values[host->requests.values_num - 1];
+			zbx_vector_ptr_remove_noorder(&host->requests, host->requests.values_num - 1);
+
+			get->item = host->item;
+			get->oids = host->oids + request->base;
+			get->results = host->results + request->base;
+			get->errcodes = host->errcodes + request->base;
+			get->query_and_ignore_type = NULL;
+			get->num = request->num;
+			get->level = request->level;
+			get->parsed_oids = host->parsed_oids + request->base;
+			get->parsed_oid_lens = host->parsed_oid_lens + request->base;
+
+			zbx_free(request);
+
+			if (SUCCEED != (ret = zbx_snmp_get_prepare(get, &pdu, host->error, sizeof(host->error))))
+			{
+				zbx_snmp_host_finish(host, ret);
+				break;
+			}
+
+			if (NULL == pdu)
+				continue;
+
+			host->ss->retries = (1 == get->mapping_num && 0 == get->level ? 1 : 0);
+		}
+
+		if (0 != snmp_async_send(host->ss, pdu, zbx_snmp_async_cb, host))
+		{
+			host->state = ZBX_SNMP_HOST_WAITING;
+			break;
+		}
+
+		/* the PDU is not freed by Net-SNMP library if sending fails */
+		snmp_free_pdu(pdu);
+		zbx_snmp_host_process(host, STAT_ERROR, NULL);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: get_values_snmp_async                                            *
+ *                                                                            *
+ * Purpose: retrieve values of SNMP items from multiple hosts concurrently    *
+ *                                                                            *
+ * Parameters: items    - [IN] the items to check                             *
+ *             results  - [OUT] the item values or error messages             *
+ *             errcodes - [IN/OUT] the item result codes, only items with     *
+ *                                 SUCCEED code are checked                   *
+ *             num      - [IN] the number of items                            *
+ *                                                                            *
+ * Comments: Only SNMPv1 and SNMPv2c items with plain OIDs are expected.      *
+ *                                                                            *
+ *           Items are grouped by interface and SNMP parameters into hosts,   *
+ *           each host is queried in its own Net-SNMP session. Requests to    *
+ *           different hosts are kept in flight at the same time, while each  *
+ *           host receives one request at a time in the same order and with   *
+ *           the same request size adaptation as in synchronous polling.      *
+ *                                                                            *
+ ******************************************************************************/
+void	get_values_snmp_async(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num)
+{
+	const char		*__function_name = "get_values_snmp_async";
+
+	zbx_vector_ptr_t	hosts;
+	zbx_snmp_host_t		*host;
+	int			i, j, k, max_vars, active_num, numfds, block, rc, err;
+	fd_set			fdset;
+	struct timeval		timeout;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() num:%d", __function_name, num);
+
+	zbx_vector_ptr_create(&hosts);
+
+	/* group items by session parameters */
+	for (i = 0; i < num; i++)
+	{
+		if (SUCCEED != errcodes[i])
+			continue;
+
+		for (j = 0; j < hosts.values_num; j++)
+		{
+			if (SUCCEED == zbx_snmp_host_match((zbx_snmp_host_t *)hosts.values[j], &items[i]))
+				break;
+		}
+
+		if (j == hosts.values_num)
+		{
+			host = (zbx_snmp_host_t *)zbx_malloc(NULL, sizeof(zbx_snmp_host_t));
+			memset(host, 0, sizeof(zbx_snmp_host_t));
+			host->item = &items[i];
+			host->indexes = (int *)zbx_malloc(NULL, sizeof(int) * num);
+			zbx_vector_ptr_append(&hosts, host);
+		}
+		else
+			host = (zbx_snmp_host_t *)hosts.values[j];
+
+		host->indexes[host->num++] = i;
+	}
+
+	/* open sessions and queue requests */
+	for (j = 0; j < hosts.values_num; j++)
+	{
+		host = (zbx_snmp_host_t *)hosts.values[j];
+
+		host->oids = (char (*)[ITEM_SNMP_OID_LEN_MAX])zbx_malloc(NULL, ITEM_SNMP_OID_LEN_MAX * host->num);
+		host->results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * host->num);
+		host->errcodes = (int *)zbx_malloc(NULL, sizeof(int) * host->num);
+		host->parsed_oids = (oid (*)[MAX_OID_LEN])zbx_malloc(NULL, sizeof(oid) * MAX_OID_LEN * host->num);
+		host->parsed_oid_lens = (size_t *)zbx_malloc(NULL, sizeof(size_t) * host->num);
+		zbx_vector_ptr_create(&host->requests);
+		host->max_succeed = 0;
+		host->min_fail = MAX_SNMP_ITEMS + 1;
+
+		for (k = 0; k < host->num; k++)
+		{
+			i = host->indexes[k];
+			host->results[k] = results[i];
+			host->errcodes[k] = zbx_snmp_prepare_standard_oid(&items[i], host->oids[k],
+					sizeof(host->oids[k]), &host->results[k]);
+		}
+
+		if (NULL == (host->ss = zbx_snmp_open_session(host->item, host->error, sizeof(host->error))))
+		{
+			zbx_snmp_host_finish(host, NETWORK_ERROR);
+			continue;
+		}
+
+		max_vars = DCconfig_get_suggested_snmp_vars(host->item->interface.interfaceid, &host->bulk);
+		max_vars = MIN(max_vars, MAX_SNMP_ITEMS);
+
+		for (k = (host->num - 1) / max_vars * max_vars; 0 <= k; k -= max_vars)
+			zbx_snmp_host_push_request(host, k, MIN(max_vars, host->num - k), 0);
+
+		host->state = ZBX_SNMP_HOST_READY;
+	}
+
+	for (;;)
+	{
+		active_num = 0;
+
+		for (j = 0; j < hosts.values_num; j++)
+		{
+			host = (zbx_snmp_host_t *)hosts.values[j];
+
+			if (ZBX_SNMP_HOST_READY == host->state)
+				zbx_snmp_host_send(host);
+
+			if (ZBX_SNMP_HOST_WAITING == host->state)
+				active_num++;
+		}
+
+		if (0 == active_num)
+			break;
+
+		numfds = 0;
+		block = 1;
+		FD_ZERO(&fdset);
+		snmp_select_info(&numfds, &fdset, &timeout, &block);
+
+		if (0 < (rc = select(numfds, &fdset, NULL, NULL, 0 == block ? &timeout : NULL)))
+		{
+			snmp_read(&fdset);
+		}
+		else if (0 > rc && EINTR != (err = errno))
+		{
+			zabbix_log(LOG_LEVEL_WARNING, "cannot wait for SNMP responses: %s", zbx_strerror(err));
+
+			for (j = 0; j < hosts.values_num; j++)
+			{
+				host = (zbx_snmp_host_t *)hosts.values[j];
+
+				if (ZBX_SNMP_HOST_WAITING != host->state)
+					continue;
+
+				zbx_snprintf(host->error, sizeof(host->error), "Cannot wait for SNMP response: %s",
+						zbx_strerror(err));
+				zbx_snmp_host_finish(host, NETWORK_ERROR);
+			}
+		}
+
+		/* responses from other hosts can keep select() from timing out, so expired requests */
+		/* must be checked on every iteration                                                 */
+		snmp_timeout();
+	}
+
+	for (j = 0; j < hosts.values_num; j++)
+	{
+		host = (zbx_snmp_host_t *)hosts.values[j];
+
+		if (NULL != host->ss)
+			zbx_snmp_close_session(host->ss);
+
+		if (SUCCEED != host->ret)
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "getting SNMP values failed: %s", host->error);
+
+			for (k = 0; k < host->num; k++)
+			{
+				if (SUCCEED != host->errcodes[k])
+					continue;
+
+				SET_MSG_RESULT(&host->results[k], zbx_strdup(NULL, host->error));
+				host->errcodes[k] = host->ret;
+			}
+		}
+		else if (SNMP_BULK_ENABLED == host->bulk && (0 != host->max_succeed ||
+				MAX_SNMP_ITEMS + 1 != host->min_fail))
+		{
+			DCconfig_update_interface_snmp_stats(host->item->interface.interfaceid, host->max_succeed,
+					host->min_fail);
+		}
+
+		for (k = 0; k < host->num; k++)
+		{
+			i = host->indexes[k];
+			results[i] = host->results[k];
+			errcodes[i] = host->errcodes[k];
+		}
+
+		zbx_vector_ptr_destroy(&host->requests);
+		zbx_free(host->parsed_oid_lens);
+		zbx_free(host->parsed_oids);
+		zbx_free(host->errcodes);
+		zbx_free(host->results);
+		zbx_free(host->oids);
+		zbx_free(host->indexes);
+		zbx_free(host);
+	}
+
+	zbx_vector_ptr_destroy(&hosts);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
+
 void	zbx_init_snmp(void)
 {
 	sigset_t	mask, orig_mask;
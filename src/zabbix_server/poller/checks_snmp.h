@@ -30,8 +30,11 @@ extern int	CONFIG_TIMEOUT;
 
 #ifdef HAVE_NETSNMP
 void	zbx_init_snmp(void);
+int	zbx_snmp_index_cache_init(char **error);
+void	zbx_snmp_index_cache_destroy(void);
 int	get_value_snmp(const DC_ITEM *item, AGENT_RESULT *result);
 void	get_values_snmp(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
+void	get_values_snmp_async(const DC_ITEM *items, AGENT_RESULT *results, int *errcodes, int num);
 #endif
 
 #endif
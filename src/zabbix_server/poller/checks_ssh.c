@@ -25,6 +25,7 @@
 
 #include "comms.h"
 #include "log.h"
+#include "zbxalgo.h"
 
 #define SSH_RUN_KEY	"ssh.run"
 
@@ -76,33 +77,81 @@ static int	waitsocket(int socket_fd, LIBSSH2_SESSION *session)
 	return rc;
 }
 
-/* example ssh.run["ls /"] */
-static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
+typedef struct
 {
-	const char	*__function_name = "ssh_run";
+	char		*addr;
+	char		*username;
+	char		*password;
+	char		*publickey;
+	char		*privatekey;
+	unsigned short	port;
+	unsigned char	authtype;
 	zbx_socket_t	s;
 	LIBSSH2_SESSION	*session;
-	LIBSSH2_CHANNEL	*channel;
-	int		auth_pw = 0, rc, ret = NOTSUPPORTED,
-			exitcode, bytecount = 0;
-	char		buffer[MAX_BUFFER_LEN], buf[16], *userauthlist,
-			*publickey = NULL, *privatekey = NULL, *ssherr, *output;
-	size_t		sz;
+	time_t		lastaccess;
+}
+zbx_ssh_session_t;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+/* idle authenticated sessions of the per-process session pool, ordered by last access time */
+static zbx_vector_ptr_t	ssh_sessions;
+
+static void	ssh_session_free(zbx_ssh_session_t *ssh)
+{
+	if (NULL != ssh->session)
+	{
+		libssh2_session_disconnect(ssh->session, "Normal Shutdown");
+		libssh2_session_free(ssh->session);
+	}
+
+	zbx_tcp_close(&ssh->s);
 
-	if (FAIL == zbx_tcp_connect(&s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
+	zbx_free(ssh->addr);
+	zbx_free(ssh->username);
+	zbx_free(ssh->password);
+	zbx_free(ssh->publickey);
+	zbx_free(ssh->privatekey);
+	zbx_free(ssh);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_open                                                 *
+ *                                                                            *
+ * Purpose: connect to SSH server and authenticate using item credentials     *
+ *                                                                            *
+ * Parameters: item   - [IN] item with interface and credentials              *
+ *             result - [OUT] error message in case of failure                *
+ *                                                                            *
+ * Return value: authenticated session or NULL in case of failure             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_t	*ssh_session_open(DC_ITEM *item, AGENT_RESULT *result)
+{
+	const char		*__function_name = "ssh_session_open";
+	zbx_ssh_session_t	*ssh;
+	LIBSSH2_SESSION		*session;
+	int			auth_pw = 0, rc, ret = FAIL;
+	char			*userauthlist, *publickey = NULL, *privatekey = NULL, *ssherr;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() addr:'%s' port:%hu", __function_name, item->interface.addr,
+			item->interface.port);
+
+	ssh = (zbx_ssh_session_t *)zbx_malloc(NULL, sizeof(zbx_ssh_session_t));
+	memset(ssh, 0, sizeof(zbx_ssh_session_t));
+
+	if (FAIL == zbx_tcp_connect(&ssh->s, CONFIG_SOURCE_IP, item->interface.addr, item->interface.port, 0,
 			ZBX_TCP_SEC_UNENCRYPTED, NULL, NULL))
 	{
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot connect to SSH server: %s", zbx_socket_strerror()));
-		goto close;
+		zbx_free(ssh);
+		goto out;
 	}
 
 	/* initializes an SSH session object */
 	if (NULL == (session = libssh2_session_init()))
 	{
 		SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot initialize SSH session"));
-		goto tcp_close;
+		goto out;
 	}
 
 	/* set blocking mode on session */
@@ -110,13 +159,16 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 
 	/* Create a session instance and start it up. This will trade welcome */
 	/* banners, exchange keys, and setup crypto, compression, and MAC layers */
-	if (0 != libssh2_session_startup(session, s.socket))
+	if (0 != libssh2_session_startup(session, ssh->s.socket))
 	{
 		libssh2_session_last_error(session, &ssherr, NULL, 0);
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot establish SSH session: %s", ssherr));
-		goto session_free;
+		libssh2_session_free(session);
+		goto out;
 	}
 
+	ssh->session = session;
+
 	/* check what authentication methods are available */
 	if (NULL != (userauthlist = libssh2_userauth_list(session, item->username, strlen(item->username))))
 	{
@@ -131,7 +183,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 	{
 		libssh2_session_last_error(session, &ssherr, NULL, 0);
 		SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot obtain authentication methods: %s", ssherr));
-		goto session_close;
+		goto out;
 	}
 
 	zabbix_log(LOG_LEVEL_DEBUG, "%s() supported authentication methods:'%s'", __function_name, userauthlist);
@@ -147,7 +199,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 					libssh2_session_last_error(session, &ssherr, NULL, 0);
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Password authentication failed: %s",
 							ssherr));
-					goto session_close;
+					goto out;
 				}
 				else
 					zabbix_log(LOG_LEVEL_DEBUG, "%s() password authentication succeeded",
@@ -162,7 +214,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 					libssh2_session_last_error(session, &ssherr, NULL, 0);
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Keyboard-interactive authentication"
 							" failed: %s", ssherr));
-					goto session_close;
+					goto out;
 				}
 				else
 					zabbix_log(LOG_LEVEL_DEBUG, "%s() keyboard-interactive authentication succeeded",
@@ -172,7 +224,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 		case ITEM_AUTHTYPE_PUBLICKEY:
@@ -182,7 +234,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 				{
 					SET_MSG_RESULT(result, zbx_strdup(NULL, "Authentication by public key failed."
 							" SSHKeyLocation option is not set"));
-					goto session_close;
+					goto out;
 				}
 
 				/* or by public key */
@@ -194,14 +246,14 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access public key file %s",
 							publickey));
-					goto session_close;
+					goto out;
 				}
 
 				if (SUCCEED != zbx_is_regular_file(privatekey))
 				{
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Cannot access private key file %s",
 							privatekey));
-					goto session_close;
+					goto out;
 				}
 
 				rc = libssh2_userauth_publickey_fromfile(session, item->username, publickey,
@@ -212,7 +264,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 					libssh2_session_last_error(session, &ssherr, NULL, 0);
 					SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Public key authentication failed:"
 							" %s", ssherr));
-					goto session_close;
+					goto out;
 				}
 				else
 					zabbix_log(LOG_LEVEL_DEBUG, "%s() authentication by public key succeeded",
@@ -222,34 +274,197 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 			{
 				SET_MSG_RESULT(result, zbx_dsprintf(NULL, "Unsupported authentication method."
 						" Supported methods: %s", userauthlist));
-				goto session_close;
+				goto out;
 			}
 			break;
 	}
 
-	/* exec non-blocking on the remove host */
-	while (NULL == (channel = libssh2_channel_open_session(session)))
+	ssh->addr = zbx_strdup(NULL, item->interface.addr);
+	ssh->port = item->interface.port;
+	ssh->authtype = item->authtype;
+	ssh->username = zbx_strdup(NULL, item->username);
+	ssh->password = zbx_strdup(NULL, item->password);
+	ssh->publickey = zbx_strdup(NULL, item->publickey);
+	ssh->privatekey = zbx_strdup(NULL, item->privatekey);
+
+	ret = SUCCEED;
+out:
+	if (SUCCEED != ret && NULL != ssh)
+	{
+		ssh_session_free(ssh);
+		ssh = NULL;
+	}
+
+	zbx_free(publickey);
+	zbx_free(privatekey);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ssh;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_get                                                  *
+ *                                                                            *
+ * Purpose: get authenticated SSH session for the item from the session pool  *
+ *          or establish a new one                                            *
+ *                                                                            *
+ * Parameters: item   - [IN] item with interface and credentials              *
+ *             result - [OUT] error message in case of failure                *
+ *             reused - [OUT] 1 - the session was taken from the pool,        *
+ *                            0 - new session was established                 *
+ *                                                                            *
+ * Return value: authenticated session or NULL in case of failure             *
+ *                                                                            *
+ * Comments: Sessions are matched by address, port, user name and all         *
+ *           authentication settings of the item, so a pooled session is      *
+ *           never used with credentials other than the ones it was           *
+ *           authenticated with.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_ssh_session_t	*ssh_session_get(DC_ITEM *item, AGENT_RESULT *result, int *reused)
+{
+	zbx_ssh_session_t	*ssh;
+	int			i;
+
+	*reused = 0;
+
+	if (NULL == ssh_sessions.values)
+		zbx_vector_ptr_create(&ssh_sessions);
+
+	for (i = ssh_sessions.values_num - 1; 0 <= i; i--)
 	{
-		switch (libssh2_session_last_error(session, NULL, NULL, 0))
+		ssh = (zbx_ssh_session_t *)ssh_sessions.values[i];
+
+		if (ssh->port != item->interface.port || ssh->authtype != item->authtype ||
+				0 != strcmp(ssh->addr, item->interface.addr) ||
+				0 != strcmp(ssh->username, item->username) ||
+				0 != strcmp(ssh->password, item->password) ||
+				0 != strcmp(ssh->publickey, item->publickey) ||
+				0 != strcmp(ssh->privatekey, item->privatekey))
 		{
-			/* marked for non-blocking I/O but the call would block. */
-			case LIBSSH2_ERROR_EAGAIN:
-				waitsocket(s.socket, session);
-				continue;
-			default:
-				SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot establish generic session channel"));
-				goto session_close;
+			continue;
 		}
+
+		zbx_vector_ptr_remove(&ssh_sessions, i);
+		*reused = 1;
+
+		return ssh;
+	}
+
+	return ssh_session_open(item, result);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: ssh_session_release                                              *
+ *                                                                            *
+ * Purpose: return SSH session to the session pool                            *
+ *                                                                            *
+ * Parameters: ssh   - [IN] the session                                       *
+ *             reuse - [IN] SUCCEED - the session can be reused,              *
+ *                          FAIL    - the session must be closed              *
+ *                                                                            *
+ ******************************************************************************/
+static void	ssh_session_release(zbx_ssh_session_t *ssh, int reuse)
+{
+	if (SUCCEED != reuse || 0 == CONFIG_SSH_SESSION_POOL_SIZE)
+	{
+		ssh_session_free(ssh);
+		return;
+	}
+
+	ssh->lastaccess = time(NULL);
+	zbx_vector_ptr_append(&ssh_sessions, ssh);
+
+	while (CONFIG_SSH_SESSION_POOL_SIZE < ssh_sessions.values_num)
+	{
+		ssh_session_free((zbx_ssh_session_t *)ssh_sessions.values[0]);
+		zbx_vector_ptr_remove(&ssh_sessions, 0);
 	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_ssh_sessions_expire                                          *
+ *                                                                            *
+ * Purpose: close pooled SSH sessions that were idle for longer than          *
+ *          SSHSessionIdleTimeout                                             *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_ssh_sessions_expire(void)
+{
+	zbx_ssh_session_t	*ssh;
+	time_t			now;
+
+	if (NULL == ssh_sessions.values)
+		return;
+
+	now = time(NULL);
+
+	while (0 != ssh_sessions.values_num)
+	{
+		ssh = (zbx_ssh_session_t *)ssh_sessions.values[0];
+
+		if (ssh->lastaccess + CONFIG_SSH_SESSION_IDLE_TIMEOUT > now)
+			break;
+
+		zabbix_log(LOG_LEVEL_DEBUG, "closing idle SSH session to [%s]:%hu", ssh->addr, ssh->port);
+		ssh_session_free(ssh);
+		zbx_vector_ptr_remove(&ssh_sessions, 0);
+	}
+}
+
+/* example ssh.run["ls /"] */
+static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
+{
+	const char		*__function_name = "ssh_run";
+	zbx_ssh_session_t	*ssh;
+	LIBSSH2_CHANNEL		*channel;
+	int			rc, ret = NOTSUPPORTED, exitcode, bytecount = 0, reused, attempt, reuse = FAIL;
+	char			buffer[MAX_BUFFER_LEN], buf[16], *ssherr, *output;
+	size_t			sz;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
 	dos2unix(item->params);	/* CR+LF (Windows) => LF (Unix) */
+
+	/* pooled session might have been closed by the server, retry once with a new session */
+	for (attempt = 0;; attempt++)
+	{
+		if (NULL == (ssh = ssh_session_get(item, result, &reused)))
+			goto close;
+
+		/* exec non-blocking on the remove host */
+		while (NULL == (channel = libssh2_channel_open_session(ssh->session)) &&
+				LIBSSH2_ERROR_EAGAIN == libssh2_session_last_error(ssh->session, NULL, NULL, 0))
+		{
+			/* marked for non-blocking I/O but the call would block. */
+			waitsocket(ssh->s.socket, ssh->session);
+		}
+
+		if (NULL != channel)
+			break;
+
+		ssh_session_release(ssh, FAIL);
+
+		if (0 == reused || 0 != attempt)
+		{
+			SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot establish generic session channel"));
+			goto close;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot open channel on pooled session", __function_name);
+	}
+
 	/* request a shell on a channel and execute command */
 	while (0 != (rc = libssh2_channel_exec(channel, item->params)))
 	{
 		switch (rc)
 		{
 			case LIBSSH2_ERROR_EAGAIN:
-				waitsocket(s.socket, session);
+				waitsocket(ssh->s.socket, ssh->session);
 				continue;
 			default:
 				SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot request a shell"));
@@ -280,7 +495,7 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 		 * this condition
 		 */
 		if (LIBSSH2_ERROR_EAGAIN == rc)
-			waitsocket(s.socket, session);
+			waitsocket(ssh->s.socket, ssh->session);
 		else if (rc < 0)
 		{
 			SET_MSG_RESULT(result, zbx_strdup(NULL, "Cannot read data from SSH server"));
@@ -299,16 +514,20 @@ static int	ssh_run(DC_ITEM *item, AGENT_RESULT *result, const char *encoding)
 		ret = SYSINFO_RET_OK;
 
 	zbx_free(output);
+
+	/* the command was executed and its output read, the session is fine */
+	reuse = SUCCEED;
 channel_close:
 	/* close an active data channel */
 	exitcode = 127;
 	while (LIBSSH2_ERROR_EAGAIN == (rc = libssh2_channel_close(channel)))
-		waitsocket(s.socket, session);
+		waitsocket(ssh->s.socket, ssh->session);
 
 	if (0 != rc)
 	{
-		libssh2_session_last_error(session, &ssherr, NULL, 0);
+		libssh2_session_last_error(ssh->session, &ssherr, NULL, 0);
 		zabbix_log(LOG_LEVEL_WARNING, "%s() cannot close generic session channel: %s", __function_name, ssherr);
+		reuse = FAIL;
 	}
 	else
 		exitcode = libssh2_channel_get_exit_status(channel);
@@ -318,18 +537,8 @@ channel_close:
 	libssh2_channel_free(channel);
 	channel = NULL;
 
-session_close:
-	libssh2_session_disconnect(session, "Normal Shutdown");
-
-session_free:
-	libssh2_session_free(session);
-
-tcp_close:
-	zbx_tcp_close(&s);
-
+	ssh_session_release(ssh, reuse);
 close:
-	zbx_free(publickey);
-	zbx_free(privatekey);
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
 
 	return ret;
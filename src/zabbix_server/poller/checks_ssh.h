@@ -28,8 +28,11 @@
 
 extern char	*CONFIG_SOURCE_IP;
 extern char	*CONFIG_SSH_KEY_LOCATION;
+extern int	CONFIG_SSH_SESSION_POOL_SIZE;
+extern int	CONFIG_SSH_SESSION_IDLE_TIMEOUT;
 
 int	get_value_ssh(DC_ITEM *item, AGENT_RESULT *result);
+void	zbx_ssh_sessions_expire(void);
 #endif	/* HAVE_SSH2 */
 
 #endif
@@ -45,6 +45,10 @@
 #include "zbxjson.h"
 #include "zbxhttp.h"
 
+#ifdef HAVE_UNIXODBC
+#	include "../odbc/odbc.h"
+#endif
+
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
 
@@ -499,12 +503,10 @@ static int	parse_query_fields(const DC_ITEM *item, char **query_fields)
  *           see DCconfig_get_poller_items()                                  *
  *                                                                            *
  ******************************************************************************/
-static int	get_values(unsigned char poller_type, int *nextcheck)
+static int	get_values(unsigned char poller_type, DC_ITEM *items, AGENT_RESULT *results, int *errcodes,
+		int *nextcheck)
 {
 	const char		*__function_name = "get_values";
-	DC_ITEM			items[MAX_POLLER_ITEMS];
-	AGENT_RESULT		results[MAX_POLLER_ITEMS];
-	int			errcodes[MAX_POLLER_ITEMS];
 	zbx_timespec_t		timespec;
 	char			*port = NULL, error[ITEM_ERROR_LEN_MAX];
 	int			i, num, last_available = HOST_AVAILABLE_UNKNOWN;
@@ -708,7 +710,10 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	{
 #ifdef HAVE_NETSNMP
 		/* SNMP checks use their own timeouts */
-		get_values_snmp(items, results, errcodes, num);
+		if (ZBX_POLLER_TYPE_SNMP == poller_type)
+			get_values_snmp_async(items, results, errcodes, num);
+		else
+			get_values_snmp(items, results, errcodes, num);
 #else
 		for (i = 0; i < num; i++)
 		{
@@ -726,6 +731,32 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 		get_values_java(ZBX_JAVA_GATEWAY_REQUEST_JMX, items, results, errcodes, num);
 		zbx_alarm_off();
 	}
+	else if (ZBX_POLLER_TYPE_AGENT == poller_type)
+	{
+		/* agent checks use their own timeouts */
+		get_values_agent(items, results, errcodes, num);
+	}
+	else if (ZBX_POLLER_TYPE_HTTPAGENT == poller_type)
+	{
+#ifdef HAVE_LIBCURL
+		/* HTTP agent checks use their own timeouts */
+		get_values_http(items, results, errcodes, num);
+#else
+		for (i = 0; i < num; i++)
+		{
+			if (SUCCEED != errcodes[i])
+				continue;
+
+			SET_MSG_RESULT(&results[i], zbx_strdup(NULL, "Support for HTTP agent checks was not compiled in."));
+			errcodes[i] = CONFIG_ERROR;
+		}
+#endif
+	}
+	else if (ITEM_TYPE_ZABBIX == items[0].type && 1 < num)
+	{
+		/* agent bulk checks use their own timeouts */
+		get_values_agent_bulk(items, results, errcodes, num);
+	}
 	else if (1 == num)
 	{
 		if (SUCCEED == errcodes[0])
@@ -739,6 +770,10 @@ static int	get_values(unsigned char poller_type, int *nextcheck)
 	/* process item values */
 	for (i = 0; i < num; i++)
 	{
+		/* asynchronous poller batches contain items from different hosts */
+		if (0 != i && items[i].host.hostid != items[i - 1].host.hostid)
+			last_available = HOST_AVAILABLE_UNKNOWN;
+
 		switch (errcodes[i])
 		{
 			case SUCCEED:
@@ -880,10 +915,12 @@ exit:
 
 ZBX_THREAD_ENTRY(poller_thread, args)
 {
-	int		nextcheck, sleeptime = -1, processed = 0, old_processed = 0;
+	int		nextcheck, sleeptime = -1, processed = 0, old_processed = 0, max_items, *errcodes;
 	double		sec, total_sec = 0.0, old_total_sec = 0.0;
 	time_t		last_stat_time;
 	unsigned char	poller_type;
+	DC_ITEM		*items;
+	AGENT_RESULT	*results;
 
 #define	STAT_INTERVAL	5	/* if a process is busy and does not sleep then update status not faster than */
 				/* once in STAT_INTERVAL seconds */
@@ -897,13 +934,34 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
 			server_num, get_process_type_string(process_type), process_num);
 #ifdef HAVE_NETSNMP
-	if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_UNREACHABLE == poller_type)
+	if (ZBX_POLLER_TYPE_NORMAL == poller_type || ZBX_POLLER_TYPE_UNREACHABLE == poller_type ||
+			ZBX_POLLER_TYPE_SNMP == poller_type)
+	{
 		zbx_init_snmp();
+	}
 #endif
 
 #if defined(HAVE_POLARSSL) || defined(HAVE_GNUTLS) || defined(HAVE_OPENSSL)
 	zbx_tls_init_child();
 #endif
+	switch (poller_type)
+	{
+		case ZBX_POLLER_TYPE_AGENT:
+			max_items = MAX_AGENT_POLLER_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_HTTPAGENT:
+			max_items = MAX_HTTPAGENT_POLLER_ITEMS;
+			break;
+		case ZBX_POLLER_TYPE_SNMP:
+			max_items = MAX_SNMP_POLLER_ITEMS;
+			break;
+		default:
+			max_items = MAX_POLLER_ITEMS;
+	}
+	items = (DC_ITEM *)zbx_malloc(NULL, sizeof(DC_ITEM) * max_items);
+	results = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT) * max_items);
+	errcodes = (int *)zbx_malloc(NULL, sizeof(int) * max_items);
+
 	zbx_setproctitle("%s #%d [connecting to the database]", get_process_type_string(process_type), process_num);
 	last_stat_time = time(NULL);
 
@@ -921,7 +979,7 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 					old_total_sec);
 		}
 
-		processed += get_values(poller_type, &nextcheck);
+		processed += get_values(poller_type, items, results, errcodes, &nextcheck);
 		total_sec += zbx_time() - sec;
 
 		sleeptime = calculate_sleeptime(nextcheck, POLLER_DELAY);
@@ -945,6 +1003,12 @@ ZBX_THREAD_ENTRY(poller_thread, args)
 			total_sec = 0.0;
 			last_stat_time = time(NULL);
 		}
+#ifdef HAVE_UNIXODBC
+		zbx_odbc_pool_expire();
+#endif
+#ifdef HAVE_SSH2
+		zbx_ssh_sessions_expire();
+#endif
 
 		zbx_sleep_loop(sleeptime);
 	}
@@ -35,6 +35,188 @@
 
 extern zbx_es_t	es_engine;
 
+/* compiled preprocessing step expression, cached by expression type and step parameters */
+typedef struct
+{
+	unsigned char	type;
+	char		*params;
+	void		*data;
+}
+zbx_preproc_expr_t;
+
+/* compiled expressions are dropped when configuration revision changes */
+static zbx_hashset_t	preproc_expr_cache;
+static int		preproc_expr_cache_revision = -1;
+
+static zbx_hash_t	preproc_expr_hash(const void *data)
+{
+	const zbx_preproc_expr_t	*expr = (const zbx_preproc_expr_t *)data;
+	zbx_hash_t			hash;
+
+	hash = ZBX_DEFAULT_STRING_HASH_FUNC(expr->params);
+
+	return ZBX_DEFAULT_HASH_ALGO(&expr->type, sizeof(expr->type), hash);
+}
+
+static int	preproc_expr_compare(const void *d1, const void *d2)
+{
+	const zbx_preproc_expr_t	*e1 = (const zbx_preproc_expr_t *)d1;
+	const zbx_preproc_expr_t	*e2 = (const zbx_preproc_expr_t *)d2;
+
+	ZBX_RETURN_IF_NOT_EQUAL(e1->type, e2->type);
+
+	return strcmp(e1->params, e2->params);
+}
+
+static void	preproc_expr_clean(void *data)
+{
+	zbx_preproc_expr_t	*expr = (zbx_preproc_expr_t *)data;
+
+	switch (expr->type)
+	{
+		case ZBX_PREPROC_JSONPATH:
+			zbx_jsonpath_clear((zbx_jsonpath_t *)expr->data);
+			zbx_free(expr->data);
+			break;
+#ifdef HAVE_LIBXML2
+		case ZBX_PREPROC_XPATH:
+			xmlXPathFreeCompExpr((xmlXPathCompExprPtr)expr->data);
+			break;
+#endif
+	}
+
+	zbx_free(expr->params);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_item_preproc_cache_sync                                      *
+ *                                                                            *
+ * Purpose: drops compiled expressions if configuration revision has changed  *
+ *                                                                            *
+ * Parameters: revision - [IN] the configuration revision                     *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_item_preproc_cache_sync(int revision)
+{
+	if (preproc_expr_cache_revision == revision)
+		return;
+
+	if (-1 != preproc_expr_cache_revision)
+		zbx_hashset_clear(&preproc_expr_cache);
+	else
+	{
+		zbx_hashset_create_ext(&preproc_expr_cache, 100, preproc_expr_hash, preproc_expr_compare,
+				preproc_expr_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+	}
+
+	preproc_expr_cache_revision = revision;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_cache_get                                           *
+ *                                                                            *
+ * Purpose: gets compiled expression of preprocessing step, compiling and     *
+ *          caching it if necessary                                           *
+ *                                                                            *
+ * Parameters: type   - [IN] the expression type (ZBX_PREPROC_JSONPATH or     *
+ *                           ZBX_PREPROC_XPATH)                               *
+ *             params - [IN] the expression                                   *
+ *                                                                            *
+ * Return value: the compiled expression or NULL if the expression cannot be  *
+ *               compiled or the cache is not used                            *
+ *                                                                            *
+ * Comments: Invalid expressions are not cached, so they are evaluated        *
+ *           without compilation to get the same error messages.              *
+ *                                                                            *
+ ******************************************************************************/
+static void	*item_preproc_cache_get(unsigned char type, const char *params)
+{
+	zbx_preproc_expr_t	*expr, expr_local;
+	zbx_jsonpath_t		*jsonpath;
+
+	if (-1 == preproc_expr_cache_revision)
+		return NULL;
+
+	expr_local.type = type;
+	expr_local.params = (char *)params;
+
+	if (NULL != (expr = (zbx_preproc_expr_t *)zbx_hashset_search(&preproc_expr_cache, &expr_local)))
+		return expr->data;
+
+	switch (type)
+	{
+		case ZBX_PREPROC_JSONPATH:
+			jsonpath = (zbx_jsonpath_t *)zbx_malloc(NULL, sizeof(zbx_jsonpath_t));
+
+			if (SUCCEED != zbx_jsonpath_compile(params, jsonpath))
+			{
+				zbx_free(jsonpath);
+				return NULL;
+			}
+
+			expr_local.data = jsonpath;
+			break;
+#ifdef HAVE_LIBXML2
+		case ZBX_PREPROC_XPATH:
+			if (NULL == (expr_local.data = xmlXPathCompile((xmlChar *)params)))
+			{
+				xmlResetLastError();
+				return NULL;
+			}
+			break;
+#endif
+		default:
+			THIS_SHOULD_NEVER_HAPPEN;
+			return NULL;
+	}
+
+	expr_local.params = zbx_strdup(NULL, params);
+	expr = (zbx_preproc_expr_t *)zbx_hashset_insert(&preproc_expr_cache, &expr_local, sizeof(expr_local));
+
+	return expr->data;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_json_path_open                                      *
+ *                                                                            *
+ * Purpose: opens an object by json path, using compiled json path if         *
+ *          possible                                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	item_preproc_json_path_open(const struct zbx_json_parse *jp, const char *params,
+		struct zbx_json_parse *out)
+{
+	zbx_jsonpath_t	*jsonpath;
+
+	if (NULL != (jsonpath = (zbx_jsonpath_t *)item_preproc_cache_get(ZBX_PREPROC_JSONPATH, params)))
+		return zbx_json_path_open_compiled(jp, jsonpath, out);
+
+	return zbx_json_path_open(jp, params, out);
+}
+
+#ifdef HAVE_LIBXML2
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_xpath_eval                                          *
+ *                                                                            *
+ * Purpose: evaluates xpath expression, using compiled expression if possible *
+ *                                                                            *
+ ******************************************************************************/
+static xmlXPathObject	*item_preproc_xpath_eval(const char *params, xmlXPathContext *xpathCtx)
+{
+	xmlXPathCompExprPtr	comp;
+
+	if (NULL != (comp = (xmlXPathCompExprPtr)item_preproc_cache_get(ZBX_PREPROC_XPATH, params)))
+		return xmlXPathCompiledEval(comp, xpathCtx);
+
+	return xmlXPathEvalExpression((xmlChar *)params, xpathCtx);
+}
+#endif
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_numeric_type_hint                                   *
@@ -838,7 +1020,7 @@ static int	item_preproc_jsonpath_op(zbx_variant_t *value, const char *params, ch
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
 
-	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_json_path_open(&jp, params, &jp_out))
+	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == item_preproc_json_path_open(&jp, params, &jp_out))
 	{
 		*errmsg = zbx_strdup(*errmsg, zbx_json_strerror());
 		return FAIL;
@@ -924,7 +1106,7 @@ static int	item_preproc_xpath_op(zbx_variant_t *value, const char *params, char
 
 	xpathCtx = xmlXPathNewContext(doc);
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)params, xpathCtx)))
+	if (NULL == (xpathObj = item_preproc_xpath_eval(params, xpathCtx)))
 	{
 		pErr = xmlGetLastError();
 		*errmsg = zbx_dsprintf(*errmsg, "cannot parse xpath: %s", pErr->message);
@@ -1226,7 +1408,7 @@ static int	item_preproc_get_error_from_json(const zbx_variant_t *value, const ch
 		goto out;
 	}
 
-	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == zbx_json_path_open(&jp, params, &jp_out))
+	if (FAIL == zbx_json_open(value->data.str, &jp) || FAIL == item_preproc_json_path_open(&jp, params, &jp_out))
 		goto out;
 
 	zbx_free(*error);
@@ -1296,7 +1478,7 @@ static int	item_preproc_get_error_from_xml(const zbx_variant_t *value, const cha
 
 	xpathCtx = xmlXPathNewContext(doc);
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)params, xpathCtx)))
+	if (NULL == (xpathObj = item_preproc_xpath_eval(params, xpathCtx)))
 	{
 		pErr = xmlGetLastError();
 		*errmsg = zbx_dsprintf(*errmsg, "cannot parse xpath: %s", pErr->message);
@@ -1504,6 +1686,161 @@ static int	item_preproc_throttle_timed_value(zbx_variant_t *value, const zbx_tim
 	return SUCCEED;
 }
 
+/* compiled script bytecode cache, the least recently used scripts are dropped when the cache size limit is reached */
+#define ZBX_PREPROC_SCRIPT_CACHE_SIZE	(4 * ZBX_MEBIBYTE)
+
+typedef struct zbx_preproc_script
+{
+	char				*script;
+	char				*code;
+	int				size;
+
+	/* the least recently used list, ordered from the most recently used script */
+	struct zbx_preproc_script	*prev;
+	struct zbx_preproc_script	*next;
+}
+zbx_preproc_script_t;
+
+static zbx_hashset_t		preproc_script_cache;
+static zbx_preproc_script_t	*preproc_script_head, *preproc_script_tail;
+static size_t			preproc_script_cache_size;
+static int			preproc_script_cache_init = 0;
+
+static zbx_hash_t	preproc_script_hash(const void *data)
+{
+	const zbx_preproc_script_t	*script = (const zbx_preproc_script_t *)data;
+
+	return ZBX_DEFAULT_STRING_HASH_FUNC(script->script);
+}
+
+static int	preproc_script_compare(const void *d1, const void *d2)
+{
+	const zbx_preproc_script_t	*s1 = (const zbx_preproc_script_t *)d1;
+	const zbx_preproc_script_t	*s2 = (const zbx_preproc_script_t *)d2;
+
+	return strcmp(s1->script, s2->script);
+}
+
+static void	preproc_script_clean(void *data)
+{
+	zbx_preproc_script_t	*script = (zbx_preproc_script_t *)data;
+
+	zbx_free(script->script);
+	zbx_free(script->code);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_script_unlink                                            *
+ *                                                                            *
+ * Purpose: removes script from the least recently used list                  *
+ *                                                                            *
+ ******************************************************************************/
+static void	preproc_script_unlink(zbx_preproc_script_t *script)
+{
+	if (NULL != script->prev)
+		script->prev->next = script->next;
+	else
+		preproc_script_head = script->next;
+
+	if (NULL != script->next)
+		script->next->prev = script->prev;
+	else
+		preproc_script_tail = script->prev;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preproc_script_link                                              *
+ *                                                                            *
+ * Purpose: adds script at the head of the least recently used list           *
+ *                                                                            *
+ ******************************************************************************/
+static void	preproc_script_link(zbx_preproc_script_t *script)
+{
+	script->prev = NULL;
+
+	if (NULL != (script->next = preproc_script_head))
+		preproc_script_head->prev = script;
+	else
+		preproc_script_tail = script;
+
+	preproc_script_head = script;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: item_preproc_script_get_code                                     *
+ *                                                                            *
+ * Purpose: gets compiled script bytecode, compiling and caching it if        *
+ *          necessary                                                         *
+ *                                                                            *
+ * Parameters: params - [IN] the script                                       *
+ *             code   - [OUT] the bytecode                                    *
+ *             size   - [OUT] the bytecode size                               *
+ *             errmsg - [OUT] error message                                   *
+ *                                                                            *
+ * Return value: SUCCEED - the bytecode was returned                          *
+ *               FAIL - otherwise                                             *
+ *                                                                            *
+ * Comments: The scripts are cached by their source, so the same script used  *
+ *           by several items or preprocessing steps is compiled only once.   *
+ *           Returned bytecode is valid until the next call of this function. *
+ *                                                                            *
+ ******************************************************************************/
+static int	item_preproc_script_get_code(const char *params, const char **code, int *size, char **errmsg)
+{
+	zbx_preproc_script_t	*script, script_local;
+
+	if (0 == preproc_script_cache_init)
+	{
+		zbx_hashset_create_ext(&preproc_script_cache, 100, preproc_script_hash, preproc_script_compare,
+				preproc_script_clean, ZBX_DEFAULT_MEM_MALLOC_FUNC, ZBX_DEFAULT_MEM_REALLOC_FUNC,
+				ZBX_DEFAULT_MEM_FREE_FUNC);
+		preproc_script_cache_init = 1;
+	}
+
+	script_local.script = (char *)params;
+
+	if (NULL != (script = (zbx_preproc_script_t *)zbx_hashset_search(&preproc_script_cache, &script_local)))
+	{
+		if (script != preproc_script_head)
+		{
+			preproc_script_unlink(script);
+			preproc_script_link(script);
+		}
+
+		*code = script->code;
+		*size = script->size;
+
+		return SUCCEED;
+	}
+
+	if (SUCCEED != zbx_es_compile(&es_engine, params, &script_local.code, &script_local.size, errmsg))
+		return FAIL;
+
+	/* drop the least recently used scripts to fit the new script in cache */
+	while (NULL != preproc_script_tail &&
+			preproc_script_cache_size + script_local.size > ZBX_PREPROC_SCRIPT_CACHE_SIZE)
+	{
+		script = preproc_script_tail;
+		preproc_script_unlink(script);
+		preproc_script_cache_size -= script->size;
+		zbx_hashset_remove_direct(&preproc_script_cache, script);
+	}
+
+	script_local.script = zbx_strdup(NULL, params);
+	script = (zbx_preproc_script_t *)zbx_hashset_insert(&preproc_script_cache, &script_local,
+			sizeof(script_local));
+	preproc_script_link(script);
+	preproc_script_cache_size += script->size;
+
+	*code = script->code;
+	*size = script->size;
+
+	return SUCCEED;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: item_preproc_script                                              *
@@ -1512,17 +1849,20 @@ static int	item_preproc_throttle_timed_value(zbx_variant_t *value, const zbx_tim
  *                                                                            *
  * Parameters: value    - [IN/OUT] the value to process                       *
  *             params   - [IN] the script to execute                          *
- *             bytecode - [IN] precompiled bytecode, can be NULL              *
  *             errmsg   - [OUT] error message                                 *
  *                                                                            *
  * Return value: SUCCEED - the value was calculated successfully              *
  *               FAIL - otherwise                                             *
  *                                                                            *
+ * Comments: The scripting engine environment is kept between executions and  *
+ *           the compiled script bytecode is cached by the worker.            *
+ *                                                                            *
  ******************************************************************************/
-static int	item_preproc_script(zbx_variant_t *value, const char *params, zbx_variant_t *bytecode, char **errmsg)
+static int	item_preproc_script(zbx_variant_t *value, const char *params, char **errmsg)
 {
-	char	*code, *output, *error = NULL;
-	int	size;
+	const char	*code;
+	char		*output, *error = NULL;
+	int		size;
 
 	if (FAIL == item_preproc_convert_value(value, ZBX_VARIANT_STR, errmsg))
 		return FAIL;
@@ -1533,17 +1873,8 @@ static int	item_preproc_script(zbx_variant_t *value, const char *params, zbx_var
 			return FAIL;
 	}
 
-	if (ZBX_VARIANT_BIN != bytecode->type)
-	{
-		if (SUCCEED != zbx_es_compile(&es_engine, params, &code, &size, errmsg))
-			goto fail;
-
-		zbx_variant_clear(bytecode);
-		zbx_variant_set_bin(bytecode, zbx_variant_data_bin_create(code, size));
-		zbx_free(code);
-	}
-
-	size = zbx_variant_data_bin_get(bytecode->data.bin, (void **)&code);
+	if (SUCCEED != item_preproc_script_get_code(params, &code, &size, errmsg))
+		goto fail;
 
 	if (SUCCEED == zbx_es_execute(&es_engine, params, code, size, value->data.str, &output, errmsg))
 	{
@@ -1657,7 +1988,7 @@ int	zbx_item_preproc(int index, unsigned char value_type, zbx_variant_t *value,
 					&errmsg);
 			break;
 		case ZBX_PREPROC_SCRIPT:
-			ret = item_preproc_script(value, op->params, history_value, &errmsg);
+			ret = item_preproc_script(value, op->params, &errmsg);
 			break;
 		default:
 			errmsg = zbx_dsprintf(NULL, "unknown preprocessing operation");
@@ -36,10 +36,17 @@
 
 
 extern unsigned char	process_type, program_type;
-extern int		server_num, process_num, CONFIG_PREPROCESSOR_FORKS;
+extern int		server_num, process_num, CONFIG_PREPROCESSOR_FORKS, CONFIG_PREPROCMAN_FORKS;
 
 #define ZBX_PREPROCESSING_MANAGER_DELAY	1
 
+/* the maximum number of values and the maximum data size sent to worker in one task batch */
+#define ZBX_PREPROCESSING_BATCH_MAX	256
+#define ZBX_PREPROCESSING_BATCH_SIZE	ZBX_MEBIBYTE
+
+/* the minimum number of dependent items with JSONPath first step to extract their values in a single pass */
+#define ZBX_PREPROCESSING_MULTIPATH_MIN	2
+
 #define ZBX_PREPROC_PRIORITY_NONE	0
 #define ZBX_PREPROC_PRIORITY_FIRST	1
 
@@ -61,6 +68,9 @@ typedef struct preprocessing_request
 	zbx_preproc_item_value_t	value;		/* unpacked item value */
 	zbx_preproc_op_t		*steps;		/* preprocessing steps */
 	int				steps_num;	/* number of preprocessing steps */
+	int				first_step;	/* the first preprocessing step to execute */
+	int				paths_ts;	/* the configuration timestamp of JSONPaths */
+							/* sent to worker for dependent items */
 	unsigned char			value_type;	/* value type from configuration */
 							/* at the beginning of preprocessing queue */
 }
@@ -70,7 +80,7 @@ zbx_preprocessing_request_t;
 typedef struct
 {
 	zbx_ipc_client_t	*client;	/* the connected preprocessing worker client */
-	zbx_list_item_t		*queue_item;	/* queued item */
+	zbx_vector_ptr_t	tasks;		/* queued items sent to worker in the current batch */
 }
 zbx_preprocessing_worker_t;
 
@@ -87,6 +97,7 @@ typedef struct
 {
 	zbx_preprocessing_worker_t	*workers;	/* preprocessing worker array */
 	int				worker_count;	/* preprocessing worker count */
+	int				worker_max;	/* workers assigned to this manager */
 	zbx_list_t			queue;		/* queue of item values */
 	zbx_hashset_t			item_config;	/* item configuration L2 cache */
 	zbx_hashset_t			history_cache;	/* item value history cache */
@@ -100,7 +111,11 @@ typedef struct
 zbx_preprocessing_manager_t;
 
 static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
-		zbx_preproc_item_value_t *value, zbx_list_item_t *master);
+		zbx_preproc_item_value_t *value, zbx_list_item_t *master, char **values, int values_num);
+static const char	**preprocessor_get_jsonpaths(zbx_preprocessing_manager_t *manager,
+		const zbx_preproc_item_t *item);
+static int	preprocessor_set_variant_result(zbx_preprocessing_request_t *request, zbx_variant_t *value,
+		char *error);
 
 /* cleanup functions */
 
@@ -193,39 +208,27 @@ static void	preprocessor_sync_configuration(zbx_preprocessing_manager_t *manager
  *                                                                            *
  * Function: preprocessor_get_queued_item                                     *
  *                                                                            *
- * Purpose: get queued item value with no dependencies (or with resolved      *
+ * Purpose: get next queued item value with no dependencies (or with resolved *
  *          dependencies)                                                     *
  *                                                                            *
- * Parameters: manager - [IN] preprocessing manager                           *
+ * Parameters: iterator - [IN/OUT] the value queue iterator                   *
  *                                                                            *
  * Return value: pointer to the queued item or NULL if none                   *
  *                                                                            *
  ******************************************************************************/
-static zbx_list_item_t	*preprocessor_get_queued_item(zbx_preprocessing_manager_t *manager)
+static zbx_list_item_t	*preprocessor_get_queued_item(zbx_list_iterator_t *iterator)
 {
-	const char			*__function_name = "preprocessor_get_queued_item";
-	zbx_list_iterator_t		iterator;
 	zbx_preprocessing_request_t	*request;
-	zbx_list_item_t			*item = NULL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
-	zbx_list_iterator_init(&manager->queue, &iterator);
-	while (SUCCEED == zbx_list_iterator_next(&iterator))
+	while (SUCCEED == zbx_list_iterator_next(iterator))
 	{
-		zbx_list_iterator_peek(&iterator, (void **)&request);
+		zbx_list_iterator_peek(iterator, (void **)&request);
 
 		if (REQUEST_STATE_QUEUED == request->state)
-		{
-			/* queued item is found */
-			item = iterator.current;
-			break;
-		}
+			return iterator->current;
 	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
-
-	return item;
+	return NULL;
 }
 
 /******************************************************************************
@@ -281,7 +284,7 @@ static zbx_preprocessing_worker_t	*preprocessor_get_free_worker(zbx_preprocessin
 
 	for (i = 0; i < manager->worker_count; i++)
 	{
-		if (NULL == manager->workers[i].queue_item)
+		if (0 == manager->workers[i].tasks.values_num)
 			return &manager->workers[i];
 	}
 
@@ -298,6 +301,10 @@ static zbx_preprocessing_worker_t	*preprocessor_get_free_worker(zbx_preprocessin
  *             request - [IN] preprocessing request                           *
  *             task    - [OUT] preprocessing task data                        *
  *                                                                            *
+ * Comments: JSONPath first steps of dependent items are added to the task,   *
+ *           so the worker can execute them with a single pass over the       *
+ *           preprocessed value.                                              *
+ *                                                                            *
  ******************************************************************************/
 static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manager,
 		zbx_preprocessing_request_t *request, unsigned char **task)
@@ -305,6 +312,10 @@ static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manage
 	zbx_variant_t		value;
 	zbx_preproc_history_t	*vault;
 	zbx_vector_ptr_t	*phistory;
+	zbx_preproc_item_t	*item;
+	const char		**paths = NULL;
+	int			paths_num = 0;
+	zbx_uint32_t		size;
 
 	if (ISSET_LOG(request->value.result))
 		zbx_variant_set_str(&value, request->value.result->log->value);
@@ -327,8 +338,52 @@ static zbx_uint32_t	preprocessor_create_task(zbx_preprocessing_manager_t *manage
 	else
 		phistory = NULL;
 
-	return zbx_preprocessor_pack_task(task, request->value.itemid, request->value_type, request->value.ts, &value,
-			phistory, request->steps, request->steps_num);
+	if (NULL != (item = (zbx_preproc_item_t *)zbx_hashset_search(&manager->item_config, &request->value.itemid)) &&
+			NULL != (paths = preprocessor_get_jsonpaths(manager, item)))
+	{
+		paths_num = item->dep_itemids_num;
+	}
+
+	request->paths_ts = manager->cache_ts;
+
+	size = zbx_preprocessor_pack_task(task, request->value.itemid, request->value_type, request->value.ts, &value,
+			phistory, request->steps, request->steps_num, request->first_step, manager->cache_ts, paths,
+			paths_num);
+
+	zbx_free(paths);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_batch_size                                      *
+ *                                                                            *
+ * Purpose: get number of values to be sent to worker in one task batch       *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *                                                                            *
+ * Return value: the task batch size                                          *
+ *                                                                            *
+ * Comments: Values are sent one by one while the queue is short to keep the  *
+ *           latency low. As the queue grows the batch size is increased to   *
+ *           split queued values evenly between workers, reducing the number  *
+ *           of IPC round trips.                                              *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_get_batch_size(const zbx_preprocessing_manager_t *manager)
+{
+	zbx_uint64_t	size;
+
+	size = manager->preproc_num / (zbx_uint64_t)MAX(manager->worker_count, 1);
+
+	if (1 > size)
+		return 1;
+
+	if (ZBX_PREPROCESSING_BATCH_MAX < size)
+		return ZBX_PREPROCESSING_BATCH_MAX;
+
+	return (int)size;
 }
 
 /******************************************************************************
@@ -344,32 +399,48 @@ static void	preprocessor_assign_tasks(zbx_preprocessing_manager_t *manager)
 {
 	const char			*__function_name = "preprocessor_assign_tasks";
 	zbx_list_item_t			*queue_item;
+	zbx_list_iterator_t		iterator;
 	zbx_preprocessing_request_t	*request;
 	zbx_preprocessing_worker_t	*worker;
-	zbx_uint32_t			size;
-	unsigned char			*task;
+	zbx_uint32_t			size, batch_alloc = 0, batch_offset;
+	unsigned char			*task, *batch = NULL;
+	int				batch_size;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
-	while (NULL != (worker = preprocessor_get_free_worker(manager)) &&
-			NULL != (queue_item = preprocessor_get_queued_item(manager)))
+	batch_size = preprocessor_get_batch_size(manager);
+	zbx_list_iterator_init(&manager->queue, &iterator);
+
+	while (NULL != (worker = preprocessor_get_free_worker(manager)))
 	{
-		request = (zbx_preprocessing_request_t *)queue_item->data;
-		size = preprocessor_create_task(manager, request, &task);
+		batch_offset = 0;
 
-		if (FAIL == zbx_ipc_client_send(worker->client, ZBX_IPC_PREPROCESSOR_REQUEST, task, size))
+		while (batch_size > worker->tasks.values_num && ZBX_PREPROCESSING_BATCH_SIZE > batch_offset &&
+				NULL != (queue_item = preprocessor_get_queued_item(&iterator)))
 		{
-			zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing worker");
-			exit(EXIT_FAILURE);
+			request = (zbx_preprocessing_request_t *)queue_item->data;
+			size = preprocessor_create_task(manager, request, &task);
+			zbx_preprocessor_pack_batch(&batch, &batch_alloc, &batch_offset, task, size);
+
+			request->state = REQUEST_STATE_PROCESSING;
+			zbx_vector_ptr_append(&worker->tasks, queue_item);
+
+			request_free_steps(request);
+			zbx_free(task);
 		}
 
-		request->state = REQUEST_STATE_PROCESSING;
-		worker->queue_item = queue_item;
+		if (0 == worker->tasks.values_num)
+			break;
 
-		request_free_steps(request);
-		zbx_free(task);
+		if (FAIL == zbx_ipc_client_send(worker->client, ZBX_IPC_PREPROCESSOR_REQUEST, batch, batch_offset))
+		{
+			zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing worker");
+			exit(EXIT_FAILURE);
+		}
 	}
 
+	zbx_free(batch);
+
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
@@ -597,26 +668,208 @@ static void	preprocessor_copy_value(zbx_preproc_item_value_t *target, zbx_prepro
 	}
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_copy_extracted_value                                *
+ *                                                                            *
+ * Purpose: create a copy of existing item value, replacing its data with     *
+ *          the value extracted from it                                       *
+ *                                                                            *
+ * Parameters: target  - [OUT] created copy                                   *
+ *             source  - [IN]  value to be copied                             *
+ *             data    - [IN]  the extracted value, the ownership is passed   *
+ *                             to the created copy                            *
+ *                                                                            *
+ * Comments: Only the result field used for preprocessing is set in the copy, *
+ *           see preprocessor_get_value_str().                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_copy_extracted_value(zbx_preproc_item_value_t *target,
+		const zbx_preproc_item_value_t *source, char *data)
+{
+	memcpy(target, source, sizeof(zbx_preproc_item_value_t));
+
+	if (NULL != source->error)
+		target->error = zbx_strdup(NULL, source->error);
+
+	if (NULL != source->ts)
+	{
+		target->ts = (zbx_timespec_t *)zbx_malloc(NULL, sizeof(zbx_timespec_t));
+		memcpy(target->ts, source->ts, sizeof(zbx_timespec_t));
+	}
+
+	target->result = (AGENT_RESULT *)zbx_malloc(NULL, sizeof(AGENT_RESULT));
+	init_result(target->result);
+
+	target->result->lastlogsize = source->result->lastlogsize;
+	target->result->mtime = source->result->mtime;
+	target->result->type = (source->result->type & AR_META);
+
+	if (NULL != source->result->msg)
+		SET_MSG_RESULT(target->result, zbx_strdup(NULL, source->result->msg));
+
+	if (ISSET_LOG(source->result))
+	{
+		zbx_log_t	*log;
+
+		log = (zbx_log_t *)zbx_malloc(NULL, sizeof(zbx_log_t));
+		memcpy(log, source->result->log, sizeof(zbx_log_t));
+		log->value = data;
+
+		if (NULL != source->result->log->source)
+			log->source = zbx_strdup(NULL, source->result->log->source);
+
+		SET_LOG_RESULT(target->result, log);
+	}
+	else if (ISSET_STR(source->result))
+		SET_STR_RESULT(target->result, data);
+	else
+		SET_TEXT_RESULT(target->result, data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_value_str                                       *
+ *                                                                            *
+ * Purpose: get string value passed to the first preprocessing step           *
+ *                                                                            *
+ * Parameters: result - [IN] the item value                                   *
+ *                                                                            *
+ * Return value: the string value or NULL if the value is numeric             *
+ *                                                                            *
+ * Comments: The value is selected in the same order as in                    *
+ *           preprocessor_create_task() function.                             *
+ *                                                                            *
+ ******************************************************************************/
+static const char	*preprocessor_get_value_str(const AGENT_RESULT *result)
+{
+	if (ISSET_LOG(result))
+		return result->log->value;
+
+	if (ISSET_UI64(result) || ISSET_DBL(result))
+		return NULL;
+
+	if (ISSET_STR(result))
+		return result->str;
+
+	if (ISSET_TEXT(result))
+		return result->text;
+
+	return NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_get_jsonpaths                                       *
+ *                                                                            *
+ * Purpose: get JSONPath first steps of dependent items that can be executed  *
+ *          with a single pass over the master item value                     *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             item    - [IN] the master item configuration                   *
+ *                                                                            *
+ * Return value: the JSONPaths for each dependent item (NULL if the item      *
+ *               first step is not JSONPath) or NULL if there are not enough  *
+ *               JSONPath steps to use a single pass                          *
+ *                                                                            *
+ * Comments: The returned array must be freed by the caller, the paths        *
+ *           reference item configuration.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static const char	**preprocessor_get_jsonpaths(zbx_preprocessing_manager_t *manager,
+		const zbx_preproc_item_t *item)
+{
+	const char		**paths;
+	zbx_preproc_item_t	*dep_item;
+	int			i, paths_num = 0;
+
+	if (ZBX_PREPROCESSING_MULTIPATH_MIN > item->dep_itemids_num || (ITEM_VALUE_TYPE_STR != item->value_type &&
+			ITEM_VALUE_TYPE_TEXT != item->value_type && ITEM_VALUE_TYPE_LOG != item->value_type))
+	{
+		return NULL;
+	}
+
+	paths = (const char **)zbx_malloc(NULL, sizeof(char *) * item->dep_itemids_num);
+
+	for (i = 0; i < item->dep_itemids_num; i++)
+	{
+		if (NULL != (dep_item = (zbx_preproc_item_t *)zbx_hashset_search(&manager->item_config,
+				&item->dep_itemids[i])) && 0 != dep_item->preproc_ops_num &&
+				ZBX_PREPROC_JSONPATH == dep_item->preproc_ops[0].type)
+		{
+			paths[i] = dep_item->preproc_ops[0].params;
+			paths_num++;
+		}
+		else
+			paths[i] = NULL;
+	}
+
+	if (ZBX_PREPROCESSING_MULTIPATH_MIN > paths_num)
+		zbx_free(paths);
+
+	return paths;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_set_extracted_result                                *
+ *                                                                            *
+ * Purpose: convert value extracted by the master item worker to the item     *
+ *          value type                                                        *
+ *                                                                            *
+ * Parameters: value      - [IN/OUT] the item value                           *
+ *             value_type - [IN] the item value type                          *
+ *                                                                            *
+ * Return value: SUCCEED - the value was converted                            *
+ *               FAIL    - otherwise, the item becomes not supported          *
+ *                                                                            *
+ * Comments: Used for items with JSONPath as the only preprocessing step to   *
+ *           avoid sending the extracted value to worker for nothing.         *
+ *                                                                            *
+ ******************************************************************************/
+static int	preprocessor_set_extracted_result(zbx_preproc_item_value_t *value, unsigned char value_type)
+{
+	zbx_preprocessing_request_t	request;
+	zbx_variant_t			variant;
+	int				ret;
+
+	request.value = *value;
+	request.value_type = value_type;
+
+	zbx_variant_set_str(&variant, zbx_strdup(NULL, preprocessor_get_value_str(value->result)));
+	ret = preprocessor_set_variant_result(&request, &variant, NULL);
+	zbx_variant_clear(&variant);
+
+	*value = request.value;
+
+	return ret;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: preprocessor_enqueue                                             *
  *                                                                            *
  * Purpose: enqueue preprocessing request                                     *
  *                                                                            *
- * Parameters: manage   - [IN] preprocessing manager                          *
- *             value    - [IN] item value                                     *
- *             master   - [IN] request should be enqueued after this item     *
- *                             (NULL for the end of the queue)                *
+ * Parameters: manage     - [IN] preprocessing manager                        *
+ *             value      - [IN] item value                                   *
+ *             master     - [IN] request should be enqueued after this item   *
+ *                               (NULL for the end of the queue)              *
+ *             first_step - [IN] the first preprocessing step to execute      *
+ *                                                                            *
+ * Comments: Items without preprocessing steps are sent to worker only if     *
+ *           JSONPath steps of their dependent items can be executed there.   *
  *                                                                            *
  ******************************************************************************/
 static void	preprocessor_enqueue(zbx_preprocessing_manager_t *manager, zbx_preproc_item_value_t *value,
-		zbx_list_item_t *master)
+		zbx_list_item_t *master, int first_step)
 {
 	const char			*__function_name = "preprocessor_enqueue";
 	zbx_preprocessing_request_t	*request;
 	zbx_preproc_item_t		*item, item_local;
 	zbx_list_item_t			*enqueued_at;
 	int				i;
+	const char			**paths;
 	zbx_preprocessing_states_t	state;
 	unsigned char			priority = ZBX_PREPROC_PRIORITY_NONE;
 
@@ -629,24 +882,40 @@ static void	preprocessor_enqueue(zbx_preprocessing_manager_t *manager, zbx_prepr
 	if (NULL != item && ITEM_TYPE_INTERNAL == item->type)
 		priority = ZBX_PREPROC_PRIORITY_FIRST;
 
-	if (NULL == item || 0 == item->preproc_ops_num || NULL == value->result || 0 == ISSET_VALUE(value->result))
+	if (NULL == item || NULL == value->result || 0 == ISSET_VALUE(value->result))
 	{
 		state = REQUEST_STATE_DONE;
-
-		if (NULL == manager->queue.head)
+	}
+	else if (0 != first_step && first_step == item->preproc_ops_num)
+	{
+		/* the only JSONPath step was executed by the master item worker */
+		(void)preprocessor_set_extracted_result(value, item->value_type);
+		state = REQUEST_STATE_DONE;
+	}
+	else if (0 == item->preproc_ops_num)
+	{
+		if (NULL != (paths = preprocessor_get_jsonpaths(manager, item)))
 		{
-			/* queue is empty and item is done, it can be flushed */
-			preprocessor_flush_value(value);
-			manager->processed_num++;
-			preprocessor_enqueue_dependent(manager, value, NULL);
-			preproc_item_value_clear(value);
-
-			goto out;
+			zbx_free(paths);
+			state = REQUEST_STATE_QUEUED;
 		}
+		else
+			state = REQUEST_STATE_DONE;
 	}
 	else
 		state = REQUEST_STATE_QUEUED;
 
+	if (REQUEST_STATE_DONE == state && NULL == manager->queue.head)
+	{
+		/* queue is empty and item is done, it can be flushed */
+		preprocessor_flush_value(value);
+		manager->processed_num++;
+		preprocessor_enqueue_dependent(manager, value, NULL, NULL, 0);
+		preproc_item_value_clear(value);
+
+		goto out;
+	}
+
 	request = (zbx_preprocessing_request_t *)zbx_malloc(NULL, sizeof(zbx_preprocessing_request_t));
 	memset(request, 0, sizeof(zbx_preprocessing_request_t));
 	memcpy(&request->value, value, sizeof(zbx_preproc_item_value_t));
@@ -657,6 +926,7 @@ static void	preprocessor_enqueue(zbx_preprocessing_manager_t *manager, zbx_prepr
 		request->value_type = item->value_type;
 		request->steps = (zbx_preproc_op_t *)zbx_malloc(NULL, sizeof(zbx_preproc_op_t) * item->preproc_ops_num);
 		request->steps_num = item->preproc_ops_num;
+		request->first_step = first_step;
 
 		for (i = 0; i < item->preproc_ops_num; i++)
 		{
@@ -703,7 +973,7 @@ static void	preprocessor_enqueue(zbx_preprocessing_manager_t *manager, zbx_prepr
 
 	/* if no preprocessing is needed, dependent items are enqueued */
 	if (REQUEST_STATE_DONE == request->state)
-		preprocessor_enqueue_dependent(manager, value, enqueued_at);
+		preprocessor_enqueue_dependent(manager, value, enqueued_at, NULL, 0);
 
 	manager->queued_num++;
 out:
@@ -720,10 +990,14 @@ out:
  *             source_value - [IN] master item value                          *
  *             master       - [IN] dependent item should be enqueued after    *
  *                                 this item                                  *
+ *             values       - [IN/OUT] the values extracted by worker for     *
+ *                                     each dependent item (NULL if none),    *
+ *                                     the used values are taken over         *
+ *             values_num   - [IN] the number of extracted values             *
  *                                                                            *
  ******************************************************************************/
 static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
-		zbx_preproc_item_value_t *source_value, zbx_list_item_t *master)
+		zbx_preproc_item_value_t *source_value, zbx_list_item_t *master, char **values, int values_num)
 {
 	const char			*__function_name = "preprocessor_enqueue_dependent";
 	int				i;
@@ -732,17 +1006,32 @@ static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() itemid: " ZBX_FS_UI64, __function_name, source_value->itemid);
 
-	if (NULL != source_value->result && ISSET_VALUE(source_value->result))
+	if (NULL != source_value->result && ISSET_VALUE(source_value->result) &&
+			ITEM_STATE_NOTSUPPORTED != source_value->state)
 	{
 		item_local.itemid = source_value->itemid;
 		if (NULL != (item = (zbx_preproc_item_t *)zbx_hashset_search(&manager->item_config, &item_local)) &&
 				0 != item->dep_itemids_num)
 		{
+			if (values_num != item->dep_itemids_num)
+				values = NULL;
+
 			for (i = item->dep_itemids_num - 1; i >= 0; i--)
 			{
-				preprocessor_copy_value(&value, source_value);
-				value.itemid = item->dep_itemids[i];
-				preprocessor_enqueue(manager, &value, master);
+				if (NULL != values && NULL != values[i])
+				{
+					/* the JSONPath step is already executed */
+					preprocessor_copy_extracted_value(&value, source_value, values[i]);
+					values[i] = NULL;
+					value.itemid = item->dep_itemids[i];
+					preprocessor_enqueue(manager, &value, master, 1);
+				}
+				else
+				{
+					preprocessor_copy_value(&value, source_value);
+					value.itemid = item->dep_itemids[i];
+					preprocessor_enqueue(manager, &value, master, 0);
+				}
 			}
 
 			preprocessor_assign_tasks(manager);
@@ -762,6 +1051,10 @@ static void	preprocessor_enqueue_dependent(zbx_preprocessing_manager_t *manager,
  * Parameters: manager - [IN] preprocessing manager                           *
  *             message - [IN] packed preprocessing request                    *
  *                                                                            *
+ * Comments: The values are unpacked into memory owned by the queued          *
+ *           requests, so the message data is not referenced after return.    *
+ *           This allows to release ring buffer messages right away.          *
+ *                                                                            *
  ******************************************************************************/
 static void	preprocessor_add_request(zbx_preprocessing_manager_t *manager, zbx_ipc_message_t *message)
 {
@@ -776,7 +1069,7 @@ static void	preprocessor_add_request(zbx_preprocessing_manager_t *manager, zbx_i
 	while (offset < message->size)
 	{
 		offset += zbx_preprocessor_unpack_value(&value, message->data + offset);
-		preprocessor_enqueue(manager, &value, NULL);
+		preprocessor_enqueue(manager, &value, NULL, 0);
 	}
 
 	preprocessor_assign_tasks(manager);
@@ -895,34 +1188,30 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: preprocessor_add_result                                          *
+ * Function: preprocessor_set_request_result                                  *
  *                                                                            *
- * Purpose: handle preprocessing result                                       *
+ * Purpose: handle preprocessing result of a single request                   *
  *                                                                            *
- * Parameters: manager - [IN] preprocessing manager                           *
- *             client  - [IN] IPC client                                      *
- *             message - [IN] packed preprocessing result                     *
+ * Parameters: manager    - [IN] preprocessing manager                        *
+ *             queue_item - [IN] the queued item of processed request         *
+ *             data       - [IN] packed preprocessing result                  *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
-		zbx_ipc_message_t *message)
+static void	preprocessor_set_request_result(zbx_preprocessing_manager_t *manager, zbx_list_item_t *queue_item,
+		const unsigned char *data)
 {
-	const char			*__function_name = "preprocessor_add_result";
-	zbx_preprocessing_worker_t	*worker;
 	zbx_preprocessing_request_t	*request;
 	zbx_variant_t			value;
-	char				*error;
+	char				*error, **values;
 	zbx_item_link_t			*index;
 	zbx_vector_ptr_t		history;
 	zbx_preproc_history_t		*vault;
+	int				i, values_num;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
-
-	worker = preprocessor_get_worker_by_client(manager, client);
-	request = (zbx_preprocessing_request_t *)worker->queue_item->data;
+	request = (zbx_preprocessing_request_t *)queue_item->data;
 
 	zbx_vector_ptr_create(&history);
-	zbx_preprocessor_unpack_result(&value, &history, &error, message->data);
+	zbx_preprocessor_unpack_result(&value, &history, &error, &values, &values_num, data);
 
 	if (NULL != (vault = (zbx_preproc_history_t *)zbx_hashset_search(&manager->history_cache,
 			&request->value.itemid)))
@@ -961,24 +1250,78 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 		request->pending->state = REQUEST_STATE_QUEUED;
 
 	if (NULL != (index = (zbx_item_link_t *)zbx_hashset_search(&manager->linked_items, &request->value.itemid)) &&
-			worker->queue_item == index->queue_item)
+			queue_item == index->queue_item)
 	{
 		zbx_hashset_remove_direct(&manager->linked_items, index);
 	}
 
+	manager->preproc_num--;
+
 	if (FAIL != preprocessor_set_variant_result(request, &value, error))
-		preprocessor_enqueue_dependent(manager, &request->value, worker->queue_item);
+	{
+		/* dependent items might have been changed since the JSONPaths were sent to worker */
+		if (request->paths_ts == manager->cache_ts)
+			preprocessor_enqueue_dependent(manager, &request->value, queue_item, values, values_num);
+		else
+			preprocessor_enqueue_dependent(manager, &request->value, queue_item, NULL, 0);
+	}
+
+	if (NULL != values)
+	{
+		for (i = 0; i < values_num; i++)
+			zbx_free(values[i]);
+
+		zbx_free(values);
+	}
 
-	worker->queue_item = NULL;
 	zbx_variant_clear(&value);
+	zbx_vector_ptr_destroy(&history);
+}
 
-	manager->preproc_num--;
+/******************************************************************************
+ *                                                                            *
+ * Function: preprocessor_add_result                                          *
+ *                                                                            *
+ * Purpose: handle preprocessing result batch                                 *
+ *                                                                            *
+ * Parameters: manager - [IN] preprocessing manager                           *
+ *             client  - [IN] IPC client                                      *
+ *             message - [IN] packed preprocessing result batch               *
+ *                                                                            *
+ ******************************************************************************/
+static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ipc_client_t *client,
+		zbx_ipc_message_t *message)
+{
+	const char			*__function_name = "preprocessor_add_result";
+	zbx_preprocessing_worker_t	*worker;
+	zbx_uint32_t			offset = 0;
+	const unsigned char		*data;
+	int				i;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+
+	worker = preprocessor_get_worker_by_client(manager, client);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "%s() results:%d", __function_name, worker->tasks.values_num);
+
+	/* results are returned in the same order as tasks were sent */
+	for (i = 0; i < worker->tasks.values_num && offset < message->size; i++)
+	{
+		offset += zbx_preprocessor_unpack_batch(message->data + offset, &data);
+		preprocessor_set_request_result(manager, (zbx_list_item_t *)worker->tasks.values[i], data);
+	}
+
+	if (i != worker->tasks.values_num)
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_vector_ptr_clear(&worker->tasks);
 
 	preprocessor_assign_tasks(manager);
 	preprocessing_flush_queue(manager);
 
-	zbx_vector_ptr_destroy(&history);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
@@ -994,12 +1337,21 @@ static void	preprocessor_add_result(zbx_preprocessing_manager_t *manager, zbx_ip
 static void	preprocessor_init_manager(zbx_preprocessing_manager_t *manager)
 {
 	const char	*__function_name = "preprocessor_init_manager";
+	int		managers_num;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __function_name, CONFIG_PREPROCESSOR_FORKS);
+	managers_num = MAX(CONFIG_PREPROCMAN_FORKS, 1);
 
 	memset(manager, 0, sizeof(zbx_preprocessing_manager_t));
 
-	manager->workers = (zbx_preprocessing_worker_t *)zbx_calloc(NULL, CONFIG_PREPROCESSOR_FORKS, sizeof(zbx_preprocessing_worker_t));
+	/* workers are assigned to managers in round-robin fashion by their process numbers */
+	manager->worker_max = CONFIG_PREPROCESSOR_FORKS / managers_num;
+	if ((process_num - 1) % managers_num < CONFIG_PREPROCESSOR_FORKS % managers_num)
+		manager->worker_max++;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() workers: %d", __function_name, manager->worker_max);
+
+	manager->workers = (zbx_preprocessing_worker_t *)zbx_calloc(NULL, MAX(manager->worker_max, 1),
+			sizeof(zbx_preprocessing_worker_t));
 	zbx_list_create(&manager->queue);
 	zbx_hashset_create_ext(&manager->item_config, 0, ZBX_DEFAULT_UINT64_HASH_FUNC, ZBX_DEFAULT_UINT64_COMPARE_FUNC,
 			(zbx_clean_func_t)preproc_item_clear,
@@ -1040,7 +1392,7 @@ static void preprocessor_register_worker(zbx_preprocessing_manager_t *manager, z
 	}
 	else
 	{
-		if (CONFIG_PREPROCESSOR_FORKS == manager->worker_count)
+		if (manager->worker_max == manager->worker_count)
 		{
 			THIS_SHOULD_NEVER_HAPPEN;
 			exit(EXIT_FAILURE);
@@ -1048,6 +1400,7 @@ static void preprocessor_register_worker(zbx_preprocessing_manager_t *manager, z
 
 		worker = (zbx_preprocessing_worker_t *)&manager->workers[manager->worker_count++];
 		worker->client = client;
+		zbx_vector_ptr_create(&worker->tasks);
 
 		preprocessor_assign_tasks(manager);
 	}
@@ -1067,6 +1420,10 @@ static void preprocessor_register_worker(zbx_preprocessing_manager_t *manager, z
 static void	preprocessor_destroy_manager(zbx_preprocessing_manager_t *manager)
 {
 	zbx_preprocessing_request_t	*request;
+	int				i;
+
+	for (i = 0; i < manager->worker_count; i++)
+		zbx_vector_ptr_destroy(&manager->workers[i].tasks);
 
 	zbx_free(manager->workers);
 
@@ -1086,7 +1443,8 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	zbx_ipc_service_t		service;
 	char				*error = NULL;
 	zbx_ipc_client_t		*client;
-	zbx_ipc_message_t		*message;
+	zbx_ipc_message_t		*message, ring_message;
+	zbx_ipc_ring_t			*ring;
 	zbx_preprocessing_manager_t	manager;
 	int				ret;
 	double				time_stat, time_idle = 0, time_now, time_flush, sec;
@@ -1103,13 +1461,23 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 	zabbix_log(LOG_LEVEL_INFORMATION, "%s #%d started [%s #%d]", get_program_type_string(program_type),
 			server_num, get_process_type_string(process_type), process_num);
 
-	if (FAIL == zbx_ipc_service_start(&service, ZBX_IPC_SERVICE_PREPROCESSING, &error))
+	if (FAIL == zbx_ipc_service_start(&service, zbx_preprocessor_get_service_name(process_num), &error))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot start preprocessing service: %s", error);
+		zbx_free(error);
+		exit(EXIT_FAILURE);
+	}
+
+	if (NULL != (ring = zbx_preprocessor_get_ring(process_num)) &&
+			FAIL == zbx_ipc_service_add_ring(&service, ring, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot start preprocessing service: %s", error);
 		zbx_free(error);
 		exit(EXIT_FAILURE);
 	}
 
+	zbx_set_sigusr_handler(zbx_ipc_service_sigusr_handler);
+
 	preprocessor_init_manager(&manager);
 
 	/* initialize statistics */
@@ -1173,6 +1541,21 @@ ZBX_THREAD_ENTRY(preprocessing_manager_thread, args)
 		if (NULL != client)
 			zbx_ipc_client_release(client);
 
+		/* values sent through the shared memory ring buffer */
+		if (NULL != ring)
+		{
+			/* The message is read in place, but its values are copied when queued. Keeping them */
+			/* in the ring until preprocessed would block producers while values wait for workers. */
+			while (SUCCEED == zbx_ipc_ring_read(ring, &ring_message))
+			{
+				preprocessor_add_request(&manager, &ring_message);
+				zbx_ipc_ring_release(ring);
+			}
+
+			/* release space used by partially received fragmented message */
+			zbx_ipc_ring_release(ring);
+		}
+
 		if (0 == manager.preproc_num || 1 < time_now - time_flush)
 		{
 			dc_flush_history();
@@ -23,6 +23,7 @@
 #include "log.h"
 #include "zbxipcservice.h"
 #include "zbxserialize.h"
+#include "zbxjson.h"
 #include "preprocessing.h"
 #include "zbxembed.h"
 
@@ -32,28 +33,82 @@
 #include "preproc_history.h"
 
 extern unsigned char	process_type, program_type;
-extern int		server_num, process_num;
+extern int		server_num, process_num, CONFIG_PREPROCMAN_FORKS;
 
 zbx_es_t	es_engine;
 
 /******************************************************************************
  *                                                                            *
- * Function: worker_preprocess_value                                          *
+ * Function: worker_extract_jsonpaths                                         *
  *                                                                            *
- * Purpose: handle item value preprocessing task                              *
+ * Purpose: execute JSONPath first steps of dependent items with a single     *
+ *          pass over the preprocessed master item value                      *
  *                                                                            *
- * Parameters: socket  - [IN] IPC socket                                      *
- *             message - [IN] packed preprocessing task                       *
+ * Parameters: value     - [IN] the preprocessed master item value            *
+ *             paths     - [IN] the JSONPaths of dependent items (NULL        *
+ *                              entries are skipped)                          *
+ *             paths_num - [IN] the number of JSONPaths                       *
+ *                                                                            *
+ * Return value: the extracted values for each path (NULL if the value was    *
+ *               not extracted) or NULL if no values were extracted           *
+ *                                                                            *
+ * Comments: Values that cannot be extracted are left to be processed as      *
+ *           usual, so errors and error handlers are processed the same way.  *
  *                                                                            *
  ******************************************************************************/
-static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
+static char	**worker_extract_jsonpaths(const zbx_variant_t *value, char **paths, int paths_num)
+{
+	char			**values = NULL;
+	struct zbx_json_parse	jp, *out;
+	int			i, *found;
+	size_t			value_alloc;
+
+	if (ZBX_VARIANT_STR != value->type || SUCCEED != zbx_json_open(value->data.str, &jp))
+		return NULL;
+
+	out = (struct zbx_json_parse *)zbx_malloc(NULL, sizeof(struct zbx_json_parse) * paths_num);
+	found = (int *)zbx_malloc(NULL, sizeof(int) * paths_num);
+
+	if (0 != zbx_json_path_open_multi(&jp, (const char **)paths, paths_num, out, found))
+	{
+		values = (char **)zbx_calloc(NULL, paths_num, sizeof(char *));
+
+		for (i = 0; i < paths_num; i++)
+		{
+			if (SUCCEED != found[i])
+				continue;
+
+			value_alloc = 0;
+			zbx_json_value_dyn(&out[i], &values[i], &value_alloc);
+		}
+	}
+
+	zbx_free(found);
+	zbx_free(out);
+
+	return values;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_task                                           *
+ *                                                                            *
+ * Purpose: preprocess single item value                                      *
+ *                                                                            *
+ * Parameters: task   - [IN] packed preprocessing task                        *
+ *             result - [OUT] packed preprocessing result                     *
+ *                                                                            *
+ * Return value: size of packed result                                        *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint32_t	worker_preprocess_task(const unsigned char *task, unsigned char **result)
 {
 	zbx_uint32_t		size = 0;
-	unsigned char		*data = NULL, value_type;
+	unsigned char		value_type;
 	zbx_uint64_t		itemid;
 	zbx_variant_t		value;
-	int			i, steps_num;
-	char			*error = NULL;
+	int			i, steps_num, first_step, revision, paths_num, values_num = 0;
+	char			*error = NULL, **paths, **values = NULL;
 	zbx_timespec_t		*ts;
 	zbx_preproc_op_t	*steps;
 	zbx_vector_ptr_t	history_in, history_out;
@@ -61,10 +116,12 @@ static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t
 	zbx_vector_ptr_create(&history_in);
 	zbx_vector_ptr_create(&history_out);
 
-	zbx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num,
-			message->data);
+	zbx_preprocessor_unpack_task(&itemid, &value_type, &ts, &value, &history_in, &steps, &steps_num, &first_step,
+			&revision, &paths, &paths_num, task);
+
+	zbx_item_preproc_cache_sync(revision);
 
-	for (i = 0; i < steps_num; i++)
+	for (i = first_step; i < steps_num; i++)
 	{
 		zbx_preproc_op_history_t	*ophistory;
 		zbx_variant_t			history_value;
@@ -100,25 +157,68 @@ static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t
 			break;
 	}
 
-	size = zbx_preprocessor_pack_result(&data, &value, &history_out, error);
+	if (0 != paths_num && NULL == error && NULL != (values = worker_extract_jsonpaths(&value, paths, paths_num)))
+		values_num = paths_num;
+
+	size = zbx_preprocessor_pack_result(result, &value, &history_out, error, values, values_num);
 	zbx_variant_clear(&value);
 	zbx_free(error);
 	zbx_free(ts);
 	zbx_free(steps);
 
-	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_RESULT, data, size))
-	{
-		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
-		exit(EXIT_FAILURE);
-	}
+	for (i = 0; i < paths_num; i++)
+		zbx_free(paths[i]);
+	zbx_free(paths);
 
-	zbx_free(data);
+	for (i = 0; i < values_num; i++)
+		zbx_free(values[i]);
+	zbx_free(values);
 
 	zbx_vector_ptr_clear_ext(&history_out, (zbx_clean_func_t)zbx_preproc_op_history_free);
 	zbx_vector_ptr_destroy(&history_out);
 
 	zbx_vector_ptr_clear_ext(&history_in, (zbx_clean_func_t)zbx_preproc_op_history_free);
 	zbx_vector_ptr_destroy(&history_in);
+
+	return size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: worker_preprocess_value                                          *
+ *                                                                            *
+ * Purpose: handle item value preprocessing task batch                        *
+ *                                                                            *
+ * Parameters: socket  - [IN] IPC socket                                      *
+ *             message - [IN] packed preprocessing task batch                 *
+ *                                                                            *
+ * Comments: The results are sent back in one message, in the same order as   *
+ *           the tasks were received.                                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	worker_preprocess_value(zbx_ipc_socket_t *socket, zbx_ipc_message_t *message)
+{
+	zbx_uint32_t		offset = 0, size, batch_alloc = 0, batch_offset = 0;
+	unsigned char		*data, *batch = NULL;
+	const unsigned char	*task;
+
+	while (offset < message->size)
+	{
+		offset += zbx_preprocessor_unpack_batch(message->data + offset, &task);
+
+		data = NULL;
+		size = worker_preprocess_task(task, &data);
+		zbx_preprocessor_pack_batch(&batch, &batch_alloc, &batch_offset, data, size);
+		zbx_free(data);
+	}
+
+	if (FAIL == zbx_ipc_socket_write(socket, ZBX_IPC_PREPROCESSOR_RESULT, batch, batch_offset))
+	{
+		zabbix_log(LOG_LEVEL_CRIT, "cannot send preprocessing result");
+		exit(EXIT_FAILURE);
+	}
+
+	zbx_free(batch);
 }
 
 ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
@@ -138,7 +238,9 @@ ZBX_THREAD_ENTRY(preprocessing_worker_thread, args)
 
 	zbx_ipc_message_init(&message);
 
-	if (FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, 10, &error))
+	/* workers are evenly distributed between preprocessing managers */
+	if (FAIL == zbx_ipc_socket_open(&socket, zbx_preprocessor_get_service_name(
+			(process_num - 1) % MAX(CONFIG_PREPROCMAN_FORKS, 1) + 1), 10, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		zbx_free(error);
@@ -44,9 +44,124 @@ zbx_packed_field_t;
 #define PACKED_FIELD(value, size)	\
 		(zbx_packed_field_t){(value), (size), (0 == (size) ? PACKED_FIELD_STRING : PACKED_FIELD_RAW)};
 
-static zbx_ipc_message_t	cached_message	= (zbx_ipc_message_t){0, 0, NULL};
+/* values are cached separately for each preprocessing manager */
+static zbx_ipc_message_t	*cached_messages = NULL;
 static int			cached_values	= 0;
 
+/* shared memory ring buffers used to pass values to preprocessing managers */
+static zbx_ipc_ring_t		*rings = NULL;
+
+extern int		CONFIG_PREPROCMAN_FORKS;
+extern zbx_uint64_t	CONFIG_PREPROCESSOR_RING_SIZE;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_create_rings                                    *
+ *                                                                            *
+ * Purpose: create shared memory ring buffers for passing item values to      *
+ *          preprocessing managers                                            *
+ *                                                                            *
+ * Parameters: error - [OUT] the error message                                *
+ *                                                                            *
+ * Return value: SUCCEED - the ring buffers were created successfully         *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: Must be called before forking processes, so the ring buffers are *
+ *           shared between value producers and preprocessing managers.       *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_create_rings(char **error)
+{
+	int	i, rings_num;
+
+	rings_num = MAX(CONFIG_PREPROCMAN_FORKS, 1);
+	rings = (zbx_ipc_ring_t *)zbx_calloc(NULL, rings_num, sizeof(zbx_ipc_ring_t));
+
+	for (i = 0; i < rings_num; i++)
+	{
+		if (SUCCEED != zbx_ipc_ring_create(&rings[i], (zbx_uint32_t)CONFIG_PREPROCESSOR_RING_SIZE, error))
+		{
+			while (0 < i--)
+				zbx_ipc_ring_destroy(&rings[i]);
+
+			zbx_free(rings);
+			return FAIL;
+		}
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_ring                                        *
+ *                                                                            *
+ * Purpose: get ring buffer of the preprocessing manager                      *
+ *                                                                            *
+ * Parameters: manager_num - [IN] the preprocessing manager number, starting  *
+ *                                with 1                                      *
+ *                                                                            *
+ * Return value: the ring buffer or NULL if ring buffers are not used         *
+ *                                                                            *
+ ******************************************************************************/
+zbx_ipc_ring_t	*zbx_preprocessor_get_ring(int manager_num)
+{
+	if (NULL == rings || 1 > manager_num || MAX(CONFIG_PREPROCMAN_FORKS, 1) < manager_num)
+		return NULL;
+
+	return &rings[manager_num - 1];
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_service_name                                *
+ *                                                                            *
+ * Purpose: get IPC service name of the preprocessing manager                 *
+ *                                                                            *
+ * Parameters: manager_num - [IN] the preprocessing manager number, starting  *
+ *                                with 1                                      *
+ *                                                                            *
+ * Return value: the IPC service name                                         *
+ *                                                                            *
+ * Comments: The first manager uses the default preprocessing service name.   *
+ *           Returns pointer to static buffer.                                *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_preprocessor_get_service_name(int manager_num)
+{
+	static char	service_name[MAX_STRING_LEN];
+
+	if (1 >= manager_num)
+		return ZBX_IPC_SERVICE_PREPROCESSING;
+
+	zbx_snprintf(service_name, sizeof(service_name), "%s_%d", ZBX_IPC_SERVICE_PREPROCESSING, manager_num);
+
+	return service_name;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_get_manager_num                                 *
+ *                                                                            *
+ * Purpose: get the preprocessing manager responsible for the item            *
+ *                                                                            *
+ * Parameters: itemid - [IN] the item identifier                              *
+ *                                                                            *
+ * Return value: the preprocessing manager number, starting with 1            *
+ *                                                                            *
+ * Comments: Item values are sharded between preprocessing managers by item   *
+ *           identifier, so all values of an item (and of its dependent       *
+ *           items) are processed by the same manager in the received order.  *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_preprocessor_get_manager_num(zbx_uint64_t itemid)
+{
+	if (1 >= CONFIG_PREPROCMAN_FORKS)
+		return 1;
+
+	return (int)(itemid % (zbx_uint64_t)CONFIG_PREPROCMAN_FORKS) + 1;
+}
+
 /******************************************************************************
  *                                                                            *
  * Function: message_pack_data                                                *
@@ -188,13 +303,20 @@ static zbx_uint32_t	preprocessor_pack_value(zbx_ipc_message_t *message, zbx_prep
  *             history       - [IN] history data (can be NULL)                *
  *             steps         - [IN] preprocessing steps                       *
  *             steps_num     - [IN] preprocessing step count                  *
+ *             first_step    - [IN] the first step to execute                 *
+ *             revision      - [IN] the configuration revision                *
+ *             paths         - [IN] JSONPaths to extract from the result      *
+ *                                  value for dependent items (NULL entries   *
+ *                                  are skipped)                              *
+ *             paths_num     - [IN] the number of JSONPaths                   *
  *                                                                            *
  * Return value: size of packed data                                          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemid, unsigned char value_type,
 		zbx_timespec_t *ts, zbx_variant_t *value, const zbx_vector_ptr_t *history,
-		const zbx_preproc_op_t *steps, int steps_num)
+		const zbx_preproc_op_t *steps, int steps_num, int first_step, int revision, const char **paths,
+		int paths_num)
 {
 	zbx_packed_field_t	*offset, *fields;
 	unsigned char		ts_marker;
@@ -205,8 +327,8 @@ zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemi
 
 	history_num = (NULL != history ? history->values_num : 0);
 
-	/* 9 is a max field count (without preprocessing step and history fields) */
-	fields = (zbx_packed_field_t *)zbx_malloc(NULL, (9 + steps_num * 4 + history_num * 5)
+	/* 12 is a max field count (without preprocessing step, history and JSONPath fields) */
+	fields = (zbx_packed_field_t *)zbx_malloc(NULL, (12 + steps_num * 4 + history_num * 5 + paths_num)
 			* sizeof(zbx_packed_field_t));
 
 	offset = fields;
@@ -287,6 +409,13 @@ zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemi
 		*offset++ = PACKED_FIELD(steps[i].error_handler_params, 0);
 	}
 
+	*offset++ = PACKED_FIELD(&first_step, sizeof(int));
+	*offset++ = PACKED_FIELD(&revision, sizeof(int));
+	*offset++ = PACKED_FIELD(&paths_num, sizeof(int));
+
+	for (i = 0; i < paths_num; i++)
+		*offset++ = PACKED_FIELD(paths[i], 0);
+
 	zbx_ipc_message_init(&message);
 	size = message_pack_data(&message, fields, offset - fields);
 	*data = message.data;
@@ -306,12 +435,15 @@ zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemi
  *             value         - [IN] result value                              *
  *             history       - [IN] item history data                         *
  *             error         - [IN] preprocessing error                       *
+ *             values        - [IN] the values extracted for dependent items  *
+ *                                  (NULL entries were not extracted)         *
+ *             values_num    - [IN] the number of extracted values            *
  *                                                                            *
  * Return value: size of packed data                                          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *value,
-		const zbx_vector_ptr_t *history, char *error)
+		const zbx_vector_ptr_t *history, char *error, char **values, int values_num)
 {
 	zbx_packed_field_t	*offset, *fields;
 	unsigned char		history_num;
@@ -327,8 +459,9 @@ zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *v
 
 	history_num = history->values_num;
 
-	/* 4 is a max field count (without history fields) */
-	fields = (zbx_packed_field_t *)zbx_malloc(NULL, (4 + history_num * 5) * sizeof(zbx_packed_field_t));
+	/* 5 is a max field count (without history and extracted value fields) */
+	fields = (zbx_packed_field_t *)zbx_malloc(NULL, (5 + history_num * 5 + values_num) *
+			sizeof(zbx_packed_field_t));
 	offset = fields;
 
 	*offset++ = PACKED_FIELD(&value->type, sizeof(unsigned char));
@@ -385,6 +518,10 @@ zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *v
 	}
 
 	*offset++ = PACKED_FIELD(error, 0);
+	*offset++ = PACKED_FIELD(&values_num, sizeof(int));
+
+	for (i = 0; i < values_num; i++)
+		*offset++ = PACKED_FIELD(values[i], 0);
 
 	zbx_ipc_message_init(&message);
 	size = message_pack_data(&message, fields, offset - fields);
@@ -479,12 +616,18 @@ zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsi
  *             history       - [OUT] history data                             *
  *             steps         - [OUT] preprocessing steps                      *
  *             steps_num     - [OUT] preprocessing step count                 *
+ *             first_step    - [OUT] the first step to execute                *
+ *             revision      - [OUT] the configuration revision               *
+ *             paths         - [OUT] JSONPaths to extract from the result     *
+ *                                   value for dependent items                *
+ *             paths_num     - [OUT] the number of JSONPaths                  *
  *             data          - [IN] IPC data buffer                           *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_type, zbx_timespec_t **ts,
 		zbx_variant_t *value, zbx_vector_ptr_t *history, zbx_preproc_op_t **steps,
-		int *steps_num, const unsigned char *data)
+		int *steps_num, int *first_step, int *revision, char ***paths, int *paths_num,
+		const unsigned char *data)
 {
 	zbx_uint32_t			value_len;
 	const unsigned char		*offset = data;
@@ -579,6 +722,20 @@ void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_typ
 	}
 	else
 		*steps = NULL;
+
+	offset += zbx_deserialize_int(offset, first_step);
+	offset += zbx_deserialize_int(offset, revision);
+	offset += zbx_deserialize_int(offset, paths_num);
+
+	if (0 < *paths_num)
+	{
+		*paths = (char **)zbx_malloc(NULL, sizeof(char *) * (*paths_num));
+
+		for (i = 0; i < *paths_num; i++)
+			offset += zbx_deserialize_str(offset, &(*paths)[i], value_len);
+	}
+	else
+		*paths = NULL;
 }
 
 /******************************************************************************
@@ -590,15 +747,18 @@ void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_typ
  * Parameters: value         - [OUT] result value                             *
  *             history       - [OUT] item history data                        *
  *             error         - [OUT] preprocessing error                      *
+ *             values        - [OUT] the values extracted for dependent items *
+ *             values_num    - [OUT] the number of extracted values           *
  *             data          - [IN] IPC data buffer                           *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *history, char **error,
-		const unsigned char *data)
+		char ***values, int *values_num, const unsigned char *data)
 {
 	zbx_uint32_t			value_len;
 	const unsigned char		*offset = data;
 	unsigned char 			history_num;
+	int				i;
 
 	offset += zbx_deserialize_char(offset, &value->type);
 
@@ -620,8 +780,6 @@ void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *hist
 	offset += zbx_deserialize_char(offset, &history_num);
 	if (0 != history_num)
 	{
-		int	i;
-
 		zbx_vector_ptr_reserve(history, history_num);
 
 		for (i = 0; i < history_num; i++)
@@ -658,7 +816,76 @@ void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *hist
 		}
 	}
 
-	(void)zbx_deserialize_str(offset, error, value_len);
+	offset += zbx_deserialize_str(offset, error, value_len);
+	offset += zbx_deserialize_int(offset, values_num);
+
+	if (0 < *values_num)
+	{
+		*values = (char **)zbx_malloc(NULL, sizeof(char *) * (*values_num));
+
+		for (i = 0; i < *values_num; i++)
+			offset += zbx_deserialize_str(offset, &(*values)[i], value_len);
+	}
+	else
+		*values = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_pack_batch                                      *
+ *                                                                            *
+ * Purpose: append packed task or result to batch data buffer                 *
+ *                                                                            *
+ * Parameters: batch        - [IN/OUT] the batch data buffer                  *
+ *             batch_alloc  - [IN/OUT] the batch data buffer size             *
+ *             batch_offset - [IN/OUT] the batch data size                    *
+ *             data         - [IN] the packed task or result                  *
+ *             size         - [IN] the packed task or result size             *
+ *                                                                            *
+ * Comments: Batch contains sequence of packed tasks (results) each prefixed  *
+ *           with its size. Results are returned in the same order as tasks.  *
+ *                                                                            *
+ ******************************************************************************/
+void	zbx_preprocessor_pack_batch(unsigned char **batch, zbx_uint32_t *batch_alloc, zbx_uint32_t *batch_offset,
+		const unsigned char *data, zbx_uint32_t size)
+{
+	zbx_uint32_t	batch_size;
+
+	batch_size = *batch_offset + sizeof(zbx_uint32_t) + size;
+
+	if (*batch_alloc < batch_size)
+	{
+		while (*batch_alloc < batch_size)
+			*batch_alloc = (0 == *batch_alloc ? ZBX_IPC_SOCKET_BUFFER_SIZE : *batch_alloc * 2);
+
+		*batch = (unsigned char *)zbx_realloc(*batch, *batch_alloc);
+	}
+
+	*batch_offset += zbx_serialize_value(*batch + *batch_offset, size);
+	memcpy(*batch + *batch_offset, data, size);
+	*batch_offset += size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_preprocessor_unpack_batch                                    *
+ *                                                                            *
+ * Purpose: get the next packed task or result from batch data buffer         *
+ *                                                                            *
+ * Parameters: batch - [IN] the batch data at the current position            *
+ *             data  - [OUT] the packed task or result                        *
+ *                                                                            *
+ * Return value: number of batch bytes used by the task or result             *
+ *                                                                            *
+ ******************************************************************************/
+zbx_uint32_t	zbx_preprocessor_unpack_batch(const unsigned char *batch, const unsigned char **data)
+{
+	zbx_uint32_t	size;
+
+	memcpy(&size, batch, sizeof(zbx_uint32_t));
+	*data = batch + sizeof(zbx_uint32_t);
+
+	return size + sizeof(zbx_uint32_t);
 }
 
 /******************************************************************************
@@ -667,34 +894,41 @@ void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *hist
  *                                                                            *
  * Purpose: sends command to preprocessor manager                             *
  *                                                                            *
- * Parameters: code     - [IN] message code                                   *
- *             data     - [IN] message data                                   *
- *             size     - [IN] message data size                              *
- *             response - [OUT] response message (can be NULL if response is  *
- *                              not requested)                                *
+ * Parameters: manager_num - [IN] the preprocessing manager number            *
+ *             code        - [IN] message code                                *
+ *             data        - [IN] message data                                *
+ *             size        - [IN] message data size                           *
+ *             response    - [OUT] response message (can be NULL if response  *
+ *                                 is not requested)                          *
  *                                                                            *
  ******************************************************************************/
-static void	preprocessor_send(zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
+static void	preprocessor_send(int manager_num, zbx_uint32_t code, unsigned char *data, zbx_uint32_t size,
 		zbx_ipc_message_t *response)
 {
-	char			*error = NULL;
-	static zbx_ipc_socket_t	socket = {0};
+	char				*error = NULL;
+	static zbx_ipc_socket_t		*sockets = NULL;
+	zbx_ipc_socket_t		*socket;
+
+	if (NULL == sockets)
+		sockets = (zbx_ipc_socket_t *)zbx_calloc(NULL, MAX(CONFIG_PREPROCMAN_FORKS, 1), sizeof(zbx_ipc_socket_t));
 
-	/* each process has a permanent connection to preprocessing manager */
-	if (0 == socket.fd && FAIL == zbx_ipc_socket_open(&socket, ZBX_IPC_SERVICE_PREPROCESSING, SEC_PER_MIN,
-			&error))
+	socket = &sockets[manager_num - 1];
+
+	/* each process has a permanent connection to every preprocessing manager */
+	if (0 == socket->fd && FAIL == zbx_ipc_socket_open(socket, zbx_preprocessor_get_service_name(manager_num),
+			SEC_PER_MIN, &error))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot connect to preprocessing service: %s", error);
 		exit(EXIT_FAILURE);
 	}
 
-	if (FAIL == zbx_ipc_socket_write(&socket, code, data, size))
+	if (FAIL == zbx_ipc_socket_write(socket, code, data, size))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot send data to preprocessing service");
 		exit(EXIT_FAILURE);
 	}
 
-	if (NULL != response && FAIL == zbx_ipc_socket_read(&socket, response))
+	if (NULL != response && FAIL == zbx_ipc_socket_read(socket, response))
 	{
 		zabbix_log(LOG_LEVEL_CRIT, "cannot receive data from preprocessing service");
 		exit(EXIT_FAILURE);
@@ -727,7 +961,13 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, unsigned char item_value_typ
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
-	preprocessor_pack_value(&cached_message, &value);
+	if (NULL == cached_messages)
+	{
+		cached_messages = (zbx_ipc_message_t *)zbx_calloc(NULL, MAX(CONFIG_PREPROCMAN_FORKS, 1),
+				sizeof(zbx_ipc_message_t));
+	}
+
+	preprocessor_pack_value(&cached_messages[zbx_preprocessor_get_manager_num(itemid) - 1], &value);
 
 	if (MAX_VALUES_LOCAL < ++cached_values)
 		zbx_preprocessor_flush();
@@ -739,39 +979,64 @@ void	zbx_preprocess_item_value(zbx_uint64_t itemid, unsigned char item_value_typ
  *                                                                            *
  * Function: zbx_preprocessor_flush                                           *
  *                                                                            *
- * Purpose: send flush command to preprocessing manager                       *
+ * Purpose: send flush command to preprocessing managers                      *
  *                                                                            *
  ******************************************************************************/
 void	zbx_preprocessor_flush(void)
 {
-	if (0 < cached_message.size)
+	int		i;
+	zbx_ipc_ring_t	*ring;
+
+	if (NULL == cached_messages)
+		return;
+
+	for (i = 0; i < MAX(CONFIG_PREPROCMAN_FORKS, 1); i++)
 	{
-		preprocessor_send(ZBX_IPC_PREPROCESSOR_REQUEST, cached_message.data, cached_message.size, NULL);
+		if (0 == cached_messages[i].size)
+			continue;
+
+		if (NULL != (ring = zbx_preprocessor_get_ring(i + 1)))
+		{
+			zbx_ipc_ring_write(ring, ZBX_IPC_PREPROCESSOR_REQUEST, cached_messages[i].data,
+					cached_messages[i].size);
+		}
+		else
+		{
+			preprocessor_send(i + 1, ZBX_IPC_PREPROCESSOR_REQUEST, cached_messages[i].data,
+					cached_messages[i].size, NULL);
+		}
 
-		zbx_ipc_message_clean(&cached_message);
-		zbx_ipc_message_init(&cached_message);
-		cached_values = 0;
+		zbx_ipc_message_clean(&cached_messages[i]);
+		zbx_ipc_message_init(&cached_messages[i]);
 	}
+
+	cached_values = 0;
 }
 
 /******************************************************************************
  *                                                                            *
  * Function: zbx_preprocessor_get_queue_size                                  *
  *                                                                            *
- * Purpose: get queue size (enqueued value count) of preprocessing manager    *
+ * Purpose: get queue size (enqueued value count) of preprocessing managers   *
  *                                                                            *
  * Return value: enqueued item count                                          *
  *                                                                            *
  ******************************************************************************/
 zbx_uint64_t	zbx_preprocessor_get_queue_size(void)
 {
-	zbx_uint64_t		size;
+	zbx_uint64_t		size, total = 0;
 	zbx_ipc_message_t	message;
+	int			i;
 
-	zbx_ipc_message_init(&message);
-	preprocessor_send(ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
-	memcpy(&size, message.data, sizeof(zbx_uint64_t));
-	zbx_ipc_message_clean(&message);
+	for (i = 1; i <= MAX(CONFIG_PREPROCMAN_FORKS, 1); i++)
+	{
+		zbx_ipc_message_init(&message);
+		preprocessor_send(i, ZBX_IPC_PREPROCESSOR_QUEUE, NULL, 0, &message);
+		memcpy(&size, message.data, sizeof(zbx_uint64_t));
+		zbx_ipc_message_clean(&message);
 
-	return size;
+		total += size;
+	}
+
+	return total;
 }
@@ -23,6 +23,7 @@
 #include "common.h"
 #include "module.h"
 #include "dbcache.h"
+#include "zbxipcservice.h"
 
 #define ZBX_IPC_SERVICE_PREPROCESSING	"preprocessing"
 
@@ -44,17 +45,28 @@ typedef struct
 }
 zbx_preproc_item_value_t;
 
+const char	*zbx_preprocessor_get_service_name(int manager_num);
+int	zbx_preprocessor_get_manager_num(zbx_uint64_t itemid);
+int	zbx_preprocessor_create_rings(char **error);
+zbx_ipc_ring_t	*zbx_preprocessor_get_ring(int manager_num);
+
 zbx_uint32_t	zbx_preprocessor_pack_task(unsigned char **data, zbx_uint64_t itemid, unsigned char value_type,
 		zbx_timespec_t *ts, zbx_variant_t *value, const zbx_vector_ptr_t *history,
-		const zbx_preproc_op_t *steps, int steps_num);
+		const zbx_preproc_op_t *steps, int steps_num, int first_step, int revision, const char **paths,
+		int paths_num);
 zbx_uint32_t	zbx_preprocessor_pack_result(unsigned char **data, zbx_variant_t *value,
-		const zbx_vector_ptr_t *history, char *error);
+		const zbx_vector_ptr_t *history, char *error, char **values, int values_num);
 
 zbx_uint32_t	zbx_preprocessor_unpack_value(zbx_preproc_item_value_t *value, unsigned char *data);
 void	zbx_preprocessor_unpack_task(zbx_uint64_t *itemid, unsigned char *value_type, zbx_timespec_t **ts,
 		zbx_variant_t *value, zbx_vector_ptr_t *history, zbx_preproc_op_t **steps,
-		int *steps_num, const unsigned char *data);
-void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *history, char **error,
+		int *steps_num, int *first_step, int *revision, char ***paths, int *paths_num,
 		const unsigned char *data);
+void	zbx_preprocessor_unpack_result(zbx_variant_t *value, zbx_vector_ptr_t *history, char **error,
+		char ***values, int *values_num, const unsigned char *data);
+
+void	zbx_preprocessor_pack_batch(unsigned char **batch, zbx_uint32_t *batch_alloc, zbx_uint32_t *batch_offset,
+		const unsigned char *data, zbx_uint32_t size);
+zbx_uint32_t	zbx_preprocessor_unpack_batch(const unsigned char *batch, const unsigned char **data);
 
 #endif /* ZABBIX_PREPROCESSING_H */
@@ -52,6 +52,11 @@
  * with the latest data from VMware vCenter (or Hypervisor), destroying the old data
  * object and replacing it with the new one.
  *
+ * With VMwareIncrementalUpdate enabled the collector keeps the vCenter session and a
+ * property filter between updates. After the first full update the service data object
+ * is not replaced - the changes reported by WaitForUpdatesEx are applied to it in place,
+ * re-reading only the objects whose structure has changed.
+ *
  * The collector must be locked only when accessing service object list and working with
  * a service object. It is not locked for new data object creation during service update,
  * which is the most time consuming task.
@@ -68,6 +73,8 @@ extern int		CONFIG_VMWARE_FREQUENCY;
 extern int		CONFIG_VMWARE_PERF_FREQUENCY;
 extern zbx_uint64_t	CONFIG_VMWARE_CACHE_SIZE;
 extern int		CONFIG_VMWARE_TIMEOUT;
+extern int		CONFIG_VMWARE_INCREMENTAL_UPDATE;
+extern int		CONFIG_VMWARE_PERF_CONCURRENCY;
 
 extern unsigned char	process_type, program_type;
 extern int		server_num, process_num;
@@ -84,6 +91,7 @@ extern char		*CONFIG_SOURCE_IP;
 #define zbx_xml_free_doc(xdoc)		if (NULL != xdoc)\
 						xmlFreeDoc(xdoc)
 #define ZBX_VMWARE_DS_REFRESH_VERSION	6
+#define ZBX_VMWARE_PERF_WAIT_TIMEOUT	1000	/* milliseconds */
 
 static zbx_mutex_t	vmware_lock = ZBX_MUTEX_NULL;
 
@@ -116,14 +124,15 @@ typedef struct
 	const char	*session_manager;
 	const char	*event_manager;
 	const char	*property_collector;
+	const char	*root_folder;
 }
 zbx_vmware_service_objects_t;
 
 static zbx_vmware_service_objects_t	vmware_service_objects[3] =
 {
-	{NULL, NULL, NULL, NULL},
-	{"ha-perfmgr", "ha-sessionmgr", "ha-eventmgr", "ha-property-collector"},
-	{"PerfMgr", "SessionManager", "EventManager", "propertyCollector"}
+	{NULL, NULL, NULL, NULL, NULL},
+	{"ha-perfmgr", "ha-sessionmgr", "ha-eventmgr", "ha-property-collector", "ha-folder-root"},
+	{"PerfMgr", "SessionManager", "EventManager", "propertyCollector", "group-d1"}
 };
 
 /* mapping of performance counter group/key[rollup type] to its id (net/transmitted[average] -> <id>) */
@@ -400,11 +409,19 @@ typedef struct
 }
 ZBX_HTTPPAGE;
 
+/* libxml2 2.12 changed structured error handler to receive a constant error */
+#if LIBXML_VERSION >= 21200
+typedef const xmlError	*zbx_libxml_error_ptr_t;
+#else
+typedef xmlErrorPtr	zbx_libxml_error_ptr_t;
+#endif
+
 static int	zbx_xml_read_values(xmlDoc *xdoc, const char *xpath, zbx_vector_str_t *values);
 static int	zbx_xml_try_read_value(const char *data, size_t len, const char *xpath, xmlDoc **xdoc, char **value,
 		char **error);
 static char	*zbx_xml_read_node_value(xmlDoc *doc, xmlNode *node, const char *xpath);
 static char	*zbx_xml_read_doc_value(xmlDoc *xdoc, const char *xpath);
+static void	libxml_handle_error(void *user_data, zbx_libxml_error_ptr_t err);
 
 static size_t	curl_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
 {
@@ -751,6 +768,11 @@ static void	vmware_entities_shared_clean_stats(zbx_hashset_t *entities)
 			counter = (zbx_vmware_perf_counter_t *)entity->counters.values[i];
 			vmware_vector_str_uint64_pair_shared_clean(&counter->values);
 
+			/* release the value array, it's allocated with exact size when new values are copied */
+			zbx_vector_str_uint64_pair_destroy(&counter->values);
+			zbx_vector_str_uint64_pair_create_ext(&counter->values, __vm_mem_malloc_func,
+					__vm_mem_realloc_func, __vm_mem_free_func);
+
 			if (0 != (counter->state & ZBX_VMWARE_COUNTER_UPDATING))
 				counter->state = ZBX_VMWARE_COUNTER_READY;
 		}
@@ -1048,6 +1070,11 @@ static void	vmware_service_shared_free(zbx_vmware_service_t *service)
 	if (NULL != service->fullname)
 		vmware_shared_strfree(service->fullname);
 
+	/* the session owning the property filter is not logged out, it will expire on the server */
+	vmware_shared_strfree(service->update_session);
+	vmware_shared_strfree(service->update_filter);
+	vmware_shared_strfree(service->update_version);
+
 	vmware_data_shared_free(service->data);
 
 	zbx_hashset_iter_reset(&service->entities, &iter);
@@ -1548,43 +1575,24 @@ static void	vmware_counter_free(zbx_vmware_counter_t *counter)
 
 /******************************************************************************
  *                                                                            *
- * Function: vmware_service_authenticate                                      *
+ * Function: vmware_service_curl_init                                         *
  *                                                                            *
- * Purpose: authenticates vmware service                                      *
+ * Purpose: sets cURL options common for all vmware service requests          *
  *                                                                            *
  * Parameters: service    - [IN] the vmware service                           *
  *             easyhandle - [IN] the CURL handle                              *
  *             page       - [IN] the CURL output buffer                       *
  *             error      - [OUT] the error message in the case of failure    *
  *                                                                            *
- * Return value: SUCCEED - the authentication was completed successfully      *
- *               FAIL    - the authentication process has failed              *
- *                                                                            *
- * Comments: If service type is unknown this function will attempt to         *
- *           determine the right service type by trying to login with vCenter *
- *           and vSphere session managers.                                    *
+ * Return value: SUCCEED - the options were set successfully                  *
+ *               FAIL    - otherwise                                          *
  *                                                                            *
  ******************************************************************************/
-static int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
+static int	vmware_service_curl_init(const zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
 		char **error)
 {
-#	define ZBX_POST_VMWARE_AUTH						\
-		ZBX_POST_VSPHERE_HEADER						\
-		"<ns0:Login xsi:type=\"ns0:LoginRequestType\">"			\
-			"<ns0:_this type=\"SessionManager\">%s</ns0:_this>"	\
-			"<ns0:userName>%s</ns0:userName>"			\
-			"<ns0:password>%s</ns0:password>"			\
-		"</ns0:Login>"							\
-		ZBX_POST_VSPHERE_FOOTER
-
-	const char	*__function_name = "vmware_service_authenticate";
-	char		xml[MAX_STRING_LEN], *error_object = NULL, *username_esc = NULL, *password_esc = NULL;
 	CURLoption	opt;
 	CURLcode	err;
-	xmlDoc		*doc = NULL;
-	int		ret = FAIL;
-
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s'", __function_name, service->username, service->url);
 
 	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_COOKIEFILE, "")) ||
 			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_FOLLOWLOCATION, 1L)) ||
@@ -1600,7 +1608,7 @@ static int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easy
 			CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_SSL_VERIFYHOST, 0L)))
 	{
 		*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
-		goto out;
+		return FAIL;
 	}
 
 	if (NULL != CONFIG_SOURCE_IP)
@@ -1609,10 +1617,54 @@ static int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easy
 		{
 			*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)opt,
 					curl_easy_strerror(err));
-			goto out;
+			return FAIL;
 		}
 	}
 
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_authenticate                                      *
+ *                                                                            *
+ * Purpose: authenticates vmware service                                      *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             page       - [IN] the CURL output buffer                       *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                                                            *
+ * Return value: SUCCEED - the authentication was completed successfully      *
+ *               FAIL    - the authentication process has failed              *
+ *                                                                            *
+ * Comments: If service type is unknown this function will attempt to         *
+ *           determine the right service type by trying to login with vCenter *
+ *           and vSphere session managers.                                    *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_authenticate(zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
+		char **error)
+{
+#	define ZBX_POST_VMWARE_AUTH						\
+		ZBX_POST_VSPHERE_HEADER						\
+		"<ns0:Login xsi:type=\"ns0:LoginRequestType\">"			\
+			"<ns0:_this type=\"SessionManager\">%s</ns0:_this>"	\
+			"<ns0:userName>%s</ns0:userName>"			\
+			"<ns0:password>%s</ns0:password>"			\
+		"</ns0:Login>"							\
+		ZBX_POST_VSPHERE_FOOTER
+
+	const char	*__function_name = "vmware_service_authenticate";
+	char		xml[MAX_STRING_LEN], *error_object = NULL, *username_esc = NULL, *password_esc = NULL;
+	xmlDoc		*doc = NULL;
+	int		ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s'", __function_name, service->username, service->url);
+
+	if (SUCCEED != vmware_service_curl_init(service, easyhandle, page, error))
+		goto out;
+
 	username_esc = xml_escape_dyn(service->username);
 	password_esc = xml_escape_dyn(service->password);
 
@@ -2775,28 +2827,33 @@ out:
 
 /******************************************************************************
  *                                                                            *
- * Function: vmware_service_init_hv                                           *
+ * Function: vmware_service_get_hv                                            *
  *                                                                            *
- * Purpose: initialize vmware hypervisor object                               *
+ * Purpose: read vmware hypervisor properties and the identifiers of its      *
+ *          datastores and virtual machines                                   *
  *                                                                            *
  * Parameters: service      - [IN] the vmware service                         *
  *             easyhandle   - [IN] the CURL handle                            *
  *             id           - [IN] the vmware hypervisor id                   *
  *             hv           - [OUT] the hypervisor object (must be allocated) *
+ *             datastores   - [OUT] the hypervisor datastore ids              *
+ *             vms          - [OUT] the hypervisor virtual machine ids        *
  *             error        - [OUT] the error message in the case of failure  *
  *                                                                            *
  * Return value: SUCCEED - the hypervisor object was initialized successfully *
  *               FAIL    - otherwise                                          *
  *                                                                            *
+ * Comments: The datastore and virtual machine vectors of the returned        *
+ *           hypervisor object are empty.                                     *
+ *                                                                            *
  ******************************************************************************/
-static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, const char *id,
-		zbx_vmware_hv_t *hv, char **error)
+static int	vmware_service_get_hv(zbx_vmware_service_t *service, CURL *easyhandle, const char *id,
+		zbx_vmware_hv_t *hv, zbx_vector_str_t *datastores, zbx_vector_str_t *vms, char **error)
 {
-	const char		*__function_name = "vmware_service_init_hv";
+	const char		*__function_name = "vmware_service_get_hv";
 	char			*value;
 	xmlDoc			*details = NULL;
-	zbx_vector_str_t	datastores, vms;
-	int			i, ret = FAIL;
+	int			ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hvid:'%s'", __function_name, id);
 
@@ -2805,9 +2862,6 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 	zbx_vector_ptr_create(&hv->datastores);
 	zbx_vector_ptr_create(&hv->vms);
 
-	zbx_vector_str_create(&datastores);
-	zbx_vector_str_create(&vms);
-
 	if (SUCCEED != vmware_service_get_hv_data(service, easyhandle, id, hv_propmap,
 			ZBX_VMWARE_HVPROPS_NUM, &details, error))
 	{
@@ -2829,7 +2883,52 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 	if (SUCCEED != vmware_hv_get_parent_data(service, easyhandle, hv, error))
 		goto out;
 
-	zbx_xml_read_values(details, ZBX_XPATH_HV_DATASTORES(), &datastores);
+	zbx_xml_read_values(details, ZBX_XPATH_HV_DATASTORES(), datastores);
+	zbx_xml_read_values(details, ZBX_XPATH_HV_VMS(), vms);
+
+	ret = SUCCEED;
+out:
+	zbx_xml_free_doc(details);
+
+	if (SUCCEED != ret)
+		vmware_hv_clean(hv);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_init_hv                                           *
+ *                                                                            *
+ * Purpose: initialize vmware hypervisor object                               *
+ *                                                                            *
+ * Parameters: service      - [IN] the vmware service                         *
+ *             easyhandle   - [IN] the CURL handle                            *
+ *             id           - [IN] the vmware hypervisor id                   *
+ *             hv           - [OUT] the hypervisor object (must be allocated) *
+ *             error        - [OUT] the error message in the case of failure  *
+ *                                                                            *
+ * Return value: SUCCEED - the hypervisor object was initialized successfully *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandle, const char *id,
+		zbx_vmware_hv_t *hv, char **error)
+{
+	const char		*__function_name = "vmware_service_init_hv";
+	zbx_vector_str_t	datastores, vms;
+	int			i, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() hvid:'%s'", __function_name, id);
+
+	zbx_vector_str_create(&datastores);
+	zbx_vector_str_create(&vms);
+
+	if (SUCCEED != vmware_service_get_hv(service, easyhandle, id, hv, &datastores, &vms, error))
+		goto out;
+
 	zbx_vector_ptr_reserve(&hv->datastores, datastores.values_num + hv->datastores.values_alloc);
 
 	for (i = 0; i < datastores.values_num; i++)
@@ -2840,7 +2939,6 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 			zbx_vector_ptr_append(&hv->datastores, datastore);
 	}
 
-	zbx_xml_read_values(details, ZBX_XPATH_HV_VMS(), &vms);
 	zbx_vector_ptr_reserve(&hv->vms, vms.values_num + hv->vms.values_alloc);
 
 	for (i = 0; i < vms.values_num; i++)
@@ -2853,17 +2951,12 @@ static int	vmware_service_init_hv(zbx_vmware_service_t *service, CURL *easyhandl
 
 	ret = SUCCEED;
 out:
-	zbx_xml_free_doc(details);
-
 	zbx_vector_str_clear_ext(&vms, zbx_str_free);
 	zbx_vector_str_destroy(&vms);
 
 	zbx_vector_str_clear_ext(&datastores, zbx_str_free);
 	zbx_vector_str_destroy(&datastores);
 
-	if (SUCCEED != ret)
-		vmware_hv_clean(hv);
-
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s", __function_name, zbx_result_string(ret));
 
 	return ret;
@@ -4100,385 +4193,2612 @@ static void	vmware_service_update_perf_entities(zbx_vmware_service_t *service)
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() entities:%d", __function_name, service->entities.num_data);
 }
 
-/******************************************************************************
- *                                                                            *
- * Function: vmware_service_update                                            *
- *                                                                            *
- * Purpose: updates object with a new data from vmware service                *
- *                                                                            *
- * Parameters: service      - [IN] the vmware service                         *
- *                                                                            *
- ******************************************************************************/
-static void	vmware_service_update(zbx_vmware_service_t *service)
+/* the maximum number of object updates requested in one WaitForUpdatesEx call */
+#define ZBX_VMWARE_UPDATE_MAXOBJECTS	500
+
+/* the managed object types tracked by incremental update */
+#define ZBX_VMWARE_OBJECT_HV		0
+#define ZBX_VMWARE_OBJECT_VM		1
+#define ZBX_VMWARE_OBJECT_DS		2
+
+/* the accumulated changes of a managed object reported by property collector */
+typedef struct
 {
-	const char		*__function_name = "vmware_service_update";
+	char			*id;
 
-	CURL			*easyhandle = NULL;
-	CURLoption		opt;
-	CURLcode		err;
-	struct curl_slist	*headers = NULL;
-	zbx_vmware_data_t	*data;
-	zbx_vector_str_t	hvs;
-	int			i, ret = FAIL;
-	ZBX_HTTPPAGE		page;	/* 347K/87K */
-	unsigned char		skip_old = service->eventlog.skip_old;
+	/* the object type, see ZBX_VMWARE_OBJECT_* defines */
+	int			type;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s'", __function_name, service->username, service->url);
+	/* the object was removed from the inventory */
+	unsigned char		leave;
 
-	data = (zbx_vmware_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_data_t));
-	memset(data, 0, sizeof(zbx_vmware_data_t));
-	page.alloc = 0;
+	/* the object must be read again - it is new or its structure has changed */
+	unsigned char		refresh;
 
-	zbx_hashset_create(&data->hvs, 1, vmware_hv_hash, vmware_hv_compare);
-	zbx_vector_ptr_create(&data->clusters);
-	zbx_vector_ptr_create(&data->events);
+	/* the changed simple properties, props_mask has bits set for the changed property indexes */
+	char			**props;
+	zbx_uint64_t		props_mask;
 
-	zbx_vector_str_create(&hvs);
+	/* the object read by refresh - zbx_vmware_hv_t, zbx_vmware_vm_t or zbx_vmware_datastore_t */
+	void			*object;
 
-	if (NULL == (easyhandle = curl_easy_init()))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "Cannot initialize cURL library");
-		goto out;
-	}
+	/* the identifiers of the refreshed hypervisor virtual machines and datastores */
+	zbx_vector_str_t	vms;
+	zbx_vector_str_t	datastores;
+}
+zbx_vmware_update_t;
 
-	page.alloc = ZBX_INIT_UPD_XML_SIZE;
-	page.data = (char *)zbx_malloc(NULL, page.alloc);
-	headers = curl_slist_append(headers, ZBX_XML_HEADER1);
-	headers = curl_slist_append(headers, ZBX_XML_HEADER2);
+/* a reference to a shared inventory object, used to locate objects by their identifiers */
+typedef struct
+{
+	const char	*id;
+	void		*object;
+	zbx_vmware_hv_t	*hv;
+}
+zbx_vmware_ref_t;
 
-	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HTTPHEADER, headers)))
-	{
-		zabbix_log(LOG_LEVEL_WARNING, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
-		goto clean;
-	}
+static zbx_hash_t	vmware_update_hash(const void *data)
+{
+	const zbx_vmware_update_t	*update = (const zbx_vmware_update_t *)data;
+	zbx_hash_t			hash;
 
-	if (SUCCEED != vmware_service_authenticate(service, easyhandle, &page, &data->error))
-		goto clean;
+	hash = ZBX_DEFAULT_STRING_HASH_ALGO(update->id, strlen(update->id), ZBX_DEFAULT_HASH_SEED);
 
-	if (0 != (service->state & ZBX_VMWARE_STATE_NEW) &&
-			SUCCEED != vmware_service_initialize(service, easyhandle, &data->error))
-	{
-		goto clean;
-	}
+	return ZBX_DEFAULT_HASH_ALGO(&update->type, sizeof(update->type), hash);
+}
 
-	if (SUCCEED != vmware_service_get_hv_list(service, easyhandle, &hvs, &data->error))
-		goto clean;
+static int	vmware_update_compare(const void *d1, const void *d2)
+{
+	const zbx_vmware_update_t	*update1 = (const zbx_vmware_update_t *)d1;
+	const zbx_vmware_update_t	*update2 = (const zbx_vmware_update_t *)d2;
 
-	if (SUCCEED != zbx_hashset_reserve(&data->hvs, hvs.values_num))
-	{
-		THIS_SHOULD_NEVER_HAPPEN;
-		exit(EXIT_FAILURE);
-	}
+	ZBX_RETURN_IF_NOT_EQUAL(update1->type, update2->type);
 
-	for (i = 0; i < hvs.values_num; i++)
-	{
-		zbx_vmware_hv_t	hv_local;
+	return strcmp(update1->id, update2->id);
+}
 
-		if (SUCCEED == vmware_service_init_hv(service, easyhandle, hvs.values[i], &hv_local, &data->error))
-			zbx_hashset_insert(&data->hvs, &hv_local, sizeof(hv_local));
-	}
+static zbx_hash_t	vmware_ref_hash(const void *data)
+{
+	const zbx_vmware_ref_t	*ref = (const zbx_vmware_ref_t *)data;
 
-	/* skip collection of event data if we don't know where we stopped last time or item can't accept values */
-	if (ZBX_VMWARE_EVENT_KEY_UNINITIALIZED != service->eventlog.last_key && 0 == service->eventlog.skip_old &&
-			SUCCEED != vmware_service_get_event_data(service, easyhandle, &data->events, &data->error))
+	return ZBX_DEFAULT_STRING_HASH_ALGO(ref->id, strlen(ref->id), ZBX_DEFAULT_HASH_SEED);
+}
+
+static int	vmware_ref_compare(const void *d1, const void *d2)
+{
+	const zbx_vmware_ref_t	*ref1 = (const zbx_vmware_ref_t *)d1;
+	const zbx_vmware_ref_t	*ref2 = (const zbx_vmware_ref_t *)d2;
+
+	return strcmp(ref1->id, ref2->id);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_update_props_num                                          *
+ *                                                                            *
+ * Purpose: gets the number of simple properties tracked for object type      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_update_props_num(int type)
+{
+	switch (type)
 	{
-		goto clean;
+		case ZBX_VMWARE_OBJECT_HV:
+			return ZBX_VMWARE_HVPROPS_NUM;
+		case ZBX_VMWARE_OBJECT_VM:
+			return ZBX_VMWARE_VMPROPS_NUM;
+		default:
+			return 0;
 	}
+}
 
-	if (0 != service->eventlog.skip_old)
-	{
-		char	*error = NULL;
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_update_clean                                              *
+ *                                                                            *
+ * Purpose: frees resources allocated to store object changes                 *
+ *                                                                            *
+ * Parameters: update - [IN] the object changes                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_update_clean(zbx_vmware_update_t *update)
+{
+	vmware_props_free(update->props, vmware_update_props_num(update->type));
 
-		/* May not be present */
-		if (SUCCEED != vmware_service_get_last_event_data(service, easyhandle, &data->events, &error))
+	if (NULL != update->object)
+	{
+		switch (update->type)
 		{
-			zabbix_log(LOG_LEVEL_DEBUG, "Unable retrieve lastevent value: %s.", error);
-			zbx_free(error);
+			case ZBX_VMWARE_OBJECT_HV:
+				vmware_hv_clean((zbx_vmware_hv_t *)update->object);
+				zbx_free(update->object);
+				break;
+			case ZBX_VMWARE_OBJECT_VM:
+				vmware_vm_free((zbx_vmware_vm_t *)update->object);
+				break;
+			case ZBX_VMWARE_OBJECT_DS:
+				vmware_datastore_free((zbx_vmware_datastore_t *)update->object);
+				break;
 		}
-		else
-			skip_old = 0;
 	}
 
-	if (ZBX_VMWARE_TYPE_VCENTER == service->type &&
-			SUCCEED != vmware_service_get_cluster_list(easyhandle, &data->clusters, &data->error))
-	{
-		goto clean;
-	}
+	zbx_vector_str_clear_ext(&update->vms, zbx_str_free);
+	zbx_vector_str_destroy(&update->vms);
 
-	if (ZBX_VMWARE_TYPE_VCENTER != service->type)
-		data->max_query_metrics = ZBX_VPXD_STATS_MAXQUERYMETRICS;
-	else if (SUCCEED != vmware_service_get_maxquerymetrics(easyhandle, &data->max_query_metrics, &data->error))
-		goto clean;
+	zbx_vector_str_clear_ext(&update->datastores, zbx_str_free);
+	zbx_vector_str_destroy(&update->datastores);
+
+	zbx_free(update->id);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_updates_clear                                             *
+ *                                                                            *
+ * Purpose: removes all object changes from the update set                    *
+ *                                                                            *
+ * Parameters: updates - [IN/OUT] the update set                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_updates_clear(zbx_hashset_t *updates)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_update_t	*update;
+
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+		vmware_update_clean(update);
+
+	zbx_hashset_clear(updates);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_update_get                                                *
+ *                                                                            *
+ * Purpose: gets changes of the specified object from the update set,         *
+ *          creating a new entry if necessary                                 *
+ *                                                                            *
+ * Parameters: updates - [IN/OUT] the update set                              *
+ *             type    - [IN] the object type (ZBX_VMWARE_OBJECT_*)           *
+ *             id      - [IN] the object identifier                           *
+ *                                                                            *
+ * Return value: the object changes                                           *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_vmware_update_t	*vmware_update_get(zbx_hashset_t *updates, int type, const char *id)
+{
+	zbx_vmware_update_t	update_local, *update;
+
+	update_local.type = type;
+	update_local.id = (char *)id;
+
+	if (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_search(updates, &update_local)))
+		return update;
+
+	memset(&update_local, 0, sizeof(update_local));
+	update_local.type = type;
+	update_local.id = zbx_strdup(NULL, id);
+	zbx_vector_str_create(&update_local.vms);
+	zbx_vector_str_create(&update_local.datastores);
+
+	return (zbx_vmware_update_t *)zbx_hashset_insert(updates, &update_local, sizeof(update_local));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_update_read_change                                        *
+ *                                                                            *
+ * Purpose: merges a property change into object changes                      *
+ *                                                                            *
+ * Parameters: update - [IN/OUT] the object changes                           *
+ *             doc    - [IN] the WaitForUpdatesEx response                    *
+ *             change - [IN] the changeSet node                               *
+ *                                                                            *
+ * Comments: Only the values of simple properties (hypervisor and virtual     *
+ *           machine properties without nested elements) are taken from the   *
+ *           change set, any other change marks the object for refresh.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_update_read_change(zbx_vmware_update_t *update, xmlDoc *doc, xmlNode *change)
+{
+	const zbx_vmware_propmap_t	*propmap;
+	xmlNode				*node, *val = NULL;
+	xmlChar				*name = NULL, *op = NULL;
+	int				i, props_num;
 
-	if (SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
+	for (node = change->children; NULL != node; node = node->next)
 	{
-		zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", data->error);
-		zbx_free(data->error);
+		if (XML_ELEMENT_NODE != node->type)
+			continue;
+
+		if (0 == xmlStrcmp(node->name, (const xmlChar *)"name") && NULL == name)
+			name = xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
+		else if (0 == xmlStrcmp(node->name, (const xmlChar *)"op") && NULL == op)
+			op = xmlNodeListGetString(doc, node->xmlChildrenNode, 1);
+		else if (0 == xmlStrcmp(node->name, (const xmlChar *)"val"))
+			val = node;
 	}
 
-	ret = SUCCEED;
-clean:
-	curl_slist_free_all(headers);
-	curl_easy_cleanup(easyhandle);
-	zbx_free(page.data);
+	if (NULL == name)
+		goto out;
 
-	zbx_vector_str_clear_ext(&hvs, zbx_str_free);
-	zbx_vector_str_destroy(&hvs);
-out:
-	zbx_vmware_lock();
+	propmap = (ZBX_VMWARE_OBJECT_HV == update->type ? hv_propmap : vm_propmap);
+	props_num = vmware_update_props_num(update->type);
 
-	/* remove UPDATING flag and set READY or FAILED flag */
-	service->state &= ~(ZBX_VMWARE_STATE_MASK | ZBX_VMWARE_STATE_UPDATING);
-	service->state |= (SUCCEED == ret) ? ZBX_VMWARE_STATE_READY : ZBX_VMWARE_STATE_FAILED;
+	for (i = 0; i < props_num; i++)
+	{
+		if (0 == strcmp(propmap[i].name, (const char *)name))
+			break;
+	}
 
-	vmware_data_shared_free(service->data);
-	service->data = vmware_data_shared_dup(data);
-	service->eventlog.skip_old = skip_old;
+	/* hypervisor uuid is the hypervisor hashset key and cannot be changed in place */
+	if (i == props_num || (ZBX_VMWARE_OBJECT_HV == update->type && ZBX_VMWARE_HVPROP_HW_UUID == i) ||
+			(NULL != op && 0 != xmlStrcmp(op, (const xmlChar *)"assign")))
+	{
+		update->refresh = 1;
+		goto out;
+	}
 
-	service->lastcheck = time(NULL);
+	if (NULL != val)
+	{
+		for (node = val->children; NULL != node; node = node->next)
+		{
+			if (XML_ELEMENT_NODE == node->type)
+			{
+				update->refresh = 1;
+				goto out;
+			}
+		}
+	}
 
-	vmware_service_update_perf_entities(service);
+	if (NULL == update->props)
+	{
+		update->props = (char **)zbx_malloc(NULL, sizeof(char *) * props_num);
+		memset(update->props, 0, sizeof(char *) * props_num);
+	}
 
-	zbx_vmware_unlock();
+	zbx_free(update->props[i]);
 
-	vmware_data_free(data);
+	if (NULL != val)
+	{
+		xmlChar	*value;
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s \tprocessed:" ZBX_FS_SIZE_T " bytes of data", __function_name,
-			zbx_result_string(ret), (zbx_fs_size_t)page.alloc);
+		if (NULL != (value = xmlNodeListGetString(doc, val->xmlChildrenNode, 1)))
+		{
+			update->props[i] = zbx_strdup(NULL, (const char *)value);
+			xmlFree(value);
+		}
+	}
+
+	update->props_mask |= __UINT64_C(1) << i;
+out:
+	if (NULL != op)
+		xmlFree(op);
+
+	if (NULL != name)
+		xmlFree(name);
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vmware_service_process_perf_entity_data                          *
- *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
+ * Function: vmware_service_read_updates                                      *
  *                                                                            *
- * Parameters: pervalues - [OUT] the performance counter values               *
- *             xdoc      - [IN] the XML document containing performance       *
- *                              counter values for all entities               *
- *             node      - [IN] the XML node containing performance counter   *
- *                              values for the specified entity               *
+ * Purpose: merges object changes from WaitForUpdatesEx response into update  *
+ *          set                                                               *
  *                                                                            *
- * Return value: SUCCEED - the performance entity data was parsed             *
- *               FAIL    - the perofmance entity data did not contain valid   *
- *                         values                                             *
+ * Parameters: doc     - [IN] the WaitForUpdatesEx response                   *
+ *             updates - [IN/OUT] the update set                              *
  *                                                                            *
  ******************************************************************************/
-static int	vmware_service_process_perf_entity_data(zbx_vector_ptr_t *pervalues, xmlDoc *xdoc, xmlNode *node)
+static void	vmware_service_read_updates(xmlDoc *doc, zbx_hashset_t *updates)
 {
-	const char			*__function_name = "vmware_service_process_perf_entity_data";
+	const char		*__function_name = "vmware_service_read_updates";
 
-	xmlXPathContext			*xpathCtx;
-	xmlXPathObject			*xpathObj;
-	xmlNodeSetPtr			nodeset;
-	char				*instance, *counter, *value;
-	int				i, values = 0, ret = FAIL;
-	zbx_vmware_perf_value_t		*perfvalue;
+	xmlXPathContext		*xpathCtx;
+	xmlXPathObject		*xpathObj;
+	xmlNodeSetPtr		nodeset;
+	xmlNode			*node;
+	zbx_vmware_update_t	*update;
+	char			*id, *type, *kind;
+	int			i, object_type;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
-	xpathCtx = xmlXPathNewContext(xdoc);
-	xpathCtx->node = node;
+	xpathCtx = xmlXPathNewContext(doc);
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)"*[local-name()='value']", xpathCtx)))
-		goto out;
+	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)ZBX_XPATH_LN2("WaitForUpdatesExResponse",
+			"returnval") ZBX_XPATH_LN("filterSet") ZBX_XPATH_LN("objectSet"), xpathCtx)))
+	{
+		goto clean;
+	}
 
 	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto out;
+		goto clean;
 
 	nodeset = xpathObj->nodesetval;
-	zbx_vector_ptr_reserve(pervalues, nodeset->nodeNr + pervalues->values_alloc);
 
 	for (i = 0; i < nodeset->nodeNr; i++)
 	{
-		value = zbx_xml_read_node_value(xdoc, nodeset->nodeTab[i], "*[local-name()='value'][last()]");
-		instance = zbx_xml_read_node_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='instance']");
-		counter = zbx_xml_read_node_value(xdoc, nodeset->nodeTab[i], "*[local-name()='id']"
-				"/*[local-name()='counterId']");
+		id = zbx_xml_read_node_value(doc, nodeset->nodeTab[i], "*[local-name()='obj']");
+		type = zbx_xml_read_node_value(doc, nodeset->nodeTab[i], "*[local-name()='obj']/@type");
+		kind = zbx_xml_read_node_value(doc, nodeset->nodeTab[i], "*[local-name()='kind']");
+
+		if (NULL == id || NULL == type || NULL == kind)
+			goto next;
+
+		if (0 == strcmp(type, "HostSystem"))
+			object_type = ZBX_VMWARE_OBJECT_HV;
+		else if (0 == strcmp(type, "VirtualMachine"))
+			object_type = ZBX_VMWARE_OBJECT_VM;
+		else if (0 == strcmp(type, "Datastore"))
+			object_type = ZBX_VMWARE_OBJECT_DS;
+		else
+			goto next;
+
+		update = vmware_update_get(updates, object_type, id);
+
+		if (0 == strcmp(kind, "leave"))
+		{
+			update->leave = 1;
+			update->refresh = 0;
+			goto next;
+		}
+
+		if (0 == strcmp(kind, "enter") || ZBX_VMWARE_OBJECT_DS == object_type)
+		{
+			update->leave = 0;
+			update->refresh = 1;
+			goto next;
+		}
 
-		if (NULL != value && NULL != counter)
+		for (node = nodeset->nodeTab[i]->children; NULL != node; node = node->next)
 		{
-			perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
+			if (XML_ELEMENT_NODE == node->type && 0 == xmlStrcmp(node->name, (const xmlChar *)"changeSet"))
+				vmware_update_read_change(update, doc, node);
+		}
+next:
+		zbx_free(kind);
+		zbx_free(type);
+		zbx_free(id);
+	}
+clean:
+	if (NULL != xpathObj)
+		xmlXPathFreeObject(xpathObj);
+
+	xmlXPathFreeContext(xpathCtx);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() objects:%d", __function_name, updates->num_data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_wait_for_updates                                  *
+ *                                                                            *
+ * Purpose: reads the inventory changes reported by the property filter       *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             version    - [IN/OUT] the version of the last change set       *
+ *             updates    - [OUT] the update set, NULL to discard changes     *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                                                            *
+ * Return value: SUCCEED - the changes were read successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The changes are requested without waiting, in portions of        *
+ *           ZBX_VMWARE_UPDATE_MAXOBJECTS objects until the returned change   *
+ *           set is not truncated.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_wait_for_updates(const zbx_vmware_service_t *service, CURL *easyhandle,
+		char **version, zbx_hashset_t *updates, char **error)
+{
+#	define ZBX_POST_VMWARE_WAIT_FOR_UPDATES						\
+		ZBX_POST_VSPHERE_HEADER							\
+		"<ns0:WaitForUpdatesEx>"						\
+			"<ns0:_this type=\"PropertyCollector\">%s</ns0:_this>"		\
+			"<ns0:version>%s</ns0:version>"					\
+			"<ns0:options>"							\
+				"<ns0:maxWaitSeconds>0</ns0:maxWaitSeconds>"		\
+				"<ns0:maxObjectUpdates>%d</ns0:maxObjectUpdates>"	\
+			"</ns0:options>"						\
+		"</ns0:WaitForUpdatesEx>"						\
+		ZBX_POST_VSPHERE_FOOTER
+
+	const char	*__function_name = "vmware_service_wait_for_updates";
+	char		tmp[MAX_STRING_LEN], *version_esc, *value;
+	xmlDoc		*doc = NULL;
+	int		truncated = 0, ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() version:'%s'", __function_name, *version);
 
-			ZBX_STR2UINT64(perfvalue->counterid, counter);
-			perfvalue->instance = (NULL != instance ? instance : zbx_strdup(NULL, ""));
+	do
+	{
+		version_esc = xml_escape_dyn(*version);
+		zbx_snprintf(tmp, sizeof(tmp), ZBX_POST_VMWARE_WAIT_FOR_UPDATES,
+				vmware_service_objects[service->type].property_collector, version_esc,
+				ZBX_VMWARE_UPDATE_MAXOBJECTS);
+		zbx_free(version_esc);
 
-			if (0 == strcmp(value, "-1") || SUCCEED != is_uint64(value, &perfvalue->value))
-				perfvalue->value = UINT64_MAX;
-			else if (FAIL == ret)
-				ret = SUCCEED;
+		zbx_xml_free_doc(doc);
+		doc = NULL;
 
-			zbx_vector_ptr_append(pervalues, perfvalue);
+		if (SUCCEED != zbx_soap_post(__function_name, easyhandle, tmp, &doc, error))
+			goto out;
 
-			instance = NULL;
-			values++;
+		/* the empty response is returned when there are no changes */
+		if (NULL == (value = zbx_xml_read_doc_value(doc, ZBX_XPATH_LN3("WaitForUpdatesExResponse",
+				"returnval", "version"))))
+		{
+			break;
 		}
 
-		zbx_free(counter);
-		zbx_free(instance);
-		zbx_free(value);
+		zbx_free(*version);
+		*version = value;
+
+		if (NULL != updates)
+			vmware_service_read_updates(doc, updates);
+
+		truncated = 0;
+
+		if (NULL != (value = zbx_xml_read_doc_value(doc, ZBX_XPATH_LN3("WaitForUpdatesExResponse",
+				"returnval", "truncated"))))
+		{
+			truncated = (0 == strcmp(value, "true"));
+			zbx_free(value);
+		}
 	}
+	while (0 != truncated);
 
+	ret = SUCCEED;
 out:
-	if (NULL != xpathObj)
-		xmlXPathFreeObject(xpathObj);
-
-	xmlXPathFreeContext(xpathCtx);
+	zbx_xml_free_doc(doc);
 
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() values:%d", __function_name, values);
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s version:'%s'", __function_name, zbx_result_string(ret),
+			ZBX_NULL2EMPTY_STR(*version));
 
 	return ret;
 }
 
 /******************************************************************************
  *                                                                            *
- * Function: vmware_service_parse_perf_data                                   *
+ * Function: vmware_service_create_filter                                     *
  *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
+ * Purpose: creates property filter reporting hypervisor, virtual machine and *
+ *          datastore changes                                                 *
  *                                                                            *
- * Parameters: perfdata - [OUT] performance entity data                       *
- *             xdoc     - [IN] the performance data xml document              *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             filter     - [OUT] the property filter id                      *
+ *             version    - [OUT] the version of the initial change set       *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                                                            *
+ * Return value: SUCCEED - the filter was created successfully                *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ * Comments: The filter is created before reading the inventory, so any       *
+ *           change made during the full update is reported again by the      *
+ *           next incremental update. The initial change set containing the   *
+ *           whole inventory is skipped.                                      *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_service_parse_perf_data(zbx_vector_ptr_t *perfdata, xmlDoc *xdoc)
+static int	vmware_service_create_filter(const zbx_vmware_service_t *service, CURL *easyhandle, char **filter,
+		char **version, char **error)
 {
-	const char		*__function_name = "vmware_service_parse_perf_data";
+#	define ZBX_POST_VMWARE_CREATE_FILTER							\
+		ZBX_POST_VSPHERE_HEADER								\
+		"<ns0:CreateFilter>"								\
+			"<ns0:_this type=\"PropertyCollector\">%s</ns0:_this>"			\
+			"<ns0:spec>"								\
+				"<ns0:propSet>"							\
+					"<ns0:type>HostSystem</ns0:type>"			\
+					"<ns0:pathSet>vm</ns0:pathSet>"				\
+					"<ns0:pathSet>datastore</ns0:pathSet>"			\
+					"<ns0:pathSet>parent</ns0:pathSet>"			\
+					"%s"							\
+				"</ns0:propSet>"						\
+				"<ns0:propSet>"							\
+					"<ns0:type>VirtualMachine</ns0:type>"			\
+					"<ns0:pathSet>config.hardware</ns0:pathSet>"		\
+					"<ns0:pathSet>config.uuid</ns0:pathSet>"		\
+					"<ns0:pathSet>config.instanceUuid</ns0:pathSet>"	\
+					"<ns0:pathSet>guest.disk</ns0:pathSet>"			\
+					"%s"							\
+				"</ns0:propSet>"						\
+				"<ns0:propSet>"							\
+					"<ns0:type>Datastore</ns0:type>"			\
+					"<ns0:pathSet>summary</ns0:pathSet>"			\
+					"<ns0:pathSet>host</ns0:pathSet>"			\
+				"</ns0:propSet>"						\
+				"<ns0:objectSet>"						\
+					"<ns0:obj type=\"Folder\">%s</ns0:obj>"			\
+					"<ns0:skip>false</ns0:skip>"				\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>visitFolders</ns0:name>"		\
+						"<ns0:type>Folder</ns0:type>"			\
+						"<ns0:path>childEntity</ns0:path>"		\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>visitFolders</ns0:name>"	\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>dcToHf</ns0:name>"		\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>crToH</ns0:name>"		\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>dcToHf</ns0:name>"			\
+						"<ns0:type>Datacenter</ns0:type>"		\
+						"<ns0:path>hostFolder</ns0:path>"		\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>visitFolders</ns0:name>"	\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>crToH</ns0:name>"			\
+						"<ns0:type>ComputeResource</ns0:type>"		\
+						"<ns0:path>host</ns0:path>"			\
+						"<ns0:skip>false</ns0:skip>"			\
+						"<ns0:selectSet>"				\
+							"<ns0:name>hToVm</ns0:name>"		\
+						"</ns0:selectSet>"				\
+						"<ns0:selectSet>"				\
+							"<ns0:name>hToDs</ns0:name>"		\
+						"</ns0:selectSet>"				\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>hToVm</ns0:name>"			\
+						"<ns0:type>HostSystem</ns0:type>"		\
+						"<ns0:path>vm</ns0:path>"			\
+						"<ns0:skip>false</ns0:skip>"			\
+					"</ns0:selectSet>"					\
+					"<ns0:selectSet xsi:type=\"ns0:TraversalSpec\">"	\
+						"<ns0:name>hToDs</ns0:name>"			\
+						"<ns0:type>HostSystem</ns0:type>"		\
+						"<ns0:path>datastore</ns0:path>"		\
+						"<ns0:skip>false</ns0:skip>"			\
+					"</ns0:selectSet>"					\
+				"</ns0:objectSet>"						\
+			"</ns0:spec>"								\
+			"<ns0:partialUpdates>false</ns0:partialUpdates>"			\
+		"</ns0:CreateFilter>"								\
+		ZBX_POST_VSPHERE_FOOTER
 
-	xmlXPathContext		*xpathCtx;
-	xmlXPathObject		*xpathObj;
-	xmlNodeSetPtr		nodeset;
-	int			i;
+	const char	*__function_name = "vmware_service_create_filter";
+	char		*request, *hv_props = NULL, *vm_props = NULL;
+	size_t		hv_props_alloc = 0, hv_props_offset = 0, vm_props_alloc = 0, vm_props_offset = 0;
+	xmlDoc		*doc = NULL;
+	int		i, ret = FAIL;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
 
-	xpathCtx = xmlXPathNewContext(xdoc);
+	for (i = 0; i < ZBX_VMWARE_HVPROPS_NUM; i++)
+	{
+		zbx_snprintf_alloc(&hv_props, &hv_props_alloc, &hv_props_offset, "<ns0:pathSet>%s</ns0:pathSet>",
+				hv_propmap[i].name);
+	}
+
+	for (i = 0; i < ZBX_VMWARE_VMPROPS_NUM; i++)
+	{
+		zbx_snprintf_alloc(&vm_props, &vm_props_alloc, &vm_props_offset, "<ns0:pathSet>%s</ns0:pathSet>",
+				vm_propmap[i].name);
+	}
+
+	/* the request does not fit into MAX_STRING_LEN buffer */
+	request = zbx_dsprintf(NULL, ZBX_POST_VMWARE_CREATE_FILTER,
+			vmware_service_objects[service->type].property_collector, hv_props, vm_props,
+			vmware_service_objects[service->type].root_folder);
+
+	zbx_free(vm_props);
+	zbx_free(hv_props);
+
+	if (SUCCEED != zbx_soap_post(__function_name, easyhandle, request, &doc, error))
+		goto out;
+
+	if (NULL == (*filter = zbx_xml_read_doc_value(doc, ZBX_XPATH_LN2("CreateFilterResponse", "returnval"))))
+	{
+		*error = zbx_strdup(*error, "Cannot read property filter identifier.");
+		goto out;
+	}
+
+	*version = zbx_strdup(*version, "");
+
+	if (SUCCEED != vmware_service_wait_for_updates(service, easyhandle, version, NULL, error))
+	{
+		zbx_free(*version);
+		zbx_free(*filter);
+		goto out;
+	}
+
+	ret = SUCCEED;
+out:
+	zbx_xml_free_doc(doc);
+	zbx_free(request);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s filter:'%s'", __function_name, zbx_result_string(ret),
+			ZBX_NULL2EMPTY_STR(*filter));
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_get_cookies                                       *
+ *                                                                            *
+ * Purpose: gets the session cookies of CURL handle                           *
+ *                                                                            *
+ * Parameters: easyhandle - [IN] the CURL handle                              *
+ *                                                                            *
+ * Return value: the cookies in Netscape format separated by newlines or NULL *
+ *               if there are no cookies                                      *
+ *                                                                            *
+ ******************************************************************************/
+static char	*vmware_service_get_cookies(CURL *easyhandle)
+{
+	struct curl_slist	*cookies = NULL, *cookie;
+	char			*value = NULL;
+	size_t			value_alloc = 0, value_offset = 0;
+
+	if (CURLE_OK != curl_easy_getinfo(easyhandle, CURLINFO_COOKIELIST, &cookies))
+		return NULL;
+
+	for (cookie = cookies; NULL != cookie; cookie = cookie->next)
+	{
+		if (0 != value_offset)
+			zbx_chrcpy_alloc(&value, &value_alloc, &value_offset, '\n');
+
+		zbx_strcpy_alloc(&value, &value_alloc, &value_offset, cookie->data);
+	}
+
+	curl_slist_free_all(cookies);
+
+	return value;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_set_cookies                                       *
+ *                                                                            *
+ * Purpose: restores the session cookies of CURL handle                       *
+ *                                                                            *
+ * Parameters: easyhandle - [IN] the CURL handle                              *
+ *             cookies    - [IN] the cookies returned by                      *
+ *                               vmware_service_get_cookies()                 *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                                                            *
+ * Return value: SUCCEED - the cookies were set successfully                  *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_set_cookies(CURL *easyhandle, const char *cookies, char **error)
+{
+	char		*buffer, *cookie, *saveptr = NULL;
+	CURLcode	err;
+	int		ret = SUCCEED;
+
+	buffer = zbx_strdup(NULL, cookies);
+
+	for (cookie = strtok_r(buffer, "\n", &saveptr); NULL != cookie; cookie = strtok_r(NULL, "\n", &saveptr))
+	{
+		if (CURLE_OK != (err = curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, cookie)))
+		{
+			*error = zbx_dsprintf(*error, "Cannot set cURL option %d: %s.", (int)CURLOPT_COOKIELIST,
+					curl_easy_strerror(err));
+			ret = FAIL;
+			break;
+		}
+	}
+
+	zbx_free(buffer);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_incremental_enabled                               *
+ *                                                                            *
+ * Purpose: checks if the service inventory can be updated incrementally      *
+ *                                                                            *
+ * Parameters: service - [IN] the vmware service                              *
+ *                                                                            *
+ * Return value: SUCCEED - incremental update is enabled for the service      *
+ *               FAIL    - the inventory must be read fully on every update   *
+ *                                                                            *
+ * Comments: The datastore free space of ESX/ESXi hosts older than 6.0 is     *
+ *           refreshed only on explicit request, so such hosts are always     *
+ *           updated fully.                                                   *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_incremental_enabled(const zbx_vmware_service_t *service)
+{
+	if (0 == CONFIG_VMWARE_INCREMENTAL_UPDATE)
+		return FAIL;
+
+	if (ZBX_VMWARE_TYPE_VSPHERE == service->type && NULL != service->version &&
+			ZBX_VMWARE_DS_REFRESH_VERSION > atoi(service->version))
+	{
+		return FAIL;
+	}
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_data_refs_create                                          *
+ *                                                                            *
+ * Purpose: indexes shared hypervisors, virtual machines and datastores by    *
+ *          their identifiers                                                 *
+ *                                                                            *
+ * Parameters: data       - [IN] the vmware service data                      *
+ *             hvs        - [OUT] the hypervisor references                   *
+ *             vms        - [OUT] the virtual machine references              *
+ *             datastores - [OUT] the datastore references                    *
+ *                                                                            *
+ * Comments: The references point to the shared data and must be used only    *
+ *           while vmware lock is held.                                       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_data_refs_create(zbx_vmware_data_t *data, zbx_hashset_t *hvs, zbx_hashset_t *vms,
+		zbx_hashset_t *datastores)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_hv_t		*hv;
+	zbx_vmware_ref_t	ref_local;
+	int			i;
+
+	zbx_hashset_create(hvs, data->hvs.num_data, vmware_ref_hash, vmware_ref_compare);
+	zbx_hashset_create(vms, data->vms_index.num_data, vmware_ref_hash, vmware_ref_compare);
+	zbx_hashset_create(datastores, 100, vmware_ref_hash, vmware_ref_compare);
+
+	zbx_hashset_iter_reset(&data->hvs, &iter);
+	while (NULL != (hv = (zbx_vmware_hv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		ref_local.id = hv->id;
+		ref_local.object = hv;
+		ref_local.hv = NULL;
+		zbx_hashset_insert(hvs, &ref_local, sizeof(ref_local));
+
+		for (i = 0; i < hv->vms.values_num; i++)
+		{
+			zbx_vmware_vm_t	*vm = (zbx_vmware_vm_t *)hv->vms.values[i];
+
+			ref_local.id = vm->id;
+			ref_local.object = vm;
+			ref_local.hv = hv;
+			zbx_hashset_insert(vms, &ref_local, sizeof(ref_local));
+		}
+
+		for (i = 0; i < hv->datastores.values_num; i++)
+		{
+			zbx_vmware_datastore_t	*datastore = (zbx_vmware_datastore_t *)hv->datastores.values[i];
+
+			ref_local.id = datastore->id;
+			ref_local.object = datastore;
+			ref_local.hv = hv;
+			zbx_hashset_insert(datastores, &ref_local, sizeof(ref_local));
+		}
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_fetch_updates                                     *
+ *                                                                            *
+ * Purpose: reads the objects marked for refresh in the update set            *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             updates    - [IN/OUT] the update set                           *
+ *                                                                            *
+ * Comments: The virtual machines and datastores of refreshed hypervisors     *
+ *           that are not present in the service data are read as well.       *
+ *           Objects that cannot be read are left without data and are        *
+ *           handled when the update set is applied.                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_fetch_updates(zbx_vmware_service_t *service, CURL *easyhandle, zbx_hashset_t *updates)
+{
+	const char		*__function_name = "vmware_service_fetch_updates";
+
+	zbx_hashset_iter_t	iter;
+	zbx_hashset_t		hv_refs, vm_refs, ds_refs;
+	zbx_vmware_update_t	*update;
+	zbx_vmware_ref_t	ref_local;
+	zbx_vector_str_t	vms, datastores;
+	char			*error = NULL;
+	int			i, fetched = 0;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() objects:%d", __function_name, updates->num_data);
+
+	zbx_vector_str_create(&vms);
+	zbx_vector_str_create(&datastores);
+
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vmware_hv_t	*hv;
+
+		if (ZBX_VMWARE_OBJECT_HV != update->type || 0 == update->refresh)
+			continue;
+
+		hv = (zbx_vmware_hv_t *)zbx_malloc(NULL, sizeof(zbx_vmware_hv_t));
+
+		if (SUCCEED != vmware_service_get_hv(service, easyhandle, update->id, hv, &update->datastores,
+				&update->vms, &error))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "cannot read hypervisor \"%s\": %s", update->id,
+					ZBX_NULL2EMPTY_STR(error));
+			zbx_free(error);
+			zbx_free(hv);
+			continue;
+		}
+
+		update->object = hv;
+		fetched++;
+	}
+
+	/* find the virtual machines and datastores that were not reported as new but are missing */
+	zbx_vmware_lock();
+
+	vmware_data_refs_create(service->data, &hv_refs, &vm_refs, &ds_refs);
+
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_VMWARE_OBJECT_HV != update->type || NULL == update->object)
+			continue;
+
+		for (i = 0; i < update->vms.values_num; i++)
+		{
+			ref_local.id = update->vms.values[i];
+
+			if (NULL == zbx_hashset_search(&vm_refs, &ref_local))
+				zbx_vector_str_append(&vms, update->vms.values[i]);
+		}
+
+		for (i = 0; i < update->datastores.values_num; i++)
+		{
+			ref_local.id = update->datastores.values[i];
+
+			if (NULL == zbx_hashset_search(&ds_refs, &ref_local))
+				zbx_vector_str_append(&datastores, update->datastores.values[i]);
+		}
+	}
+
+	zbx_hashset_destroy(&ds_refs);
+	zbx_hashset_destroy(&vm_refs);
+	zbx_hashset_destroy(&hv_refs);
+
+	zbx_vmware_unlock();
+
+	/* the identifiers are owned by the hypervisor entries of the update set */
+	for (i = 0; i < vms.values_num; i++)
+		vmware_update_get(updates, ZBX_VMWARE_OBJECT_VM, vms.values[i])->refresh = 1;
+
+	for (i = 0; i < datastores.values_num; i++)
+		vmware_update_get(updates, ZBX_VMWARE_OBJECT_DS, datastores.values[i])->refresh = 1;
+
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (0 == update->refresh || 0 != update->leave || NULL != update->object)
+			continue;
+
+		switch (update->type)
+		{
+			case ZBX_VMWARE_OBJECT_VM:
+				if (NULL == (update->object = vmware_service_create_vm(service, easyhandle, update->id,
+						&error)))
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "cannot read virtual machine \"%s\": %s",
+							update->id, ZBX_NULL2EMPTY_STR(error));
+					zbx_free(error);
+				}
+				break;
+			case ZBX_VMWARE_OBJECT_DS:
+				update->object = vmware_service_create_datastore(service, easyhandle, update->id);
+				break;
+			default:
+				continue;
+		}
+
+		if (NULL != update->object)
+			fetched++;
+	}
+
+	zbx_vector_str_destroy(&datastores);
+	zbx_vector_str_destroy(&vms);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s() fetched:%d", __function_name, fetched);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_get_updates                                       *
+ *                                                                            *
+ * Purpose: reads the inventory changes since the last update using the       *
+ *          session and property filter kept from the previous update         *
+ *                                                                            *
+ * Parameters: service    - [IN] the vmware service                           *
+ *             easyhandle - [IN] the CURL handle                              *
+ *             page       - [IN] the CURL output buffer                       *
+ *             version    - [OUT] the version of the read change set          *
+ *             updates    - [OUT] the update set                              *
+ *             error      - [OUT] the error message in the case of failure    *
+ *                                                                            *
+ * Return value: SUCCEED - the changes were read successfully                 *
+ *               FAIL    - otherwise                                          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_service_get_updates(zbx_vmware_service_t *service, CURL *easyhandle, ZBX_HTTPPAGE *page,
+		char **version, zbx_hashset_t *updates, char **error)
+{
+	const char	*__function_name = "vmware_service_get_updates";
+	int		ret = FAIL;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s' filter:'%s'", __function_name, service->username,
+			service->url, service->update_filter);
+
+	if (SUCCEED != vmware_service_curl_init(service, easyhandle, page, error))
+		goto out;
+
+	if (SUCCEED != vmware_service_set_cookies(easyhandle, service->update_session, error))
+		goto out;
+
+	*version = zbx_strdup(*version, service->update_version);
+
+	if (SUCCEED != vmware_service_wait_for_updates(service, easyhandle, version, updates, error))
+		goto out;
+
+	vmware_service_fetch_updates(service, easyhandle, updates);
+
+	ret = SUCCEED;
+out:
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s objects:%d", __function_name, zbx_result_string(ret),
+			updates->num_data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_reset_updates                                     *
+ *                                                                            *
+ * Purpose: drops the incremental update state, so the next service update    *
+ *          reads the whole inventory                                         *
+ *                                                                            *
+ * Parameters: service - [IN] the vmware service                              *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_reset_updates(zbx_vmware_service_t *service)
+{
+	vmware_shared_strfree(service->update_session);
+	vmware_shared_strfree(service->update_filter);
+	vmware_shared_strfree(service->update_version);
+
+	service->update_session = NULL;
+	service->update_filter = NULL;
+	service->update_version = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_props_shared_update                                       *
+ *                                                                            *
+ * Purpose: replaces the changed properties in shared properties list         *
+ *                                                                            *
+ * Parameters: props      - [IN/OUT] the shared properties list               *
+ *             values     - [IN] the new property values                      *
+ *             props_mask - [IN] the indexes of the changed properties        *
+ *             props_num  - [IN] the number of properties in the list         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_props_shared_update(char **props, char **values, zbx_uint64_t props_mask, int props_num)
+{
+	int	i;
+
+	for (i = 0; i < props_num; i++)
+	{
+		if (0 == (props_mask & (__UINT64_C(1) << i)))
+			continue;
+
+		vmware_shared_strfree(props[i]);
+		props[i] = vmware_shared_strdup(values[i]);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_hv_vm_detach                                              *
+ *                                                                            *
+ * Purpose: removes virtual machine from the hypervisor virtual machine list  *
+ *          without freeing it                                                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_hv_vm_detach(zbx_vmware_hv_t *hv, zbx_vmware_vm_t *vm)
+{
+	int	i;
+
+	if (FAIL != (i = zbx_vector_ptr_search(&hv->vms, vm, ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+		zbx_vector_ptr_remove(&hv->vms, i);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_data_hv_remove                                            *
+ *                                                                            *
+ * Purpose: removes hypervisor from the service data, leaving its virtual     *
+ *          machines unassigned                                               *
+ *                                                                            *
+ * Parameters: data    - [IN/OUT] the vmware service data                     *
+ *             hv      - [IN] the hypervisor to remove                        *
+ *             vm_refs - [IN/OUT] the virtual machine references              *
+ *             removed - [OUT] the removed hypervisors                        *
+ *                                                                            *
+ * Comments: The removed hypervisor is freed only after the whole update set  *
+ *           is applied, as datastore references can point to its data.       *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_data_hv_remove(zbx_vmware_data_t *data, zbx_vmware_hv_t *hv, zbx_hashset_t *vm_refs,
+		zbx_vector_ptr_t *removed)
+{
+	zbx_vmware_ref_t	ref_local, *ref;
+	int			i;
+
+	for (i = 0; i < hv->vms.values_num; i++)
+	{
+		ref_local.id = ((zbx_vmware_vm_t *)hv->vms.values[i])->id;
+
+		if (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_search(vm_refs, &ref_local)))
+			ref->hv = NULL;
+	}
+
+	zbx_vector_ptr_clear(&hv->vms);
+
+	zbx_vector_ptr_append(removed, zbx_malloc(NULL, sizeof(zbx_vmware_hv_t)));
+	memcpy(removed->values[removed->values_num - 1], hv, sizeof(zbx_vmware_hv_t));
+
+	zbx_hashset_remove_direct(&data->hvs, hv);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_data_shared_update                                        *
+ *                                                                            *
+ * Purpose: applies the update set to vmware service data in shared memory    *
+ *                                                                            *
+ * Parameters: data    - [IN/OUT] the vmware service data                     *
+ *             src     - [IN] the vmware data object with new events,         *
+ *                            clusters and error                              *
+ *             updates - [IN] the update set                                  *
+ *                                                                            *
+ * Return value: SUCCEED - the update set was applied                         *
+ *               FAIL    - the update set did not match the service data or   *
+ *                         the changed objects could not be read, the         *
+ *                         inventory must be read fully                       *
+ *                                                                            *
+ * Comments: The service data is left consistent in the case of failure.      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_data_shared_update(zbx_vmware_data_t *data, zbx_vmware_data_t *src, zbx_hashset_t *updates)
+{
+	const char		*__function_name = "vmware_data_shared_update";
+
+	zbx_hashset_t		hv_refs, vm_refs, ds_refs;
+	zbx_hashset_iter_t	iter, hv_iter;
+	zbx_vmware_update_t	*update;
+	zbx_vmware_ref_t	ref_local, *ref;
+	zbx_vmware_hv_t		*hv, hv_local;
+	zbx_vmware_vm_t		*vm;
+	zbx_vector_ptr_t	removed;
+	int			i, ret = SUCCEED;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() objects:%d", __function_name, updates->num_data);
+
+	zbx_vector_ptr_create(&removed);
+	vmware_data_refs_create(data, &hv_refs, &vm_refs, &ds_refs);
+
+	/* virtual machines */
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_VMWARE_OBJECT_VM != update->type)
+			continue;
+
+		ref_local.id = update->id;
+		ref = (zbx_vmware_ref_t *)zbx_hashset_search(&vm_refs, &ref_local);
+
+		if (0 != update->leave)
+		{
+			if (NULL == ref)
+				continue;
+
+			vm = (zbx_vmware_vm_t *)ref->object;
+
+			if (NULL != ref->hv)
+				vmware_hv_vm_detach(ref->hv, vm);
+
+			zbx_hashset_remove_direct(&vm_refs, ref);
+			vmware_vm_shared_free(vm);
+		}
+		else if (NULL != update->object)
+		{
+			vm = vmware_vm_shared_dup((zbx_vmware_vm_t *)update->object);
+
+			if (NULL != ref)
+			{
+				if (FAIL != (i = zbx_vector_ptr_search(&ref->hv->vms, ref->object,
+						ZBX_DEFAULT_PTR_COMPARE_FUNC)))
+				{
+					ref->hv->vms.values[i] = vm;
+				}
+
+				vmware_vm_shared_free((zbx_vmware_vm_t *)ref->object);
+				ref->id = vm->id;
+				ref->object = vm;
+			}
+			else
+			{
+				/* new virtual machine, assigned to hypervisor when its virtual machine list is updated */
+				ref_local.id = vm->id;
+				ref_local.object = vm;
+				ref_local.hv = NULL;
+				zbx_hashset_insert(&vm_refs, &ref_local, sizeof(ref_local));
+			}
+		}
+		else
+		{
+			if (0 != update->refresh)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() virtual machine \"%s\" was not read", __function_name,
+						update->id);
+				ret = FAIL;
+			}
+
+			if (NULL != ref && 0 != update->props_mask)
+			{
+				vmware_props_shared_update(((zbx_vmware_vm_t *)ref->object)->props, update->props,
+						update->props_mask, ZBX_VMWARE_VMPROPS_NUM);
+			}
+		}
+	}
+
+	/* datastores */
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		zbx_vmware_datastore_t	*datastore = (zbx_vmware_datastore_t *)update->object;
+
+		if (ZBX_VMWARE_OBJECT_DS != update->type)
+			continue;
+
+		if (0 == update->leave && NULL == datastore)
+		{
+			if (0 != update->refresh)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() datastore \"%s\" was not read", __function_name,
+						update->id);
+				ret = FAIL;
+			}
+
+			continue;
+		}
+
+		ref_local.id = update->id;
+
+		if (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_search(&ds_refs, &ref_local)))
+			zbx_hashset_remove_direct(&ds_refs, ref);
+
+		if (0 == update->leave)
+		{
+			/* the new hypervisor datastores are copied from the read object */
+			ref_local.id = datastore->id;
+			ref_local.object = datastore;
+			ref_local.hv = NULL;
+			zbx_hashset_insert(&ds_refs, &ref_local, sizeof(ref_local));
+		}
+
+		zbx_hashset_iter_reset(&data->hvs, &hv_iter);
+		while (NULL != (hv = (zbx_vmware_hv_t *)zbx_hashset_iter_next(&hv_iter)))
+		{
+			for (i = 0; i < hv->datastores.values_num; i++)
+			{
+				zbx_vmware_datastore_t	*old = (zbx_vmware_datastore_t *)hv->datastores.values[i];
+
+				if (0 != strcmp(old->id, update->id))
+					continue;
+
+				if (0 == update->leave)
+					hv->datastores.values[i] = vmware_datastore_shared_dup(datastore);
+				else
+					zbx_vector_ptr_remove(&hv->datastores, i--);
+
+				vmware_datastore_shared_free(old);
+			}
+		}
+	}
+
+	/* hypervisors */
+	zbx_hashset_iter_reset(updates, &iter);
+	while (NULL != (update = (zbx_vmware_update_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (ZBX_VMWARE_OBJECT_HV != update->type)
+			continue;
+
+		ref_local.id = update->id;
+		ref = (zbx_vmware_ref_t *)zbx_hashset_search(&hv_refs, &ref_local);
+
+		if (0 != update->leave)
+		{
+			if (NULL == ref)
+				continue;
+
+			vmware_data_hv_remove(data, (zbx_vmware_hv_t *)ref->object, &vm_refs, &removed);
+			zbx_hashset_remove_direct(&hv_refs, ref);
+		}
+		else if (0 != update->refresh)
+		{
+			if (NULL == update->object)
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() hypervisor \"%s\" was not read", __function_name,
+						update->id);
+				ret = FAIL;
+				continue;
+			}
+
+			vmware_hv_shared_copy(&hv_local, (zbx_vmware_hv_t *)update->object);
+
+			for (i = 0; i < update->vms.values_num; i++)
+			{
+				ref_local.id = update->vms.values[i];
+
+				if (NULL == (ref = (zbx_vmware_ref_t *)zbx_hashset_search(&vm_refs, &ref_local)))
+				{
+					zabbix_log(LOG_LEVEL_DEBUG, "%s() virtual machine \"%s\" was not read",
+							__function_name, update->vms.values[i]);
+					ret = FAIL;
+					continue;
+				}
+
+				if (NULL != ref->hv)
+				{
+					vmware_hv_vm_detach(ref->hv, (zbx_vmware_vm_t *)ref->object);
+					ref->hv = NULL;
+				}
+
+				zbx_vector_ptr_append(&hv_local.vms, ref->object);
+			}
+
+			for (i = 0; i < update->datastores.values_num; i++)
+			{
+				ref_local.id = update->datastores.values[i];
+
+				if (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_search(&ds_refs, &ref_local)))
+				{
+					zbx_vector_ptr_append(&hv_local.datastores, vmware_datastore_shared_dup(
+							(zbx_vmware_datastore_t *)ref->object));
+				}
+			}
+
+			ref_local.id = update->id;
+
+			if (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_search(&hv_refs, &ref_local)))
+			{
+				vmware_data_hv_remove(data, (zbx_vmware_hv_t *)ref->object, &vm_refs, &removed);
+				zbx_hashset_remove_direct(&hv_refs, ref);
+			}
+
+			if (NULL != zbx_hashset_search(&data->hvs, &hv_local))
+			{
+				zabbix_log(LOG_LEVEL_DEBUG, "%s() duplicate hypervisor uuid \"%s\"", __function_name,
+						hv_local.uuid);
+
+				/* the adopted virtual machines are left unassigned and freed below */
+				zbx_vector_ptr_clear(&hv_local.vms);
+				vmware_hv_shared_clean(&hv_local);
+				ret = FAIL;
+				continue;
+			}
+
+			hv = (zbx_vmware_hv_t *)zbx_hashset_insert(&data->hvs, &hv_local, sizeof(hv_local));
+
+			for (i = 0; i < hv->vms.values_num; i++)
+			{
+				ref_local.id = ((zbx_vmware_vm_t *)hv->vms.values[i])->id;
+
+				if (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_search(&vm_refs, &ref_local)))
+					ref->hv = hv;
+			}
+
+			ref_local.id = hv->id;
+			ref_local.object = hv;
+			ref_local.hv = NULL;
+			zbx_hashset_insert(&hv_refs, &ref_local, sizeof(ref_local));
+		}
+		else if (NULL != ref && 0 != update->props_mask)
+		{
+			vmware_props_shared_update(((zbx_vmware_hv_t *)ref->object)->props, update->props,
+					update->props_mask, ZBX_VMWARE_HVPROPS_NUM);
+		}
+	}
+
+	/* free virtual machines that are not assigned to any hypervisor */
+	zbx_hashset_iter_reset(&vm_refs, &iter);
+	while (NULL != (ref = (zbx_vmware_ref_t *)zbx_hashset_iter_next(&iter)))
+	{
+		if (NULL == ref->hv)
+			vmware_vm_shared_free((zbx_vmware_vm_t *)ref->object);
+	}
+
+	for (i = 0; i < removed.values_num; i++)
+		vmware_hv_shared_clean((zbx_vmware_hv_t *)removed.values[i]);
+
+	zbx_vector_ptr_clear_ext(&removed, zbx_ptr_free);
+	zbx_vector_ptr_destroy(&removed);
+
+	zbx_hashset_destroy(&ds_refs);
+	zbx_hashset_destroy(&vm_refs);
+	zbx_hashset_destroy(&hv_refs);
+
+	/* rebuild virtual machine index */
+	zbx_hashset_clear(&data->vms_index);
+
+	zbx_hashset_iter_reset(&data->hvs, &iter);
+	while (NULL != (hv = (zbx_vmware_hv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		for (i = 0; i < hv->vms.values_num; i++)
+		{
+			zbx_vmware_vm_index_t	vmi_local = {(zbx_vmware_vm_t *)hv->vms.values[i], hv};
+
+			zbx_hashset_insert(&data->vms_index, &vmi_local, sizeof(vmi_local));
+		}
+	}
+
+	/* events, clusters and error are replaced on every update */
+	zbx_vector_ptr_clear_ext(&data->clusters, (zbx_clean_func_t)vmware_cluster_shared_free);
+	zbx_vector_ptr_reserve(&data->clusters, src->clusters.values_num);
+
+	for (i = 0; i < src->clusters.values_num; i++)
+	{
+		zbx_vector_ptr_append(&data->clusters,
+				vmware_cluster_shared_dup((zbx_vmware_cluster_t *)src->clusters.values[i]));
+	}
+
+	zbx_vector_ptr_clear_ext(&data->events, (zbx_clean_func_t)vmware_event_shared_free);
+	zbx_vector_ptr_reserve(&data->events, src->events.values_num);
+
+	for (i = 0; i < src->events.values_num; i++)
+	{
+		zbx_vector_ptr_append(&data->events,
+				vmware_event_shared_dup((zbx_vmware_event_t *)src->events.values[i]));
+	}
+
+	vmware_shared_strfree(data->error);
+	data->error = vmware_shared_strdup(src->error);
+	data->max_query_metrics = src->max_query_metrics;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s hvs:%d vms:%d", __function_name, zbx_result_string(ret),
+			data->hvs.num_data, data->vms_index.num_data);
+
+	return ret;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_update                                            *
+ *                                                                            *
+ * Purpose: updates object with a new data from vmware service                *
+ *                                                                            *
+ * Parameters: service      - [IN] the vmware service                         *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_update(zbx_vmware_service_t *service)
+{
+	const char		*__function_name = "vmware_service_update";
+
+	CURL			*easyhandle = NULL;
+	CURLoption		opt;
+	CURLcode		err;
+	struct curl_slist	*headers = NULL;
+	zbx_vmware_data_t	*data;
+	zbx_vector_str_t	hvs;
+	zbx_hashset_t		updates;
+	char			*update_session = NULL, *update_filter = NULL, *update_version = NULL;
+	int			i, ret = FAIL, incremental = FAIL, logout = FAIL;
+	ZBX_HTTPPAGE		page;	/* 347K/87K */
+	unsigned char		skip_old = service->eventlog.skip_old;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() '%s'@'%s'", __function_name, service->username, service->url);
+
+	data = (zbx_vmware_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_data_t));
+	memset(data, 0, sizeof(zbx_vmware_data_t));
+	page.alloc = 0;
+	page.data = NULL;
+
+	zbx_hashset_create(&data->hvs, 1, vmware_hv_hash, vmware_hv_compare);
+	zbx_vector_ptr_create(&data->clusters);
+	zbx_vector_ptr_create(&data->events);
+
+	zbx_vector_str_create(&hvs);
+	zbx_hashset_create(&updates, 100, vmware_update_hash, vmware_update_compare);
+
+	if (NULL == (easyhandle = curl_easy_init()))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "Cannot initialize cURL library");
+		goto out;
+	}
+
+	page.alloc = ZBX_INIT_UPD_XML_SIZE;
+	page.data = (char *)zbx_malloc(NULL, page.alloc);
+	headers = curl_slist_append(headers, ZBX_XML_HEADER1);
+	headers = curl_slist_append(headers, ZBX_XML_HEADER2);
+
+	if (CURLE_OK != (err = curl_easy_setopt(easyhandle, opt = CURLOPT_HTTPHEADER, headers)))
+	{
+		zabbix_log(LOG_LEVEL_WARNING, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
+		goto clean;
+	}
+
+	if (NULL != service->update_filter && SUCCEED == vmware_service_incremental_enabled(service))
+	{
+		char	*error = NULL;
+
+		if (SUCCEED == (incremental = vmware_service_get_updates(service, easyhandle, &page, &update_version,
+				&updates, &error)))
+		{
+			goto update;
+		}
+
+		zabbix_log(LOG_LEVEL_DEBUG, "Cannot read vmware inventory changes, performing full update: %s.",
+				error);
+		zbx_free(error);
+
+		/* the session usually has expired, but close it in the case it is still alive */
+		if (SUCCEED != vmware_service_logout(service, easyhandle, &error))
+			zbx_free(error);
+
+		curl_easy_setopt(easyhandle, CURLOPT_COOKIELIST, "ALL");
+		vmware_updates_clear(&updates);
+	}
+
+	if (SUCCEED != vmware_service_authenticate(service, easyhandle, &page, &data->error))
+		goto clean;
+
+	if (0 != (service->state & ZBX_VMWARE_STATE_NEW) &&
+			SUCCEED != vmware_service_initialize(service, easyhandle, &data->error))
+	{
+		goto clean;
+	}
+
+	if (SUCCEED == vmware_service_incremental_enabled(service))
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != vmware_service_create_filter(service, easyhandle, &update_filter, &update_version,
+				&error))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Cannot create vmware property filter: %s.", error);
+			zbx_free(error);
+		}
+	}
+
+	if (SUCCEED != vmware_service_get_hv_list(service, easyhandle, &hvs, &data->error))
+		goto clean;
+
+	if (SUCCEED != zbx_hashset_reserve(&data->hvs, hvs.values_num))
+	{
+		THIS_SHOULD_NEVER_HAPPEN;
+		exit(EXIT_FAILURE);
+	}
+
+	for (i = 0; i < hvs.values_num; i++)
+	{
+		zbx_vmware_hv_t	hv_local;
+
+		if (SUCCEED == vmware_service_init_hv(service, easyhandle, hvs.values[i], &hv_local, &data->error))
+			zbx_hashset_insert(&data->hvs, &hv_local, sizeof(hv_local));
+	}
+update:
+	/* skip collection of event data if we don't know where we stopped last time or item can't accept values */
+	if (ZBX_VMWARE_EVENT_KEY_UNINITIALIZED != service->eventlog.last_key && 0 == service->eventlog.skip_old &&
+			SUCCEED != vmware_service_get_event_data(service, easyhandle, &data->events, &data->error))
+	{
+		goto clean;
+	}
+
+	if (0 != service->eventlog.skip_old)
+	{
+		char	*error = NULL;
+
+		/* May not be present */
+		if (SUCCEED != vmware_service_get_last_event_data(service, easyhandle, &data->events, &error))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Unable retrieve lastevent value: %s.", error);
+			zbx_free(error);
+		}
+		else
+			skip_old = 0;
+	}
+
+	if (ZBX_VMWARE_TYPE_VCENTER == service->type &&
+			SUCCEED != vmware_service_get_cluster_list(easyhandle, &data->clusters, &data->error))
+	{
+		goto clean;
+	}
+
+	if (ZBX_VMWARE_TYPE_VCENTER != service->type)
+		data->max_query_metrics = ZBX_VPXD_STATS_MAXQUERYMETRICS;
+	else if (SUCCEED != vmware_service_get_maxquerymetrics(easyhandle, &data->max_query_metrics, &data->error))
+		goto clean;
+
+	/* keep the session owning the property filter for the next incremental update */
+	if (NULL != update_filter)
+	{
+		update_session = vmware_service_get_cookies(easyhandle);
+	}
+	else if (SUCCEED != incremental && SUCCEED != vmware_service_logout(service, easyhandle, &data->error))
+	{
+		zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", data->error);
+		zbx_free(data->error);
+	}
+
+	ret = SUCCEED;
+clean:
+	zbx_vector_str_clear_ext(&hvs, zbx_str_free);
+	zbx_vector_str_destroy(&hvs);
+out:
+	zbx_vmware_lock();
+
+	/* remove UPDATING flag and set READY or FAILED flag */
+	service->state &= ~(ZBX_VMWARE_STATE_MASK | ZBX_VMWARE_STATE_UPDATING);
+	service->state |= (SUCCEED == ret) ? ZBX_VMWARE_STATE_READY : ZBX_VMWARE_STATE_FAILED;
+
+	if (SUCCEED == incremental)
+	{
+		if (SUCCEED == ret)
+		{
+			vmware_shared_strfree(service->update_version);
+			service->update_version = vmware_shared_strdup(update_version);
+
+			if (SUCCEED != vmware_data_shared_update(service->data, data, &updates))
+				logout = SUCCEED;
+		}
+		else
+		{
+			/* the inventory was not changed, keep it and report the error */
+			vmware_shared_strfree(service->data->error);
+			service->data->error = vmware_shared_strdup(data->error);
+			logout = SUCCEED;
+		}
+
+		/* the next update reads the whole inventory with a new session */
+		if (SUCCEED == logout)
+			vmware_service_reset_updates(service);
+	}
+	else
+	{
+		vmware_data_shared_free(service->data);
+		service->data = vmware_data_shared_dup(data);
+
+		vmware_service_reset_updates(service);
+
+		if (SUCCEED == ret && NULL != update_filter && NULL != update_session)
+		{
+			service->update_session = vmware_shared_strdup(update_session);
+			service->update_filter = vmware_shared_strdup(update_filter);
+			service->update_version = vmware_shared_strdup(update_version);
+		}
+	}
+
+	service->eventlog.skip_old = skip_old;
+
+	service->lastcheck = time(NULL);
+
+	vmware_service_update_perf_entities(service);
+
+	zbx_vmware_unlock();
+
+	/* close the session owning the dropped property filter */
+	if (SUCCEED == logout)
+	{
+		char	*error = NULL;
+
+		if (SUCCEED != vmware_service_logout(service, easyhandle, &error))
+		{
+			zabbix_log(LOG_LEVEL_DEBUG, "Cannot close vmware connection: %s.", error);
+			zbx_free(error);
+		}
+	}
+
+	curl_easy_cleanup(easyhandle);
+	curl_slist_free_all(headers);
+	zbx_free(page.data);
+
+	vmware_data_free(data);
+
+	vmware_updates_clear(&updates);
+	zbx_hashset_destroy(&updates);
+
+	zbx_free(update_version);
+	zbx_free(update_filter);
+	zbx_free(update_session);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s():%s \tprocessed:" ZBX_FS_SIZE_T " bytes of data", __function_name,
+			zbx_result_string(ret), (zbx_fs_size_t)page.alloc);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * QueryPerf response streaming parser                                        *
+ *                                                                            *
+ * The performance counter values are parsed with libxml2 SAX push parser     *
+ * while the response is being received, so the response is neither           *
+ * buffered nor converted to a DOM tree. The parser follows the response      *
+ * structure:                                                                 *
+ *                                                                            *
+ *   Envelope/Body/QueryPerfResponse/returnval     - performance entity       *
+ *     entity                                      - entity id and type       *
+ *     value                                       - counter value series     *
+ *       id/counterId, id/instance                 - counter id and instance  *
+ *       value                                     - the counter value        *
+ *                                                                            *
+ ******************************************************************************/
+
+/* the elements with text data collected by perf parser */
+#define ZBX_PERF_TEXT_NONE	0
+#define ZBX_PERF_TEXT_ENTITY	1
+#define ZBX_PERF_TEXT_COUNTERID	2
+#define ZBX_PERF_TEXT_INSTANCE	3
+#define ZBX_PERF_TEXT_VALUE	4
+#define ZBX_PERF_TEXT_FAULT	5
+
+/* the response element depths, Envelope element being at depth 1 */
+#define ZBX_PERF_DEPTH_FAULT	3
+#define ZBX_PERF_DEPTH_ENTITY	4
+#define ZBX_PERF_DEPTH_SERIES	5
+#define ZBX_PERF_DEPTH_ID	6
+#define ZBX_PERF_DEPTH_COUNTER	7
+
+typedef struct
+{
+	xmlParserCtxt		*ctxt;
+
+	/* the raw response, collected only for trace logging */
+	ZBX_HTTPPAGE		*page;
+
+	/* the parsed performance entity data (see zbx_vmware_perf_data_t) */
+	zbx_vector_ptr_t	perfdata;
+
+	/* the current element depth */
+	int			depth;
+
+	/* the element context flags */
+	unsigned char		in_fault;
+	unsigned char		in_series;
+	unsigned char		in_id;
+
+	/* the element text being collected, see ZBX_PERF_TEXT_* defines */
+	unsigned char		text_type;
+	unsigned char		text_set;
+	int			text_depth;
+	char			*text;
+	size_t			text_alloc;
+	size_t			text_offset;
+
+	/* the current performance entity and its parsing status */
+	zbx_vmware_perf_data_t	*data;
+	int			data_ret;
+
+	/* the current counter value series */
+	char			*counter;
+	char			*instance;
+	char			*value;
+
+	char			*faultstring;
+}
+zbx_vmware_perf_parser_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_text_start                                    *
+ *                                                                            *
+ * Purpose: starts collecting text of the current element                     *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_text_start(zbx_vmware_perf_parser_t *parser, unsigned char type)
+{
+	parser->text_type = type;
+	parser->text_depth = parser->depth;
+	parser->text_offset = 0;
+	parser->text_set = 0;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_text_store                                    *
+ *                                                                            *
+ * Purpose: stores the collected element text into the specified value        *
+ *                                                                            *
+ * Comments: As with DOM based parsing an element without text results in     *
+ *           NULL value.                                                      *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_text_store(zbx_vmware_perf_parser_t *parser, char **value)
+{
+	zbx_free(*value);
+
+	if (0 != parser->text_set)
+		*value = zbx_strdup(NULL, parser->text);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_series_end                                    *
+ *                                                                            *
+ * Purpose: adds the parsed counter value to the current entity               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_series_end(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_vmware_perf_value_t	*perfvalue;
+
+	if (NULL != parser->value && NULL != parser->counter)
+	{
+		perfvalue = (zbx_vmware_perf_value_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_value_t));
+
+		ZBX_STR2UINT64(perfvalue->counterid, parser->counter);
+		perfvalue->instance = (NULL != parser->instance ? parser->instance : zbx_strdup(NULL, ""));
+		parser->instance = NULL;
+
+		if (0 == strcmp(parser->value, "-1") || SUCCEED != is_uint64(parser->value, &perfvalue->value))
+			perfvalue->value = UINT64_MAX;
+		else
+			parser->data_ret = SUCCEED;
+
+		zbx_vector_ptr_append(&parser->data->values, perfvalue);
+	}
+
+	zbx_free(parser->counter);
+	zbx_free(parser->instance);
+	zbx_free(parser->value);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_entity_end                                    *
+ *                                                                            *
+ * Purpose: adds the parsed performance entity to the parsed data if it       *
+ *          contains valid values                                             *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_entity_end(zbx_vmware_perf_parser_t *parser)
+{
+	zbx_vmware_perf_data_t	*data = parser->data;
+
+	if (NULL != data->type && NULL != data->id && SUCCEED == parser->data_ret)
+		zbx_vector_ptr_append(&parser->perfdata, data);
+	else
+		vmware_free_perfdata(data);
+
+	parser->data = NULL;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_start_element                                 *
+ *                                                                            *
+ * Purpose: libxml2 SAX2 element start callback                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_start_element(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+		const xmlChar *URI, int nb_namespaces, const xmlChar **namespaces, int nb_attributes,
+		int nb_defaulted, const xmlChar **attributes)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+	const char			*name = (const char *)localname;
+	int				i;
+
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+	ZBX_UNUSED(nb_namespaces);
+	ZBX_UNUSED(namespaces);
+	ZBX_UNUSED(nb_defaulted);
+
+	switch (++parser->depth)
+	{
+		case ZBX_PERF_DEPTH_FAULT:
+			if (0 == strcmp(name, "Fault"))
+				parser->in_fault = 1;
+			break;
+		case ZBX_PERF_DEPTH_ENTITY:
+			if (0 != parser->in_fault)
+			{
+				if (0 == strcmp(name, "faultstring"))
+					vmware_perf_parser_text_start(parser, ZBX_PERF_TEXT_FAULT);
+				break;
+			}
+
+			parser->data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+			parser->data->id = NULL;
+			parser->data->type = NULL;
+			parser->data->error = NULL;
+			zbx_vector_ptr_create(&parser->data->values);
+			parser->data_ret = FAIL;
+			break;
+		case ZBX_PERF_DEPTH_SERIES:
+			if (NULL == parser->data)
+				break;
+
+			if (0 == strcmp(name, "value"))
+			{
+				parser->in_series = 1;
+				break;
+			}
+
+			if (0 != strcmp(name, "entity") || NULL != parser->data->type || NULL != parser->data->id)
+				break;
+
+			/* attributes are passed as (localname, prefix, URI, value, end) tuples */
+			for (i = 0; i < nb_attributes; i++)
+			{
+				const xmlChar	**attr = attributes + i * 5;
+
+				if (NULL == attr[1] && 0 == strcmp((const char *)attr[0], "type"))
+				{
+					parser->data->type = zbx_malloc(NULL, attr[4] - attr[3] + 1);
+					memcpy(parser->data->type, attr[3], attr[4] - attr[3]);
+					parser->data->type[attr[4] - attr[3]] = '\0';
+					break;
+				}
+			}
+
+			vmware_perf_parser_text_start(parser, ZBX_PERF_TEXT_ENTITY);
+			break;
+		case ZBX_PERF_DEPTH_ID:
+			if (0 == parser->in_series)
+				break;
+
+			if (0 == strcmp(name, "id"))
+				parser->in_id = 1;
+			else if (0 == strcmp(name, "value"))
+				vmware_perf_parser_text_start(parser, ZBX_PERF_TEXT_VALUE);
+			break;
+		case ZBX_PERF_DEPTH_COUNTER:
+			if (0 == parser->in_id)
+				break;
+
+			if (0 == strcmp(name, "counterId") && NULL == parser->counter)
+				vmware_perf_parser_text_start(parser, ZBX_PERF_TEXT_COUNTERID);
+			else if (0 == strcmp(name, "instance") && NULL == parser->instance)
+				vmware_perf_parser_text_start(parser, ZBX_PERF_TEXT_INSTANCE);
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_end_element                                   *
+ *                                                                            *
+ * Purpose: libxml2 SAX2 element end callback                                 *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_end_element(void *ctx, const xmlChar *localname, const xmlChar *prefix,
+		const xmlChar *URI)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+
+	ZBX_UNUSED(localname);
+	ZBX_UNUSED(prefix);
+	ZBX_UNUSED(URI);
+
+	if (ZBX_PERF_TEXT_NONE != parser->text_type && parser->depth == parser->text_depth)
+	{
+		switch (parser->text_type)
+		{
+			case ZBX_PERF_TEXT_ENTITY:
+				vmware_perf_parser_text_store(parser, &parser->data->id);
+				break;
+			case ZBX_PERF_TEXT_COUNTERID:
+				vmware_perf_parser_text_store(parser, &parser->counter);
+				break;
+			case ZBX_PERF_TEXT_INSTANCE:
+				vmware_perf_parser_text_store(parser, &parser->instance);
+				break;
+			case ZBX_PERF_TEXT_VALUE:
+				vmware_perf_parser_text_store(parser, &parser->value);
+				break;
+			case ZBX_PERF_TEXT_FAULT:
+				vmware_perf_parser_text_store(parser, &parser->faultstring);
+				break;
+		}
+
+		parser->text_type = ZBX_PERF_TEXT_NONE;
+	}
+
+	switch (parser->depth--)
+	{
+		case ZBX_PERF_DEPTH_FAULT:
+			parser->in_fault = 0;
+			break;
+		case ZBX_PERF_DEPTH_ENTITY:
+			if (NULL != parser->data)
+				vmware_perf_parser_entity_end(parser);
+			break;
+		case ZBX_PERF_DEPTH_SERIES:
+			if (0 != parser->in_series)
+			{
+				vmware_perf_parser_series_end(parser);
+				parser->in_series = 0;
+			}
+			break;
+		case ZBX_PERF_DEPTH_ID:
+			parser->in_id = 0;
+			break;
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_characters                                    *
+ *                                                                            *
+ * Purpose: libxml2 SAX2 text callback                                        *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_characters(void *ctx, const xmlChar *ch, int len)
+{
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)ctx;
+
+	/* collect only the direct text content of the selected element */
+	if (ZBX_PERF_TEXT_NONE == parser->text_type || parser->depth != parser->text_depth)
+		return;
+
+	zbx_strncpy_alloc(&parser->text, &parser->text_alloc, &parser->text_offset, (const char *)ch, len);
+	parser->text_set = 1;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: curl_perf_write_cb                                               *
+ *                                                                            *
+ * Purpose: passes the received QueryPerf response data to perf parser        *
+ *                                                                            *
+ ******************************************************************************/
+static size_t	curl_perf_write_cb(void *ptr, size_t size, size_t nmemb, void *userdata)
+{
+	size_t				r_size = size * nmemb;
+	zbx_vmware_perf_parser_t	*parser = (zbx_vmware_perf_parser_t *)userdata;
+
+	if (NULL != parser->page)
+	{
+		zbx_strncpy_alloc(&parser->page->data, &parser->page->alloc, &parser->page->offset,
+				(const char *)ptr, r_size);
+	}
+
+	/* parsing errors are checked after the whole response is received */
+	xmlParseChunk(parser->ctxt, (const char *)ptr, (int)r_size, 0);
+
+	return r_size;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_init                                          *
+ *                                                                            *
+ * Purpose: prepares perf parser for a new QueryPerf response                 *
+ *                                                                            *
+ * Parameters: parser - [OUT] the perf parser                                 *
+ *             page   - [IN] the buffer for raw response, used only for trace *
+ *                           logging                                          *
+ *                                                                            *
+ * Return value: SUCCEED - the parser was initialized successfully            *
+ *               FAIL    - failed to create XML parser                        *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_parser_init(zbx_vmware_perf_parser_t *parser, ZBX_HTTPPAGE *page)
+{
+	xmlSAXHandler	sax;
+
+	memset(&sax, 0, sizeof(sax));
+	sax.initialized = XML_SAX2_MAGIC;
+	sax.startElementNs = vmware_perf_parser_start_element;
+	sax.endElementNs = vmware_perf_parser_end_element;
+	sax.characters = vmware_perf_parser_characters;
+	sax.ignorableWhitespace = vmware_perf_parser_characters;
+	sax.cdataBlock = vmware_perf_parser_characters;
+	sax.serror = libxml_handle_error;
+
+	memset(parser, 0, sizeof(zbx_vmware_perf_parser_t));
+	zbx_vector_ptr_create(&parser->perfdata);
+	parser->text_type = ZBX_PERF_TEXT_NONE;
+
+	if (SUCCEED == zabbix_check_log_level(LOG_LEVEL_TRACE))
+	{
+		parser->page = page;
+		page->offset = 0;
+	}
+
+	if (NULL == (parser->ctxt = xmlCreatePushParserCtxt(&sax, parser, NULL, 0, ZBX_VM_NONAME_XML)))
+		return FAIL;
+
+	xmlCtxtUseOptions(parser->ctxt, ZBX_XML_PARSE_OPTS);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_clean                                         *
+ *                                                                            *
+ * Purpose: frees resources allocated by perf parser                          *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_parser_clean(zbx_vmware_perf_parser_t *parser)
+{
+	if (NULL != parser->ctxt)
+		xmlFreeParserCtxt(parser->ctxt);
+
+	if (NULL != parser->data)
+		vmware_free_perfdata(parser->data);
+
+	zbx_vector_ptr_clear_ext(&parser->perfdata, (zbx_mem_free_func_t)vmware_free_perfdata);
+	zbx_vector_ptr_destroy(&parser->perfdata);
+
+	zbx_free(parser->counter);
+	zbx_free(parser->instance);
+	zbx_free(parser->value);
+	zbx_free(parser->faultstring);
+	zbx_free(parser->text);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_parser_result                                        *
+ *                                                                            *
+ * Purpose: finishes parsing of a received QueryPerf response                 *
+ *                                                                            *
+ * Parameters: fn_parent - [IN] the parent function name for Log records      *
+ *             parser    - [IN] the perf parser                               *
+ *             perfdata  - [OUT] the performance entity data                  *
+ *             error     - [OUT] the error message in the case of failure     *
+ *                                                                            *
+ * Return value: SUCCEED - the response was parsed successfully               *
+ *               FAIL    - the response was not valid or contained SOAP fault *
+ *                                                                            *
+ * Comments: The performance entity data is added to perfdata vector only if  *
+ *           the whole response was parsed successfully.                      *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_parser_result(const char *fn_parent, zbx_vmware_perf_parser_t *parser,
+		zbx_vector_ptr_t *perfdata, char **error)
+{
+	xmlParseChunk(parser->ctxt, NULL, 0, 1);
+
+	if (NULL != parser->page)
+	{
+		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP response: %s", fn_parent,
+				ZBX_NULL2EMPTY_STR(parser->page->data));
+	}
+
+	if (0 == parser->ctxt->wellFormed)
+	{
+		*error = zbx_strdup(*error, "Received response has no valid XML data.");
+		return FAIL;
+	}
+
+	if (NULL != parser->faultstring)
+	{
+		*error = parser->faultstring;
+		parser->faultstring = NULL;
+		return FAIL;
+	}
+
+	zbx_vector_ptr_append_array(perfdata, parser->perfdata.values, parser->perfdata.values_num);
+	zbx_vector_ptr_clear(&parser->perfdata);
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_data_add_error                                       *
+ *                                                                            *
+ * Purpose: adds error for the specified perf entity                          *
+ *                                                                            *
+ * Parameters: perfdata - [OUT] the collected performance counter data        *
+ *             type     - [IN] the performance entity type (HostSystem,       *
+ *                             (Datastore, VirtualMachine...)                 *
+ *             id       - [IN] the performance entity id                      *
+ *             error    - [IN] the error to add                               *
+ *             instance - [IN] the performance counter instance name          *
+ *             now      - [IN] the current timestamp                          *
+ *                                                                            *
+ * Comments: The performance counters are specified by their path:            *
+ *             <group>/<key>[<rollup type>]                                   *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_data_add_error(zbx_vector_ptr_t *perfdata, const char *type, const char *id,
+		const char *error)
+{
+	zbx_vmware_perf_data_t	*data;
+
+	data = zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+
+	data->type = zbx_strdup(NULL, type);
+	data->id = zbx_strdup(NULL, id);
+	data->error = zbx_strdup(NULL, error);
+	zbx_vector_ptr_create(&data->values);
+
+	zbx_vector_ptr_append(perfdata, data);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_service_parse_perf_data                                   *
+ *                                                                            *
+ * Purpose: updates vmware performance statistics data                        *
+ *                                                                            *
+ * Parameters: service  - [IN] the vmware service                             *
+ *             perfdata - [IN] the performance data                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_service_copy_perf_data(zbx_vmware_service_t *service, zbx_vector_ptr_t *perfdata)
+{
+	const char			*__function_name = "vmware_service_copy_perf_data";
+
+	int				i, j, *indexes = NULL, *counts = NULL;
+	zbx_vmware_perf_data_t		*data;
+	zbx_vmware_perf_value_t		*value;
+	zbx_vmware_perf_entity_t	*entity;
+	zbx_vmware_perf_counter_t	*perfcounter;
+	zbx_str_uint64_pair_t		perfvalue;
+
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+
+	for (i = 0; i < perfdata->values_num; i++)
+	{
+		data = (zbx_vmware_perf_data_t *)perfdata->values[i];
+
+		if (NULL == (entity = zbx_vmware_service_get_perf_entity(service, data->type, data->id)))
+			continue;
+
+		if (NULL != data->error)
+		{
+			entity->error = vmware_shared_strdup(data->error);
+			continue;
+		}
+
+		if (0 == data->values.values_num || 0 == entity->counters.values_num)
+			continue;
+
+		/* count the values of each counter to allocate the value arrays with exact size */
+		indexes = (int *)zbx_realloc(indexes, sizeof(int) * data->values.values_num);
+		counts = (int *)zbx_realloc(counts, sizeof(int) * entity->counters.values_num);
+		memset(counts, 0, sizeof(int) * entity->counters.values_num);
+
+		for (j = 0; j < data->values.values_num; j++)
+		{
+			value = (zbx_vmware_perf_value_t *)data->values.values[j];
+
+			if (FAIL != (indexes[j] = zbx_vector_ptr_bsearch(&entity->counters, &value->counterid,
+					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
+			{
+				counts[indexes[j]]++;
+			}
+		}
+
+		for (j = 0; j < entity->counters.values_num; j++)
+		{
+			if (0 == counts[j])
+				continue;
+
+			perfcounter = (zbx_vmware_perf_counter_t *)entity->counters.values[j];
+			zbx_vector_str_uint64_pair_reserve(&perfcounter->values, perfcounter->values.values_num +
+					counts[j]);
+		}
+
+		for (j = 0; j < data->values.values_num; j++)
+		{
+			if (FAIL == indexes[j])
+				continue;
+
+			value = (zbx_vmware_perf_value_t *)data->values.values[j];
+			perfcounter = (zbx_vmware_perf_counter_t *)entity->counters.values[indexes[j]];
+
+			perfvalue.name = vmware_shared_strdup(value->instance);
+			perfvalue.value = value->value;
+
+			zbx_vector_str_uint64_pair_append_ptr(&perfcounter->values, &perfvalue);
+		}
+	}
+
+	zbx_free(counts);
+	zbx_free(indexes);
+
+	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+}
+
+/* the QueryPerf request */
+typedef struct
+{
+	char			*request;
+
+	/* the entities having their last performance counters queried by this request */
+	zbx_vector_ptr_t	entities;
+}
+zbx_vmware_perf_query_t;
+
+/* the connection executing QueryPerf requests */
+typedef struct
+{
+	CURL				*easyhandle;
+
+	/* the request being executed, NULL if the connection is idle */
+	zbx_vmware_perf_query_t		*query;
+
+	zbx_vmware_perf_parser_t	parser;
+
+	/* the raw response buffer for trace logging */
+	ZBX_HTTPPAGE			page;
+}
+zbx_vmware_perf_conn_t;
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_query_free                                           *
+ *                                                                            *
+ * Purpose: frees QueryPerf request                                           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_query_free(zbx_vmware_perf_query_t *query)
+{
+	zbx_free(query->request);
+	zbx_vector_ptr_destroy(&query->entities);
+	zbx_free(query);
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_query_add_error                                      *
+ *                                                                            *
+ * Purpose: adds error for the entities of a failed QueryPerf request         *
+ *                                                                            *
+ * Parameters: perfdata - [OUT] the collected performance counter data        *
+ *             query    - [IN] the failed request                             *
+ *             error    - [IN] the error to add                               *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_perf_query_add_error(zbx_vector_ptr_t *perfdata, const zbx_vmware_perf_query_t *query,
+		const char *error)
+{
+	int				i;
+	zbx_vmware_perf_entity_t	*entity;
+
+	for (i = 0; i < query->entities.values_num; i++)
+	{
+		entity = (zbx_vmware_perf_entity_t *)query->entities.values[i];
+		vmware_perf_data_add_error(perfdata, entity->type, entity->id, error);
+	}
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_conn_start                                           *
+ *                                                                            *
+ * Purpose: prepares connection to execute QueryPerf request                  *
+ *                                                                            *
+ * Parameters: conn     - [IN] the idle connection                            *
+ *             query    - [IN] the request to execute                         *
+ *             perfdata - [OUT] the collected performance counter data        *
+ *                                                                            *
+ * Return value: SUCCEED - the connection is ready to perform the request     *
+ *               FAIL    - otherwise, the error is added to perfdata          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_conn_start(zbx_vmware_perf_conn_t *conn, zbx_vmware_perf_query_t *query,
+		zbx_vector_ptr_t *perfdata)
+{
+	CURLoption	opt;
+	CURLcode	err;
+	char		*error = NULL;
+
+	if (SUCCEED != vmware_perf_parser_init(&conn->parser, &conn->page))
+	{
+		error = zbx_strdup(error, "Cannot create XML parser.");
+	}
+	else if (CURLE_OK != (err = curl_easy_setopt(conn->easyhandle, opt = CURLOPT_WRITEFUNCTION,
+					curl_perf_write_cb)) ||
+			CURLE_OK != (err = curl_easy_setopt(conn->easyhandle, opt = CURLOPT_WRITEDATA,
+					&conn->parser)) ||
+			CURLE_OK != (err = curl_easy_setopt(conn->easyhandle, opt = CURLOPT_POSTFIELDS,
+					query->request)))
+	{
+		error = zbx_dsprintf(error, "Cannot set cURL option %d: %s.", (int)opt, curl_easy_strerror(err));
+	}
+
+	if (NULL != error)
+	{
+		vmware_perf_query_add_error(perfdata, query, error);
+		vmware_perf_parser_clean(&conn->parser);
+		zbx_free(error);
+
+		return FAIL;
+	}
+
+	conn->query = query;
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_conn_finish                                          *
+ *                                                                            *
+ * Purpose: processes the result of QueryPerf request and marks the           *
+ *          connection idle                                                   *
+ *                                                                            *
+ * Parameters: fn_parent - [IN] the parent function name for Log records      *
+ *             conn      - [IN] the connection                                *
+ *             error     - [IN] the transfer error, NULL if the response was  *
+ *                              received successfully                         *
+ *             perfdata  - [OUT] the collected performance counter data       *
+ *                                                                            *
+ * Return value: SUCCEED - the performance counter values were parsed         *
+ *               FAIL    - otherwise, the error is added to perfdata          *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_conn_finish(const char *fn_parent, zbx_vmware_perf_conn_t *conn, const char *error,
+		zbx_vector_ptr_t *perfdata)
+{
+	char	*parse_error = NULL;
+	int	ret = FAIL;
+
+	if (NULL == error && SUCCEED == (ret = vmware_perf_parser_result(fn_parent, &conn->parser, perfdata,
+			&parse_error)))
+	{
+		goto out;
+	}
+
+	vmware_perf_query_add_error(perfdata, conn->query, NULL != error ? error : parse_error);
+	zbx_free(parse_error);
+out:
+	vmware_perf_parser_clean(&conn->parser);
+	conn->query = NULL;
+
+	return ret;
+}
+
+#if LIBCURL_VERSION_NUM >= 0x071c00
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_queries_perform_multi                                *
+ *                                                                            *
+ * Purpose: executes QueryPerf requests concurrently over the specified       *
+ *          connections                                                       *
+ *                                                                            *
+ * Parameters: fn_parent - [IN] the parent function name for Log records      *
+ *             conns     - [IN] the connections                               *
+ *             conns_num - [IN] the number of connections                     *
+ *             queries   - [IN] the requests to execute                       *
+ *             perfdata  - [OUT] the collected performance counter data       *
+ *                                                                            *
+ * Return value: SUCCEED - the requests were executed                         *
+ *               FAIL    - failed to initialize cURL multi handle, no         *
+ *                         requests were executed                             *
+ *                                                                            *
+ * Comments: As with sequential execution no new requests are started after   *
+ *           a request has failed.                                            *
+ *                                                                            *
+ ******************************************************************************/
+static int	vmware_perf_queries_perform_multi(const char *fn_parent, zbx_vmware_perf_conn_t *conns,
+		int conns_num, const zbx_vector_ptr_t *queries, zbx_vector_ptr_t *perfdata)
+{
+	CURLM		*handle;
+	CURLMcode	code;
+	CURLMsg		*msg;
+	CURL		*easyhandle;
+	CURLcode	result;
+	const char	*error = NULL;
+	int		i, index = 0, active = 0, running, msgnum, failed = 0;
+
+	if (NULL == (handle = curl_multi_init()))
+		return FAIL;
+
+	while (1)
+	{
+		/* start the pending requests on idle connections */
+		for (i = 0; i < conns_num && index < queries->values_num && 0 == failed; i++)
+		{
+			if (NULL != conns[i].query)
+				continue;
+
+			if (SUCCEED != vmware_perf_conn_start(&conns[i], (zbx_vmware_perf_query_t *)queries->values[index++],
+					perfdata))
+			{
+				failed = 1;
+				break;
+			}
+
+			if (CURLM_OK != (code = curl_multi_add_handle(handle, conns[i].easyhandle)))
+			{
+				vmware_perf_conn_finish(fn_parent, &conns[i], curl_multi_strerror(code), perfdata);
+				failed = 1;
+				break;
+			}
+
+			active++;
+		}
+
+		if (0 == active)
+			break;
+
+		if (CURLM_OK != (code = curl_multi_perform(handle, &running)))
+		{
+			error = curl_multi_strerror(code);
+			break;
+		}
 
-	if (NULL == (xpathObj = xmlXPathEvalExpression((xmlChar *)"/*/*/*/*", xpathCtx)))
-		goto clean;
+		while (NULL != (msg = curl_multi_info_read(handle, &msgnum)))
+		{
+			if (CURLMSG_DONE != msg->msg)
+				continue;
 
-	if (0 != xmlXPathNodeSetIsEmpty(xpathObj->nodesetval))
-		goto clean;
+			easyhandle = msg->easy_handle;
+			result = msg->data.result;
 
-	nodeset = xpathObj->nodesetval;
-	zbx_vector_ptr_reserve(perfdata, nodeset->nodeNr + perfdata->values_alloc);
+			curl_multi_remove_handle(handle, easyhandle);
+			active--;
 
-	for (i = 0; i < nodeset->nodeNr; i++)
-	{
-		zbx_vmware_perf_data_t 	*data;
-		int			ret = FAIL;
+			for (i = 0; i < conns_num && conns[i].easyhandle != easyhandle; i++)
+				;
 
-		data = (zbx_vmware_perf_data_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+			if (SUCCEED != vmware_perf_conn_finish(fn_parent, &conns[i],
+					CURLE_OK != result ? curl_easy_strerror(result) : NULL, perfdata))
+			{
+				failed = 1;
+			}
+		}
 
-		data->id = zbx_xml_read_node_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']");
-		data->type = zbx_xml_read_node_value(xdoc, nodeset->nodeTab[i], "*[local-name()='entity']/@type");
-		data->error = NULL;
-		zbx_vector_ptr_create(&data->values);
+		if (0 != running && CURLM_OK != (code = curl_multi_wait(handle, NULL, 0, ZBX_VMWARE_PERF_WAIT_TIMEOUT,
+				NULL)))
+		{
+			error = curl_multi_strerror(code);
+			break;
+		}
+	}
 
-		if (NULL != data->type && NULL != data->id)
-			ret = vmware_service_process_perf_entity_data(&data->values, xdoc, nodeset->nodeTab[i]);
+	/* fail the requests interrupted by cURL multi interface error */
+	for (i = 0; i < conns_num; i++)
+	{
+		if (NULL == conns[i].query)
+			continue;
 
-		if (SUCCEED == ret)
-			zbx_vector_ptr_append(perfdata, data);
-		else
-			vmware_free_perfdata(data);
+		curl_multi_remove_handle(handle, conns[i].easyhandle);
+		vmware_perf_conn_finish(fn_parent, &conns[i], error, perfdata);
 	}
-clean:
-	if (NULL != xpathObj)
-		xmlXPathFreeObject(xpathObj);
 
-	xmlXPathFreeContext(xpathCtx);
-	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
+	curl_multi_cleanup(handle);
+
+	return SUCCEED;
 }
+#endif
 
 /******************************************************************************
  *                                                                            *
- * Function: vmware_perf_data_add_error                                       *
+ * Function: vmware_service_query_perf                                        *
  *                                                                            *
- * Purpose: adds error for the specified perf entity                          *
+ * Purpose: executes QueryPerf requests and parses the performance counter    *
+ *          values from the responses while they are being received           *
  *                                                                            *
- * Parameters: perfdata - [OUT] the collected performance counter data        *
- *             type     - [IN] the performance entity type (HostSystem,       *
- *                             (Datastore, VirtualMachine...)                 *
- *             id       - [IN] the performance entity id                      *
- *             error    - [IN] the error to add                               *
- *             instance - [IN] the performance counter instance name          *
- *             now      - [IN] the current timestamp                          *
+ * Parameters: fn_parent  - [IN] the parent function name for Log records     *
+ *             easyhandle - [IN] the authenticated CURL handle                *
+ *             queries    - [IN] the requests to execute                      *
+ *             perfdata   - [OUT] the collected performance counter data      *
  *                                                                            *
- * Comments: The performance counters are specified by their path:            *
- *             <group>/<key>[<rollup type>]                                   *
+ * Comments: Up to VMwarePerfConcurrency requests are executed concurrently,  *
+ *           using additional connections cloned from the authenticated one   *
+ *           and sharing its session.                                         *
  *                                                                            *
  ******************************************************************************/
-static void	vmware_perf_data_add_error(zbx_vector_ptr_t *perfdata, const char *type, const char *id,
-		const char *error)
+static void	vmware_service_query_perf(const char *fn_parent, CURL *easyhandle, const zbx_vector_ptr_t *queries,
+		zbx_vector_ptr_t *perfdata)
 {
-	zbx_vmware_perf_data_t	*data;
-
-	data = zbx_malloc(NULL, sizeof(zbx_vmware_perf_data_t));
+	const char		*__function_name = "vmware_service_query_perf";
 
-	data->type = zbx_strdup(NULL, type);
-	data->id = zbx_strdup(NULL, id);
-	data->error = zbx_strdup(NULL, error);
-	zbx_vector_ptr_create(&data->values);
+	zbx_vmware_perf_conn_t	*conns;
+	ZBX_HTTPPAGE		*page;
+	CURLcode		err;
+	char			*cookies = NULL, *error = NULL;
+	int			i, conns_num;
 
-	zbx_vector_ptr_append(perfdata, data);
-}
+	zabbix_log(LOG_LEVEL_DEBUG, "In %s() queries:%d", __function_name, queries->values_num);
 
-/******************************************************************************
- *                                                                            *
- * Function: vmware_service_parse_perf_data                                   *
- *                                                                            *
- * Purpose: updates vmware performance statistics data                        *
- *                                                                            *
- * Parameters: service  - [IN] the vmware service                             *
- *             perfdata - [IN] the performance data                           *
- *                                                                            *
- ******************************************************************************/
-static void	vmware_service_copy_perf_data(zbx_vmware_service_t *service, zbx_vector_ptr_t *perfdata)
-{
-	const char			*__function_name = "vmware_service_copy_perf_data";
+	if (0 == queries->values_num)
+		goto out;
 
-	int				i, j, index;
-	zbx_vmware_perf_data_t		*data;
-	zbx_vmware_perf_value_t		*value;
-	zbx_vmware_perf_entity_t	*entity;
-	zbx_vmware_perf_counter_t	*perfcounter;
-	zbx_str_uint64_pair_t		perfvalue;
+	if (CURLE_OK != (err = curl_easy_getinfo(easyhandle, CURLINFO_PRIVATE, (char **)&page)))
+	{
+		error = zbx_dsprintf(error, "Cannot get response buffer: %s.", curl_easy_strerror(err));
+		vmware_perf_query_add_error(perfdata, (zbx_vmware_perf_query_t *)queries->values[0], error);
+		zbx_free(error);
+		goto out;
+	}
 
-	zabbix_log(LOG_LEVEL_DEBUG, "In %s()", __function_name);
+	conns_num = MIN(CONFIG_VMWARE_PERF_CONCURRENCY, queries->values_num);
+#if LIBCURL_VERSION_NUM < 0x071c00
+	conns_num = 1;
+#endif
+	conns = (zbx_vmware_perf_conn_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_conn_t) * conns_num);
+	memset(conns, 0, sizeof(zbx_vmware_perf_conn_t) * conns_num);
+	conns[0].easyhandle = easyhandle;
 
-	for (i = 0; i < perfdata->values_num; i++)
+	if (1 < conns_num && NULL == (cookies = vmware_service_get_cookies(easyhandle)))
 	{
-		data = (zbx_vmware_perf_data_t *)perfdata->values[i];
+		zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot share session without cookies", __function_name);
+		conns_num = 1;
+	}
 
-		if (NULL == (entity = zbx_vmware_service_get_perf_entity(service, data->type, data->id)))
-			continue;
+	for (i = 1; i < conns_num; i++)
+	{
+		if (NULL == (conns[i].easyhandle = curl_easy_duphandle(easyhandle)))
+			break;
 
-		if (NULL != data->error)
+		if (SUCCEED != vmware_service_set_cookies(conns[i].easyhandle, cookies, &error))
 		{
-			entity->error = vmware_shared_strdup(data->error);
-			continue;
+			zabbix_log(LOG_LEVEL_DEBUG, "%s() cannot share session: %s", __function_name, error);
+			zbx_free(error);
+			curl_easy_cleanup(conns[i].easyhandle);
+			break;
 		}
+	}
 
-		for (j = 0; j < data->values.values_num; j++)
+	conns_num = i;
+	zbx_free(cookies);
+
+#if LIBCURL_VERSION_NUM >= 0x071c00
+	if (1 < conns_num && SUCCEED == vmware_perf_queries_perform_multi(fn_parent, conns, conns_num, queries,
+			perfdata))
+	{
+		goto clean;
+	}
+#endif
+	for (i = 0; i < queries->values_num; i++)
+	{
+		if (SUCCEED != vmware_perf_conn_start(&conns[0], (zbx_vmware_perf_query_t *)queries->values[i],
+				perfdata))
 		{
-			value = (zbx_vmware_perf_value_t *)data->values.values[j];
+			break;
+		}
 
-			if (FAIL == (index = zbx_vector_ptr_bsearch(&entity->counters, &value->counterid,
-					ZBX_DEFAULT_UINT64_PTR_COMPARE_FUNC)))
-			{
-				continue;
-			}
+		if (CURLE_OK != (err = curl_easy_perform(easyhandle)))
+		{
+			vmware_perf_conn_finish(fn_parent, &conns[0], curl_easy_strerror(err), perfdata);
+			break;
+		}
 
-			perfcounter = (zbx_vmware_perf_counter_t *)entity->counters.values[index];
+		if (SUCCEED != vmware_perf_conn_finish(fn_parent, &conns[0], NULL, perfdata))
+			break;
+	}
+#if LIBCURL_VERSION_NUM >= 0x071c00
+clean:
+#endif
+	for (i = 1; i < conns_num; i++)
+		curl_easy_cleanup(conns[i].easyhandle);
 
-			perfvalue.name = vmware_shared_strdup(value->instance);
-			perfvalue.value = value->value;
+	for (i = 0; i < conns_num; i++)
+		zbx_free(conns[i].page.data);
 
-			zbx_vector_str_uint64_pair_append_ptr(&perfcounter->values, &perfvalue);
-		}
-	}
+	zbx_free(conns);
 
+	/* restore the response buffer of the authenticated connection */
+	(void)curl_easy_setopt(easyhandle, CURLOPT_WRITEFUNCTION, curl_write_cb);
+	(void)curl_easy_setopt(easyhandle, CURLOPT_WRITEDATA, page);
+out:
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
 
@@ -4501,27 +6821,31 @@ static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service,
 {
 	const char			*__function_name = "vmware_service_retrieve_perf_counters";
 
-	char				*tmp = NULL, *error = NULL;
+	char				*tmp = NULL;
 	size_t				tmp_alloc = 0, tmp_offset;
-	int				i, j, start_counter = 0;
+	int				i, j, first, start_counter = 0;
 	zbx_vmware_perf_entity_t	*entity;
-	xmlDoc				*doc = NULL;
+	zbx_vmware_perf_query_t		*query;
+	zbx_vector_ptr_t		queries;
 
 	zabbix_log(LOG_LEVEL_DEBUG, "In %s() counters_max:%d", __function_name, counters_max);
 
-	while (0 != entities->values_num)
+	zbx_vector_ptr_create(&queries);
+
+	zbx_vmware_lock();
+
+	for (i = entities->values_num - 1; 0 <= i;)
 	{
 		int	counters_num = 0;
 
+		first = i;
 		tmp_offset = 0;
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_HEADER);
 		zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "<ns0:QueryPerf>"
 				"<ns0:_this type=\"PerformanceManager\">%s</ns0:_this>",
 				vmware_service_objects[service->type].performance_manager);
 
-		zbx_vmware_lock();
-
-		for (i = entities->values_num - 1; 0 <= i && counters_num < counters_max;)
+		for (; 0 <= i && counters_num < counters_max;)
 		{
 			char	*id_esc;
 
@@ -4585,36 +6909,30 @@ static void	vmware_service_retrieve_perf_counters(zbx_vmware_service_t *service,
 			zbx_snprintf_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:querySpec>");
 		}
 
-		zbx_vmware_unlock();
-		zbx_xml_free_doc(doc);
-		doc = NULL;
-
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, "</ns0:QueryPerf>");
 		zbx_strcpy_alloc(&tmp, &tmp_alloc, &tmp_offset, ZBX_POST_VSPHERE_FOOTER);
 
 		zabbix_log(LOG_LEVEL_TRACE, "%s() SOAP request: %s", __function_name, tmp);
 
-		if (SUCCEED != zbx_soap_post(__function_name, easyhandle, tmp, &doc, &error))
-		{
-			for (j = i + 1; j < entities->values_num; j++)
-			{
-				entity = (zbx_vmware_perf_entity_t *)entities->values[j];
-				vmware_perf_data_add_error(perfdata, entity->type, entity->id, error);
-			}
-
-			zbx_free(error);
-			break;
-		}
+		query = (zbx_vmware_perf_query_t *)zbx_malloc(NULL, sizeof(zbx_vmware_perf_query_t));
+		query->request = zbx_strdup(NULL, tmp);
+		zbx_vector_ptr_create(&query->entities);
 
-		/* parse performance data into local memory */
-		vmware_service_parse_perf_data(perfdata, doc);
+		for (j = i + 1; j <= first; j++)
+			zbx_vector_ptr_append(&query->entities, entities->values[j]);
 
-		while (entities->values_num > i + 1)
-			zbx_vector_ptr_remove_noorder(entities, entities->values_num - 1);
+		zbx_vector_ptr_append(&queries, query);
 	}
 
+	zbx_vmware_unlock();
+
+	/* Entities are removed only during performance counter update, so they can */
+	/* be referenced outside vmware lock when reporting request errors.          */
+	vmware_service_query_perf(__function_name, easyhandle, &queries, perfdata);
+
+	zbx_vector_ptr_clear_ext(&queries, (zbx_mem_free_func_t)vmware_perf_query_free);
+	zbx_vector_ptr_destroy(&queries);
 	zbx_free(tmp);
-	zbx_xml_free_doc(doc);
 
 	zabbix_log(LOG_LEVEL_DEBUG, "End of %s()", __function_name);
 }
@@ -5023,6 +7341,158 @@ zbx_vmware_perf_entity_t	*zbx_vmware_service_get_perf_entity(zbx_vmware_service_
 
 	return pentity;
 }
+
+/* the vmware cache memory taken by the specified allocation size */
+#define ZBX_VMWARE_MEM_CHUNK(size)	zbx_mem_required_chunk_size((zbx_uint64_t)(size))
+
+#define ZBX_VMWARE_MEM_ARRAY(num, type)	ZBX_VMWARE_MEM_CHUNK((zbx_uint64_t)(num) * sizeof(type))
+
+#define ZBX_VMWARE_MEM_HASHSET(hashset, type)								\
+		(ZBX_VMWARE_MEM_ARRAY((hashset)->num_slots, ZBX_HASHSET_ENTRY_T *) + (hashset)->num_data *	\
+		ZBX_VMWARE_MEM_CHUNK(offsetof(ZBX_HASHSET_ENTRY_T, data) + sizeof(type)))
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_vm_mem_usage                                              *
+ *                                                                            *
+ * Purpose: estimates vmware cache memory used by virtual machine data        *
+ *                                                                            *
+ * Comments: The strings are accounted separately as they are shared.         *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vmware_vm_mem_usage(const zbx_vmware_vm_t *vm)
+{
+	zbx_uint64_t	mem;
+
+	mem = ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_vm_t));
+	mem += ZBX_VMWARE_MEM_ARRAY(NULL != vm->props ? ZBX_VMWARE_VMPROPS_NUM : 0, char *);
+	mem += ZBX_VMWARE_MEM_ARRAY(vm->devs.values_alloc, void *);
+	mem += vm->devs.values_num * ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_dev_t));
+	mem += ZBX_VMWARE_MEM_ARRAY(vm->file_systems.values_alloc, void *);
+	mem += vm->file_systems.values_num * ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_fs_t));
+
+	return mem;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_data_mem_usage                                            *
+ *                                                                            *
+ * Purpose: estimates vmware cache memory used by service data object         *
+ *                                                                            *
+ * Parameters: data   - [IN] the vmware service data object                   *
+ *             memory - [IN/OUT] the memory usage by structure                *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_data_mem_usage(const zbx_vmware_data_t *data, zbx_uint64_t *memory)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_hv_t		*hv;
+	int			i;
+
+	memory[ZBX_VMWARE_MEMORY_HVS] += ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_data_t));
+	memory[ZBX_VMWARE_MEMORY_HVS] += ZBX_VMWARE_MEM_HASHSET(&data->hvs, zbx_vmware_hv_t);
+	memory[ZBX_VMWARE_MEMORY_VMS] += ZBX_VMWARE_MEM_HASHSET(&data->vms_index, zbx_vmware_vm_index_t);
+
+	zbx_hashset_iter_reset((zbx_hashset_t *)&data->hvs, &iter);
+	while (NULL != (hv = (zbx_vmware_hv_t *)zbx_hashset_iter_next(&iter)))
+	{
+		memory[ZBX_VMWARE_MEMORY_HVS] += ZBX_VMWARE_MEM_ARRAY(NULL != hv->props ? ZBX_VMWARE_HVPROPS_NUM : 0,
+				char *);
+		memory[ZBX_VMWARE_MEMORY_HVS] += ZBX_VMWARE_MEM_ARRAY(hv->datastores.values_alloc, void *);
+		memory[ZBX_VMWARE_MEMORY_HVS] += ZBX_VMWARE_MEM_ARRAY(hv->vms.values_alloc, void *);
+
+		memory[ZBX_VMWARE_MEMORY_DATASTORES] += hv->datastores.values_num *
+				ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_datastore_t));
+
+		for (i = 0; i < hv->vms.values_num; i++)
+			memory[ZBX_VMWARE_MEMORY_VMS] += vmware_vm_mem_usage((zbx_vmware_vm_t *)hv->vms.values[i]);
+	}
+
+	memory[ZBX_VMWARE_MEMORY_CLUSTERS] += ZBX_VMWARE_MEM_ARRAY(data->clusters.values_alloc, void *);
+	memory[ZBX_VMWARE_MEMORY_CLUSTERS] += data->clusters.values_num *
+			ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_cluster_t));
+
+	memory[ZBX_VMWARE_MEMORY_EVENTS] += ZBX_VMWARE_MEM_ARRAY(data->events.values_alloc, void *);
+	memory[ZBX_VMWARE_MEMORY_EVENTS] += data->events.values_num * ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_event_t));
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_perf_mem_usage                                            *
+ *                                                                            *
+ * Purpose: estimates vmware cache memory used by service performance         *
+ *          counters and entities                                             *
+ *                                                                            *
+ ******************************************************************************/
+static zbx_uint64_t	vmware_perf_mem_usage(const zbx_vmware_service_t *service)
+{
+	zbx_hashset_iter_t		iter;
+	zbx_vmware_perf_entity_t	*entity;
+	zbx_vmware_perf_counter_t	*counter;
+	zbx_uint64_t			mem;
+	int				i;
+
+	mem = ZBX_VMWARE_MEM_HASHSET(&service->counters, zbx_vmware_counter_t);
+	mem += ZBX_VMWARE_MEM_HASHSET(&service->entities, zbx_vmware_perf_entity_t);
+
+	zbx_hashset_iter_reset((zbx_hashset_t *)&service->entities, &iter);
+	while (NULL != (entity = (zbx_vmware_perf_entity_t *)zbx_hashset_iter_next(&iter)))
+	{
+		mem += ZBX_VMWARE_MEM_ARRAY(entity->counters.values_alloc, void *);
+
+		for (i = 0; i < entity->counters.values_num; i++)
+		{
+			counter = (zbx_vmware_perf_counter_t *)entity->counters.values[i];
+
+			mem += ZBX_VMWARE_MEM_CHUNK(sizeof(zbx_vmware_perf_counter_t));
+			mem += ZBX_VMWARE_MEM_ARRAY(counter->values.values_alloc, zbx_str_uint64_pair_t);
+		}
+	}
+
+	return mem;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: vmware_get_memory_usage                                          *
+ *                                                                            *
+ * Purpose: estimates vmware cache memory used by the cached structures       *
+ *                                                                            *
+ * Parameters: memory - [OUT] the memory usage by structure, see              *
+ *                            ZBX_VMWARE_MEMORY_* defines                     *
+ *                                                                            *
+ * Comments: The estimation follows the shared memory allocator chunk layout  *
+ *           and does not include the free space lost to fragmentation.       *
+ *           This function must be called with vmware cache locked.           *
+ *                                                                            *
+ ******************************************************************************/
+static void	vmware_get_memory_usage(zbx_uint64_t *memory)
+{
+	zbx_hashset_iter_t	iter;
+	zbx_vmware_service_t	*service;
+	const char		*str;
+	int			i;
+
+	memory[ZBX_VMWARE_MEMORY_STRINGS] = ZBX_VMWARE_MEM_ARRAY(vmware->strpool.num_slots, ZBX_HASHSET_ENTRY_T *);
+
+	zbx_hashset_iter_reset(&vmware->strpool, &iter);
+	while (NULL != (str = (const char *)zbx_hashset_iter_next(&iter)))
+	{
+		memory[ZBX_VMWARE_MEMORY_STRINGS] += ZBX_VMWARE_MEM_CHUNK(offsetof(ZBX_HASHSET_ENTRY_T, data) +
+				REFCOUNT_FIELD_SIZE + strlen(str + REFCOUNT_FIELD_SIZE) + 1);
+	}
+
+	for (i = 0; i < vmware->services.values_num; i++)
+	{
+		service = (zbx_vmware_service_t *)vmware->services.values[i];
+
+		if (NULL != service->data)
+			vmware_data_mem_usage(service->data, memory);
+
+		memory[ZBX_VMWARE_MEMORY_PERF] += vmware_perf_mem_usage(service);
+	}
+}
 #endif
 
 /******************************************************************************
@@ -5211,6 +7681,15 @@ ZBX_THREAD_ENTRY(vmware_thread, args)
 					removed_services++;
 					break;
 			}
+
+			/* cache memory usage here, so statistics requests do not traverse the whole cache */
+			if (ZBX_VMWARE_TASK_IDLE != task)
+			{
+				zbx_vmware_lock();
+				memset(vmware->memory, 0, sizeof(vmware->memory));
+				vmware_get_memory_usage(vmware->memory);
+				zbx_vmware_unlock();
+			}
 		}
 		while (ZBX_VMWARE_TASK_IDLE != task);
 
@@ -5303,6 +7782,69 @@ int	zbx_vmware_get_statistics(zbx_vmware_stats_t *stats)
 	return SUCCEED;
 }
 
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vmware_get_memory_usage                                      *
+ *                                                                            *
+ * Purpose: gets vmware cache memory used by the cached structures            *
+ *                                                                            *
+ * Parameters: memory - [OUT] the memory usage by structure, see              *
+ *                            ZBX_VMWARE_MEMORY_* defines                     *
+ *                                                                            *
+ * Return value: SUCCEED - the memory usage was retrieved successfully        *
+ *               FAIL    - no vmware collectors are running                   *
+ *                                                                            *
+ * Comments: Returns the usage cached by collectors after their last task.    *
+ *                                                                            *
+ ******************************************************************************/
+int	zbx_vmware_get_memory_usage(zbx_uint64_t *memory)
+{
+	if (NULL == vmware_mem)
+		return FAIL;
+
+	zbx_vmware_lock();
+	memcpy(memory, vmware->memory, sizeof(vmware->memory));
+	zbx_vmware_unlock();
+
+	return SUCCEED;
+}
+
+/******************************************************************************
+ *                                                                            *
+ * Function: zbx_vmware_memory_string                                         *
+ *                                                                            *
+ * Purpose: gets the name of vmware cache structure used in memory usage      *
+ *          statistics                                                        *
+ *                                                                            *
+ * Parameters: structure - [IN] the structure, see ZBX_VMWARE_MEMORY_*        *
+ *                         defines                                            *
+ *                                                                            *
+ * Return value: the structure name                                           *
+ *                                                                            *
+ ******************************************************************************/
+const char	*zbx_vmware_memory_string(int structure)
+{
+	switch (structure)
+	{
+		case ZBX_VMWARE_MEMORY_STRINGS:
+			return "strings";
+		case ZBX_VMWARE_MEMORY_HVS:
+			return "hypervisors";
+		case ZBX_VMWARE_MEMORY_VMS:
+			return "vms";
+		case ZBX_VMWARE_MEMORY_DATASTORES:
+			return "datastores";
+		case ZBX_VMWARE_MEMORY_CLUSTERS:
+			return "clusters";
+		case ZBX_VMWARE_MEMORY_EVENTS:
+			return "events";
+		case ZBX_VMWARE_MEMORY_PERF:
+			return "perf";
+		default:
+			return "unknown";
+	}
+}
+
 #if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
 
 /*
@@ -5318,7 +7860,7 @@ int	zbx_vmware_get_statistics(zbx_vmware_stats_t *stats)
  *             err       - [IN] the libxml2 error message                     *
  *                                                                            *
  ******************************************************************************/
-static void	libxml_handle_error(void *user_data, xmlErrorPtr err)
+static void	libxml_handle_error(void *user_data, zbx_libxml_error_ptr_t err)
 {
 	ZBX_UNUSED(user_data);
 	ZBX_UNUSED(err);
@@ -235,17 +235,39 @@ typedef struct
 
 	/* lastlogsize when vmware.eventlog[] item was polled last time and skip old flag*/
 	zbx_vmware_eventlog_state_t	eventlog;
+
+	/* the incremental update state, set only when VMwareIncrementalUpdate is enabled: */
+	/*   update_session - the cookies of the session owning the property filter         */
+	/*   update_filter  - the property filter reporting inventory changes               */
+	/*   update_version - the version of the last applied inventory change set          */
+	char				*update_session;
+	char				*update_filter;
+	char				*update_version;
 }
 zbx_vmware_service_t;
 
 #define ZBX_VMWARE_PERF_INTERVAL_UNKNOWN	0
 #define ZBX_VMWARE_PERF_INTERVAL_NONE		-1
 
+/* the vmware cache structures for memory usage statistics */
+#define ZBX_VMWARE_MEMORY_STRINGS	0
+#define ZBX_VMWARE_MEMORY_HVS		1
+#define ZBX_VMWARE_MEMORY_VMS		2
+#define ZBX_VMWARE_MEMORY_DATASTORES	3
+#define ZBX_VMWARE_MEMORY_CLUSTERS	4
+#define ZBX_VMWARE_MEMORY_EVENTS	5
+#define ZBX_VMWARE_MEMORY_PERF		6
+
+#define ZBX_VMWARE_MEMORY_COUNT		7
+
 /* the vmware collector data */
 typedef struct
 {
 	zbx_vector_ptr_t	services;
 	zbx_hashset_t		strpool;
+
+	/* the memory usage by structure, recalculated by collectors after each task */
+	zbx_uint64_t		memory[ZBX_VMWARE_MEMORY_COUNT];
 }
 zbx_vmware_t;
 
@@ -266,6 +288,8 @@ void	zbx_vmware_lock(void);
 void	zbx_vmware_unlock(void);
 
 int	zbx_vmware_get_statistics(zbx_vmware_stats_t *stats);
+int	zbx_vmware_get_memory_usage(zbx_uint64_t *memory);
+const char	*zbx_vmware_memory_string(int structure);
 
 #if defined(HAVE_LIBXML2) && defined(HAVE_LIBCURL)
 
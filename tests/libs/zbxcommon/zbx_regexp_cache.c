@@ -0,0 +1,65 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxregexp.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hpatterns, hpattern;
+	zbx_mock_error_t	err;
+	const char		*string, *pattern, *expected;
+	zbx_uint64_t		repeat, i, hits, misses;
+	int			len;
+	char			*match;
+
+	ZBX_UNUSED(state);
+
+	string = zbx_mock_get_parameter_string("in.string");
+	repeat = zbx_mock_get_parameter_uint64("in.repeat");
+
+	for (i = 0; i < repeat; i++)
+	{
+		hpatterns = zbx_mock_get_parameter_handle("in.patterns");
+
+		while (ZBX_MOCK_SUCCESS == (err = zbx_mock_vector_element(hpatterns, &hpattern)))
+		{
+			pattern = zbx_mock_get_object_member_string(hpattern, "pattern");
+			expected = zbx_mock_get_object_member_string(hpattern, "match");
+
+			if (NULL == (match = zbx_regexp_match(string, pattern, &len)))
+			{
+				zbx_mock_assert_str_eq("Unexpected regexp match result", expected, "no");
+				continue;
+			}
+
+			zbx_mock_assert_str_eq("Unexpected regexp match result", expected, "yes");
+		}
+	}
+
+	zbx_regexp_cache_stats(&hits, &misses);
+
+	zbx_mock_assert_uint64_eq("Invalid cache hit count", zbx_mock_get_parameter_uint64("out.hits"), hits);
+	zbx_mock_assert_uint64_eq("Invalid cache miss count", zbx_mock_get_parameter_uint64("out.misses"), misses);
+}
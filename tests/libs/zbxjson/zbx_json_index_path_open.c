@@ -0,0 +1,96 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hpaths, hpath, hresults, hresult;
+	zbx_mock_error_t	err;
+	const char		*json, *path, *result;
+	struct zbx_json_parse	jp, jp_out, out;
+	zbx_json_index_t	index;
+	zbx_jsonpath_t		jsonpath;
+	char			*buffer = NULL, *expected = NULL, *error;
+	size_t			size = 0, expected_size = 0;
+
+	ZBX_UNUSED(state);
+
+	json = zbx_mock_get_parameter_string("in.json");
+
+	if (SUCCEED != zbx_json_open(json, &jp))
+		fail_msg("Cannot open json: %s", zbx_json_strerror());
+
+	if (SUCCEED != zbx_json_index_open(json, &index))
+		fail_msg("Cannot index json: %s", zbx_json_strerror());
+
+	hpaths = zbx_mock_get_parameter_handle("in.paths");
+	hresults = zbx_mock_get_parameter_handle("out.results");
+
+	while (ZBX_MOCK_SUCCESS == (err = zbx_mock_vector_element(hpaths, &hpath)))
+	{
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hpath, &path)))
+			fail_msg("Cannot read json path: %s", zbx_mock_error_string(err));
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hresults, &hresult)))
+			fail_msg("Cannot get result for path \"%s\": %s", path, zbx_mock_error_string(err));
+
+		result = zbx_mock_get_object_member_string(hresult, "result");
+
+		if (SUCCEED != zbx_jsonpath_compile(path, &jsonpath))
+			fail_msg("Cannot compile json path \"%s\": %s", path, zbx_json_strerror());
+
+		/* paths must be resolved exactly like with zbx_json_path_open() */
+		if (SUCCEED != zbx_json_path_open(&jp, path, &jp_out))
+		{
+			error = zbx_strdup(NULL, zbx_json_strerror());
+
+			zbx_mock_assert_str_eq("Invalid zbx_json_path_open() return value", result, "fail");
+			zbx_mock_assert_result_eq("Invalid zbx_json_index_path_open() return value", FAIL,
+					zbx_json_index_path_open(&index, 0, &jsonpath, &out));
+			zbx_mock_assert_str_eq("Error differs from zbx_json_path_open()", error, zbx_json_strerror());
+
+			zbx_free(error);
+			zbx_jsonpath_clear(&jsonpath);
+			continue;
+		}
+
+		zbx_mock_assert_str_eq("Invalid zbx_json_path_open() return value", result, "succeed");
+		zbx_mock_assert_result_eq("Invalid zbx_json_index_path_open() return value", SUCCEED,
+				zbx_json_index_path_open(&index, 0, &jsonpath, &out));
+
+		zbx_json_value_dyn(&jp_out, &expected, &expected_size);
+		zbx_json_value_dyn(&out, &buffer, &size);
+
+		zbx_mock_assert_str_eq("Invalid value", zbx_mock_get_object_member_string(hresult, "value"), buffer);
+		zbx_mock_assert_str_eq("Value differs from zbx_json_path_open()", expected, buffer);
+
+		zbx_jsonpath_clear(&jsonpath);
+	}
+
+	zbx_json_index_clear(&index);
+	zbx_free(expected);
+	zbx_free(buffer);
+}
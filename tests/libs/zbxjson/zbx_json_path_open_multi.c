@@ -0,0 +1,92 @@
+/*
+** Zabbix
+** Copyright (C) 2001-2019 Zabbix SIA
+**
+** This program is free software; you can redistribute it and/or modify
+** it under the terms of the GNU General Public License as published by
+** the Free Software Foundation; either version 2 of the License, or
+** (at your option) any later version.
+**
+** This program is distributed in the hope that it will be useful,
+** but WITHOUT ANY WARRANTY; without even the implied warranty of
+** MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+** GNU General Public License for more details.
+**
+** You should have received a copy of the GNU General Public License
+** along with this program; if not, write to the Free Software
+** Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA.
+**/
+
+#include "zbxmocktest.h"
+#include "zbxmockdata.h"
+#include "zbxmockassert.h"
+#include "zbxmockutil.h"
+
+#include "common.h"
+#include "zbxjson.h"
+
+#define MAX_PATHS	16
+
+void	zbx_mock_test_entry(void **state)
+{
+	zbx_mock_handle_t	hpaths, hpath, hresults, hresult;
+	zbx_mock_error_t	err;
+	const char		*json, *paths[MAX_PATHS], *result;
+	struct zbx_json_parse	jp, jp_out, out[MAX_PATHS];
+	char			*buffer = NULL, *expected = NULL;
+	int			i, paths_num = 0, found[MAX_PATHS], found_num = 0, ret;
+	size_t			size = 0, expected_size = 0;
+
+	ZBX_UNUSED(state);
+
+	json = zbx_mock_get_parameter_string("in.json");
+
+	hpaths = zbx_mock_get_parameter_handle("in.paths");
+
+	while (ZBX_MOCK_SUCCESS == (err = zbx_mock_vector_element(hpaths, &hpath)))
+	{
+		if (MAX_PATHS == paths_num)
+			fail_msg("Too many json paths");
+
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_string(hpath, &paths[paths_num++])))
+			fail_msg("Cannot read json path: %s", zbx_mock_error_string(err));
+	}
+
+	if (SUCCEED != zbx_json_open(json, &jp))
+		fail_msg("Cannot open json: %s", zbx_json_strerror());
+
+	ret = zbx_json_path_open_multi(&jp, paths, paths_num, out, found);
+
+	hresults = zbx_mock_get_parameter_handle("out.results");
+
+	for (i = 0; i < paths_num; i++)
+	{
+		if (ZBX_MOCK_SUCCESS != (err = zbx_mock_vector_element(hresults, &hresult)))
+			fail_msg("Cannot get result for path \"%s\": %s", paths[i], zbx_mock_error_string(err));
+
+		result = zbx_mock_get_object_member_string(hresult, "result");
+
+		/* paths must be resolved exactly like with zbx_json_path_open() */
+		if (SUCCEED != zbx_json_path_open(&jp, paths[i], &jp_out))
+		{
+			zbx_mock_assert_str_eq("Invalid zbx_json_path_open() return value", result, "fail");
+			zbx_mock_assert_result_eq("Invalid zbx_json_path_open_multi() result", FAIL, found[i]);
+			continue;
+		}
+
+		zbx_mock_assert_str_eq("Invalid zbx_json_path_open() return value", result, "succeed");
+		zbx_mock_assert_result_eq("Invalid zbx_json_path_open_multi() result", SUCCEED, found[i]);
+		found_num++;
+
+		zbx_json_value_dyn(&jp_out, &expected, &expected_size);
+		zbx_json_value_dyn(&out[i], &buffer, &size);
+
+		zbx_mock_assert_str_eq("Invalid value", zbx_mock_get_object_member_string(hresult, "value"), buffer);
+		zbx_mock_assert_str_eq("Value differs from zbx_json_path_open()", expected, buffer);
+	}
+
+	zbx_mock_assert_int_eq("Invalid number of located objects", found_num, ret);
+
+	zbx_free(expected);
+	zbx_free(buffer);
+}